@@ -80,6 +80,19 @@ static const void *stripPointer(const void *ptr) {
 
 pthread_mutex_t RecursiveAutoLock::_sMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
 
+RecursiveAutoLock::RecursiveAutoLock()
+{
+    // must wait out parallel initializers before taking the lock, as they may call dlopen() too
+    gAllImages.beginLoadAPI();
+    pthread_mutex_lock(&_sMutex);
+}
+
+RecursiveAutoLock::~RecursiveAutoLock()
+{
+    pthread_mutex_unlock(&_sMutex);
+    gAllImages.endLoadAPI();
+}
+
 uint32_t _dyld_image_count(void)
 {
     log_apis("_dyld_image_count()\n");
@@ -1063,7 +1076,8 @@ static void* dlsym_search(const char* symName, const LoadedImage& start, bool se
 
 void* dlsym_internal(void* handle, const char* symbolName, void* callerAddress)
 {
-    log_apis("dlsym(%p, \"%s\")\n", handle, symbolName);
+    MachOLoaded::ExportCacheStats cacheStats = MachOLoaded::exportCacheStats();
+    log_apis("dlsym(%p, \"%s\") export cache hits so far: %llu of %llu\n", handle, symbolName, cacheStats.hits, cacheStats.lookups);
 
     clearErrorString();
 
@@ -59,12 +59,8 @@ namespace dyld3 {
 class __attribute__((visibility("hidden"))) RecursiveAutoLock
 {
 public:
-    RecursiveAutoLock() {
-        pthread_mutex_lock(&_sMutex);
-    }
-    ~RecursiveAutoLock() {
-        pthread_mutex_unlock(&_sMutex);
-    }
+    RecursiveAutoLock();
+    ~RecursiveAutoLock();
 private:
     static pthread_mutex_t _sMutex;
 };
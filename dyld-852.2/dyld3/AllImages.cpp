@@ -32,6 +32,7 @@
 #include <uuid/uuid.h>
 #include <mach-o/dyld_images.h>
 #include <libc_private.h>
+#include <dispatch/dispatch.h>
 
 #include <vector>
 #include <algorithm>
@@ -145,6 +146,16 @@ void AllImages::setHasCacheOverrides(bool someCacheImageOverriden)
     _someImageOverridden = someCacheImageOverriden;
 }
 
+void AllImages::setParallelInitializers(bool enabled)
+{
+    _parallelInitializers = enabled;
+}
+
+void AllImages::setCompactImageInfoEnabled(bool enabled)
+{
+    _compactImageInfo.setEnabled(enabled);
+}
+
 bool AllImages::hasCacheOverrides() const {
     return _someImageOverridden;
 }
@@ -229,6 +240,9 @@ void AllImages::mirrorToOldAllImageInfos()
         _oldAllImageInfos->infoArrayChangeTimestamp = mach_absolute_time();
         _oldAllImageInfos->infoArray                = _oldAllImageArray;
 
+        // republish single buffer snapshot of image list
+        _compactImageInfo.publish(_oldAllImageInfos, _oldAllImageArray, imageCount);
+
         // <radr://problem/42668846> update UUID array if needed
         uint32_t nonCachedCount = 1; // always add dyld
         for (const LoadedImage& li : _loadedImages) {
@@ -501,6 +515,9 @@ void AllImages::removeImages(const Array<LoadedImage>& unloadImages)
         recomputeBounds();
     });
 
+    // dlsym() results cached for these images are now stale
+    MachOLoaded::flushExportCache();
+
     // sync to old all image infos struct
     mirrorToOldAllImageInfos();
 
@@ -1561,7 +1578,7 @@ void AllImages::runStartupInitialzers()
             if ( _loadedImages[imageIndex].loadedAddress()->isMainExecutable() )
                 mainExecutableInitializerNeedsToRun = false;
         });
-       runInitialzersBottomUp(image);
+       runInitialzersBottomUp(image, true);
         ++imageIndex;
     }
 }
@@ -1614,8 +1631,19 @@ bool AllImages::swapImageState(closure::ImageNum num, uint32_t& indexHint, Loade
 // Because an initializer may call dlopen() and/or create threads, the _loadedImages array
 // may move under us. So, never keep a pointer into it. Always reference images by ImageNum
 // and use hint to make that faster in the case where the _loadedImages does not move.
-void AllImages::runInitialzersBottomUp(const closure::Image* topImage)
+void AllImages::runInitialzersBottomUp(const closure::Image* topImage, bool atLaunch)
 {
+    // Initializers are only run in parallel at launch.  dlopen() holds the load lock while running
+    // initializers, so an initializer on a worker thread which called dlopen() would deadlock.
+    // A launch initializer run in parallel may still call dlopen(), see beginLoadAPI().
+    const bool allowParallel = atLaunch && _parallelInitializers && _oldAllImageInfos->libSystemInitialized;
+
+    // measuring depths or running initializers in parallel needs to track every image in the list
+    if ( allowParallel || initializerTimesLogged() ) {
+        runInitializersScheduled(topImage, allowParallel);
+        return;
+    }
+
     // walk closure specified initializer list, already ordered bottom up
     topImage->forEachImageToInitBefore(^(closure::ImageNum imageToInit, bool& stop) {
         // get copy of LoadedImage about imageToInit, but don't keep reference into _loadedImages, because it may move if initialzers call dlopen()
@@ -1623,21 +1651,199 @@ void AllImages::runInitialzersBottomUp(const closure::Image* topImage)
         LoadedImage loadedImageCopy = findImageNum(imageToInit, indexHint);
         // skip if the image is already inited, or in process of being inited (dependency cycle)
         if ( (loadedImageCopy.state() == LoadedImage::State::fixedUp) && swapImageState(imageToInit, indexHint, LoadedImage::State::fixedUp, LoadedImage::State::beingInited) ) {
-            // tell objc to run any +load methods in image
-            if ( (_objcNotifyInit != nullptr) && loadedImageCopy.image()->mayHavePlusLoads() ) {
-                dyld3::ScopedTimer timer(DBG_DYLD_TIMING_OBJC_INIT, (uint64_t)loadedImageCopy.loadedAddress(), 0, 0);
-                const char* path = imagePath(loadedImageCopy.image());
-                log_notifications("dyld: objc-init-notifier called with mh=%p, path=%s\n", loadedImageCopy.loadedAddress(), path);
-                (*_objcNotifyInit)(path, loadedImageCopy.loadedAddress());
+            runInitializersForImage(imageToInit, loadedImageCopy, indexHint, 0);
+        }
+    });
+}
+
+// Runs +load methods and initializers in an image which has been moved to the beingInited state
+void AllImages::runInitializersForImage(closure::ImageNum imageNum, const LoadedImage& loadedImage, uint32_t indexHint, uint32_t depth)
+{
+    const uint64_t startTime = mach_absolute_time();
+
+    // tell objc to run any +load methods in image
+    if ( (_objcNotifyInit != nullptr) && loadedImage.image()->mayHavePlusLoads() ) {
+        dyld3::ScopedTimer timer(DBG_DYLD_TIMING_OBJC_INIT, (uint64_t)loadedImage.loadedAddress(), 0, 0);
+        const char* path = imagePath(loadedImage.image());
+        log_notifications("dyld: objc-init-notifier called with mh=%p, path=%s\n", loadedImage.loadedAddress(), path);
+        (*_objcNotifyInit)(path, loadedImage.loadedAddress());
+    }
+
+    // run all initializers in image
+    runAllInitializersInImage(loadedImage.image(), loadedImage.loadedAddress());
+
+    if ( initializerTimesLogged() ) {
+        static mach_timebase_info_data_t sTimebaseInfo;
+        if ( sTimebaseInfo.denom == 0 )
+            mach_timebase_info(&sTimebaseInfo);
+        uint64_t micros = ((mach_absolute_time() - startTime) * sTimebaseInfo.numer) / (sTimebaseInfo.denom * 1000);
+        log_initializer_times("dyld: initializers in %s took %llu us, dependency depth %u\n", imagePath(loadedImage.image()), micros, depth);
+    }
+
+    // advance state to inited
+    swapImageState(imageNum, indexHint, LoadedImage::State::beingInited, LoadedImage::State::inited);
+}
+
+// Like runInitialzersBottomUp(), but also tracks the dependency depth of each image initialized, which
+// is one more than the deepest image it links with.  If allowParallel is set, consecutive
+// images in the init list which opted in with a __TEXT,__dyld_par_init section, have no +load methods,
+// and do not link with each other, are batched up and have their initializers run concurrently.
+void AllImages::runInitializersScheduled(const closure::Image* topImage, bool allowParallel)
+{
+    struct InitRecord { closure::ImageNum imageNum; uint32_t depth; bool inBatch; };
+    struct BatchEntry { closure::ImageNum imageNum; LoadedImage loadedImage; uint32_t indexHint; uint32_t depth; };
+    STACK_ALLOC_OVERFLOW_SAFE_ARRAY(InitRecord, records, 512);
+    STACK_ALLOC_OVERFLOW_SAFE_ARRAY(BatchEntry, batch, 32);
+
+    // batch images are only claimed when their initializers start, because a dlopen() from a
+    // batch-mate's initializer may have run them first, as it would have if run serially
+    void (^runBatch)(void) = ^{
+        if ( batch.count() == 1 ) {
+            uint32_t indexHint = batch[0].indexHint;
+            if ( swapImageState(batch[0].imageNum, indexHint, LoadedImage::State::fixedUp, LoadedImage::State::beingInited) )
+                runInitializersForImage(batch[0].imageNum, batch[0].loadedImage, indexHint, batch[0].depth);
+        }
+        else if ( batch.count() > 1 ) {
+            dispatch_apply(batch.count(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+                const BatchEntry& entry = batch[index];
+                ParallelInitWorker worker;
+                beginParallelInitializer(worker);
+                uint32_t indexHint = entry.indexHint;
+                if ( swapImageState(entry.imageNum, indexHint, LoadedImage::State::fixedUp, LoadedImage::State::beingInited) )
+                    runInitializersForImage(entry.imageNum, entry.loadedImage, indexHint, entry.depth);
+                endParallelInitializer(worker);
+            });
+        }
+        batch.clear();
+        for (InitRecord& record : records)
+            record.inBatch = false;
+    };
+
+    // walk closure specified initializer list, already ordered bottom up
+    topImage->forEachImageToInitBefore(^(closure::ImageNum imageToInit, bool& stop) {
+        // get copy of LoadedImage about imageToInit, but don't keep reference into _loadedImages, because it may move if initialzers call dlopen()
+        uint32_t    indexHint = 0;
+        LoadedImage loadedImageCopy = findImageNum(imageToInit, indexHint);
+
+        // dependents were earlier in the list, unless already initialized by a previous call
+        __block uint32_t depth          = 0;
+        __block bool     dependsOnBatch = false;
+        loadedImageCopy.image()->forEachDependentImage(^(uint32_t depIndex, closure::Image::LinkKind kind, closure::ImageNum depImageNum, bool& depStop) {
+            uint32_t depDepth = 0;
+            for (const InitRecord& record : records) {
+                if ( record.imageNum == depImageNum ) {
+                    depDepth = record.depth;
+                    dependsOnBatch |= record.inBatch;
+                    break;
+                }
             }
+            if ( depDepth + 1 > depth )
+                depth = depDepth + 1;
+        });
 
-            // run all initializers in image
-            runAllInitializersInImage(loadedImageCopy.image(), loadedImageCopy.loadedAddress());
+        // images which did not opt in may depend on initializer side effects of any earlier image.  Images with
+        // +load methods are run serially, because objc holds its load lock while running them, so a +load
+        // calling dlopen() would wait for batch-mates which are themselves waiting for that lock
+        const bool canBatch = allowParallel && loadedImageCopy.image()->parallelInitSafe() && !loadedImageCopy.image()->mayHavePlusLoads();
+        if ( !canBatch || dependsOnBatch )
+            runBatch();
 
-            // advance state to inited
-            swapImageState(imageToInit, indexHint, LoadedImage::State::beingInited, LoadedImage::State::inited);
+        bool inBatch = false;
+        // skip if the image is already inited, or in process of being inited (dependency cycle)
+        if ( canBatch && (loadedImageCopy.state() == LoadedImage::State::fixedUp) ) {
+            batch.push_back({ imageToInit, loadedImageCopy, indexHint, depth });
+            inBatch = true;
+        }
+        else if ( (loadedImageCopy.state() == LoadedImage::State::fixedUp) && swapImageState(imageToInit, indexHint, LoadedImage::State::fixedUp, LoadedImage::State::beingInited) ) {
+            runInitializersForImage(imageToInit, loadedImageCopy, indexHint, depth);
         }
+        records.push_back({ imageToInit, depth, inBatch });
     });
+    runBatch();
+}
+
+//
+// A launch initializer run in parallel may call dlopen(), or any other API which takes the load lock.
+// That load must not run while a batch-mate is part way through its initializers on another thread,
+// because it would skip that image as already being initialized and run initializers which depend
+// on it too early.  So, while parallel initializers are allowed, load APIs first wait until no
+// other batch initializer is running, and batch initializers do not start while a load API is in
+// progress.  A worker which itself calls a load API stops counting as running until the API returns,
+// so two workers which both call dlopen() take turns rather than wait on each other.  Batch images
+// which have not started are still fixedUp, so the load runs them itself, in the same order that
+// serial initialization would.
+//
+
+AllImages::ParallelInitWorker* AllImages::findParallelInitWorker(pthread_t thread)
+{
+    for (ParallelInitWorker* worker = _parallelInitWorkers; worker != nullptr; worker = worker->next) {
+        if ( pthread_equal(worker->thread, thread) )
+            return worker;
+    }
+    return nullptr;
+}
+
+void AllImages::beginParallelInitializer(ParallelInitWorker& worker)
+{
+    pthread_mutex_lock(&_parallelInitMutex);
+    while ( _loadAPIDepth != 0 )
+        pthread_cond_wait(&_parallelInitCond, &_parallelInitMutex);
+    worker.thread = pthread_self();
+    worker.next   = _parallelInitWorkers;
+    _parallelInitWorkers = &worker;
+    ++_parallelInitRunning;
+    pthread_mutex_unlock(&_parallelInitMutex);
+}
+
+void AllImages::endParallelInitializer(ParallelInitWorker& worker)
+{
+    pthread_mutex_lock(&_parallelInitMutex);
+    for (ParallelInitWorker** link = &_parallelInitWorkers; *link != nullptr; link = &(*link)->next) {
+        if ( *link == &worker ) {
+            *link = worker.next;
+            break;
+        }
+    }
+    --_parallelInitRunning;
+    pthread_cond_broadcast(&_parallelInitCond);
+    pthread_mutex_unlock(&_parallelInitMutex);
+}
+
+void AllImages::beginLoadAPI()
+{
+    if ( !_parallelInitializers )
+        return;
+    pthread_mutex_lock(&_parallelInitMutex);
+    pthread_t self = pthread_self();
+    if ( (_loadAPIDepth != 0) && pthread_equal(_loadAPIOwner, self) ) {
+        // initializer run by this load called another load API
+        ++_loadAPIDepth;
+        pthread_mutex_unlock(&_parallelInitMutex);
+        return;
+    }
+    if ( findParallelInitWorker(self) != nullptr ) {
+        --_parallelInitRunning;
+        pthread_cond_broadcast(&_parallelInitCond);
+    }
+    while ( (_loadAPIDepth != 0) || (_parallelInitRunning != 0) )
+        pthread_cond_wait(&_parallelInitCond, &_parallelInitMutex);
+    _loadAPIOwner = self;
+    _loadAPIDepth = 1;
+    pthread_mutex_unlock(&_parallelInitMutex);
+}
+
+void AllImages::endLoadAPI()
+{
+    if ( !_parallelInitializers )
+        return;
+    pthread_mutex_lock(&_parallelInitMutex);
+    if ( --_loadAPIDepth == 0 ) {
+        // a worker goes back to running the rest of its initializer
+        if ( findParallelInitWorker(_loadAPIOwner) != nullptr )
+            ++_parallelInitRunning;
+        pthread_cond_broadcast(&_parallelInitCond);
+    }
+    pthread_mutex_unlock(&_parallelInitMutex);
 }
 
 void AllImages::runLibSystemInitializer(LoadedImage& libSystem)
@@ -1677,7 +1883,7 @@ void AllImages::runAllInitializersInImage(const closure::Image* image, const Mac
         initFunc = (Initializer)__builtin_ptrauth_sign_unauthenticated((void*)initFunc, 0, 0);
 #endif
         {
-            ScopedTimer(DBG_DYLD_TIMING_STATIC_INITIALIZER, (uint64_t)ml, (uint64_t)func, 0);
+            ScopedTimer timer(DBG_DYLD_TIMING_STATIC_INITIALIZER, (uint64_t)ml, (uint64_t)func, 0);
             initFunc(NXArgc, NXArgv, environ, appleParams, _programVars);
 
         }
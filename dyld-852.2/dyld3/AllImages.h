@@ -37,6 +37,7 @@
 #include "MachOLoaded.h"
 #include "DyldSharedCache.h"
 #include "PointerAuth.h"
+#include "dyld_process_info_internal.h"
 
 
 #if TARGET_OS_OSX
@@ -65,6 +66,8 @@ public:
                                      const Array<LoadedImage>& initialImages);
     void                        setRestrictions(bool allowAtPaths, bool allowEnvPaths);
     void                        setHasCacheOverrides(bool someCacheImageOverriden);
+    void                        setParallelInitializers(bool enabled);
+    void                        setCompactImageInfoEnabled(bool enabled);
     bool                        hasCacheOverrides() const;
     void                        setMainPath(const char* path);
     void                        setLaunchMode(uint32_t flags);
@@ -76,8 +79,10 @@ public:
     void                        runImageCallbacks(const Array<LoadedImage>& newImages);
     void                        applyInterposingToDyldCache(const closure::Closure* closure, mach_port_t mach_task_self);
     void                        runStartupInitialzers();
-    void                        runInitialzersBottomUp(const closure::Image* topImage);
+    void                        runInitialzersBottomUp(const closure::Image* topImage, bool atLaunch=false);
     void                        runLibSystemInitializer(LoadedImage& libSystem);
+    void                        beginLoadAPI();
+    void                        endLoadAPI();
 
     uint32_t                    count() const;
 
@@ -211,6 +216,12 @@ private:
     LoadedImage                 findImageNum(closure::ImageNum num, uint32_t& indexHint);
     bool                        swapImageState(closure::ImageNum num, uint32_t& indexHint, LoadedImage::State expectedCurrentState, LoadedImage::State newState);
     void                        runAllInitializersInImage(const closure::Image* image, const MachOLoaded* ml);
+    void                        runInitializersForImage(closure::ImageNum imageNum, const LoadedImage& loadedImage, uint32_t indexHint, uint32_t depth);
+    void                        runInitializersScheduled(const closure::Image* topImage, bool allowParallel);
+    struct ParallelInitWorker { pthread_t thread; ParallelInitWorker* next; };
+    ParallelInitWorker*         findParallelInitWorker(pthread_t thread);
+    void                        beginParallelInitializer(ParallelInitWorker& worker);
+    void                        endParallelInitializer(ParallelInitWorker& worker);
     void                        recomputeBounds();
     void                        runAllStaticTerminators();
     uintptr_t                   resolveTarget(closure::Image::ResolvedSymbolTarget target) const;
@@ -235,6 +246,7 @@ private:
     dyld_all_image_infos*                   _oldAllImageInfos    = nullptr;
     dyld_image_info*                        _oldAllImageArray    = nullptr;
     dyld_uuid_info*                         _oldUUIDArray        = nullptr;
+    CompactImageInfoPublisher               _compactImageInfo;
     const GradedArchs*                      _archs               = nullptr;
     ImmutableRanges                         _immutableRanges     = { nullptr, 2 };
     uint32_t                                _oldArrayAllocCount  = 0;
@@ -245,7 +257,14 @@ private:
     bool                                    _allowAtPaths        = false;
     bool                                    _allowEnvPaths       = false;
     bool                                    _someImageOverridden = false;
+    bool                                    _parallelInitializers = false;
     uint32_t                                _launchMode          = 0;
+    pthread_mutex_t                         _parallelInitMutex   = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t                          _parallelInitCond    = PTHREAD_COND_INITIALIZER;
+    ParallelInitWorker*                     _parallelInitWorkers = nullptr;
+    uint32_t                                _parallelInitRunning = 0;
+    pthread_t                               _loadAPIOwner        = nullptr;
+    uint32_t                                _loadAPIDepth        = 0;
     uintptr_t                               _lowestNonCached     = 0;
     uintptr_t                               _highestNonCached    = UINTPTR_MAX;
     
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2021 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef BulkFileInfo_h
+#define BulkFileInfo_h
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/attr.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/vnode.h>
+
+//
+// Finds whether each of a list of files exists, and its inode and mtime, which is what validating
+// a launch closure needs for every file it recorded.  Paths are grouped by parent directory, and a
+// directory holding several of them is read with getattrlistbulk(), which returns the name, type,
+// inode and mtime of many entries per call, instead of stat()ing each path.
+//
+// A listing is only trusted when it answers exactly.  Symlinks, names which only match ignoring
+// case, and non-ASCII names (which a volume may normalize) are stat()ed.  So is everything in a
+// directory which cannot be read, or which turns out to be so large that reading it would take
+// more calls than stat()ing the paths in it.
+//
+
+namespace dyld3 {
+
+struct BulkFileInfo
+{
+    const char*     path;
+    uint64_t        inode;
+    uint64_t        mtime;
+    bool            exists;
+    bool            answered;       // used internally
+};
+
+struct BulkFileInfoStats
+{
+    uint32_t        directoriesRead = 0;    // open() of a directory, successful or not
+    uint32_t        bulkReads       = 0;    // getattrlistbulk() calls
+    uint32_t        stats           = 0;    // stat() calls
+};
+
+typedef int (*BulkFileInfoStatFunc)(const char* path, struct stat* buf);
+
+// directories holding fewer paths than this are cheaper to stat() a path at a time
+enum { kBulkFileInfoMinPathsPerDirectory = 3 };
+
+
+// returns the length of the directory part of path, or zero if it should not be listed
+static inline size_t bulkFileInfoDirLength(const char* path)
+{
+    if ( path[0] != '/' )
+        return 0;
+    const char* lastSlash = strrchr(path, '/');
+    if ( (lastSlash == path) || (lastSlash[1] == '\0') || ((size_t)(lastSlash - path) >= MAXPATHLEN) )
+        return 0;
+    for (const char* s = lastSlash + 1; *s != '\0'; ++s) {
+        if ( (uint8_t)*s >= 0x80 )
+            return 0;
+    }
+    return lastSlash - path;
+}
+
+static inline void bulkFileInfoStat(BulkFileInfo& info, BulkFileInfoStatFunc statFunc, BulkFileInfoStats& stats)
+{
+    struct stat statBuf;
+    ++stats.stats;
+    info.exists   = (statFunc(info.path, &statBuf) == 0);
+    info.inode    = info.exists ? statBuf.st_ino   : 0;
+    info.mtime    = info.exists ? statBuf.st_mtime : 0;
+    info.answered = true;
+}
+
+// infoDirLength is bulkFileInfoDirLength(info.path), computed once per path by getBulkFileInfo()
+static inline bool bulkFileInfoInDirectory(const BulkFileInfo& info, size_t infoDirLength, const char* dirPath, size_t dirLength)
+{
+    return !info.answered && (infoDirLength == dirLength) && (strncmp(info.path, dirPath, dirLength) == 0);
+}
+
+// Answers infos[first..count) which are in the directory of infos[first] from a listing of it.
+// Returns false if the directory could not be completely read, leaving some paths unanswered.
+static inline bool bulkFileInfoReadDirectory(BulkFileInfo infos[], const uint16_t dirLengths[], uint32_t first, uint32_t count,
+                                             uint32_t pathsInDir, BulkFileInfoStatFunc statFunc, BulkFileInfoStats& stats)
+{
+    const size_t dirLength = dirLengths[first];
+    char dirPath[MAXPATHLEN];
+    memcpy(dirPath, infos[first].path, dirLength);
+    dirPath[dirLength] = '\0';
+
+    ++stats.directoriesRead;
+    int fd = ::open(dirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if ( fd == -1 ) {
+        // a missing directory has no entries, but one we cannot read may contain files stat() can find
+        if ( (errno != ENOENT) && (errno != ENOTDIR) )
+            return false;
+        for (uint32_t i=first; i < count; ++i) {
+            if ( bulkFileInfoInDirectory(infos[i], dirLengths[i], infos[first].path, dirLength) ) {
+                infos[i].exists   = false;
+                infos[i].answered = true;
+            }
+        }
+        return true;
+    }
+
+    struct attrlist attrList;
+    bzero(&attrList, sizeof(attrList));
+    attrList.bitmapcount = ATTR_BIT_MAP_COUNT;
+    attrList.commonattr  = ATTR_CMN_RETURNED_ATTRS | ATTR_CMN_NAME | ATTR_CMN_OBJTYPE | ATTR_CMN_MODTIME | ATTR_CMN_FILEID;
+    const attrgroup_t neededAttrs = ATTR_CMN_NAME | ATTR_CMN_OBJTYPE | ATTR_CMN_MODTIME | ATTR_CMN_FILEID;
+
+    // never make more calls than stat()ing every path would have
+    const uint32_t maxBulkReads = pathsInDir;
+    uint32_t       bulkReads    = 0;
+    bool           complete     = false;
+    uint8_t        buffer[8192] __attribute__((aligned(8)));
+    while ( bulkReads < maxBulkReads ) {
+        ++bulkReads;
+        ++stats.bulkReads;
+        int entryCount = ::getattrlistbulk(fd, &attrList, buffer, sizeof(buffer), FSOPT_PACK_INVAL_ATTRS);
+        if ( entryCount == -1 ) {
+            if ( errno == EINTR )
+                continue;
+            break;
+        }
+        if ( entryCount == 0 ) {
+            complete = true;
+            break;
+        }
+        // with FSOPT_PACK_INVAL_ATTRS every entry has every attribute, in bit order, after its length and returned set
+        const uint8_t* entry = buffer;
+        for (int e=0; e < entryCount; ++e) {
+            uint32_t entryLength;
+            memcpy(&entryLength, entry, sizeof(uint32_t));
+            const uint8_t*  field = entry + sizeof(uint32_t);
+            attribute_set_t returned;
+            memcpy(&returned, field, sizeof(attribute_set_t));
+            field += sizeof(attribute_set_t);
+            attrreference_t nameRef;
+            memcpy(&nameRef, field, sizeof(attrreference_t));
+            const char* name = (const char*)field + nameRef.attr_dataoffset;
+            field += sizeof(attrreference_t);
+            fsobj_type_t objType;
+            memcpy(&objType, field, sizeof(fsobj_type_t));
+            field += sizeof(fsobj_type_t);
+            struct timespec modTime;
+            memcpy(&modTime, field, sizeof(struct timespec));
+            field += sizeof(struct timespec);
+            uint64_t fileID;
+            memcpy(&fileID, field, sizeof(uint64_t));
+            const bool usable = ((returned.commonattr & neededAttrs) == neededAttrs) && (objType != VLNK);
+
+            for (uint32_t i=first; i < count; ++i) {
+                BulkFileInfo& info = infos[i];
+                if ( !bulkFileInfoInDirectory(info, dirLengths[i], infos[first].path, dirLength) )
+                    continue;
+                const char* leafName = &info.path[dirLength+1];
+                if ( usable && (strcmp(leafName, name) == 0) ) {
+                    info.exists   = true;
+                    info.inode    = fileID;
+                    info.mtime    = modTime.tv_sec;
+                    info.answered = true;
+                }
+                else if ( strcasecmp(leafName, name) == 0 ) {
+                    // a symlink, or a case insensitive volume may resolve the path to this entry
+                    bulkFileInfoStat(info, statFunc, stats);
+                }
+            }
+            entry += entryLength;
+        }
+    }
+    ::close(fd);
+    if ( !complete )
+        return false;
+
+    // anything not listed is missing
+    for (uint32_t i=first; i < count; ++i) {
+        if ( bulkFileInfoInDirectory(infos[i], dirLengths[i], infos[first].path, dirLength) ) {
+            infos[i].exists   = false;
+            infos[i].answered = true;
+        }
+    }
+    return true;
+}
+
+//
+// Sets exists, inode and mtime for each of infos[0..count).  If allowListings is false every path
+// is just stat()ed with statFunc, which callers need when statFunc may find files a listing would not.
+//
+static inline void getBulkFileInfo(BulkFileInfo infos[], uint32_t count, bool allowListings,
+                                   BulkFileInfoStatFunc statFunc, BulkFileInfoStats& stats)
+{
+    // find each directory length once, rather than every time the paths are grouped by directory
+    uint16_t dirLengths[count + 1];
+    for (uint32_t i=0; i < count; ++i) {
+        infos[i].answered = false;
+        dirLengths[i]     = allowListings ? (uint16_t)bulkFileInfoDirLength(infos[i].path) : 0;
+    }
+
+    for (uint32_t i=0; i < count; ++i) {
+        BulkFileInfo& info = infos[i];
+        if ( info.answered )
+            continue;
+        const size_t dirLength = dirLengths[i];
+        uint32_t pathsInDir = 0;
+        if ( dirLength != 0 ) {
+            for (uint32_t j=i; j < count; ++j) {
+                if ( bulkFileInfoInDirectory(infos[j], dirLengths[j], info.path, dirLength) )
+                    ++pathsInDir;
+            }
+        }
+        if ( pathsInDir < kBulkFileInfoMinPathsPerDirectory ) {
+            bulkFileInfoStat(info, statFunc, stats);
+        }
+        else if ( !bulkFileInfoReadDirectory(infos, dirLengths, i, count, pathsInDir, statFunc, stats) ) {
+            // don't try listing the same directory again for the other paths in it
+            for (uint32_t j=count; j-- > i; ) {
+                if ( bulkFileInfoInDirectory(infos[j], dirLengths[j], info.path, dirLength) )
+                    bulkFileInfoStat(infos[j], statFunc, stats);
+            }
+        }
+    }
+}
+
+} // namespace dyld3
+
+#endif // BulkFileInfo_h
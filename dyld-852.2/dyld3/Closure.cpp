@@ -191,6 +191,11 @@ bool Image::mayHavePlusLoads() const
     return getFlags().mayHavePlusLoads;
 }
 
+bool Image::parallelInitSafe() const
+{
+    return getFlags().parallelInitSafe;
+}
+
 bool Image::neverUnload() const
 {
     return getFlags().neverUnload;
@@ -624,9 +629,9 @@ void Image::forEachFixup(void (^rebase)(uint64_t imageOffsetToRebase, bool& stop
                          void (^fixupObjCMethodList)(uint64_t imageOffsetToFixup, bool& stop)) const
 {
     const uint32_t pointerSize = is64() ? 8 : 4;
-	uint64_t curRebaseOffset = 0;
-	bool stop = false;
-    for (const Image::RebasePattern& rebasePat : rebaseFixups()) {
+    __block uint64_t curRebaseOffset = 0;
+    __block bool     stop            = false;
+    forEachRebasePattern(^(const Image::RebasePattern& rebasePat, bool& stopPatterns) {
         //fprintf(stderr, " repeat=0x%04X, contig=%d, skip=%d\n", rebasePat.repeatCount, rebasePat.contigCount, rebasePat.skipCount);
         if ( rebasePat.contigCount == 0 ) {
             // note: contigCount==0 means this just advances location
@@ -648,9 +653,8 @@ void Image::forEachFixup(void (^rebase)(uint64_t imageOffsetToRebase, bool& stop
                 curRebaseOffset += pointerSize * rebasePat.skipCount;
             }
         }
-        if ( stop )
-            break;
-    }
+        stopPatterns = stop;
+    });
     if ( stop )
         return;
 
@@ -736,8 +740,8 @@ void Image::forEachFixup(void (^rebase)(uint64_t imageOffsetToRebase, bool& stop
 bool Image::forEachBind(void (^bind)(uint64_t imageOffsetToBind, ResolvedSymbolTarget bindTarget, bool& stop)) const
 {
     const uint32_t pointerSize = is64() ? 8 : 4;
-    bool stop = false;
-    for (const Image::BindPattern& bindPat : bindFixups()) {
+    __block bool stop = false;
+    forEachBindPattern(^(const Image::BindPattern& bindPat, bool& stopPatterns) {
         uint64_t curBindOffset = bindPat.startVmOffset;
         for (uint16_t i=0; i < bindPat.repeatCount; ++i) {
             bind(curBindOffset, bindPat.target, stop);
@@ -745,9 +749,8 @@ bool Image::forEachBind(void (^bind)(uint64_t imageOffsetToBind, ResolvedSymbolT
             if ( stop )
                 break;
         }
-        if ( stop )
-            break;
-    }
+        stopPatterns = stop;
+    });
     return stop;
 }
 
@@ -784,6 +787,109 @@ const Array<Image::BindPattern> Image::bindFixups() const
     return Array<BindPattern>(bindFixupsContent, bindCount, bindCount);
 }
 
+// closures are only read by the dyld that wrote them, so malformed patterns just end the iteration
+static inline bool readCompactUleb128(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    uint32_t bit = 0;
+    do {
+        if ( (p == end) || (bit > 63) )
+            return false;
+        value |= ((uint64_t)(*p & 0x7f) << bit);
+        bit += 7;
+    } while ( *p++ & 0x80 );
+    return true;
+}
+
+static inline bool readCompactSleb128(const uint8_t*& p, const uint8_t* end, int64_t& value)
+{
+    value = 0;
+    uint32_t bit = 0;
+    uint8_t  byte;
+    do {
+        if ( (p == end) || (bit > 63) )
+            return false;
+        byte = *p++;
+        value |= (((int64_t)(byte & 0x7f)) << bit);
+        bit += 7;
+    } while ( byte & 0x80 );
+    // sign extend negative numbers
+    if ( ((byte & 0x40) != 0) && (bit < 64) )
+        value |= (-1LL) << bit;
+    return true;
+}
+
+const Array<Image::ResolvedSymbolTarget> Image::compactBindTargets() const
+{
+    const CompactFixups* compact = (CompactFixups*)findAttributePayload(Type::compactBindFixups);
+    if ( compact == nullptr )
+        return Array<ResolvedSymbolTarget>();
+    ResolvedSymbolTarget* targets = (ResolvedSymbolTarget*)((uint8_t*)compact + sizeof(CompactFixups));
+    return Array<ResolvedSymbolTarget>(targets, compact->targetCount, compact->targetCount);
+}
+
+void Image::forEachRebasePattern(void (^handler)(const RebasePattern& pattern, bool& stop)) const
+{
+    bool stop = false;
+    const CompactFixups* compact = (CompactFixups*)findAttributePayload(Type::compactRebaseFixups);
+    if ( compact == nullptr ) {
+        for (const Image::RebasePattern& rebasePat : rebaseFixups()) {
+            handler(rebasePat, stop);
+            if ( stop )
+                break;
+        }
+        return;
+    }
+    const uint8_t* p   = (uint8_t*)compact + sizeof(CompactFixups);
+    const uint8_t* end = p + compact->patternsSize;
+    uint64_t       value;
+    while ( !stop && readCompactUleb128(p, end, value) ) {
+        RebasePattern rebasePat;
+        rebasePat.contigCount = (uint32_t)(value & 0xFF);
+        rebasePat.skipCount   = (uint32_t)((value >> 8) & 0xF);
+        rebasePat.repeatCount = (uint32_t)(value >> 12);
+        handler(rebasePat, stop);
+    }
+}
+
+void Image::forEachBindPattern(void (^handler)(const BindPattern& pattern, bool& stop)) const
+{
+    bool stop = false;
+    const CompactFixups* compact = (CompactFixups*)findAttributePayload(Type::compactBindFixups);
+    if ( compact == nullptr ) {
+        for (const Image::BindPattern& bindPat : bindFixups()) {
+            handler(bindPat, stop);
+            if ( stop )
+                break;
+        }
+        return;
+    }
+    const ResolvedSymbolTarget* targets = (ResolvedSymbolTarget*)((uint8_t*)compact + sizeof(CompactFixups));
+    const uint8_t* p   = (uint8_t*)&targets[compact->targetCount];
+    const uint8_t* end = p + compact->patternsSize;
+    uint64_t       startVmOffset = 0;
+    uint64_t       indexAndFlag;
+    while ( !stop && readCompactUleb128(p, end, indexAndFlag) ) {
+        int64_t  delta;
+        uint64_t skipCount   = 0;
+        uint64_t repeatCount = 1;
+        if ( !readCompactSleb128(p, end, delta) )
+            break;
+        if ( (indexAndFlag & 1) && (!readCompactUleb128(p, end, skipCount) || !readCompactUleb128(p, end, repeatCount)) )
+            break;
+        uint64_t targetIndex = indexAndFlag >> 1;
+        if ( targetIndex >= compact->targetCount )
+            break;
+        startVmOffset += delta;
+        BindPattern bindPat;
+        bindPat.target        = targets[targetIndex];
+        bindPat.startVmOffset = startVmOffset;
+        bindPat.skipCount     = skipCount;
+        bindPat.repeatCount   = repeatCount;
+        handler(bindPat, stop);
+    }
+}
+
 uint64_t Image::chainedStartsOffset() const
 {
     uint32_t size;
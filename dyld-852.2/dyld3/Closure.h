@@ -47,7 +47,7 @@ namespace closure {
 
 
 // bump this number each time binary format changes
-enum  { kFormatVersion = 10 };
+enum  { kFormatVersion = 11 };
 
 
 typedef uint32_t ImageNum;
@@ -101,6 +101,7 @@ struct VIS_HIDDEN TypedBytes
         termOffsets      = 28, // sizeof(uint32_t) * count
         chainedStartsOffset = 29, // sizeof(uint64_t)
         objcFixups       = 30,   // sizeof(ResolvedSymbolTarget) + (sizeof(uint32_t) * 2) + (sizeof(ProtocolISAFixup) * count) + (sizeof(SelectorReferenceFixup) * count)
+        compactBindFixups = 31, // sizeof(CompactFixups) + (sizeof(ResolvedSymbolTarget) * targetCount) + patternsSize
 
         // attributes for Closures (launch or dlopen)
         closureFlags            = 32,  // sizeof(Closure::Flags)
@@ -120,6 +121,9 @@ struct VIS_HIDDEN TypedBytes
         warning                 = 47,  // len = uint32_t + length path + 1, use one entry per warning
         duplicateClassesTable   = 48,  // duplicateClassesHashTable
         progVars                = 49,  // sizeof(uint32_t)
+
+        // more attributes for Images
+        compactRebaseFixups     = 50,  // sizeof(CompactFixups) + patternsSize
     };
 
     Type         type          : 8;
@@ -175,6 +179,7 @@ struct VIS_HIDDEN Image : ContainerTypedBytes
     bool                isExecutable() const;
     bool                hasWeakDefs() const;
     bool                mayHavePlusLoads() const;
+    bool                parallelInitSafe() const;
     bool                is64() const;
     bool                neverUnload() const;
     bool                cwdMustBeThisDir() const;
@@ -404,7 +409,8 @@ private:
                         fixupsNotEncoded             : 1,
                         rebasesNotEncoded            : 1,
                         hasOverrideImageNum          : 1,
-                        padding                      : 14;
+                        parallelInitSafe             : 1,       // initializers do not depend on images they do not link
+                        padding                      : 13;
     };
 
     static_assert(sizeof(Flags) == sizeof(uint64_t), "Flags overflow");
@@ -522,6 +528,23 @@ private:
     };
     const Array<BindPattern> bindFixups() const;
 
+    // Compact form of rebase and bind patterns.  Each pattern is a few uleb128s instead of a fixed
+    // width record.  Bind patterns refer to their target by index in a table which follows this
+    // header, so each target is stored once, and a bind's start is a delta from the previous one.
+    //   rebase: uleb128((repeatCount << 12) | (skipCount << 8) | contigCount)
+    //   bind:   uleb128((targetIndex << 1) | notSingle), sleb128(startVmOffset delta),
+    //           and if notSingle: uleb128(skipCount), uleb128(repeatCount)
+    struct CompactFixups
+    {
+        uint32_t    targetCount;        // number of ResolvedSymbolTargets after this header
+        uint32_t    patternsSize;       // number of bytes of patterns after the targets
+    };
+    const Array<ResolvedSymbolTarget> compactBindTargets() const;
+
+    // Iterates rebase or bind patterns in whichever form the image has
+    void                forEachRebasePattern(void (^handler)(const RebasePattern& pattern, bool& stop)) const;
+    void                forEachBindPattern(void (^handler)(const BindPattern& pattern, bool& stop)) const;
+
     // An optimzied selector reference bind will either point to the shared cache
     // or a binary optimized in our launch closure.  We can use the index in to each
     // of their respective selector hash tables as the target or the bind.
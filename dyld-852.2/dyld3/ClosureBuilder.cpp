@@ -77,6 +77,8 @@ ClosureBuilder::~ClosureBuilder() {
         PathPool::deallocate(_mustBeMissingPaths);
     if ( _objcDuplicateClassWarnings != nullptr )
         PathPool::deallocate(_objcDuplicateClassWarnings);
+    if ( _listedPaths != nullptr )
+        PathPool::deallocate(_listedPaths);
 }
 
 static bool iOSSupport(const char* path)
@@ -124,40 +126,50 @@ bool ClosureBuilder::findImage(const char* loadPath, const LoadedImageChain& for
 
             // look at already loaded images
             const char* leafName = strrchr(possiblePath, '/');
-            for (BuilderLoadedImage& li: _loadedImages) {
-                if ( strcmp(li.path(), possiblePath) == 0 ) {
-                    foundImage = &li;
-                    result = true;
-                    stop = true;
-                    return;
-                }
-                else if ( isRPath ) {
-                    // Special case @rpath/ because name in li.fileInfo.path is full path.
-                    // Getting installName is expensive, so first see if an already loaded image
-                    // has same leaf name and if so see if its installName matches request @rpath
-                    if (const char* aLeaf = strrchr(li.path(), '/')) {
-                        if ( strcmp(aLeaf, leafName) == 0 ) {
-                            if ( li.loadAddress()->isDylib() && (strcmp(loadPath, li.loadAddress()->installName()) == 0) ) {
-                                foundImage = &li;
-                                result = true;
-                                stop = true;
-                                return;
-                            }
+            if ( isRPath ) {
+                // Special case @rpath/ because name in li.fileInfo.path is full path.
+                // Getting installName is expensive, so only look at already loaded images
+                // with the same leaf name, and see if their installName matches request @rpath
+                const LoadedImageIndexes& indexes = loadedImageIndexes();
+                auto leafPos = (leafName != nullptr) ? indexes.byLeafName.find(leafName) : indexes.byLeafName.end();
+                if ( leafPos != indexes.byLeafName.end() ) {
+                    for (uint32_t i = leafPos->second.first; i != UINT32_MAX; i = indexes.nextWithSameLeafName[i]) {
+                        BuilderLoadedImage& li = _loadedImages[i];
+                        if ( (strcmp(li.path(), possiblePath) == 0)
+                            || (li.loadAddress()->isDylib() && (strcmp(loadPath, li.loadAddress()->installName()) == 0)) ) {
+                            foundImage = &li;
+                            result = true;
+                            stop = true;
+                            return;
                         }
                     }
                 }
             }
+            else if ( BuilderLoadedImage* li = loadedImageWithPath(possiblePath) ) {
+                foundImage = li;
+                result = true;
+                stop = true;
+                return;
+            }
 
             // look to see if image already loaded via a different symlink
             bool                  fileFound             = false;
             uint64_t              fileFoundINode        = 0;
             uint64_t              fileFoundMTime        = 0;
             bool                  inodesMatchRuntime    = false;
+            bool                  fileListedAsMissing   = false;
             // Note, we only do this check if we even expect to find this on-disk
             // We can also use the pathIsInDyldCacheWhichCannotBeOverridden result if we are still trying the same path
             // it was computed from
             if ( dylibsExpectedOnDisk || !pathIsInDyldCacheWhichCannotBeOverridden || (loadPath != possiblePath) ) {
-                if ( _fileSystem.fileExists(possiblePath, &fileFoundINode, &fileFoundMTime, nullptr, &inodesMatchRuntime) ) {
+                if ( pathDefinitelyMissing(possiblePath) ) {
+                    fileListedAsMissing = true;
+                    ++_pathProbeStats.statsAvoided;
+                }
+                else if ( !_fileSystem.fileExists(possiblePath, &fileFoundINode, &fileFoundMTime, nullptr, &inodesMatchRuntime) ) {
+                    noteProbeMissed(possiblePath);
+                }
+                else {
                     fileFound = true;
                     for (BuilderLoadedImage& li: _loadedImages) {
                         if ( (li.loadedFileInfo.inode == 0) && (li.loadedFileInfo.mtime == 0) ) {
@@ -182,13 +194,11 @@ bool ClosureBuilder::findImage(const char* loadPath, const LoadedImageChain& for
             if ( fileFound ) {
                 char realPath[MAXPATHLEN];
                 if ( _fileSystem.getRealPath(possiblePath, realPath) ) {
-                    for (BuilderLoadedImage& li: _loadedImages) {
-                        if ( strcmp(li.path(), realPath) == 0 ) {
-                            foundImage = &li;
-                            result = true;
-                            stop = true;
-                            return;
-                        }
+                    if ( BuilderLoadedImage* li = loadedImageWithPath(realPath) ) {
+                        foundImage = li;
+                        result = true;
+                        stop = true;
+                        return;
                     }
                 }
             }
@@ -245,13 +255,11 @@ bool ClosureBuilder::findImage(const char* loadPath, const LoadedImageChain& for
                 // This doesn't work with the calls to realpath when the symlinks themselves were removed from disk.
                 if ( foundInCache && !fileFound ) {
                     ImageNum dyldCacheImageNum = dyldCacheImageIndex + 1;
-                    for (BuilderLoadedImage& li: _loadedImages) {
-                        if ( (li.overrideImageNum == dyldCacheImageNum) || (li.imageNum == dyldCacheImageNum) ) {
-                            foundImage = &li;
-                            result = true;
-                            stop = true;
-                            return;
-                        }
+                    if ( BuilderLoadedImage* li = loadedImageWithNum(dyldCacheImageNum, true) ) {
+                        foundImage = li;
+                        result = true;
+                        stop = true;
+                        return;
                     }
                 }
 
@@ -268,13 +276,11 @@ bool ClosureBuilder::findImage(const char* loadPath, const LoadedImageChain& for
 #if BUILDING_LIBDYLD
                             // handle case where OS dylib was updated after this process launched
                             if ( foundInCache ) {
-                                for (BuilderLoadedImage& li: _loadedImages) {
-                                    if ( strcmp(li.path(), filePath) == 0 ) {
-                                        foundImage = &li;
-                                        result = true;
-                                        stop = true;
-                                        return;
-                                    }
+                                if ( BuilderLoadedImage* li = loadedImageWithPath(filePath) ) {
+                                    foundImage = li;
+                                    result = true;
+                                    stop = true;
+                                    return;
                                 }
                             }
 #endif
@@ -341,7 +347,11 @@ bool ClosureBuilder::findImage(const char* loadPath, const LoadedImageChain& for
 
             // if not found yet, mmap file
             if ( mh == nullptr ) {
-                loadedFileInfo = MachOAnalyzer::load(_diag, _fileSystem, filePath, _archs, _platform, realPath);
+                // no need to try opening a file its directory listing shows is not there
+                if ( fileListedAsMissing && (filePath == possiblePath) )
+                    ++_pathProbeStats.opensAvoided;
+                else
+                    loadedFileInfo = MachOAnalyzer::load(_diag, _fileSystem, filePath, _archs, _platform, realPath);
                 mh = (const MachOAnalyzer*)loadedFileInfo.fileContent;
                 if ( mh == nullptr ) {
                     // Don't add must be missing paths for dlopen as we don't cache dlopen closures
@@ -698,44 +708,165 @@ void ClosureBuilder::addSkippedFile(const char* path, uint64_t inode, uint64_t m
     _skippedFiles.push_back({ strdup_temp(path), inode, mtime });
 }
 
-ClosureBuilder::BuilderLoadedImage& ClosureBuilder::findLoadedImage(ImageNum imageNum)
+// Copies the directory part of path, with its trailing slash, to dirKey.  Returns false if a directory listing
+// could not answer whether path exists.
+bool ClosureBuilder::listedDirectoryKey(const char* path, char dirKey[MAXPATHLEN])
 {
-    for (BuilderLoadedImage& li : _loadedImages) {
-        if ( li.imageNum == imageNum ) {
-            return li;
-        }
+    const char* lastSlash = strrchr(path, '/');
+    if ( (lastSlash == nullptr) || (lastSlash == path) || (lastSlash[1] == '\0') )
+        return false;
+    // listings of volumes which normalize unicode cannot prove a non-ascii name is missing
+    for (const char* s = lastSlash + 1; *s != '\0'; ++s) {
+        if ( (uint8_t)*s >= 0x80 )
+            return false;
     }
-    for (BuilderLoadedImage& li : _loadedImages) {
-        if ( li.overrideImageNum == imageNum ) {
-            return li;
-        }
+    const size_t dirLen = lastSlash + 1 - path;
+    if ( dirLen >= MAXPATHLEN )
+        return false;
+    memcpy(dirKey, path, dirLen);
+    dirKey[dirLen] = '\0';
+    return true;
+}
+
+// Called when a probe of path found nothing.  A directory is listed once a second probe misses in it, so the
+// many failing stat()s and open()s of deep @rpath and fallback path searches turn into one listing per
+// directory, while directories probed once or which hold what is looked for are never listed.
+void ClosureBuilder::noteProbeMissed(const char* path)
+{
+    char dirKey[MAXPATHLEN];
+    if ( !listedDirectoryKey(path, dirKey) )
+        return;
+
+    if ( !_listedDirectoryEntries.has_value() ) {
+        _listedDirectoryEntries.emplace();
+        _listedPaths = PathPool::allocate();
+    }
+    auto pos = _listedDirectoryEntries->find(dirKey);
+    if ( pos == _listedDirectoryEntries->end() ) {
+        _listedDirectoryEntries->insert({ _listedPaths->add(dirKey), ListedPath::missedOnce });
+        return;
     }
-    assert(0 && "LoadedImage not found by num");
+    if ( pos->second != ListedPath::missedOnce )
+        return;
+
+    const size_t dirLen = strlen(dirKey);
+    char  entryPath[MAXPATHLEN];
+    char* entryPathPtr = entryPath;
+    memcpy(entryPath, dirKey, dirLen);
+    dirKey[dirLen-1] = '\0';
+    bool complete = _fileSystem.forEachDirectoryEntry(dirKey, ^(const char* name) {
+        // a name too long to append could never be probed, so it can be left out
+        if ( strlcpy(&entryPathPtr[dirLen], name, MAXPATHLEN - dirLen) < (MAXPATHLEN - dirLen) )
+            _listedDirectoryEntries->insert({ _listedPaths->add(entryPathPtr), ListedPath::entry });
+    });
+    // the map may have grown, so look the directory up again
+    dirKey[dirLen-1] = '/';
+    _listedDirectoryEntries->find(dirKey)->second = complete ? ListedPath::listed : ListedPath::notListable;
+    if ( complete )
+        ++_pathProbeStats.directoriesListed;
+    else
+        ++_pathProbeStats.directoriesNotListable;
 }
 
-const ClosureBuilder::BuilderLoadedImage& ClosureBuilder::findLoadedImage(ImageNum imageNum) const
+// Returns true if the directory containing path has been listed and path is not in it.
+// A false result does not mean the file exists.
+bool ClosureBuilder::pathDefinitelyMissing(const char* path)
 {
-    for (const BuilderLoadedImage& li : _loadedImages) {
-        if ( li.imageNum == imageNum ) {
-            return li;
-        }
+    char dirKey[MAXPATHLEN];
+    if ( !listedDirectoryKey(path, dirKey) || !_listedDirectoryEntries.has_value() ) {
+        ++_pathProbeStats.probesPassedThrough;
+        return false;
     }
-    for (const BuilderLoadedImage& li : _loadedImages) {
-        if ( li.overrideImageNum == imageNum ) {
-            return li;
-        }
+    auto pos = _listedDirectoryEntries->find(dirKey);
+    if ( (pos == _listedDirectoryEntries->end()) || (pos->second != ListedPath::listed) ) {
+        ++_pathProbeStats.probesPassedThrough;
+        return false;
     }
-    assert(0 && "LoadedImage not found");
+    ++_pathProbeStats.probesAnsweredFromListings;
+    return (_listedDirectoryEntries->find(path) == _listedDirectoryEntries->end());
 }
 
-ClosureBuilder::BuilderLoadedImage& ClosureBuilder::findLoadedImage(const MachOAnalyzer* mh)
+ClosureBuilder::LoadedImageIndexes& ClosureBuilder::loadedImageIndexes() const
 {
-    for (BuilderLoadedImage& li : _loadedImages) {
-        if ( li.loadAddress() == mh ) {
-             return li;
+    if ( !_loadedImageIndexes.has_value() )
+        _loadedImageIndexes.emplace();
+    LoadedImageIndexes& indexes = *_loadedImageIndexes;
+    for (uint32_t i = indexes.indexedCount; i < _loadedImages.count(); ++i) {
+        const BuilderLoadedImage& li = _loadedImages[i];
+        // when keys are duplicated, the first image wins, as it did when scanning _loadedImages in order
+        indexes.byPath.insert({ li.path(), i });
+        indexes.byImageNum.insert({ li.imageNum, i });
+        indexes.byOverrideImageNum.insert({ (ImageNum)li.overrideImageNum, i });
+        indexes.byMachO.insert({ li.loadAddress(), i });
+        indexes.nextWithSameLeafName.push_back(UINT32_MAX);
+        if ( const char* leaf = strrchr(li.path(), '/') ) {
+            auto itAndInserted = indexes.byLeafName.insert({ leaf, { i, i } });
+            if ( !itAndInserted.second ) {
+                indexes.nextWithSameLeafName[itAndInserted.first->second.second] = i;
+                itAndInserted.first->second.second = i;
+            }
         }
     }
-    assert(0 && "LoadedImage not found by mh");
+    indexes.indexedCount = (uint32_t)_loadedImages.count();
+    return indexes;
+}
+
+ClosureBuilder::BuilderLoadedImage* ClosureBuilder::loadedImageWithPath(const char* path)
+{
+    const LoadedImageIndexes& indexes = loadedImageIndexes();
+    auto pos = indexes.byPath.find(path);
+    if ( pos == indexes.byPath.end() )
+        return nullptr;
+    return &_loadedImages[pos->second];
+}
+
+ClosureBuilder::BuilderLoadedImage* ClosureBuilder::loadedImageWithNum(ImageNum imageNum, bool orOverrideNum)
+{
+    const LoadedImageIndexes& indexes = loadedImageIndexes();
+    uint32_t index = UINT32_MAX;
+    auto pos = indexes.byImageNum.find(imageNum);
+    if ( pos != indexes.byImageNum.end() )
+        index = pos->second;
+    if ( orOverrideNum ) {
+        auto overridePos = indexes.byOverrideImageNum.find(imageNum);
+        if ( (overridePos != indexes.byOverrideImageNum.end()) && (overridePos->second < index) )
+            index = overridePos->second;
+    }
+    if ( index == UINT32_MAX )
+        return nullptr;
+    return &_loadedImages[index];
+}
+
+ClosureBuilder::BuilderLoadedImage* ClosureBuilder::loadedImageWithMachO(const MachOAnalyzer* mh)
+{
+    const LoadedImageIndexes& indexes = loadedImageIndexes();
+    auto pos = indexes.byMachO.find(mh);
+    if ( pos == indexes.byMachO.end() )
+        return nullptr;
+    return &_loadedImages[pos->second];
+}
+
+ClosureBuilder::BuilderLoadedImage& ClosureBuilder::findLoadedImage(ImageNum imageNum)
+{
+    // an image's own num is preferred over an image which overrides that num
+    if ( BuilderLoadedImage* li = loadedImageWithNum(imageNum, false) )
+        return *li;
+    const LoadedImageIndexes& indexes = loadedImageIndexes();
+    auto pos = indexes.byOverrideImageNum.find(imageNum);
+    assert((pos != indexes.byOverrideImageNum.end()) && "LoadedImage not found by num");
+    return _loadedImages[pos->second];
+}
+
+const ClosureBuilder::BuilderLoadedImage& ClosureBuilder::findLoadedImage(ImageNum imageNum) const
+{
+    return const_cast<ClosureBuilder*>(this)->findLoadedImage(imageNum);
+}
+
+ClosureBuilder::BuilderLoadedImage& ClosureBuilder::findLoadedImage(const MachOAnalyzer* mh)
+{
+    BuilderLoadedImage* li = loadedImageWithMachO(mh);
+    assert((li != nullptr) && "LoadedImage not found by mh");
+    return *li;
 }
 
 const MachOAnalyzer* ClosureBuilder::machOForImageNum(ImageNum imageNum)
@@ -745,32 +876,26 @@ const MachOAnalyzer* ClosureBuilder::machOForImageNum(ImageNum imageNum)
 
 const MachOAnalyzer* ClosureBuilder::findDependent(const MachOLoaded* mh, uint32_t depIndex)
 {
-    for (const BuilderLoadedImage& li : _loadedImages) {
-        if ( li.loadAddress() == mh ) {
-            if (li.isBadImage) {
-                // Bad image duting building group 1 closures, so the dependents array
-                // is potentially incomplete.
-                return nullptr;
-            }
-            ImageNum childNum = li.dependents[depIndex].imageNum();
-            // This is typically something like a missing weak-dylib we are re-exporting a weak-import symbol from
-            if (childNum == kMissingWeakLinkedImage)
-                return nullptr;
-            return machOForImageNum(childNum);
-        }
+    const BuilderLoadedImage* li = loadedImageWithMachO((const MachOAnalyzer*)mh);
+    if ( li == nullptr )
+        return nullptr;
+    if (li->isBadImage) {
+        // Bad image duting building group 1 closures, so the dependents array
+        // is potentially incomplete.
+        return nullptr;
     }
-    return nullptr;
+    ImageNum childNum = li->dependents[depIndex].imageNum();
+    // This is typically something like a missing weak-dylib we are re-exporting a weak-import symbol from
+    if (childNum == kMissingWeakLinkedImage)
+        return nullptr;
+    return machOForImageNum(childNum);
 }
 
 ImageNum ClosureBuilder::imageNumForMachO(const MachOAnalyzer* mh)
 {
-    for (const BuilderLoadedImage& li : _loadedImages) {
-        if ( li.loadAddress() == mh ) {
-             return li.imageNum;
-        }
-    }
-    assert(0 && "unknown mach-o");
-    return 0;
+    BuilderLoadedImage* li = loadedImageWithMachO(mh);
+    assert((li != nullptr) && "unknown mach-o");
+    return li->imageNum;
 }
 
 void ClosureBuilder::recursiveLoadDependents(LoadedImageChain& forImageChain, bool canUseSharedCacheClosure)
@@ -940,6 +1065,10 @@ void ClosureBuilder::buildImage(ImageWriter& writer, BuilderLoadedImage& forImag
         writer.setNeverUnload(true);
     }
 
+    // images opt in to having their initializers run concurrently with those of images they do not link with
+    uint64_t parallelInitSize;
+    writer.setParallelInitSafe(macho->findSectionContent("__TEXT", "__dyld_par_init", parallelInitSize) != nullptr);
+
 #if BUILDING_DYLD || BUILDING_LIBDYLD
     if ( _foundDyldCacheRoots ) {
         // If we had roots, then some images are potentially on-disk while others are
@@ -1011,11 +1140,8 @@ void ClosureBuilder::buildImage(ImageWriter& writer, BuilderLoadedImage& forImag
     // if shared cache contains two variants of same framework (macOS and iOS), mark iOS one as override of macOS one
     if ( _makingDyldCacheImages && iOSSupport(forImage.path()) ) {
         const char* truncName = forImage.path()+18;
-        for (const BuilderLoadedImage& li : _loadedImages) {
-            if ( strcmp(li.path(), truncName) == 0 ) {
-                writer.setAsOverrideOf(li.imageNum);
-            }
-        }
+        if ( const BuilderLoadedImage* li = loadedImageWithPath(truncName) )
+            writer.setAsOverrideOf(li->imageNum);
     }
 
     // record if this dylib overrides something in the cache
@@ -1949,6 +2075,33 @@ bool ClosureBuilder::EqualCString::equal(const char* s1, const char* s2) {
     return strcmp(s1, s2) == 0;
 }
 
+static inline char asciiLower(char c) {
+    return ((c >= 'A') && (c <= 'Z')) ? (c + ('a' - 'A')) : c;
+}
+
+size_t ClosureBuilder::HashListedPath::hash(const char* v) {
+    const char* leaf = strrchr(v, '/');
+    leaf = (leaf == nullptr) ? v : leaf + 1;
+    size_t h = 5381;
+    for (const char* s = v; *s != '\0'; ++s)
+        h = (h * 33) + (uint8_t)((s < leaf) ? *s : asciiLower(*s));
+    return h;
+}
+
+bool ClosureBuilder::EqualListedPath::equal(const char* s1, const char* s2) {
+    const char* leaf1 = strrchr(s1, '/');
+    const char* leaf2 = strrchr(s2, '/');
+    size_t dirLen1 = (leaf1 == nullptr) ? 0 : (leaf1 + 1 - s1);
+    size_t dirLen2 = (leaf2 == nullptr) ? 0 : (leaf2 + 1 - s2);
+    if ( (dirLen1 != dirLen2) || (strncmp(s1, s2, dirLen1) != 0) )
+        return false;
+    for (s1 += dirLen1, s2 += dirLen2; asciiLower(*s1) == asciiLower(*s2); ++s1, ++s2) {
+        if ( *s1 == '\0' )
+            return true;
+    }
+    return false;
+}
+
 
 
 struct HashUInt64 {
@@ -3206,7 +3359,7 @@ const LaunchClosure* ClosureBuilder::makeLaunchClosure(const LoadedFileInfo& fil
     STACK_ALLOC_ARRAY(ImageWriter, writers, _loadedImages.count());
     for (BuilderLoadedImage& li : _loadedImages) {
         if ( li.mustBuildClosure ) {
-            writers.push_back(ImageWriter());
+            writers.push_back(ImageWriter(_writerArena));
             buildImage(writers.back(), li);
             if ( _diag.hasError() )
                 return nullptr;
@@ -3226,7 +3379,7 @@ const LaunchClosure* ClosureBuilder::makeLaunchClosure(const LoadedFileInfo& fil
     }
 
     // combine all Image objects into one ImageArray
-    ImageArrayWriter imageArrayWriter(_startImageNum, (uint32_t)writers.count(), _foundDyldCacheRoots);
+    ImageArrayWriter imageArrayWriter(_startImageNum, (uint32_t)writers.count(), _foundDyldCacheRoots, _writerArena);
     for (ImageWriter& writer : writers) {
         imageArrayWriter.appendImage(writer.finalize());
         writer.deallocate();
@@ -3510,7 +3663,7 @@ const DlopenClosure* ClosureBuilder::makeDlopenClosure(const char* path, const L
         for (uintptr_t loadedImageIndex = 0; loadedImageIndex != _loadedImages.count(); ++loadedImageIndex) {
             BuilderLoadedImage& li = _loadedImages[loadedImageIndex];
             if ( li.mustBuildClosure ) {
-                writers.push_back(ImageWriter());
+                writers.push_back(ImageWriter(_writerArena));
                 buildImage(writers.back(), li);
                 if ( _diag.hasError() )
                     return nullptr;
@@ -3546,7 +3699,7 @@ const DlopenClosure* ClosureBuilder::makeDlopenClosure(const char* path, const L
     }
 
     // combine all Image objects into one ImageArray
-    ImageArrayWriter imageArrayWriter(_startImageNum, (uint32_t)writers.count(), _foundDyldCacheRoots);
+    ImageArrayWriter imageArrayWriter(_startImageNum, (uint32_t)writers.count(), _foundDyldCacheRoots, _writerArena);
     for (ImageWriter& writer : writers) {
         imageArrayWriter.appendImage(writer.finalize());
         writer.deallocate();
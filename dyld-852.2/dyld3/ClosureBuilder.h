@@ -88,6 +88,7 @@ public:
     const LaunchClosure*        makeLaunchClosure(const char* mainPath,bool allowInsertFailures);
     void                        makeMinimalClosures() { _makeMinimalClosure = true; }
     void                        setCanSkipEncodingRebases() { _leaveRebasesAsOpcodes = true; }
+    void                        setWriterArena(WriterArena* arena) { _writerArena = arena; }
 
     static const DlopenClosure* sRetryDlopenClosure;
     const DlopenClosure*        makeDlopenClosure(const char* dylibPath, const LaunchClosure* mainClosure, const Array<LoadedImage>& loadedList,
@@ -99,6 +100,7 @@ public:
     
     void                        setDyldCacheInvalidFormatVersion();
     void                        disableInterposing() { _interposingDisabled = true; }
+    const PathProbeStats&       pathProbeStats() const { return _pathProbeStats; }
 
 
     struct PatchableExport
@@ -196,12 +198,18 @@ private:
     BuilderLoadedImage&     findLoadedImage(ImageNum imageNum);
     const BuilderLoadedImage& findLoadedImage(ImageNum imageNum) const;
     BuilderLoadedImage&     findLoadedImage(const MachOAnalyzer* mh);
+    BuilderLoadedImage*     loadedImageWithPath(const char* path);
+    BuilderLoadedImage*     loadedImageWithNum(ImageNum imageNum, bool orOverrideNum);
+    BuilderLoadedImage*     loadedImageWithMachO(const MachOAnalyzer* mh);
     uint32_t                index(const BuilderLoadedImage&);
     bool                    expandAtLoaderPath(const char* loadPath, bool fromLCRPATH, const BuilderLoadedImage& loadedImage, char fixedPath[]);
     bool                    expandAtExecutablePath(const char* loadPath, bool fromLCRPATH, bool fromLCRPATHinMain, char fixedPath[]);
     void                    addMustBeMissingPath(const char* path);
     void                    addSkippedFile(const char* path, uint64_t inode, uint64_t mtime);
     const char*             strdup_temp(const char* path) const;
+    bool                    listedDirectoryKey(const char* path, char dirKey[MAXPATHLEN]);
+    void                    noteProbeMissed(const char* path);
+    bool                    pathDefinitelyMissing(const char* path);
     bool                    overridableDylib(const BuilderLoadedImage& forImage);
     void                    addOperatorCachePatches(BuilderLoadedImage& forImage);
     void                    addWeakDefCachePatch(uint32_t cachedDylibIndex, uint32_t exportCacheOffset, const FixupTarget& patchTarget);
@@ -214,6 +222,19 @@ private:
         static bool equal(const char* s1, const char* s2);
     };
 
+    // directory part of path compared exactly, leaf name ignoring case, because a listing of a
+    // case insensitive volume cannot prove that a differently cased leaf name is missing
+    struct HashListedPath {
+        static size_t hash(const char* v);
+    };
+
+    struct EqualListedPath {
+        static bool equal(const char* s1, const char* s2);
+    };
+
+    // a directory is only listed once a second probe misses in it
+    enum class ListedPath : uint8_t { missedOnce, listed, notListable, entry };
+
     struct HashPointer {
         template<typename T>
         static size_t hash(const T* v) {
@@ -228,6 +249,32 @@ private:
         }
     };
 
+    struct HashImageNum {
+        static size_t hash(const ImageNum& v) {
+            return std::hash<ImageNum>{}(v);
+        }
+    };
+
+    struct EqualImageNum {
+        static bool equal(const ImageNum& n1, const ImageNum& n2) {
+            return n1 == n2;
+        }
+    };
+
+    // Indexes into _loadedImages, so that finding an image is not a linear scan.  Images are only ever
+    // appended, so loadedImageIndexes() brings the indexes up to date by adding any images added since.
+    struct LoadedImageIndexes {
+        Map<const char*, uint32_t, HashCString, EqualCString>                   byPath;
+        Map<const char*, std::pair<uint32_t, uint32_t>, HashCString, EqualCString> byLeafName;      // first and last index with that leaf
+        OverflowSafeArray<uint32_t>                                             nextWithSameLeafName;
+        Map<ImageNum, uint32_t, HashImageNum, EqualImageNum>                    byImageNum;
+        Map<ImageNum, uint32_t, HashImageNum, EqualImageNum>                    byOverrideImageNum;
+        Map<const MachOAnalyzer*, uint32_t, HashPointer, EqualPointer>          byMachO;
+        uint32_t                                                                indexedCount = 0;
+    };
+
+    LoadedImageIndexes&     loadedImageIndexes() const;
+
     struct ObjCOptimizerImage {
 
         ObjCOptimizerImage() {
@@ -329,8 +376,13 @@ private:
     mutable PathPool*                       _tempPaths                      = nullptr;
     PathPool*                               _mustBeMissingPaths             = nullptr;
     OverflowSafeArray<SkippedFile>          _skippedFiles;
+    PathPool*                               _listedPaths                    = nullptr;
+    std::optional<Map<const char*, ListedPath, HashListedPath, EqualListedPath>> _listedDirectoryEntries;  // "dir/" -> listing state, "dir/leaf" -> entry
+    PathProbeStats                          _pathProbeStats;
+    WriterArena*                            _writerArena                    = nullptr;
     uint32_t                                _nextIndex                      = 0;
     OverflowSafeArray<BuilderLoadedImage,2048>  _loadedImages;
+    mutable std::optional<LoadedImageIndexes>   _loadedImageIndexes;
     OverflowSafeArray<Image::LinkedImage,65536> _dependencies;                  // all dylibs in cache need ~20,000 edges
     OverflowSafeArray<InterposingTuple>     _interposingTuples;
     OverflowSafeArray<Closure::PatchEntry>  _weakDefCacheOverrides;
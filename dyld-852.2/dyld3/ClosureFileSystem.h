@@ -46,6 +46,16 @@ struct LoadedFileInfo {
     const char*  path                       = nullptr;
 };
 
+// Counts of file system probes made while building a closure, and how many were answered from directory listings
+struct PathProbeStats {
+    uint32_t     directoriesListed          = 0;
+    uint32_t     directoriesNotListable     = 0;
+    uint32_t     probesAnsweredFromListings = 0;
+    uint32_t     probesPassedThrough        = 0;
+    uint32_t     statsAvoided               = 0;
+    uint32_t     opensAvoided               = 0;
+};
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wnon-virtual-dtor"
 class FileSystem {
@@ -73,6 +83,11 @@ public:
     // If a file exists at path, returns true and sets inode and mtime
     virtual bool fileExists(const char* path, uint64_t* inode=nullptr, uint64_t* mtime=nullptr,
                             bool* issetuid=nullptr, bool* inodesMatchRuntime = nullptr) const = 0;
+
+    // Calls the handler with the name of each entry in the directory at dirPath.  A directory that does not exist
+    // has no entries.  Returns false if the entries could not be read, or if fileExists() and loadFile() may
+    // find files which are not listed, in which case nothing can be inferred from the entries handled.
+    virtual bool forEachDirectoryEntry(const char* dirPath, void (^handler)(const char* name)) const { return false; }
 };
 #pragma clang diagnostic pop
 
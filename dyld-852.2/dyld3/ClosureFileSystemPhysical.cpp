@@ -32,6 +32,7 @@
 #include <sys/errno.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <mach/mach.h>
 #if !TARGET_OS_SIMULATOR && !TARGET_OS_DRIVERKIT
   #include <sandbox.h>
@@ -308,3 +309,39 @@ bool FileSystemPhysical::fileExists(const char* path, uint64_t* inode, uint64_t*
     });
     return result;
 }
+
+bool FileSystemPhysical::forEachDirectoryEntry(const char* dirPath, void (^handler)(const char* name)) const {
+    // if stat() and open() fall back to a subsystem root, a directory listing does not show everything they can find
+    if ( dyld3::hasSubsystemRoot() )
+        return false;
+    if ( !_allowRelativePaths && isFileRelativePath(dirPath) )
+        return false;
+    // entries of the overlay and the root are merged, just as fileExists() looks in both
+    __block bool result = true;
+    forEachPath(dirPath, ^(const char* aPath, unsigned prefixLen, bool& stop) {
+        DIR* dirp = ::opendir(aPath);
+        if ( dirp == nullptr ) {
+            // a missing directory has no entries, but one we cannot read may contain files stat() can find
+            if ( (errno != ENOENT) && (errno != ENOTDIR) ) {
+                result = false;
+                stop   = true;
+            }
+            return;
+        }
+        // entries are read in batches with getdirentries(), so a whole directory costs a few syscalls
+        dirent  entry;
+        dirent* entp = nullptr;
+        while ( ::readdir_r(dirp, &entry, &entp) == 0 ) {
+            if ( entp == nullptr )
+                break;
+            handler(entp->d_name);
+        }
+        // a listing cut short by an error cannot prove anything is missing
+        if ( entp != nullptr ) {
+            result = false;
+            stop   = true;
+        }
+        ::closedir(dirp);
+    });
+    return result;
+}
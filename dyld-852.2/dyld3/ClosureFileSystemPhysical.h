@@ -50,6 +50,8 @@ public:
     bool fileExists(const char* path, uint64_t* inode=nullptr, uint64_t* mtime=nullptr,
                     bool* issetuid=nullptr, bool* inodesMatchRuntime = nullptr) const override;
 
+    bool forEachDirectoryEntry(const char* dirPath, void (^handler)(const char* name)) const override;
+
 private:
 
     void forEachPath(const char* path, void (^handler)(const char* fullPath, unsigned prefixLen, bool& stop)) const;
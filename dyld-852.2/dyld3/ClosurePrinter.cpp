@@ -106,6 +106,10 @@ static const char* nameForType(TypedBytes::Type type) {
         return "rebaseFixups";
     case TypedBytes::Type::bindFixups:
         return "bindFixups";
+    case TypedBytes::Type::compactRebaseFixups:
+        return "compactRebaseFixups";
+    case TypedBytes::Type::compactBindFixups:
+        return "compactBindFixups";
     case TypedBytes::Type::cachePatchInfo:
         return "cachePatchInfo";
     case TypedBytes::Type::textFixups:
@@ -206,6 +210,8 @@ static Node buildImageNode(const Image* image, const Array<const ImageArray*>& i
     imageNode.map["has-weak-defs"].value = (image->hasWeakDefs() ? "true" : "false");
     imageNode.map["has-plus-loads"].value = (image->mayHavePlusLoads() ? "true" : "false");
     imageNode.map["never-unload"].value = (image->neverUnload() ? "true" : "false");
+    if ( image->parallelInitSafe() )
+        imageNode.map["parallel-init-safe"].value = "true";
     imageNode.map["has-precomputed-objc"].value = (image->hasPrecomputedObjC() ? "true" : "false");
 //    if ( image->cwdMustBeThisDir() )
 //        imageNode.map["cwd-must-be-this-dir"].value = "true";
@@ -760,17 +766,35 @@ void printDyldCacheImagesAsJSON(const DyldSharedCache* dyldCache, bool printFixu
     printJSON(root, 0, out);
 }
 
+static Node buildPathProbeStatsNode(const PathProbeStats& stats)
+{
+    Node statsNode;
+    statsNode.map["directories-listed"].value            = decimal(stats.directoriesListed);
+    statsNode.map["directories-not-listable"].value      = decimal(stats.directoriesNotListable);
+    statsNode.map["probes-answered-from-listings"].value = decimal(stats.probesAnsweredFromListings);
+    statsNode.map["probes-passed-through"].value         = decimal(stats.probesPassedThrough);
+    statsNode.map["stat-calls-avoided"].value            = decimal(stats.statsAvoided);
+    statsNode.map["open-calls-avoided"].value            = decimal(stats.opensAvoided);
+    return statsNode;
+}
+
 void printClosureAsJSON(const LaunchClosure* cls, const Array<const ImageArray*>& imagesArrays,
-                        bool printFixups, bool printRaw, const DyldSharedCache* dyldCache, std::ostream& out)
+                        bool printFixups, bool printRaw, const DyldSharedCache* dyldCache, std::ostream& out,
+                        const PathProbeStats* pathProbeStats)
 {
     Node root = buildClosureNode(cls, imagesArrays, printFixups, false, printRaw, dyldCache);
+    if ( pathProbeStats != nullptr )
+        root.map["path-probes"] = buildPathProbeStatsNode(*pathProbeStats);
     printJSON(root, 0, out);
 }
 
 void printClosureAsJSON(const DlopenClosure* cls, const Array<const ImageArray*>& imagesArrays,
-                        bool printFixups, bool printRaw, const DyldSharedCache* dyldCache, std::ostream& out)
+                        bool printFixups, bool printRaw, const DyldSharedCache* dyldCache, std::ostream& out,
+                        const PathProbeStats* pathProbeStats)
 {
     Node root = buildClosureNode(cls, imagesArrays, printFixups, printRaw, false);
+    if ( pathProbeStats != nullptr )
+        root.map["path-probes"] = buildPathProbeStatsNode(*pathProbeStats);
     printJSON(root, 0, out);
 }
 
@@ -29,6 +29,7 @@
 #include <iostream>
 
 #include "Closure.h"
+#include "ClosureFileSystem.h"
 #include "DyldSharedCache.h"
 
 
@@ -37,9 +38,11 @@ namespace closure {
 
 
 void printClosureAsJSON(   const LaunchClosure* cls,     const Array<const ImageArray*>& imagesArrays, bool printFixups=false,
-                           bool printRaw = false,        const DyldSharedCache* dyldCache=nullptr, std::ostream& out = std::cout);
+                           bool printRaw = false,        const DyldSharedCache* dyldCache=nullptr, std::ostream& out = std::cout,
+                           const PathProbeStats* pathProbeStats=nullptr);
 void printClosureAsJSON(   const DlopenClosure* cls,     const Array<const ImageArray*>& imagesArrays, bool printFixups=false,
-                           bool printRaw = false,        const DyldSharedCache* dyldCache=nullptr, std::ostream& out = std::cout);
+                           bool printRaw = false,        const DyldSharedCache* dyldCache=nullptr, std::ostream& out = std::cout,
+                           const PathProbeStats* pathProbeStats=nullptr);
 void printImageAsJSON(     const Image* image,           const Array<const ImageArray*>& imagesArrays, bool printFixups=false,
                            bool printRaw = false,        const DyldSharedCache* dyldCache=nullptr, std::ostream& out = std::cout);
 
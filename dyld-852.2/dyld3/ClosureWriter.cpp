@@ -31,21 +31,103 @@
 
 #include "ClosureWriter.h"
 #include "MachOFile.h"
+#include "Map.h"
 
 
 namespace dyld3 {
 namespace closure {
 
 
+////////////////////////////  WriterArena ////////////////////////////////////////
+
+
+WriterArena::~WriterArena()
+{
+    for (Chunk* chunk = _chunks; chunk != nullptr; ) {
+        Chunk* next = chunk->next;
+        ::vm_deallocate(mach_task_self(), (vm_address_t)chunk, chunk->size);
+        chunk = next;
+    }
+}
+
+void* WriterArena::alloc(size_t size)
+{
+    size = (size + 15) & (-16);
+    // use the rest of the current chunk, or the next chunk kept from before the last reset()
+    while ( _current != nullptr ) {
+        if ( _current->used + size <= _current->size ) {
+            void* result = (uint8_t*)_current + _current->used;
+            _current->used += size;
+            _lastAlloc = result;
+            // chunks are reused after reset(), and closures must not pick up stale padding bytes
+            ::bzero(result, size);
+            return result;
+        }
+        if ( _current->next == nullptr )
+            break;
+        _current = _current->next;
+    }
+    size_t chunkSize = 16 * 1024 * 1024;
+    if ( chunkSize < (size + sizeof(Chunk)) )
+        chunkSize = round_page(size + sizeof(Chunk));
+    vm_address_t chunkAddr;
+    ::vm_allocate(mach_task_self(), &chunkAddr, chunkSize, VM_FLAGS_ANYWHERE);
+    assert(chunkAddr != 0);
+    Chunk* chunk = (Chunk*)chunkAddr;
+    chunk->next = nullptr;
+    chunk->size = chunkSize;
+    chunk->used = (sizeof(Chunk) + 15) & (-16);
+    if ( _current != nullptr )
+        _current->next = chunk;
+    else
+        _chunks = chunk;
+    _current = chunk;
+    return alloc(size);
+}
+
+void* WriterArena::grow(void* p, size_t oldSize, size_t newSize)
+{
+    // the most recent allocation can usually be extended in place
+    if ( (p == _lastAlloc) && (_current != nullptr) ) {
+        size_t start = (uint8_t*)p - (uint8_t*)_current;
+        size_t end   = start + ((newSize + 15) & (-16));
+        if ( end <= _current->size ) {
+            ::bzero((uint8_t*)p + oldSize, end - start - oldSize);
+            _current->used = end;
+            return p;
+        }
+    }
+    // otherwise move it, the old space is reclaimed by the next reset()
+    void* result = alloc(newSize);
+    memcpy(result, p, oldSize);
+    return result;
+}
+
+void WriterArena::reset()
+{
+    for (Chunk* chunk = _chunks; chunk != nullptr; chunk = chunk->next)
+        chunk->used = (sizeof(Chunk) + 15) & (-16);
+    _current   = _chunks;
+    _lastAlloc = nullptr;
+}
+
+
 ////////////////////////////  ContainerTypedBytesWriter ////////////////////////////////////////
 
 
 void ContainerTypedBytesWriter::setContainerType(TypedBytes::Type containerType)
 {
     assert(_vmAllocationStart == 0);
-    _vmAllocationSize = 1024 * 1024;
     vm_address_t allocationAddr;
-    ::vm_allocate(mach_task_self(), &allocationAddr, _vmAllocationSize, VM_FLAGS_ANYWHERE);
+    if ( _arena != nullptr ) {
+        // scratch writers start small and grow inside the arena
+        _vmAllocationSize = 16 * 1024;
+        allocationAddr = (vm_address_t)_arena->alloc(_vmAllocationSize);
+    }
+    else {
+        _vmAllocationSize = 1024 * 1024;
+        ::vm_allocate(mach_task_self(), &allocationAddr, _vmAllocationSize, VM_FLAGS_ANYWHERE);
+    }
     assert(allocationAddr != 0);
     _vmAllocationStart = (void*)allocationAddr;
     _containerTypedBytes =  (TypedBytes*)_vmAllocationStart;
@@ -64,11 +146,16 @@ void* ContainerTypedBytesWriter::append(TypedBytes::Type t, const void* payload,
             growth = _vmAllocationSize*((payloadSize/_vmAllocationSize)+1);
         vm_address_t newAllocationAddr;
         size_t newAllocationSize = _vmAllocationSize+growth;
-        ::vm_allocate(mach_task_self(), &newAllocationAddr, newAllocationSize, VM_FLAGS_ANYWHERE);
-	    assert(newAllocationAddr != 0);
         size_t currentInUse = (char*)_end - (char*)_vmAllocationStart;
-        memcpy((void*)newAllocationAddr, _vmAllocationStart, currentInUse);
-        ::vm_deallocate(mach_task_self(), (vm_address_t)_vmAllocationStart, _vmAllocationSize);
+        if ( _arena != nullptr ) {
+            newAllocationAddr = (vm_address_t)_arena->grow(_vmAllocationStart, currentInUse, newAllocationSize);
+        }
+        else {
+            ::vm_allocate(mach_task_self(), &newAllocationAddr, newAllocationSize, VM_FLAGS_ANYWHERE);
+            assert(newAllocationAddr != 0);
+            memcpy((void*)newAllocationAddr, _vmAllocationStart, currentInUse);
+            ::vm_deallocate(mach_task_self(), (vm_address_t)_vmAllocationStart, _vmAllocationSize);
+        }
         _end                 = (void*)(newAllocationAddr + currentInUse);
         _vmAllocationStart   = (void*)newAllocationAddr;
         _containerTypedBytes = (TypedBytes*)_vmAllocationStart;
@@ -88,6 +175,10 @@ void* ContainerTypedBytesWriter::append(TypedBytes::Type t, const void* payload,
 
 const void* ContainerTypedBytesWriter::finalizeContainer()
 {
+    // arena memory is only read until the arena is reset, so there is nothing to trim or protect
+    if ( _arena != nullptr )
+        return (void*)_vmAllocationStart;
+
     // trim vm allocation down to just what is needed
     uintptr_t bufferStart = (uintptr_t)_vmAllocationStart;
     uintptr_t used = round_page((uintptr_t)_end - bufferStart);
@@ -109,6 +200,9 @@ const void* ContainerTypedBytesWriter::currentTypedBytes()
 
 void ContainerTypedBytesWriter::deallocate()
 {
+    // arena memory is released all at once by WriterArena::reset()
+    if ( _arena != nullptr )
+        return;
     ::vm_deallocate(mach_task_self(), (long)_vmAllocationStart, _vmAllocationSize);
 }
 
@@ -165,6 +259,11 @@ void ImageWriter::setHasPlusLoads(bool value)
     getFlags().mayHavePlusLoads = value;
 }
 
+void ImageWriter::setParallelInitSafe(bool value)
+{
+    getFlags().parallelInitSafe = value;
+}
+
 void ImageWriter::setIsBundle(bool value)
 {
     getFlags().isBundle = value;
@@ -297,9 +396,52 @@ void ImageWriter::setFileInfo(uint64_t inode, uint64_t mTime)
     append(TypedBytes::Type::fileInodeAndTime, &info, sizeof(info));
 }
 
+static void appendUleb128(OverflowSafeArray<uint8_t>& out, uint64_t value)
+{
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if ( value != 0 )
+            byte |= 0x80;
+        out.push_back(byte);
+    } while ( value != 0 );
+}
+
+static void appendSleb128(OverflowSafeArray<uint8_t>& out, int64_t value)
+{
+    bool more;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        more = !(((value == 0) && ((byte & 0x40) == 0)) || ((value == -1) && ((byte & 0x40) != 0)));
+        if ( more )
+            byte |= 0x80;
+        out.push_back(byte);
+    } while ( more );
+}
+
+void ImageWriter::appendCompactFixups(TypedBytes::Type type, const Array<Image::ResolvedSymbolTarget>& targets, const Array<uint8_t>& patterns)
+{
+    const uint32_t targetsSize = (uint32_t)(targets.count() * sizeof(Image::ResolvedSymbolTarget));
+    const uint32_t unpaddedSize = (uint32_t)(sizeof(Image::CompactFixups) + targetsSize + patterns.count());
+    const uint32_t payloadSize  = (unpaddedSize + 3) & (-4);
+    uint8_t* payload = (uint8_t*)append(type, nullptr, payloadSize);
+    Image::CompactFixups* header = (Image::CompactFixups*)payload;
+    header->targetCount  = (uint32_t)targets.count();
+    header->patternsSize = (uint32_t)patterns.count();
+    if ( targetsSize != 0 )
+        memcpy(payload + sizeof(Image::CompactFixups), targets.begin(), targetsSize);
+    if ( !patterns.empty() )
+        memcpy(payload + sizeof(Image::CompactFixups) + targetsSize, patterns.begin(), patterns.count());
+    bzero(payload + unpaddedSize, payloadSize - unpaddedSize);
+}
+
 void ImageWriter::setRebaseInfo(const Array<Image::RebasePattern>& fixups)
 {
-    append(TypedBytes::Type::rebaseFixups, fixups.begin(), (uint32_t)fixups.count()*sizeof(Image::RebasePattern));
+    OverflowSafeArray<uint8_t> patterns;
+    for (const Image::RebasePattern& pat : fixups)
+        appendUleb128(patterns, ((uint64_t)pat.repeatCount << 12) | (pat.skipCount << 8) | pat.contigCount);
+    appendCompactFixups(TypedBytes::Type::compactRebaseFixups, Array<Image::ResolvedSymbolTarget>(), patterns);
 }
 
 void ImageWriter::setTextRebaseInfo(const Array<Image::TextFixupPattern>& fixups)
@@ -307,9 +449,40 @@ void ImageWriter::setTextRebaseInfo(const Array<Image::TextFixupPattern>& fixups
     append(TypedBytes::Type::textFixups, fixups.begin(), (uint32_t)fixups.count()*sizeof(Image::TextFixupPattern));
 }
 
+struct HashTargetRaw {
+    static size_t hash(const uint64_t& v) {
+        return std::hash<uint64_t>{}(v);
+    }
+};
+
+struct EqualTargetRaw {
+    static bool equal(const uint64_t& a, const uint64_t& b) {
+        return a == b;
+    }
+};
+
 void ImageWriter::setBindInfo(const Array<Image::BindPattern>& fixups)
 {
-    append(TypedBytes::Type::bindFixups, fixups.begin(), (uint32_t)fixups.count()*sizeof(Image::BindPattern));
+    // each distinct target is stored once, and patterns refer to it by index
+    OverflowSafeArray<Image::ResolvedSymbolTarget>      targets;
+    Map<uint64_t, uint32_t, HashTargetRaw, EqualTargetRaw> targetIndexes;
+    OverflowSafeArray<uint8_t>                          patterns;
+    uint64_t                                            prevStartVmOffset = 0;
+    for (const Image::BindPattern& pat : fixups) {
+        auto itAndInserted = targetIndexes.insert({ pat.target.raw, (uint32_t)targets.count() });
+        if ( itAndInserted.second )
+            targets.push_back(pat.target);
+        const uint64_t targetIndex = itAndInserted.first->second;
+        const bool     single      = (pat.repeatCount == 1) && (pat.skipCount == 0);
+        appendUleb128(patterns, (targetIndex << 1) | (single ? 0 : 1));
+        appendSleb128(patterns, (int64_t)(pat.startVmOffset - prevStartVmOffset));
+        if ( !single ) {
+            appendUleb128(patterns, pat.skipCount);
+            appendUleb128(patterns, pat.repeatCount);
+        }
+        prevStartVmOffset = pat.startVmOffset;
+    }
+    appendCompactFixups(TypedBytes::Type::compactBindFixups, targets, patterns);
 }
 
 void ImageWriter::setFixupsNotEncoded()
@@ -419,8 +592,9 @@ void ImageWriter::setInitsOrder(const ImageNum images[], uint32_t count)
 ////////////////////////////  ImageArrayWriter ////////////////////////////////////////
 
 
-ImageArrayWriter::ImageArrayWriter(ImageNum startImageNum, unsigned count, bool hasRoots) : _index(0)
+ImageArrayWriter::ImageArrayWriter(ImageNum startImageNum, unsigned count, bool hasRoots, WriterArena* arena) : _index(0)
 {
+    useArena(arena);
     setContainerType(TypedBytes::Type::imageArray);
     _end = (void*)((uint8_t*)_end + sizeof(ImageArray) - sizeof(TypedBytes) + sizeof(uint32_t)*count);
     _containerTypedBytes->payloadLength = sizeof(ImageArray) - sizeof(TypedBytes) + sizeof(uint32_t)*count;
@@ -468,6 +642,14 @@ void ClosureWriter::applyInterposing(const LaunchClosure* launchClosure)
                 }
             }
 
+            // Compact binds share a table of targets, so interposing a target changes all binds to it.
+            for (const Image::ResolvedSymbolTarget& bindTarget : image->compactBindTargets()) {
+                if ( (bindTarget == tuple.stockImplementation) && (tuple.newImplementation.image.imageNum != image->imageNum()) ) {
+                    Image::ResolvedSymbolTarget* writeTarget = const_cast<Image::ResolvedSymbolTarget*>(&bindTarget);
+                    *writeTarget = tuple.newImplementation;
+                }
+            }
+
             // Chained fixups may also be interposed.  We can't change elements in the chain, but we can change
             // the target list.
             for (const Image::ResolvedSymbolTarget& symbolTarget : image->chainedTargets()) {
@@ -43,10 +43,43 @@ namespace dyld3 {
 namespace closure {
 
 
+//
+// Scratch memory for writers whose result is copied into another container and then
+// thrown away (the per-image ImageWriters and the ImageArrayWriter of a closure).
+// Allocating is a pointer bump and memory is only given back to the kernel when the
+// arena is destroyed, so threads building closures in parallel, each with their own
+// arena, do not serialize on vm_allocate()/vm_deallocate().
+//
+class VIS_HIDDEN WriterArena
+{
+public:
+                WriterArena() = default;
+                WriterArena(const WriterArena&) = delete;
+                ~WriterArena();
+
+    void*       alloc(size_t size);
+    void*       grow(void* p, size_t oldSize, size_t newSize);
+    void        reset();
+
+private:
+    struct Chunk
+    {
+        Chunk*      next;
+        size_t      size;
+        size_t      used;
+    };
+
+    Chunk*      _chunks         = nullptr;
+    Chunk*      _current        = nullptr;
+    void*       _lastAlloc      = nullptr;
+};
+
+
 class VIS_HIDDEN ContainerTypedBytesWriter
 {
 public:
     void        deallocate();
+    void        useArena(WriterArena* arena) { _arena = arena; }
 
 protected:
     void        setContainerType(TypedBytes::Type containerType);
@@ -59,12 +92,14 @@ protected:
     size_t      _vmAllocationSize       = 0;
     TypedBytes* _containerTypedBytes    = nullptr;
     void*       _end                    = nullptr;
+    WriterArena* _arena                 = nullptr;
 };
 
 
 class VIS_HIDDEN ImageWriter : public ContainerTypedBytesWriter
 {
 public:
+                ImageWriter(WriterArena* arena=nullptr) { useArena(arena); }
 
     void        setImageNum(ImageNum num);
     void        addPath(const char* path); // first is canonical, others are aliases
@@ -74,6 +109,7 @@ public:
     void        setIs64(bool);
     void        setHasObjC(bool);
     void        setHasPlusLoads(bool);
+    void        setParallelInitSafe(bool);
     void        setIsBundle(bool);
     void        setIsDylib(bool);
     void        setIsExecutable(bool);
@@ -117,6 +153,7 @@ public:
 
 private:
     Image::Flags& getFlags();
+    void          appendCompactFixups(TypedBytes::Type type, const Array<Image::ResolvedSymbolTarget>& targets, const Array<uint8_t>& patterns);
 
     int   _flagsOffset = -1;
 };
@@ -125,7 +162,7 @@ private:
 class VIS_HIDDEN ImageArrayWriter : public ContainerTypedBytesWriter
 {
 public:
-                        ImageArrayWriter(ImageNum startImageNum, unsigned count, bool hasRoots);
+                        ImageArrayWriter(ImageNum startImageNum, unsigned count, bool hasRoots, WriterArena* arena=nullptr);
 
     void                appendImage(const Image*);
     const ImageArray*   finalize();
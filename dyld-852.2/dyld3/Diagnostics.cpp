@@ -51,11 +51,6 @@
 
 #include "Diagnostics.h"
 
-#if BUILDING_CACHE_BUILDER
-  #include <dispatch/dispatch.h>
-  dispatch_queue_t sWarningQueue = dispatch_queue_create("com.apple.dyld.cache-builder.warnings", NULL);
-#endif
-
 Diagnostics::Diagnostics(bool verbose)
 #if BUILDING_CACHE_BUILDER
     : _verbose(verbose)
@@ -149,13 +144,10 @@ void Diagnostics::warning(const char* format, ...)
     va_start(list, format);
     _simple_vsprintf(tmp, format, list);
     va_end(list);
-#if BUILDING_CACHE_BUILDER
-    dispatch_sync(sWarningQueue, ^{
-        _warnings.insert(_simple_string(tmp));
-    });
-#else
+    // Each Diagnostics has its own lock, so threads using their own Diagnostics never contend
+    os_unfair_lock_lock(&_warningsLock);
     _warnings.insert(_simple_string(tmp));
-#endif
+    os_unfair_lock_unlock(&_warningsLock);
     _simple_sfree(tmp);
 }
 
@@ -201,26 +193,17 @@ std::string Diagnostics::errorMessage() const
 
 const std::set<std::string> Diagnostics::warnings() const
 {
-#if BUILDING_CACHE_BUILDER
-    __block std::set<std::string> retval;
-    dispatch_sync(sWarningQueue, ^{
-        retval = _warnings;
-    });
+    os_unfair_lock_lock(&_warningsLock);
+    std::set<std::string> retval = _warnings;
+    os_unfair_lock_unlock(&_warningsLock);
     return retval;
-#else
-    return _warnings;
-#endif
 }
 
 void Diagnostics::clearWarnings()
 {
-#if BUILDING_CACHE_BUILDER
-    dispatch_sync(sWarningQueue, ^{
-        _warnings.clear();
-    });
-#else
+    os_unfair_lock_lock(&_warningsLock);
     _warnings.clear();
-#endif
+    os_unfair_lock_unlock(&_warningsLock);
 }
 
 #if BUILDING_CACHE_BUILDER
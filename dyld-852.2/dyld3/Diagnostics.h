@@ -32,6 +32,7 @@
 #include <string>
 #include <vector>
 #include <dispatch/dispatch.h>
+#include <os/lock.h>
 #endif
 
 #include "Logging.h"
@@ -74,6 +75,7 @@ private:
 #if BUILDING_CACHE_BUILDER
     std::string              _prefix;
     std::set<std::string>    _warnings;
+    mutable os_unfair_lock   _warningsLock = OS_UNFAIR_LOCK_INIT;
     bool                     _verbose = false;
 #endif
 };
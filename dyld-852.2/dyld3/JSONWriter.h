@@ -121,6 +121,79 @@ static inline void printJSON(const Node& node, uint32_t indent = 0, std::ostream
         out << "\n";
 }
 
+static inline void printJSONLineString(const std::string& value, std::ostream& out)
+{
+    out << "\"";
+    for (char c : value) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if ( (unsigned char)c < 0x20 ) {
+                char buff[8];
+                sprintf(buff, "\\u%04X", c);
+                out << buff;
+            }
+            else {
+                out << c;
+            }
+            break;
+        }
+    }
+    out << "\"";
+}
+
+static inline void printJSONLineNode(const Node& node, std::ostream& out)
+{
+    if ( !node.map.empty() ) {
+        out << "{";
+        bool needComma = false;
+        for (const auto& entry : node.map) {
+            if ( needComma )
+                out << ",";
+            printJSONLineString(entry.first, out);
+            out << ":";
+            printJSONLineNode(entry.second, out);
+            needComma = true;
+        }
+        out << "}";
+    }
+    else if ( !node.array.empty() ) {
+        out << "[";
+        bool needComma = false;
+        for (const auto& entry : node.array) {
+            if ( needComma )
+                out << ",";
+            printJSONLineNode(entry, out);
+            needComma = true;
+        }
+        out << "]";
+    }
+    else if ( node.type == NodeValueType::RawValue ) {
+        out << node.value;
+    }
+    else {
+        printJSONLineString(node.value, out);
+    }
+}
+
+// Prints node on one line, with full string escaping, for tools which exchange one JSON value per line
+static inline void printJSONLine(const Node& node, std::ostream& out = std::cout)
+{
+    printJSONLineNode(node, out);
+    out << "\n";
+}
+
 static inline void streamArrayBegin(bool &needsComma, std::ostream& out = std::cout)
 {
     out << "[";
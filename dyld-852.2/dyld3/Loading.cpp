@@ -881,11 +881,13 @@ void Loader::applyFixupsToImage(Diagnostics& diag, LoadedImage& info)
     else {
         if ( image->rebasesNotEncoded() ) {
             // <rdar://problem/56172089> some apps have so many rebases the closure file is too big, instead we go back to rebase opcodes
-            ((MachOAnalyzer*)imageLoadAddress)->forEachRebase(diag, true, ^(uint64_t imageOffsetToRebase, bool& stop) {
-                // this is a rebase, add slide
-                uintptr_t* fixUpLoc = (uintptr_t*)(imageLoadAddress + imageOffsetToRebase);
-                *fixUpLoc += slide;
-                _logFixups("dyld: fixup: %s:%p += %p\n", leafName, fixUpLoc, (void*)slide);
+            ((MachOAnalyzer*)imageLoadAddress)->forEachRebaseBatch(diag, true, ^(const uint64_t imageOffsetsToRebase[], uint32_t count, bool& stop) {
+                // these are rebases, add slide
+                for (uint32_t i=0; i < count; ++i) {
+                    uintptr_t* fixUpLoc = (uintptr_t*)(imageLoadAddress + imageOffsetsToRebase[i]);
+                    *fixUpLoc += slide;
+                    _logFixups("dyld: fixup: %s:%p += %p\n", leafName, fixUpLoc, (void*)slide);
+                }
             });
         }
         image->forEachFixup(^(uint64_t imageOffsetToRebase, bool& stop) {
@@ -34,6 +34,7 @@ namespace dyld3 {
 
 static bool sVerboseLoading         = false;
 static bool sVerboseInitializers    = false;
+static bool sVerboseInitTimes       = false;
 static bool sVerboseSegments        = false;
 static bool sVerboseAPIs            = false;
 static bool sVerboseNotifications   = false;
@@ -102,6 +103,22 @@ bool log_initializers(const char* format, ...)
     return true;
 }
 
+bool log_initializer_times(const char* format, ...)
+{
+    if ( !sVerboseInitTimes )
+        return false;
+    va_list  list;
+    va_start(list, format);
+    vlog(format, list);
+    va_end(list);
+    return true;
+}
+
+bool initializerTimesLogged()
+{
+    return sVerboseInitTimes;
+}
+
 bool log_apis(const char* format, ...)
 {
     if ( !sVerboseAPIs )
@@ -157,6 +174,9 @@ void setLoggingFromEnvs(const char* envp[])
             else if ( strcmp(key, "DYLD_PRINT_INITIALIZERS") == 0 ) {
                 sVerboseInitializers = true;
             }
+            else if ( strcmp(key, "DYLD_PRINT_INITIALIZER_TIMES") == 0 ) {
+                sVerboseInitTimes = true;
+            }
             else if ( strcmp(key, "DYLD_PRINT_APIS") == 0 ) {
                 sVerboseAPIs = true;
             }
@@ -40,12 +40,16 @@ bool log_loads(const char* format, ...)         __attribute__((format(printf, 1,
 bool log_apis(const char* format, ...)          __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
 bool log_segments(const char* format, ...)      __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
 bool log_initializers(const char* format, ...)  __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
+bool log_initializer_times(const char* format, ...) __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
 bool log_fixups(const char* format, ...)        __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
 bool log_notifications(const char* format, ...) __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
 bool log_dofs(const char* format, ...)        __attribute__((format(printf, 1, 2))) VIS_HIDDEN;
 
 void halt(const char* message) __attribute((noreturn)) VIS_HIDDEN ;
 
+// lets callers skip measuring when the result will not be logged
+bool initializerTimesLogged() VIS_HIDDEN;
+
 
 // only called during libdyld set up
 void setLoggingFromEnvs(const char* envp[]) VIS_HIDDEN ;
@@ -319,12 +319,23 @@ bool MachOAnalyzer::validMachOForArchAndPlatform(Diagnostics& diag, size_t slice
 
 bool MachOAnalyzer::validLinkedit(Diagnostics& diag, const char* path) const
 {
+    // decode the LINKEDIT load commands and the segment table once, for all the checks below
+    LinkEditInfo leInfo;
+    getLinkEditPointers(diag, leInfo);
+    if ( diag.hasError() )
+        return false;
+
+    BLOCK_ACCCESSIBLE_ARRAY(SegmentInfo, segmentsInfo, leInfo.layout.lastSegIndex+1);
+    getAllSegmentsInfos(diag, segmentsInfo);
+    if ( diag.hasError() )
+        return false;
+
     // validate LINKEDIT layout
-    if ( !validLinkeditLayout(diag, path) )
+    if ( !validLinkeditLayout(diag, path, leInfo) )
         return false;
 
-    if ( hasLoadCommand(LC_DYLD_CHAINED_FIXUPS) ) {
-        if ( !validChainedFixupsInfo(diag, path) )
+    if ( leInfo.chainedFixups != nullptr ) {
+        if ( !validChainedFixupsInfo(diag, path, leInfo, segmentsInfo) )
             return false;
     }
 #if SUPPORT_ARCH_arm64e
@@ -335,11 +346,11 @@ bool MachOAnalyzer::validLinkedit(Diagnostics& diag, const char* path) const
 #endif
     else {
         // validate rebasing info
-        if ( !validRebaseInfo(diag, path) )
+        if ( !validRebaseInfo(diag, path, leInfo, segmentsInfo) )
             return false;
 
        // validate binding info
-        if ( !validBindInfo(diag, path) )
+        if ( !validBindInfo(diag, path, leInfo, segmentsInfo) )
             return false;
     }
 
@@ -729,9 +740,11 @@ bool MachOAnalyzer::validEmbeddedPaths(Diagnostics& diag, Platform platform, con
 bool MachOAnalyzer::validSegments(Diagnostics& diag, const char* path, size_t fileLen) const
 {
     // check segment load command size
-    __block bool badSegmentLoadCommand = false;
+    __block bool     badSegmentLoadCommand = false;
+    __block uint32_t segCount              = 0;
     forEachLoadCommand(diag, ^(const load_command* cmd, bool& stop) {
         if ( cmd->cmd == LC_SEGMENT_64 ) {
+            ++segCount;
             const segment_command_64* seg = (segment_command_64*)cmd;
             int32_t sectionsSpace = cmd->cmdsize - sizeof(segment_command_64);
             if ( sectionsSpace < 0 ) {
@@ -762,6 +775,7 @@ bool MachOAnalyzer::validSegments(Diagnostics& diag, const char* path, size_t fi
             }
         }
         else if ( cmd->cmd == LC_SEGMENT ) {
+            ++segCount;
             const segment_command* seg = (segment_command*)cmd;
             int32_t sectionsSpace = cmd->cmdsize - sizeof(segment_command);
             if ( sectionsSpace < 0 ) {
@@ -790,17 +804,21 @@ bool MachOAnalyzer::validSegments(Diagnostics& diag, const char* path, size_t fi
      if ( badSegmentLoadCommand )
          return false;
 
+    // decode the segment table once, instead of re-walking the load commands for every pair of segments
+    BLOCK_ACCCESSIBLE_ARRAY(SegmentInfo, segments, segCount);
+    getAllSegmentsInfos(diag, segments);
+
     // check mapping permissions of segments
-    __block bool badPermissions = false;
-    __block bool badSize        = false;
-    __block bool hasTEXT        = false;
-    __block bool hasLINKEDIT    = false;
-    forEachSegment(^(const SegmentInfo& info, bool& stop) {
+    bool badPermissions = false;
+    bool badSize        = false;
+    bool hasTEXT        = false;
+    bool hasLINKEDIT    = false;
+    for (uint32_t i=0; (i < segCount) && !badPermissions && !badSize; ++i) {
+        const SegmentInfo& info = segments[i];
         if ( strcmp(info.segName, "__TEXT") == 0 ) {
             if ( (info.protections != (VM_PROT_READ|VM_PROT_EXECUTE)) && enforceFormat(Malformed::textPermissions) ) {
                 diag.error("in '%s' __TEXT segment permissions is not 'r-x'", path);
                 badPermissions = true;
-                stop = true;
             }
             hasTEXT = true;
         }
@@ -808,35 +826,30 @@ bool MachOAnalyzer::validSegments(Diagnostics& diag, const char* path, size_t fi
             if ( (info.protections != VM_PROT_READ) && enforceFormat(Malformed::linkeditPermissions) ) {
                 diag.error("in '%s' __LINKEDIT segment permissions is not 'r--'", path);
                 badPermissions = true;
-                stop = true;
             }
             hasLINKEDIT = true;
         }
         else if ( (info.protections & 0xFFFFFFF8) != 0 ) {
             diag.error("in '%s' %s segment permissions has invalid bits set", path, info.segName);
             badPermissions = true;
-            stop = true;
         }
         if ( greaterThanAddOrOverflow(info.fileOffset, info.fileSize, fileLen) ) {
             diag.error("in '%s' %s segment content extends beyond end of file", path, info.segName);
             badSize = true;
-            stop = true;
         }
         if ( is64() ) {
             if ( info.vmAddr+info.vmSize < info.vmAddr ) {
                 diag.error("in '%s' %s segment vm range wraps", path, info.segName);
                 badSize = true;
-                stop = true;
             }
        }
        else {
             if ( (uint32_t)(info.vmAddr+info.vmSize) < (uint32_t)(info.vmAddr) ) {
                 diag.error("in '%s' %s segment vm range wraps", path, info.segName);
                 badSize = true;
-                stop = true;
             }
        }
-    });
+    }
     if ( badPermissions || badSize )
         return false;
     if ( !hasTEXT ) {
@@ -849,41 +862,37 @@ bool MachOAnalyzer::validSegments(Diagnostics& diag, const char* path, size_t fi
     }
 
     // check for overlapping segments
-    __block bool badSegments = false;
-    forEachSegment(^(const SegmentInfo& info1, bool& stop1) {
+    bool badSegments = false;
+    for (uint32_t i=0; (i < segCount) && !badSegments; ++i) {
+        const SegmentInfo& info1 = segments[i];
         uint64_t seg1vmEnd   = info1.vmAddr + info1.vmSize;
         uint64_t seg1FileEnd = info1.fileOffset + info1.fileSize;
-        forEachSegment(^(const SegmentInfo& info2, bool& stop2) {
+        for (uint32_t j=0; (j < segCount) && !badSegments; ++j) {
+            const SegmentInfo& info2 = segments[j];
             if ( info1.segIndex == info2.segIndex )
-                return;
+                continue;
             uint64_t seg2vmEnd   = info2.vmAddr + info2.vmSize;
             uint64_t seg2FileEnd = info2.fileOffset + info2.fileSize;
             if ( ((info2.vmAddr <= info1.vmAddr) && (seg2vmEnd > info1.vmAddr) && (seg1vmEnd > info1.vmAddr )) || ((info2.vmAddr >= info1.vmAddr ) && (info2.vmAddr < seg1vmEnd) && (seg2vmEnd > info2.vmAddr)) ) {
                 diag.error("in '%s' segment %s vm range overlaps segment %s", path, info1.segName, info2.segName);
                 badSegments = true;
-                stop1 = true;
-                stop2 = true;
             }
              if ( ((info2.fileOffset  <= info1.fileOffset) && (seg2FileEnd > info1.fileOffset) && (seg1FileEnd > info1.fileOffset)) || ((info2.fileOffset  >= info1.fileOffset) && (info2.fileOffset  < seg1FileEnd) && (seg2FileEnd > info2.fileOffset )) ) {
                 diag.error("in '%s' segment %s file content overlaps segment %s", path, info1.segName, info2.segName);
                 badSegments = true;
-                stop1 = true;
-                stop2 = true;
             }
-            if ( (info1.segIndex < info2.segIndex) && !stop1 ) {
+            if ( (info1.segIndex < info2.segIndex) && !badSegments ) {
                 if ( (info1.vmAddr > info2.vmAddr) || ((info1.fileOffset > info2.fileOffset ) && (info1.fileOffset != 0) && (info2.fileOffset  != 0)) ){
                     if ( !inDyldCache() && enforceFormat(Malformed::segmentOrder) && !isStaticExecutable() ) {
                         // dyld cache __DATA_* segments are moved around
                         // The static kernel also has segments with vmAddr's before __TEXT
                         diag.error("in '%s' segment load commands out of order with respect to layout for %s and %s", path, info1.segName, info2.segName);
                         badSegments = true;
-                        stop1 = true;
-                        stop2 = true;
                     }
                 }
             }
-        });
-    });
+        }
+    }
     if ( badSegments )
         return false;
 
@@ -1061,12 +1070,8 @@ namespace {
 
 
 
-bool MachOAnalyzer::validLinkeditLayout(Diagnostics& diag, const char* path) const
+bool MachOAnalyzer::validLinkeditLayout(Diagnostics& diag, const char* path, const LinkEditInfo& leInfo) const
 {
-    LinkEditInfo leInfo;
-    getLinkEditPointers(diag, leInfo);
-    if ( diag.hasError() )
-        return false;
     const uint32_t ptrSize = pointerSize();
 
     // build vector of all blobs in LINKEDIT
@@ -1288,9 +1293,9 @@ void MachOAnalyzer::getAllSegmentsInfos(Diagnostics& diag, SegmentInfo segments[
 }
 
 
-bool MachOAnalyzer::validRebaseInfo(Diagnostics& diag, const char* path) const
+bool MachOAnalyzer::validRebaseInfo(Diagnostics& diag, const char* path, const LinkEditInfo& linkeditInfo, const SegmentInfo segmentsInfo[]) const
 {
-    forEachRebase(diag, ^(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+    forEachRebase(diag, linkeditInfo, segmentsInfo, ^(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
                           bool segIndexSet, uint32_t ptrSize, uint8_t segmentIndex, uint64_t segmentOffset, Rebase kind, bool& stop) {
         if ( invalidRebaseState(diag, opcodeName, path, leInfo, segments, segIndexSet, ptrSize, segmentIndex, segmentOffset, kind) )
             stop = true;
@@ -1322,24 +1327,56 @@ void MachOAnalyzer::forEachTextRebase(Diagnostics& diag, void (^handler)(uint64_
     });
 }
 
-void MachOAnalyzer::forEachRebase(Diagnostics& diag, void (^callback)(uint64_t runtimeOffset, bool isLazyPointerRebase, bool& stop)) const
+void MachOAnalyzer::getLazyPointerRanges(uint64_t& lpVmAddr, uint64_t& lpEndVmAddr, uint64_t& shVmAddr, uint64_t& shEndVmAddr) const
 {
-    __block bool     startVmAddrSet = false;
-    __block uint64_t startVmAddr    = 0;
-    __block uint64_t lpVmAddr       = 0;
-    __block uint64_t lpEndVmAddr    = 0;
-    __block uint64_t shVmAddr       = 0;
-    __block uint64_t shEndVmAddr    = 0;
+    __block uint64_t lpStart = 0;
+    __block uint64_t lpEnd   = 0;
+    __block uint64_t shStart = 0;
+    __block uint64_t shEnd   = 0;
     forEachSection(^(const dyld3::MachOAnalyzer::SectionInfo& info, bool malformedSectionRange, bool &stop) {
         if ( (info.sectFlags & SECTION_TYPE) == S_LAZY_SYMBOL_POINTERS ) {
-            lpVmAddr    = info.sectAddr;
-            lpEndVmAddr = info.sectAddr + info.sectSize;
+            lpStart = info.sectAddr;
+            lpEnd   = info.sectAddr + info.sectSize;
         }
         else if ( (info.sectFlags & S_ATTR_PURE_INSTRUCTIONS) && (strcmp(info.sectName, "__stub_helper") == 0) ) {
-            shVmAddr    = info.sectAddr;
-            shEndVmAddr = info.sectAddr + info.sectSize;
+            shStart = info.sectAddr;
+            shEnd   = info.sectAddr + info.sectSize;
         }
     });
+    lpVmAddr    = lpStart;
+    lpEndVmAddr = lpEnd;
+    shVmAddr    = shStart;
+    shEndVmAddr = shEnd;
+}
+
+// a rebase in the lazy pointer section is only needed if the lazy pointer does not point to a regular stub helper
+bool MachOAnalyzer::isLazyStubRebase(uint64_t rebaseVmAddr, uint64_t textVmAddr, uint32_t ptrSize, uint64_t shVmAddr, uint64_t shEndVmAddr) const
+{
+    uint64_t lpValue = 0;
+    if ( ptrSize == 8 )
+        lpValue = *((uint64_t*)(rebaseVmAddr-textVmAddr+(uint8_t*)this));
+    else
+        lpValue = *((uint32_t*)(rebaseVmAddr-textVmAddr+(uint8_t*)this));
+    if ( (lpValue >= shVmAddr) && (lpValue < shEndVmAddr) ) {
+        // content is into stub_helper section
+        uint64_t lpTargetImageOffset = lpValue - textVmAddr;
+        const uint8_t* helperContent = (uint8_t*)this + lpTargetImageOffset;
+        // ignore rebases for normal lazy pointers, but leave rebase for resolver helper stub
+        return contentIsRegularStub(helperContent);
+    }
+    // if lazy pointer does not point into stub_helper, then it points to weak-def symbol and we need rebase
+    return false;
+}
+
+void MachOAnalyzer::forEachRebase(Diagnostics& diag, void (^callback)(uint64_t runtimeOffset, bool isLazyPointerRebase, bool& stop)) const
+{
+    __block bool     startVmAddrSet = false;
+    __block uint64_t startVmAddr    = 0;
+    uint64_t         lpVmAddr;
+    uint64_t         lpEndVmAddr;
+    uint64_t         shVmAddr;
+    uint64_t         shEndVmAddr;
+    getLazyPointerRanges(lpVmAddr, lpEndVmAddr, shVmAddr, shEndVmAddr);
     forEachRebase(diag, ^(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
                           bool segIndexSet, uint32_t ptrSize, uint8_t segmentIndex, uint64_t segmentOffset, Rebase kind, bool& stop) {
         switch ( kind ) {
@@ -1366,23 +1403,7 @@ void MachOAnalyzer::forEachRebase(Diagnostics& diag, void (^callback)(uint64_t r
         bool isLazyPointerRebase = false;
         if ( (rebaseVmAddr >= lpVmAddr) && (rebaseVmAddr < lpEndVmAddr) ) {
             // rebase is in lazy pointer section
-            uint64_t lpValue = 0;
-            if ( ptrSize == 8 )
-                lpValue = *((uint64_t*)(rebaseVmAddr-startVmAddr+(uint8_t*)this));
-            else
-                lpValue = *((uint32_t*)(rebaseVmAddr-startVmAddr+(uint8_t*)this));
-            if ( (lpValue >= shVmAddr) && (lpValue < shEndVmAddr) ) {
-                // content is into stub_helper section
-                uint64_t lpTargetImageOffset = lpValue - startVmAddr;
-                const uint8_t* helperContent = (uint8_t*)this + lpTargetImageOffset;
-                bool isLazyStub = contentIsRegularStub(helperContent);
-                // ignore rebases for normal lazy pointers, but leave rebase for resolver helper stub
-                if ( isLazyStub )
-                    isLazyPointerRebase = true;
-            }
-            else {
-                // if lazy pointer does not point into stub_helper, then it points to weak-def symbol and we need rebase
-            }
+            isLazyPointerRebase = isLazyStubRebase(rebaseVmAddr, startVmAddr, ptrSize, shVmAddr, shEndVmAddr);
         }
         uint64_t runtimeOffset = rebaseVmAddr - startVmAddr;
         callback(runtimeOffset, isLazyPointerRebase, stop);
@@ -1400,6 +1421,127 @@ void MachOAnalyzer::forEachRebase(Diagnostics& diag, bool ignoreLazyPointers, vo
     });
 }
 
+void MachOAnalyzer::forEachRebaseBatch(Diagnostics& diag, bool ignoreLazyPointers, void (^handler)(const uint64_t runtimeOffsets[], uint32_t count, bool& stop)) const
+{
+    LinkEditInfo leInfo;
+    getLinkEditPointers(diag, leInfo);
+    if ( diag.hasError() )
+        return;
+
+    BLOCK_ACCCESSIBLE_ARRAY(uint64_t, batch, kFixupBatchCount);
+    if ( (leInfo.dyldInfo == nullptr) || (leInfo.dyldInfo->rebase_size == 0) ) {
+        // relocations are rare enough to just batch up what the per-fixup decoder finds
+        __block uint32_t batchCount = 0;
+        forEachRebase(diag, ignoreLazyPointers, ^(uint64_t runtimeOffset, bool& stop) {
+            batch[batchCount++] = runtimeOffset;
+            if ( batchCount == kFixupBatchCount ) {
+                handler(batch, batchCount, stop);
+                batchCount = 0;
+            }
+        });
+        if ( (batchCount != 0) && diag.noError() ) {
+            bool stop = false;
+            handler(batch, batchCount, stop);
+        }
+        return;
+    }
+
+    BLOCK_ACCCESSIBLE_ARRAY(SegmentInfo, segmentsInfo, leInfo.layout.lastSegIndex+1);
+    getAllSegmentsInfos(diag, segmentsInfo);
+    if ( diag.hasError() )
+        return;
+
+    uint64_t lpVmAddr    = 0;
+    uint64_t lpEndVmAddr = 0;
+    uint64_t shVmAddr    = 0;
+    uint64_t shEndVmAddr = 0;
+    if ( ignoreLazyPointers )
+        getLazyPointerRanges(lpVmAddr, lpEndVmAddr, shVmAddr, shEndVmAddr);
+
+    // The opcodes were validated when the image was loaded, so this only checks what it needs to stay within the image
+    const uint8_t* const start      = getLinkEditContent(leInfo.layout, leInfo.dyldInfo->rebase_off);
+    const uint8_t* const end        = start + leInfo.dyldInfo->rebase_size;
+    const uint8_t*       p          = start;
+    const uint32_t       ptrSize    = pointerSize();
+    const uint64_t       textVmAddr = leInfo.layout.textUnslidVMAddr;
+    uint32_t             batchCount = 0;
+    bool                 isPointer  = false;
+    uint8_t              segIndex   = 0;
+    uint64_t             segOffset  = 0;
+    bool                 stop       = false;
+    while ( !stop && diag.noError() && (p < end) ) {
+        uint8_t  immediate = *p & REBASE_IMMEDIATE_MASK;
+        uint8_t  opcode    = *p & REBASE_OPCODE_MASK;
+        uint64_t count     = 0;
+        uint64_t skip      = 0;
+        ++p;
+        switch (opcode) {
+            case REBASE_OPCODE_DONE:
+                stop = true;
+                break;
+            case REBASE_OPCODE_SET_TYPE_IMM:
+                isPointer = (immediate == REBASE_TYPE_POINTER);
+                break;
+            case REBASE_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+                segIndex  = immediate;
+                segOffset = read_uleb128(diag, p, end);
+                if ( segIndex >= leInfo.layout.linkeditSegIndex )
+                    diag.error("rebase segment index %d too large", segIndex);
+                break;
+            case REBASE_OPCODE_ADD_ADDR_ULEB:
+                segOffset += read_uleb128(diag, p, end);
+                break;
+            case REBASE_OPCODE_ADD_ADDR_IMM_SCALED:
+                segOffset += immediate*ptrSize;
+                break;
+            case REBASE_OPCODE_DO_REBASE_IMM_TIMES:
+                count = immediate;
+                break;
+            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES:
+                count = read_uleb128(diag, p, end);
+                break;
+            case REBASE_OPCODE_DO_REBASE_ADD_ADDR_ULEB:
+                count = 1;
+                skip  = read_uleb128(diag, p, end);
+                break;
+            case REBASE_OPCODE_DO_REBASE_ULEB_TIMES_SKIPPING_ULEB:
+                count = read_uleb128(diag, p, end);
+                skip  = read_uleb128(diag, p, end);
+                break;
+            default:
+                diag.error("unknown rebase opcode 0x%02X", opcode);
+                break;
+        }
+        if ( (count == 0) || diag.hasError() )
+            continue;
+        const SegmentInfo& seg = segmentsInfo[segIndex];
+        for (uint64_t i=0; i < count; ++i) {
+            if ( segOffset + ptrSize > seg.vmSize ) {
+                diag.error("rebase offset 0x%08llX beyond segment %s size (0x%08llX)", segOffset, seg.segName, seg.vmSize);
+                break;
+            }
+            if ( isPointer ) {
+                uint64_t rebaseVmAddr = seg.vmAddr + segOffset;
+                if ( !ignoreLazyPointers || (rebaseVmAddr < lpVmAddr) || (rebaseVmAddr >= lpEndVmAddr)
+                    || !isLazyStubRebase(rebaseVmAddr, textVmAddr, ptrSize, shVmAddr, shEndVmAddr) ) {
+                    batch[batchCount++] = rebaseVmAddr - textVmAddr;
+                    if ( batchCount == kFixupBatchCount ) {
+                        handler(batch, batchCount, stop);
+                        batchCount = 0;
+                        if ( stop )
+                            return;
+                    }
+                }
+            }
+            segOffset += skip + ptrSize;
+        }
+    }
+    if ( (batchCount != 0) && diag.noError() ) {
+        stop = false;
+        handler(batch, batchCount, stop);
+    }
+}
+
 bool MachOAnalyzer::hasStompedLazyOpcodes() const
 {
     // if first eight bytes of lazy opcodes are zeros, then the opcodes have been stomped
@@ -1456,6 +1598,14 @@ void MachOAnalyzer::forEachRebase(Diagnostics& diag,
     if ( diag.hasError() )
         return;
 
+    forEachRebase(diag, leInfo, segmentsInfo, handler);
+}
+
+void MachOAnalyzer::forEachRebase(Diagnostics& diag, const LinkEditInfo& leInfo, const SegmentInfo segmentsInfo[],
+                                 void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+                                                 bool segIndexSet, uint32_t ptrSize, uint8_t segmentIndex, uint64_t segmentOffset,
+                                                 Rebase kind, bool& stop)) const
+{
     const Rebase pointerRebaseKind = is64() ? Rebase::pointer64 : Rebase::pointer32;
 
     if ( leInfo.dyldInfo != nullptr ) {
@@ -1790,9 +1940,9 @@ int MachOAnalyzer::libOrdinalFromDesc(uint16_t n_desc) const
     return libIndex;
 }
 
-bool MachOAnalyzer::validBindInfo(Diagnostics& diag, const char* path) const
+bool MachOAnalyzer::validBindInfo(Diagnostics& diag, const char* path, const LinkEditInfo& linkeditInfo, const SegmentInfo segmentsInfo[]) const
 {
-    forEachBind(diag, ^(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+    forEachBind(diag, linkeditInfo, segmentsInfo, ^(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
                          bool segIndexSet, bool libraryOrdinalSet, uint32_t dylibCount, int libOrdinal,
                          uint32_t ptrSize, uint8_t segmentIndex, uint64_t segmentOffset,
                          uint8_t type, const char* symbolName, bool weakImport, bool lazyBind, uint64_t addend, bool& stop) {
@@ -1914,6 +2064,170 @@ void MachOAnalyzer::forEachBind(Diagnostics& diag, void (^handler)(uint64_t runt
     }, strongHandler);
 }
 
+void MachOAnalyzer::forEachBindBatch(Diagnostics& diag, void (^handler)(const PackedBind binds[], uint32_t count,
+                                                                         const BindTarget targets[], uint32_t targetCount, bool& stop)) const
+{
+    LinkEditInfo leInfo;
+    getLinkEditPointers(diag, leInfo);
+    if ( diag.hasError() )
+        return;
+
+    BLOCK_ACCCESSIBLE_ARRAY(PackedBind, batch, kFixupBatchCount);
+    __block uint32_t batchCount = 0;
+    STACK_ALLOC_OVERFLOW_SAFE_ARRAY(BindTarget, targets, 256);
+    if ( leInfo.dyldInfo == nullptr ) {
+        // chained fixups have no binds to report, and relocations are rare enough to just batch up what the per-fixup decoder finds
+        forEachBind(diag, ^(uint64_t runtimeOffset, int libOrdinal, uint8_t type, const char* symbolName,
+                            bool weakImport, bool lazyBind, uint64_t addend, bool& stop) {
+            // runs of binds from the same relocation symbol share one target
+            if ( targets.empty() || (targets.back().symbolName != symbolName) || (targets.back().libOrdinal != libOrdinal)
+                || (targets.back().addend != addend) || (targets.back().weakImport != weakImport) || (targets.back().lazyBind != lazyBind) ) {
+                targets.push_back({ symbolName, libOrdinal, weakImport, lazyBind, addend });
+            }
+            batch[batchCount++] = { runtimeOffset, (uint32_t)targets.count() - 1, type };
+            if ( batchCount == kFixupBatchCount ) {
+                handler(batch, batchCount, &targets[0], (uint32_t)targets.count(), stop);
+                batchCount = 0;
+            }
+        }, ^(const char* symbolName) {
+        });
+        if ( (batchCount != 0) && diag.noError() ) {
+            bool stop = false;
+            handler(batch, batchCount, &targets[0], (uint32_t)targets.count(), stop);
+        }
+        return;
+    }
+
+    BLOCK_ACCCESSIBLE_ARRAY(SegmentInfo, segmentsInfo, leInfo.layout.lastSegIndex+1);
+    getAllSegmentsInfos(diag, segmentsInfo);
+    if ( diag.hasError() )
+        return;
+
+    // Like forEachBind(), walks the bind, then lazy bind, then weak bind opcodes.  The opcodes were validated
+    // when the image was loaded, so this only checks what it needs to stay within the image.
+    const uint32_t ptrSize          = pointerSize();
+    const uint64_t textVmAddr       = leInfo.layout.textUnslidVMAddr;
+    const uint32_t streamOffsets[3] = { leInfo.dyldInfo->bind_off,  leInfo.dyldInfo->lazy_bind_off,  leInfo.dyldInfo->weak_bind_off  };
+    const uint32_t streamSizes[3]   = { leInfo.dyldInfo->bind_size, leInfo.dyldInfo->lazy_bind_size, leInfo.dyldInfo->weak_bind_size };
+    bool           stop             = false;
+    for (int stream=0; (stream < 3) && !stop && diag.noError(); ++stream) {
+        if ( streamSizes[stream] == 0 )
+            continue;
+        const bool           lazy       = (stream == 1);
+        const bool           weak       = (stream == 2);
+        const uint8_t*       p          = getLinkEditContent(leInfo.layout, streamOffsets[stream]);
+        const uint8_t* const end        = p + streamSizes[stream];
+        uint8_t              type       = BIND_TYPE_POINTER;
+        uint8_t              segIndex   = 0;
+        uint64_t             segOffset  = 0;
+        const char*          symbolName = nullptr;
+        int                  libOrdinal = weak ? BIND_SPECIAL_DYLIB_WEAK_LOOKUP : 0;
+        int64_t              addend     = 0;
+        bool                 weakImport = false;
+        bool                 newTarget  = true;
+        bool                 done       = false;
+        while ( !done && diag.noError() && (p < end) ) {
+            uint8_t  immediate = *p & BIND_IMMEDIATE_MASK;
+            uint8_t  opcode    = *p & BIND_OPCODE_MASK;
+            uint64_t count     = 0;
+            uint64_t skip      = 0;
+            ++p;
+            switch (opcode) {
+                case BIND_OPCODE_DONE:
+                    // each lazy bind ends with one, so only the other streams end here
+                    done = !lazy;
+                    break;
+                case BIND_OPCODE_SET_DYLIB_ORDINAL_IMM:
+                    libOrdinal = immediate;
+                    newTarget  = true;
+                    break;
+                case BIND_OPCODE_SET_DYLIB_ORDINAL_ULEB:
+                    libOrdinal = (int)read_uleb128(diag, p, end);
+                    newTarget  = true;
+                    break;
+                case BIND_OPCODE_SET_DYLIB_SPECIAL_IMM:
+                    // the special ordinals are negative numbers
+                    libOrdinal = (immediate == 0) ? 0 : (int8_t)(BIND_OPCODE_MASK | immediate);
+                    newTarget  = true;
+                    break;
+                case BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM:
+                    weakImport = ( (immediate & BIND_SYMBOL_FLAGS_WEAK_IMPORT) != 0 );
+                    symbolName = (char*)p;
+                    while ( (p < end) && (*p != '\0') )
+                        ++p;
+                    ++p;
+                    newTarget  = true;
+                    break;
+                case BIND_OPCODE_SET_TYPE_IMM:
+                    type = immediate;
+                    break;
+                case BIND_OPCODE_SET_ADDEND_SLEB:
+                    addend    = read_sleb128(diag, p, end);
+                    newTarget = true;
+                    break;
+                case BIND_OPCODE_SET_SEGMENT_AND_OFFSET_ULEB:
+                    segIndex  = immediate;
+                    segOffset = read_uleb128(diag, p, end);
+                    if ( segIndex >= leInfo.layout.linkeditSegIndex )
+                        diag.error("bind segment index %d too large", segIndex);
+                    break;
+                case BIND_OPCODE_ADD_ADDR_ULEB:
+                    segOffset += read_uleb128(diag, p, end);
+                    break;
+                case BIND_OPCODE_DO_BIND:
+                    count = 1;
+                    break;
+                case BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB:
+                    count = 1;
+                    skip  = read_uleb128(diag, p, end);
+                    break;
+                case BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED:
+                    count = 1;
+                    skip  = immediate*ptrSize;
+                    break;
+                case BIND_OPCODE_DO_BIND_ULEB_TIMES_SKIPPING_ULEB:
+                    count = read_uleb128(diag, p, end);
+                    skip  = read_uleb128(diag, p, end);
+                    break;
+                default:
+                    diag.error("bad bind opcode 0x%02X", opcode);
+                    break;
+            }
+            if ( (count == 0) || diag.hasError() )
+                continue;
+            if ( symbolName == nullptr ) {
+                diag.error("bind missing preceding BIND_OPCODE_SET_SYMBOL_TRAILING_FLAGS_IMM");
+                break;
+            }
+            // all binds until the next symbol, ordinal or addend change share one target
+            if ( newTarget ) {
+                targets.push_back({ symbolName, libOrdinal, weakImport, lazy, (uint64_t)addend });
+                newTarget = false;
+            }
+            const uint32_t     targetIndex = (uint32_t)targets.count() - 1;
+            const SegmentInfo& seg         = segmentsInfo[segIndex];
+            for (uint64_t i=0; i < count; ++i) {
+                if ( segOffset + ptrSize > seg.vmSize ) {
+                    diag.error("bind offset 0x%08llX beyond segment %s size (0x%08llX)", segOffset, seg.segName, seg.vmSize);
+                    break;
+                }
+                batch[batchCount++] = { seg.vmAddr + segOffset - textVmAddr, targetIndex, type };
+                if ( batchCount == kFixupBatchCount ) {
+                    handler(batch, batchCount, &targets[0], (uint32_t)targets.count(), stop);
+                    batchCount = 0;
+                    if ( stop )
+                        return;
+                }
+                segOffset += skip + ptrSize;
+            }
+        }
+    }
+    if ( (batchCount != 0) && diag.noError() ) {
+        stop = false;
+        handler(batch, batchCount, &targets[0], (uint32_t)targets.count(), stop);
+    }
+}
+
 void MachOAnalyzer::forEachBind(Diagnostics& diag,
                                  void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
                                                  bool segIndexSet,  bool libraryOrdinalSet, uint32_t dylibCount, int libOrdinal,
@@ -1921,9 +2235,6 @@ void MachOAnalyzer::forEachBind(Diagnostics& diag,
                                                  const char* symbolName, bool weakImport, bool lazyBind, uint64_t addend, bool& stop),
                                  void (^strongHandler)(const char* symbolName)) const
 {
-    const uint32_t  ptrSize = this->pointerSize();
-    bool            stop    = false;
-
     LinkEditInfo leInfo;
     getLinkEditPointers(diag, leInfo);
     if ( diag.hasError() )
@@ -1934,7 +2245,18 @@ void MachOAnalyzer::forEachBind(Diagnostics& diag,
     if ( diag.hasError() )
         return;
 
+    forEachBind(diag, leInfo, segmentsInfo, handler, strongHandler);
+}
 
+void MachOAnalyzer::forEachBind(Diagnostics& diag, const LinkEditInfo& leInfo, const SegmentInfo segmentsInfo[],
+                                 void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+                                                 bool segIndexSet,  bool libraryOrdinalSet, uint32_t dylibCount, int libOrdinal,
+                                                 uint32_t ptrSize, uint8_t segmentIndex, uint64_t segmentOffset, uint8_t type,
+                                                 const char* symbolName, bool weakImport, bool lazyBind, uint64_t addend, bool& stop),
+                                 void (^strongHandler)(const char* symbolName)) const
+{
+    const uint32_t  ptrSize = this->pointerSize();
+    bool            stop    = false;
 
     const uint32_t dylibCount = dependentDylibCount();
 
@@ -2301,18 +2623,8 @@ void MachOAnalyzer::forEachBind(Diagnostics& diag,
 
 }
 
-bool MachOAnalyzer::validChainedFixupsInfo(Diagnostics& diag, const char* path) const
+bool MachOAnalyzer::validChainedFixupsInfo(Diagnostics& diag, const char* path, const LinkEditInfo& leInfo, const SegmentInfo segmentsInfo[]) const
 {
-    LinkEditInfo leInfo;
-    getLinkEditPointers(diag, leInfo);
-    if ( diag.hasError() )
-        return false;
-
-    BLOCK_ACCCESSIBLE_ARRAY(SegmentInfo, segmentsInfo, leInfo.layout.lastSegIndex+1);
-    getAllSegmentsInfos(diag, segmentsInfo);
-    if ( diag.hasError() )
-        return false;
-
     // validate dyld_chained_fixups_header
     const dyld_chained_fixups_header* chainsHeader = (dyld_chained_fixups_header*)getLinkEditContent(leInfo.layout, leInfo.chainedFixups->dataoff);
     if ( chainsHeader->fixups_version != 0 ) {
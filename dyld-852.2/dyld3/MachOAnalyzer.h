@@ -69,6 +69,8 @@ struct VIS_HIDDEN MachOAnalyzer : public MachOLoaded
     typedef void (^ExportsCallback)(const char* symbolName, uint64_t imageOffset, uint64_t flags,
                                     uint64_t other, const char* importName, bool& stop);
     bool                validMachOForArchAndPlatform(Diagnostics& diag, size_t mappedSize, const char* path, const GradedArchs& archs, Platform platform, bool isOSBinary) const;
+    // the rest of validation, once LINKEDIT is at its expected offset
+    bool                validLinkedit(Diagnostics& diag, const char* path) const;
 
     // Caches data useful for converting from raw data to VM addresses
     struct VMAddrConverter {
@@ -140,6 +142,28 @@ struct VIS_HIDDEN MachOAnalyzer : public MachOLoaded
                                                                         bool weakImport, bool lazyBind, uint64_t addend, bool& stop),
                                     void (^strongHandler)(const char* symbolName)) const;
     void                forEachChainedFixupTarget(Diagnostics& diag, void (^callback)(int libOrdinal, const char* symbolName, uint64_t addend, bool weakImport, bool& stop)) const;
+
+    // Rebases and binds expanded from the fixup opcodes into arrays, so that they can be applied in a
+    // loop instead of with a block call per pointer.  Handlers get up to kFixupBatchCount at a time.
+    enum { kFixupBatchCount = 512 };
+    struct BindTarget
+    {
+        const char*     symbolName;
+        int             libOrdinal;
+        bool            weakImport;
+        bool            lazyBind;
+        uint64_t        addend;
+    };
+    struct PackedBind
+    {
+        uint64_t        runtimeOffset;
+        uint32_t        targetIndex;    // index into the targets passed to the handler
+        uint8_t         type;
+    };
+    void                forEachRebaseBatch(Diagnostics& diag, bool ignoreLazyPointers, void (^handler)(const uint64_t runtimeOffsets[], uint32_t count, bool& stop)) const;
+    // targets[] holds every target decoded so far, so each only needs resolving the first time it is seen
+    void                forEachBindBatch(Diagnostics& diag, void (^handler)(const PackedBind binds[], uint32_t count,
+                                                                            const BindTarget targets[], uint32_t targetCount, bool& stop)) const;
     void                forEachRebase(Diagnostics& diag, void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
                                                                              bool segIndexSet, uint32_t pointerSize, uint8_t segmentIndex, uint64_t segmentOffset, Rebase kind, bool& stop)) const;
     void                forEachBind(Diagnostics& diag, void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
@@ -403,12 +427,11 @@ private:
     bool                    validLoadCommands(Diagnostics& diag, const char* path, size_t fileLen) const;
     bool                    validEmbeddedPaths(Diagnostics& diag, Platform platform, const char* path) const;
     bool                    validSegments(Diagnostics& diag, const char* path, size_t fileLen) const;
-    bool                    validLinkedit(Diagnostics& diag, const char* path) const;
-    bool                    validLinkeditLayout(Diagnostics& diag, const char* path) const;
-    bool                    validRebaseInfo(Diagnostics& diag, const char* path) const;
-    bool                    validBindInfo(Diagnostics& diag, const char* path) const;
+    bool                    validLinkeditLayout(Diagnostics& diag, const char* path, const LinkEditInfo& leInfo) const;
+    bool                    validRebaseInfo(Diagnostics& diag, const char* path, const LinkEditInfo& leInfo, const SegmentInfo segments[]) const;
+    bool                    validBindInfo(Diagnostics& diag, const char* path, const LinkEditInfo& leInfo, const SegmentInfo segments[]) const;
     bool                    validMain(Diagnostics& diag, const char* path) const;
-    bool                    validChainedFixupsInfo(Diagnostics& diag, const char* path) const;
+    bool                    validChainedFixupsInfo(Diagnostics& diag, const char* path, const LinkEditInfo& leInfo, const SegmentInfo segments[]) const;
     bool                    validChainedFixupsInfoOldArm64e(Diagnostics& diag, const char* path) const;
 
     bool                    invalidRebaseState(Diagnostics& diag, const char* opcodeName, const char* path, const LinkEditInfo& leInfo, const SegmentInfo segments[],
@@ -424,7 +447,19 @@ private:
                                                              uint64_t addend, const char* symbolName, bool weakImport, bool lazy, bool& stop)) const;
 
     void                    getAllSegmentsInfos(Diagnostics& diag, SegmentInfo segments[]) const;
+    // variants of the public forEachRebase()/forEachBind() which use an already decoded LinkEditInfo and segment table
+    void                    forEachRebase(Diagnostics& diag, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+                                          void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+                                                          bool segIndexSet, uint32_t pointerSize, uint8_t segmentIndex, uint64_t segmentOffset, Rebase kind, bool& stop)) const;
+    void                    forEachBind(Diagnostics& diag, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+                                        void (^handler)(const char* opcodeName, const LinkEditInfo& leInfo, const SegmentInfo segments[],
+                                                        bool segIndexSet,  bool libraryOrdinalSet, uint32_t dylibCount, int libOrdinal,
+                                                        uint32_t pointerSize, uint8_t segmentIndex, uint64_t segmentOffset,
+                                                        uint8_t type, const char* symbolName, bool weakImport, bool lazyBind, uint64_t addend, bool& stop),
+                                        void (^strongHandler)(const char* symbolName)) const;
     bool                    segmentHasTextRelocs(uint32_t segIndex) const;
+    void                    getLazyPointerRanges(uint64_t& lpVmAddr, uint64_t& lpEndVmAddr, uint64_t& shVmAddr, uint64_t& shEndVmAddr) const;
+    bool                    isLazyStubRebase(uint64_t rebaseVmAddr, uint64_t textVmAddr, uint32_t ptrSize, uint64_t shVmAddr, uint64_t shEndVmAddr) const;
     uint64_t                localRelocBaseAddress(const SegmentInfo segmentsInfos[], uint32_t segCount) const;
     uint64_t                externalRelocBaseAddress(const SegmentInfo segmentsInfos[], uint32_t segCount) const;
     bool                    segIndexAndOffsetForAddress(uint64_t addr, const SegmentInfo segmentsInfos[], uint32_t segCount, uint32_t& segIndex, uint64_t& segOffset) const;
@@ -22,6 +22,7 @@
 */
 
 #include "MachOAppCache.h"
+#include "OSSerializeBinary.h"
 
 #include <list>
 
@@ -82,18 +83,30 @@ void MachOAppCache::forEachPrelinkInfoLibrary(Diagnostics& diags,
     if ( prelinkInfoBuffer == nullptr )
         return;
 
-    CFReadStreamRef readStreamRef = CFReadStreamCreateWithBytesNoCopy(kCFAllocatorDefault, prelinkInfoBuffer, prelinkInfoBufferSize, kCFAllocatorNull);
-    if ( !CFReadStreamOpen(readStreamRef) ) {
-        fprintf(stderr, "Could not open plist stream\n");
-        exit(1);
-    }
-    CFErrorRef errorRef = nullptr;
-    CFPropertyListRef plistRef = CFPropertyListCreateWithStream(kCFAllocatorDefault, readStreamRef, prelinkInfoBufferSize, kCFPropertyListImmutable, nullptr, &errorRef);
-    if ( errorRef != nullptr ) {
-        CFStringRef stringRef = CFErrorCopyFailureReason(errorRef);
-        fprintf(stderr, "Could not read plist because: %s\n", CFStringGetCStringPtr(stringRef, kCFStringEncodingASCII));
-        CFRelease(stringRef);
-        exit(1);
+    CFReadStreamRef readStreamRef = nullptr;
+    CFPropertyListRef plistRef = nullptr;
+    if ( isOSSerializeBinary(prelinkInfoBuffer, prelinkInfoBufferSize) ) {
+        // Collections built with -binary-prelink-info
+        std::string failureReason;
+        plistRef = createCFObjectFromOSSerializeBinary(prelinkInfoBuffer, prelinkInfoBufferSize, failureReason);
+        if ( plistRef == nullptr ) {
+            fprintf(stderr, "Could not read plist because: %s\n", failureReason.c_str());
+            exit(1);
+        }
+    } else {
+        readStreamRef = CFReadStreamCreateWithBytesNoCopy(kCFAllocatorDefault, prelinkInfoBuffer, prelinkInfoBufferSize, kCFAllocatorNull);
+        if ( !CFReadStreamOpen(readStreamRef) ) {
+            fprintf(stderr, "Could not open plist stream\n");
+            exit(1);
+        }
+        CFErrorRef errorRef = nullptr;
+        plistRef = CFPropertyListCreateWithStream(kCFAllocatorDefault, readStreamRef, prelinkInfoBufferSize, kCFPropertyListImmutable, nullptr, &errorRef);
+        if ( errorRef != nullptr ) {
+            CFStringRef stringRef = CFErrorCopyFailureReason(errorRef);
+            fprintf(stderr, "Could not read plist because: %s\n", CFStringGetCStringPtr(stringRef, kCFStringEncodingASCII));
+            CFRelease(stringRef);
+            exit(1);
+        }
     }
     assert(CFGetTypeID(plistRef) == CFDictionaryGetTypeID());
 
@@ -157,7 +170,8 @@ void MachOAppCache::forEachPrelinkInfoLibrary(Diagnostics& diags,
     }
 
     CFRelease(plistRef);
-    CFRelease(readStreamRef);
+    if ( readStreamRef != nullptr )
+        CFRelease(readStreamRef);
 }
 
 } // namespace dyld3
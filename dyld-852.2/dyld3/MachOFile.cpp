@@ -82,6 +82,20 @@ int open(const char* path, int flag, int other)
     return result;
 }
 
+static bool sHasSubsystemRoot = false;
+
+bool hasSubsystemRoot()
+{
+    return sHasSubsystemRoot;
+}
+
+void setHasSubsystemRoot(bool value)
+{
+#if BUILDING_DYLD || BUILDING_LIBDYLD
+    sHasSubsystemRoot = value;
+#endif
+}
+
 
 ////////////////////////////  FatFile ////////////////////////////////////////
 
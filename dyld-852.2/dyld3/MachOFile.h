@@ -84,6 +84,10 @@ namespace dyld3 {
 int	stat(const char* path, struct stat* buf) VIS_HIDDEN;
 int	open(const char* path, int flag, int other) VIS_HIDDEN;
 
+// true if stat() and open() above also look for missing files in a subsystem root
+bool hasSubsystemRoot() VIS_HIDDEN;
+void setHasSubsystemRoot(bool value) VIS_HIDDEN;
+
 
 /// Returns true if (addLHS + addRHS) > b, or if the add overflowed
 template<typename T>
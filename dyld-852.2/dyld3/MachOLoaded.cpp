@@ -34,6 +34,10 @@
 #include <assert.h>
 #include <mach-o/reloc.h>
 #include <mach-o/nlist.h>
+#if BUILDING_LIBDYLD
+  #include <os/lock.h>
+  #include <atomic>
+#endif
 extern "C" {
   #include <corecrypto/ccdigest.h>
   #include <corecrypto/ccsha1.h>
@@ -43,6 +47,7 @@ extern "C" {
 #include "MachOFile.h"
 #include "MachOLoaded.h"
 #include "CodeSigningTypes.h"
+#include "TrieEdge.h"
 
 
 
@@ -236,15 +241,167 @@ bool MachOLoaded::hasExportTrie(uint32_t& runtimeOffset, uint32_t& size) const
 
 
 #if BUILDING_LIBDYLD
+//
+// dlsym() heavy code tends to look up the same symbols over and over, and each lookup walks
+// the export trie from the root, plus the tries of any re-exported dylibs.  This bounded cache
+// remembers the outcome of recent lookups, including misses and re-export chains, keyed by
+// image and hash of the symbol name.  Each entry keeps its own copy of the name, so a hash
+// collision is never mistaken for a hit.  Slots are guarded by a small set of locks, so
+// concurrent dlsym() calls only contend when they hash to the same shard.  The cache is
+// flushed whenever an image is unloaded, because cached results may point into the unloaded image.
+//
+struct MachOLoaded::ExportCache
+{
+    struct Entry {
+        const MachOLoaded*  image;
+        uint64_t            nameHash;
+        const char*         name;       // malloc()ed copy, owned by the entry
+        bool                usedFinder;
+        bool                found;
+        FoundSymbol         info;
+    };
+    enum { kEntryCount = 512, kLockCount = 16 };
+
+    static bool             lookup(const MachOLoaded* image, const char* symbolName, bool usedFinder, bool& found, FoundSymbol& info);
+    static void             add(const MachOLoaded* image, const char* symbolName, bool usedFinder, bool found, const FoundSymbol& info);
+    static void             flush();
+
+    static uint64_t         hashName(const char* symbolName);
+    static uint32_t         slotIndex(const MachOLoaded* image, uint64_t nameHash);
+    static os_unfair_lock&  lockForSlot(uint32_t index) { return locks[index % kLockCount]; }
+
+    static os_unfair_lock           locks[kLockCount];
+    static std::atomic<Entry*>      entries;
+    static bool                     enabled;
+    static std::atomic<uint64_t>    lookups;
+    static std::atomic<uint64_t>    hits;
+};
+
+os_unfair_lock                                  MachOLoaded::ExportCache::locks[kLockCount];
+std::atomic<MachOLoaded::ExportCache::Entry*>   MachOLoaded::ExportCache::entries(nullptr);
+bool                                            MachOLoaded::ExportCache::enabled = true;
+std::atomic<uint64_t>                           MachOLoaded::ExportCache::lookups(0);
+std::atomic<uint64_t>                           MachOLoaded::ExportCache::hits(0);
+
+uint64_t MachOLoaded::ExportCache::hashName(const char* symbolName)
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char* s = symbolName; *s != '\0'; ++s)
+        hash = (hash ^ (uint8_t)*s) * 0x100000001B3ULL;
+    return hash;
+}
+
+uint32_t MachOLoaded::ExportCache::slotIndex(const MachOLoaded* image, uint64_t nameHash)
+{
+    uint64_t key = nameHash ^ ((uintptr_t)image >> 12);
+    return (uint32_t)((key ^ (key >> 32)) & (kEntryCount-1));
+}
+
+bool MachOLoaded::ExportCache::lookup(const MachOLoaded* image, const char* symbolName, bool usedFinder, bool& found, FoundSymbol& info)
+{
+    if ( !enabled )
+        return false;
+    lookups.fetch_add(1, std::memory_order_relaxed);
+    Entry* table = entries.load(std::memory_order_acquire);
+    if ( table == nullptr )
+        return false;
+    uint64_t nameHash = hashName(symbolName);
+    uint32_t index    = slotIndex(image, nameHash);
+    bool     result   = false;
+    os_unfair_lock_lock(&lockForSlot(index));
+    const Entry& entry = table[index];
+    if ( (entry.image == image) && (entry.nameHash == nameHash) && (entry.usedFinder == usedFinder)
+        && (entry.name != nullptr) && (strcmp(entry.name, symbolName) == 0) ) {
+        found  = entry.found;
+        info   = entry.info;
+        result = true;
+    }
+    os_unfair_lock_unlock(&lockForSlot(index));
+    if ( result )
+        hits.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+void MachOLoaded::ExportCache::add(const MachOLoaded* image, const char* symbolName, bool usedFinder, bool found, const FoundSymbol& info)
+{
+    if ( !enabled )
+        return;
+    Entry* table = entries.load(std::memory_order_acquire);
+    if ( table == nullptr ) {
+        Entry* newTable = (Entry*)calloc(kEntryCount, sizeof(Entry));
+        if ( newTable == nullptr )
+            return;
+        if ( entries.compare_exchange_strong(table, newTable, std::memory_order_acq_rel) )
+            table = newTable;
+        else
+            free(newTable);     // another thread won, table now holds its copy
+    }
+    char* nameCopy = strdup(symbolName);
+    if ( nameCopy == nullptr )
+        return;
+    uint64_t nameHash = hashName(symbolName);
+    uint32_t index    = slotIndex(image, nameHash);
+    os_unfair_lock_lock(&lockForSlot(index));
+    Entry& entry = table[index];
+    const char* oldName = entry.name;
+    entry.image                = image;
+    entry.nameHash             = nameHash;
+    entry.name                 = nameCopy;
+    entry.usedFinder           = usedFinder;
+    entry.found                = found;
+    entry.info                 = info;
+    // may point into caller's buffer, so don't keep it
+    entry.info.foundSymbolName = nullptr;
+    os_unfair_lock_unlock(&lockForSlot(index));
+    free((void*)oldName);
+}
+
+void MachOLoaded::ExportCache::flush()
+{
+    Entry* table = entries.load(std::memory_order_acquire);
+    if ( table == nullptr )
+        return;
+    for (uint32_t lockIndex=0; lockIndex < kLockCount; ++lockIndex) {
+        os_unfair_lock_lock(&locks[lockIndex]);
+        for (uint32_t i=lockIndex; i < kEntryCount; i += kLockCount) {
+            free((void*)table[i].name);
+            bzero(&table[i], sizeof(Entry));
+        }
+        os_unfair_lock_unlock(&locks[lockIndex]);
+    }
+}
+
+void MachOLoaded::setExportCacheEnabled(bool enabled)
+{
+    ExportCache::enabled = enabled;
+}
+
+void MachOLoaded::flushExportCache()
+{
+    ExportCache::flush();
+}
+
+MachOLoaded::ExportCacheStats MachOLoaded::exportCacheStats()
+{
+    return { ExportCache::lookups.load(std::memory_order_relaxed), ExportCache::hits.load(std::memory_order_relaxed) };
+}
+
 // this is only used by dlsym() at runtime.  All other binding is done when the closure is built.
 bool MachOLoaded::hasExportedSymbol(const char* symbolName, DependentToMachOLoaded finder, void** result,
                                     bool* resultPointsToInstructions) const
 {
     typedef void* (*ResolverFunc)(void);
     ResolverFunc resolver;
-    Diagnostics diag;
     FoundSymbol foundInfo;
-    if ( findExportedSymbol(diag, symbolName, false, foundInfo, finder) ) {
+    bool        found;
+    if ( !ExportCache::lookup(this, symbolName, (finder != nullptr), found, foundInfo) ) {
+        Diagnostics diag;
+        found = findExportedSymbol(diag, symbolName, false, foundInfo, finder);
+        if ( !diag.hasError() )
+            ExportCache::add(this, symbolName, (finder != nullptr), found, foundInfo);
+    }
+    if ( found ) {
         switch ( foundInfo.kind ) {
             case FoundSymbol::Kind::headerOffset: {
                 *result = (uint8_t*)foundInfo.foundInDylib + foundInfo.value;
@@ -732,36 +889,26 @@ const uint8_t* MachOLoaded::trieWalk(Diagnostics& diag, const uint8_t* start, co
         p = children;
         uint64_t nodeOffset = 0;
         for (; childrenRemaining > 0; --childrenRemaining) {
-            const char* ss = symbol;
-            bool wrongEdge = false;
-            // scan whole edge to get to next edge
-            // if edge is longer than target symbol name, don't read past end of symbol name
-            char c = *p;
-            while ( c != '\0' ) {
-                if ( !wrongEdge ) {
-                    if ( c != *ss )
-                        wrongEdge = true;
-                    ++ss;
-                }
-                ++p;
-                c = *p;
+            // compare whole edge with symbol, and find end of edge
+            bool edgeMatches;
+            const uint8_t* edgeEnd = trieMatchEdge<true>(p, end, symbol, edgeMatches);
+            if ( edgeEnd == nullptr ) {
+                diag.error("malformed trie node, child node extends past end of trie\n");
+                return nullptr;
             }
-            if ( wrongEdge ) {
+            const size_t edgeLength = edgeEnd - p;
+            p = edgeEnd + 1; // skip over zero terminator
+            if ( !edgeMatches ) {
                 // advance to next child
-                ++p; // skip over zero terminator
-                // skip over uleb128 until last byte is found
-                while ( (*p & 0x80) != 0 )
-                    ++p;
-                ++p; // skip over last byte of uleb128
-                if ( p > end ) {
+                p = trieSkipUleb128(p, end);
+                if ( p == nullptr ) {
                     diag.error("malformed trie node, child node extends past end of trie\n");
                     return nullptr;
                 }
             }
             else {
-                 // the symbol so far matches this edge (child)
+                // the symbol so far matches this edge (child)
                 // so advance to the child's node
-                ++p;
                 nodeOffset = read_uleb128(diag, p, end);
                 if ( diag.hasError() )
                     return nullptr;
@@ -769,7 +916,7 @@ const uint8_t* MachOLoaded::trieWalk(Diagnostics& diag, const uint8_t* start, co
                     diag.error("malformed trie child, nodeOffset=0x%llX out of range\n", nodeOffset);
                     return nullptr;
                 }
-                symbol = ss;
+                symbol += edgeLength;
                 break;
             }
         }
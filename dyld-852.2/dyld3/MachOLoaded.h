@@ -45,6 +45,14 @@ struct VIS_HIDDEN MachOLoaded : public MachOFile
 	bool                hasExportedSymbol(const char* symbolName, DependentToMachOLoaded finder, void** result,
                                           bool* resultPointsToInstructions) const;
 
+#if BUILDING_LIBDYLD
+    // for dlsym() hot symbol cache
+    struct ExportCacheStats { uint64_t lookups; uint64_t hits; };
+    static void             setExportCacheEnabled(bool enabled);
+    static void             flushExportCache();
+    static ExportCacheStats exportCacheStats();
+#endif
+
     // for DYLD_PRINT_SEGMENTS
     const char*         segmentName(uint32_t segIndex) const;
 
@@ -194,6 +202,9 @@ protected:
     };
 
     bool                    findExportedSymbol(Diagnostics& diag, const char* symbolName, bool weakImport, FoundSymbol& foundInfo, DependentToMachOLoaded finder) const;
+#if BUILDING_LIBDYLD
+    struct ExportCache;
+#endif
 
     void                    getLinkEditLoadCommands(Diagnostics& diag, LinkEditInfo& result) const;
     void                    getLayoutInfo(LayoutInfo&) const;
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2021 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef OSSerializeBinary_h
+#define OSSerializeBinary_h
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+//
+// Reads and writes the binary property list format which libkern's OSUnserializeXML() accepts in
+// place of XML, when the buffer starts with its signature.  It is much smaller than XML, and the
+// kernel parses it without any text processing, which matters for the __PRELINK_INFO of a kernel
+// collection with thousands of kexts.
+//
+// The buffer is the signature, then the root object.  Each object is a 32-bit key holding its type
+// and a 24-bit length, followed by its payload padded to 4 bytes.  A collection's length is its
+// number of entries (key/value pairs for a dictionary), and its entries follow it.  The last entry
+// of each collection, and the root, have kOSSerializeEndCollection set.
+//
+// Numbers always have an 8 byte payload, so the writer returns their offset and they can be
+// patched in place once the real value is known.
+//
+
+namespace dyld3 {
+
+enum : uint32_t {
+    kOSSerializeBinarySignature = 0x000000D3,
+
+    kOSSerializeDictionary      = 0x01000000U,
+    kOSSerializeArray           = 0x02000000U,
+    kOSSerializeSet             = 0x03000000U,
+    kOSSerializeNumber          = 0x04000000U,
+    kOSSerializeSymbol          = 0x08000000U,
+    kOSSerializeString          = 0x09000000U,
+    kOSSerializeData            = 0x0a000000U,
+    kOSSerializeBoolean         = 0x0b000000U,
+    kOSSerializeObject          = 0x0c000000U,
+    kOSSerializeTypeMask        = 0x7F000000U,
+    kOSSerializeDataMask        = 0x00FFFFFFU,
+
+    kOSSerializeEndCollection   = 0x80000000U,
+};
+
+static inline bool isOSSerializeBinary(const uint8_t* buffer, size_t bufferSize)
+{
+    uint32_t signature;
+    if ( bufferSize < sizeof(signature) )
+        return false;
+    memcpy(&signature, buffer, sizeof(signature));
+    return (signature == kOSSerializeBinarySignature);
+}
+
+
+class OSSerializeBinaryWriter
+{
+public:
+                OSSerializeBinaryWriter() { addWord(kOSSerializeBinarySignature); }
+
+    // Collections take the number of entries which will follow.  Dictionary keys are added with addKey()
+    void        beginDictionary(uint32_t count)     { addObject(kOSSerializeDictionary, count, nullptr, 0, count * 2); }
+    void        beginArray(uint32_t count)          { addObject(kOSSerializeArray, count, nullptr, 0, count); }
+    void        addKey(const char* key)             { addObject(kOSSerializeSymbol, strlen(key) + 1, key, strlen(key) + 1); }
+    void        addString(const char* str)          { addObject(kOSSerializeString, strlen(str), str, strlen(str)); }
+    void        addBoolean(bool value)              { addObject(kOSSerializeBoolean, value ? 1 : 0, nullptr, 0); }
+
+    // Returns the offset of the number/bytes in the buffer, for patching with patchNumber() or patchData()
+    size_t      addNumber(uint64_t value)           { return addObject(kOSSerializeNumber, 64, &value, sizeof(value)); }
+    size_t      addData(const void* bytes, size_t size) { return addObject(kOSSerializeData, size, bytes, size); }
+
+    // Adds a CFDictionary, CFArray, CFSet, CFString, CFData, CFBoolean or integer CFNumber, and
+    // everything it contains.  Dictionaries are written in key order so the output is reproducible
+    bool        addCFObject(CFTypeRef object);
+
+    void        patchNumber(size_t offset, uint64_t value)  { memcpy(&_bytes[offset], &value, sizeof(value)); }
+    void        patchData(size_t offset, const void* bytes, size_t size) { memcpy(&_bytes[offset], bytes, size); }
+
+    // False if something could not be represented, or if collections are missing entries
+    bool        complete() const                    { return _failureReason.empty() && _remaining.empty() && _hasRoot; }
+    const char* failureReason() const               { return _failureReason.empty() ? "incomplete collection" : _failureReason.c_str(); }
+
+    const std::vector<uint8_t>& bytes() const       { return _bytes; }
+
+private:
+    void        addWord(uint32_t word);
+    size_t      addObject(uint32_t type, size_t length, const void* payload, size_t payloadSize, uint32_t entryCount = 0);
+    void        fail(const char* reason)            { if ( _failureReason.empty() ) _failureReason = reason; }
+
+    std::vector<uint8_t>    _bytes;
+    std::vector<uint32_t>   _remaining;     // entries still to be added to each open collection
+    std::string             _failureReason;
+    bool                    _hasRoot        = false;
+};
+
+inline void OSSerializeBinaryWriter::addWord(uint32_t word)
+{
+    const uint8_t* p = (const uint8_t*)&word;
+    _bytes.insert(_bytes.end(), p, p + sizeof(word));
+}
+
+inline size_t OSSerializeBinaryWriter::addObject(uint32_t type, size_t length, const void* payload, size_t payloadSize, uint32_t entryCount)
+{
+    if ( length > kOSSerializeDataMask ) {
+        fail("object too large");
+        length = 0;
+        payloadSize = 0;
+    }
+
+    // The last entry in a collection, or the root, ends its collection
+    bool end;
+    if ( _remaining.empty() ) {
+        if ( _hasRoot )
+            fail("object added after root");
+        _hasRoot = true;
+        end = true;
+    }
+    else {
+        end = (--_remaining.back() == 0);
+        if ( end )
+            _remaining.pop_back();
+    }
+    // Empty collections have nothing to end, and neither do leaves.  Others stay open until their entries are added
+    if ( entryCount != 0 )
+        _remaining.push_back(entryCount);
+
+    addWord(type | (uint32_t)length | (end ? kOSSerializeEndCollection : 0));
+    size_t payloadOffset = _bytes.size();
+    if ( payloadSize != 0 ) {
+        const uint8_t* p = (const uint8_t*)payload;
+        _bytes.insert(_bytes.end(), p, p + payloadSize);
+        _bytes.resize((_bytes.size() + 3) & ~3);
+    }
+    return payloadOffset;
+}
+
+// Gets the entries of a CF dictionary sorted by key, which must all be strings
+static inline bool getSortedCFDictionaryEntries(CFDictionaryRef dict, std::vector<std::pair<std::string, CFTypeRef>>& entries)
+{
+    CFIndex count = CFDictionaryGetCount(dict);
+    std::vector<const void*> keys(count);
+    std::vector<const void*> values(count);
+    CFDictionaryGetKeysAndValues(dict, keys.data(), values.data());
+    for (CFIndex i = 0; i != count; ++i) {
+        if ( CFGetTypeID(keys[i]) != CFStringGetTypeID() )
+            return false;
+        CFStringRef keyRef = (CFStringRef)keys[i];
+        CFIndex maxLength = CFStringGetMaximumSizeForEncoding(CFStringGetLength(keyRef), kCFStringEncodingUTF8) + 1;
+        std::string key(maxLength, '\0');
+        if ( !CFStringGetCString(keyRef, &key[0], maxLength, kCFStringEncodingUTF8) )
+            return false;
+        key.resize(strlen(key.c_str()));
+        entries.push_back({ key, (CFTypeRef)values[i] });
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return true;
+}
+
+inline bool OSSerializeBinaryWriter::addCFObject(CFTypeRef object)
+{
+    CFTypeID typeID = CFGetTypeID(object);
+    if ( typeID == CFDictionaryGetTypeID() ) {
+        std::vector<std::pair<std::string, CFTypeRef>> entries;
+        if ( !getSortedCFDictionaryEntries((CFDictionaryRef)object, entries) ) {
+            fail("dictionary key is not a UTF-8 string");
+            return false;
+        }
+        beginDictionary((uint32_t)entries.size());
+        for (const auto& entry : entries) {
+            addKey(entry.first.c_str());
+            if ( !addCFObject(entry.second) )
+                return false;
+        }
+    }
+    else if ( typeID == CFArrayGetTypeID() ) {
+        CFArrayRef array = (CFArrayRef)object;
+        CFIndex count = CFArrayGetCount(array);
+        beginArray((uint32_t)count);
+        for (CFIndex i = 0; i != count; ++i) {
+            if ( !addCFObject(CFArrayGetValueAtIndex(array, i)) )
+                return false;
+        }
+    }
+    else if ( typeID == CFSetGetTypeID() ) {
+        CFSetRef set = (CFSetRef)object;
+        CFIndex count = CFSetGetCount(set);
+        std::vector<const void*> values(count);
+        CFSetGetValues(set, values.data());
+        addObject(kOSSerializeSet, count, nullptr, 0, (uint32_t)count);
+        for (const void* value : values) {
+            if ( !addCFObject(value) )
+                return false;
+        }
+    }
+    else if ( typeID == CFStringGetTypeID() ) {
+        CFStringRef stringRef = (CFStringRef)object;
+        if ( const char* str = CFStringGetCStringPtr(stringRef, kCFStringEncodingUTF8) ) {
+            addString(str);
+        }
+        else {
+            CFIndex maxLength = CFStringGetMaximumSizeForEncoding(CFStringGetLength(stringRef), kCFStringEncodingUTF8) + 1;
+            std::string str(maxLength, '\0');
+            if ( !CFStringGetCString(stringRef, &str[0], maxLength, kCFStringEncodingUTF8) ) {
+                fail("could not convert string to UTF-8");
+                return false;
+            }
+            addString(str.c_str());
+        }
+    }
+    else if ( typeID == CFDataGetTypeID() ) {
+        CFDataRef data = (CFDataRef)object;
+        addData(CFDataGetBytePtr(data), CFDataGetLength(data));
+    }
+    else if ( typeID == CFBooleanGetTypeID() ) {
+        addBoolean(CFBooleanGetValue((CFBooleanRef)object));
+    }
+    else if ( typeID == CFNumberGetTypeID() ) {
+        // OSNumber has no floating point
+        if ( CFNumberIsFloatType((CFNumberRef)object) ) {
+            fail("floating point numbers are not supported");
+            return false;
+        }
+        int64_t value = 0;
+        CFNumberGetValue((CFNumberRef)object, kCFNumberSInt64Type, &value);
+        addNumber((uint64_t)value);
+    }
+    else {
+        // Including CFDate, which OSUnserializeXML() does not support either
+        fail("unsupported object type");
+        return false;
+    }
+    return _failureReason.empty();
+}
+
+
+//
+// Parses a buffer written by OSSerializeBinaryWriter, or by libkern's OSSerialize, in to the
+// equivalent CF objects.  Returns nullptr, and sets failureReason, if the buffer is malformed.
+//
+static inline CFTypeRef createCFObjectFromOSSerializeBinary(const uint8_t* buffer, size_t bufferSize, std::string& failureReason)
+{
+    if ( !isOSSerializeBinary(buffer, bufferSize) ) {
+        failureReason = "missing signature";
+        return nullptr;
+    }
+
+    std::vector<CFTypeRef>  objects;            // for kOSSerializeObject references, and to release everything at the end
+    std::vector<CFTypeRef>  stack;
+    CFTypeRef               parent      = nullptr;
+    CFStringRef             pendingKey  = nullptr;
+    CFTypeRef               root        = nullptr;
+    bool                    done        = false;
+
+    size_t offset = sizeof(uint32_t);
+    while ( !done ) {
+        uint32_t key;
+        if ( offset + sizeof(key) > bufferSize )
+            break;
+        memcpy(&key, buffer + offset, sizeof(key));
+        offset += sizeof(key);
+
+        bool            end         = (key & kOSSerializeEndCollection) != 0;
+        uint32_t        length      = key & kOSSerializeDataMask;
+        size_t          payloadSize = 0;
+        const uint8_t*  payload     = buffer + offset;
+        bool            newCollect  = false;
+        CFTypeRef       o           = nullptr;
+        switch ( key & kOSSerializeTypeMask ) {
+            case kOSSerializeDictionary:
+                o = CFDictionaryCreateMutable(kCFAllocatorDefault, length, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+                newCollect = (length != 0);
+                break;
+            case kOSSerializeArray:
+                o = CFArrayCreateMutable(kCFAllocatorDefault, length, &kCFTypeArrayCallBacks);
+                newCollect = (length != 0);
+                break;
+            case kOSSerializeSet:
+                o = CFSetCreateMutable(kCFAllocatorDefault, length, &kCFTypeSetCallBacks);
+                newCollect = (length != 0);
+                break;
+            case kOSSerializeObject:
+                if ( length >= objects.size() )
+                    break;
+                o = CFRetain(objects[length]);
+                break;
+            case kOSSerializeNumber: {
+                payloadSize = sizeof(uint64_t);
+                if ( offset + payloadSize > bufferSize )
+                    break;
+                int64_t value;
+                memcpy(&value, payload, sizeof(value));
+                o = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &value);
+                break;
+            }
+            case kOSSerializeSymbol:
+                payloadSize = length;
+                if ( (length == 0) || (offset + payloadSize > bufferSize) || (payload[length - 1] != '\0') )
+                    break;
+                o = CFStringCreateWithBytes(kCFAllocatorDefault, payload, length - 1, kCFStringEncodingUTF8, false);
+                break;
+            case kOSSerializeString:
+                payloadSize = length;
+                if ( offset + payloadSize > bufferSize )
+                    break;
+                o = CFStringCreateWithBytes(kCFAllocatorDefault, payload, length, kCFStringEncodingUTF8, false);
+                break;
+            case kOSSerializeData:
+                payloadSize = length;
+                if ( offset + payloadSize > bufferSize )
+                    break;
+                o = CFDataCreate(kCFAllocatorDefault, payload, length);
+                break;
+            case kOSSerializeBoolean:
+                o = CFRetain(length ? kCFBooleanTrue : kCFBooleanFalse);
+                break;
+        }
+        offset += (payloadSize + 3) & ~3;
+        if ( o == nullptr )
+            break;
+        // references are released with the object they refer to
+        if ( (key & kOSSerializeTypeMask) == kOSSerializeObject )
+            CFRelease(o);
+        else
+            objects.push_back(o);
+
+        if ( parent == nullptr ) {
+            if ( root != nullptr )
+                break;
+            root = o;
+        }
+        else if ( CFGetTypeID(parent) == CFDictionaryGetTypeID() ) {
+            if ( pendingKey == nullptr ) {
+                if ( CFGetTypeID(o) != CFStringGetTypeID() )
+                    break;
+                pendingKey = (CFStringRef)o;
+            }
+            else {
+                CFDictionarySetValue((CFMutableDictionaryRef)parent, pendingKey, o);
+                pendingKey = nullptr;
+            }
+        }
+        else if ( CFGetTypeID(parent) == CFArrayGetTypeID() ) {
+            CFArrayAppendValue((CFMutableArrayRef)parent, o);
+        }
+        else {
+            CFSetAddValue((CFMutableSetRef)parent, o);
+        }
+
+        // A collection which ends its parent replaces it, so there is nothing to return to
+        if ( newCollect ) {
+            if ( !end )
+                stack.push_back(parent);
+            parent = o;
+            pendingKey = nullptr;
+            end = false;
+        }
+        if ( end ) {
+            if ( stack.empty() ) {
+                done = true;
+                break;
+            }
+            parent = stack.back();
+            stack.pop_back();
+            pendingKey = nullptr;
+        }
+    }
+
+    CFTypeRef result = nullptr;
+    if ( done )
+        result = CFRetain(root);
+    else
+        failureReason = "malformed binary property list";
+    for (CFTypeRef object : objects)
+        CFRelease(object);
+    return result;
+}
+
+} // namespace dyld3
+
+#endif // OSSerializeBinary_h
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2021 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef SymbolicationIndex_h
+#define SymbolicationIndex_h
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <uuid/uuid.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//
+// An address to symbol index for a whole shared cache, laid out so it can be mmap()ed and used
+// in place.  Looking up an address with MachOLoaded::findClosestSymbol() scans every nlist of the
+// image, and the local symbols of a cache are not even in the mapped cache, so symbolicating a
+// crash or profile with millions of addresses was dominated by those scans.
+//
+// The index is a header, then the images, then the sections of every image sorted by address,
+// then every global and local symbol sorted by address, then the names.  An address resolves to
+// the section containing it, and to the last symbol at or before it in that section.
+//
+// Addresses which are already sorted are resolved in a single merge of the addresses with the
+// sections and symbols, see SymbolicationIndex::symbolicateSorted().
+//
+
+namespace dyld3 {
+
+struct SymbolicationIndexHeader
+{
+    char        magic[16];          // "dyld_symindex_1"
+    uuid_t      cacheUUID;
+    uint64_t    imagesOffset;
+    uint64_t    imageCount;
+    uint64_t    rangesOffset;
+    uint64_t    rangeCount;
+    uint64_t    symbolsOffset;
+    uint64_t    symbolCount;
+    uint64_t    stringsOffset;
+    uint64_t    stringsSize;
+};
+
+struct SymbolicationIndexImage
+{
+    uint64_t    loadAddress;
+    uint64_t    pathOffset;         // into the names
+};
+
+struct SymbolicationIndexRange
+{
+    uint64_t    vmAddr;
+    uint64_t    vmSize;
+    uint64_t    imageIndex;
+};
+
+struct SymbolicationIndexSymbol
+{
+    uint64_t    vmAddr;
+    uint64_t    nameOffset;         // into the names
+};
+
+static const char kSymbolicationIndexMagic[16] = "dyld_symindex_1";
+
+
+class SymbolicationIndexBuilder
+{
+public:
+    uint32_t    addImage(const char* path, uint64_t loadAddress);
+    // a section of the image, symbols are only used for addresses in the same section
+    void        addRange(uint32_t imageIndex, uint64_t vmAddr, uint64_t vmSize);
+    // when several symbols have the same address, the one added first is kept
+    void        addSymbol(uint64_t vmAddr, const char* name);
+    void        write(const uuid_t cacheUUID, std::vector<uint8_t>& bytes);
+
+private:
+    uint64_t    addString(const char* str);
+
+    std::vector<SymbolicationIndexImage>    _images;
+    std::vector<SymbolicationIndexRange>    _ranges;
+    std::vector<SymbolicationIndexSymbol>   _symbols;
+    std::vector<char>                       _strings;
+};
+
+inline uint64_t SymbolicationIndexBuilder::addString(const char* str)
+{
+    uint64_t offset = _strings.size();
+    _strings.insert(_strings.end(), str, str + strlen(str) + 1);
+    return offset;
+}
+
+inline uint32_t SymbolicationIndexBuilder::addImage(const char* path, uint64_t loadAddress)
+{
+    _images.push_back({ loadAddress, addString(path) });
+    return (uint32_t)_images.size() - 1;
+}
+
+inline void SymbolicationIndexBuilder::addRange(uint32_t imageIndex, uint64_t vmAddr, uint64_t vmSize)
+{
+    if ( vmSize != 0 )
+        _ranges.push_back({ vmAddr, vmSize, imageIndex });
+}
+
+inline void SymbolicationIndexBuilder::addSymbol(uint64_t vmAddr, const char* name)
+{
+    _symbols.push_back({ vmAddr, addString(name) });
+}
+
+inline void SymbolicationIndexBuilder::write(const uuid_t cacheUUID, std::vector<uint8_t>& bytes)
+{
+    std::sort(_ranges.begin(), _ranges.end(), [](const SymbolicationIndexRange& l, const SymbolicationIndexRange& r) {
+        return l.vmAddr < r.vmAddr;
+    });
+    // stable, so that of the symbols at one address the first one added stays first
+    std::stable_sort(_symbols.begin(), _symbols.end(), [](const SymbolicationIndexSymbol& l, const SymbolicationIndexSymbol& r) {
+        return l.vmAddr < r.vmAddr;
+    });
+    auto last = std::unique(_symbols.begin(), _symbols.end(), [](const SymbolicationIndexSymbol& l, const SymbolicationIndexSymbol& r) {
+        return l.vmAddr == r.vmAddr;
+    });
+    _symbols.erase(last, _symbols.end());
+
+    SymbolicationIndexHeader header;
+    bzero(&header, sizeof(header));
+    memcpy(header.magic, kSymbolicationIndexMagic, sizeof(header.magic));
+    memcpy(header.cacheUUID, cacheUUID, sizeof(uuid_t));
+    header.imagesOffset  = sizeof(SymbolicationIndexHeader);
+    header.imageCount    = _images.size();
+    header.rangesOffset  = header.imagesOffset + _images.size() * sizeof(SymbolicationIndexImage);
+    header.rangeCount    = _ranges.size();
+    header.symbolsOffset = header.rangesOffset + _ranges.size() * sizeof(SymbolicationIndexRange);
+    header.symbolCount   = _symbols.size();
+    header.stringsOffset = header.symbolsOffset + _symbols.size() * sizeof(SymbolicationIndexSymbol);
+    header.stringsSize   = _strings.size();
+
+    bytes.resize(header.stringsOffset + header.stringsSize);
+    memcpy(&bytes[0], &header, sizeof(header));
+    if ( !_images.empty() )
+        memcpy(&bytes[header.imagesOffset], _images.data(), _images.size() * sizeof(SymbolicationIndexImage));
+    if ( !_ranges.empty() )
+        memcpy(&bytes[header.rangesOffset], _ranges.data(), _ranges.size() * sizeof(SymbolicationIndexRange));
+    if ( !_symbols.empty() )
+        memcpy(&bytes[header.symbolsOffset], _symbols.data(), _symbols.size() * sizeof(SymbolicationIndexSymbol));
+    if ( !_strings.empty() )
+        memcpy(&bytes[header.stringsOffset], _strings.data(), _strings.size());
+}
+
+
+class SymbolicationIndex
+{
+public:
+    struct Result
+    {
+        const char*     imagePath           = nullptr;      // null if the address is not in any section
+        uint64_t        imageLoadAddress    = 0;
+        const char*     symbolName          = nullptr;      // null if no symbol precedes the address in its section
+        uint64_t        symbolAddress       = 0;
+    };
+
+    // the bytes are used in place, and must stay valid while this is used
+    bool            init(const void* bytes, size_t size, std::string& failureReason);
+    const uint8_t*  cacheUUID() const { return _header->cacheUUID; }
+    uint64_t        symbolCount() const { return _header->symbolCount; }
+
+    Result          symbolicate(uint64_t address) const;
+    // Calls handler with the result for each address, in order.  Sorted addresses are done with one
+    // pass over the index.  Any address lower than the one before it is looked up on its own instead.
+    void            symbolicateSorted(const uint64_t addresses[], size_t count, void (^handler)(size_t index, const Result& result)) const;
+
+private:
+    const char*     string(uint64_t offset) const;
+    Result          result(const SymbolicationIndexRange* range, const SymbolicationIndexSymbol* symbol) const;
+
+    const SymbolicationIndexHeader*     _header     = nullptr;
+    const SymbolicationIndexImage*      _images     = nullptr;
+    const SymbolicationIndexRange*      _ranges     = nullptr;
+    const SymbolicationIndexSymbol*     _symbols    = nullptr;
+    const char*                         _strings    = nullptr;
+};
+
+inline bool SymbolicationIndex::init(const void* bytes, size_t size, std::string& failureReason)
+{
+    const SymbolicationIndexHeader* header = (SymbolicationIndexHeader*)bytes;
+    if ( (size < sizeof(SymbolicationIndexHeader)) || (memcmp(header->magic, kSymbolicationIndexMagic, sizeof(header->magic)) != 0) ) {
+        failureReason = "not a symbolication index";
+        return false;
+    }
+    // every table must be in the file.  Counts are checked by division so they cannot overflow
+    auto fits = [size](uint64_t offset, uint64_t count, uint64_t entrySize) {
+        return (offset <= size) && (count <= (size - offset) / entrySize);
+    };
+    if ( !fits(header->imagesOffset, header->imageCount, sizeof(SymbolicationIndexImage))
+      || !fits(header->rangesOffset, header->rangeCount, sizeof(SymbolicationIndexRange))
+      || !fits(header->symbolsOffset, header->symbolCount, sizeof(SymbolicationIndexSymbol))
+      || !fits(header->stringsOffset, header->stringsSize, 1) ) {
+        failureReason = "symbolication index is truncated";
+        return false;
+    }
+    if ( (header->stringsSize != 0) && (((const char*)bytes)[header->stringsOffset + header->stringsSize - 1] != '\0') ) {
+        failureReason = "symbolication index names are not terminated";
+        return false;
+    }
+    _header  = header;
+    _images  = (SymbolicationIndexImage*)((uint8_t*)bytes + header->imagesOffset);
+    _ranges  = (SymbolicationIndexRange*)((uint8_t*)bytes + header->rangesOffset);
+    _symbols = (SymbolicationIndexSymbol*)((uint8_t*)bytes + header->symbolsOffset);
+    _strings = (const char*)bytes + header->stringsOffset;
+    return true;
+}
+
+// names are checked as they are used, so that opening a large index does not touch all of it
+inline const char* SymbolicationIndex::string(uint64_t offset) const
+{
+    return (offset < _header->stringsSize) ? &_strings[offset] : nullptr;
+}
+
+inline SymbolicationIndex::Result SymbolicationIndex::result(const SymbolicationIndexRange* range, const SymbolicationIndexSymbol* symbol) const
+{
+    Result result;
+    if ( (range == nullptr) || (range->imageIndex >= _header->imageCount) )
+        return result;
+    const SymbolicationIndexImage& image = _images[range->imageIndex];
+    result.imagePath        = string(image.pathOffset);
+    result.imageLoadAddress = image.loadAddress;
+    // a symbol before the start of the section is in some other section
+    if ( (symbol != nullptr) && (symbol->vmAddr >= range->vmAddr) ) {
+        result.symbolName    = string(symbol->nameOffset);
+        result.symbolAddress = symbol->vmAddr;
+    }
+    return result;
+}
+
+inline SymbolicationIndex::Result SymbolicationIndex::symbolicate(uint64_t address) const
+{
+    const SymbolicationIndexRange* rangesEnd = &_ranges[_header->rangeCount];
+    const SymbolicationIndexRange* range = std::upper_bound(_ranges, rangesEnd, address, [](uint64_t addr, const SymbolicationIndexRange& r) {
+        return addr < r.vmAddr;
+    });
+    if ( (range == _ranges) || (address >= (range-1)->vmAddr + (range-1)->vmSize) )
+        return Result();
+
+    const SymbolicationIndexSymbol* symbolsEnd = &_symbols[_header->symbolCount];
+    const SymbolicationIndexSymbol* symbol = std::upper_bound(_symbols, symbolsEnd, address, [](uint64_t addr, const SymbolicationIndexSymbol& s) {
+        return addr < s.vmAddr;
+    });
+    return result(range-1, (symbol == _symbols) ? nullptr : symbol-1);
+}
+
+inline void SymbolicationIndex::symbolicateSorted(const uint64_t addresses[], size_t count, void (^handler)(size_t index, const Result& result)) const
+{
+    uint64_t rangeIndex  = 0;
+    uint64_t symbolIndex = 0;     // first symbol after the last merged address
+    uint64_t lastMerged  = 0;
+    for (size_t i=0; i < count; ++i) {
+        const uint64_t address = addresses[i];
+        if ( address < lastMerged ) {
+            handler(i, symbolicate(address));
+            continue;
+        }
+        lastMerged = address;
+        while ( (rangeIndex < _header->rangeCount) && (_ranges[rangeIndex].vmAddr + _ranges[rangeIndex].vmSize <= address) )
+            ++rangeIndex;
+        while ( (symbolIndex < _header->symbolCount) && (_symbols[symbolIndex].vmAddr <= address) )
+            ++symbolIndex;
+        const SymbolicationIndexRange*  range  = nullptr;
+        const SymbolicationIndexSymbol* symbol = nullptr;
+        if ( (rangeIndex < _header->rangeCount) && (_ranges[rangeIndex].vmAddr <= address) )
+            range = &_ranges[rangeIndex];
+        if ( symbolIndex != 0 )
+            symbol = &_symbols[symbolIndex-1];
+        handler(i, result(range, symbol));
+    }
+}
+
+} // namespace dyld3
+
+#endif // SymbolicationIndex_h
@@ -24,9 +24,19 @@
 
 #include <atomic>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <_simple.h>
 #include <assert.h>
 #include <mach/mach.h>
+#include <mach/mach_time.h>
 #include <kern/kcdata.h>
+#if BUILDING_DYLD
+  #include <os/tsd.h>
+#else
+  #include <pthread.h>
+#endif
 #include <mach-o/dyld_priv.h>
 
 #include "Loading.h"
@@ -131,12 +141,185 @@ void kdebug_trace_dyld_duration_end(uint64_t trace_id, uint32_t code, kt_arg dat
     }
 }
 
+//
+// Launch profile ring buffer.  Recording claims a slot with one atomic add, so threads never wait
+// on each other.  Each slot's sequence is zeroed while it is being filled in, and then set to its
+// index+1, so the writer can skip slots that were overwritten or are still being filled in.
+//
+struct LaunchProfileEvent {
+    std::atomic<uint64_t>   sequence;
+    uint32_t                code;
+    uint32_t                thread;
+    uint64_t                startTime;
+    uint64_t                endTime;
+    uint64_t                data1;
+    uint64_t                data2;
+    char                    str[88];
+};
+
+enum { kLaunchProfileEventCount = 8192 };
+
+static bool                     sLaunchProfileEnabled = false;
+static char                     sLaunchProfilePath[PATH_MAX];
+static LaunchProfileEvent*      sLaunchProfileEvents = nullptr;
+static std::atomic<uint64_t>    sLaunchProfileNext(0);
+static uint64_t                 sLaunchProfileWritten = 0;
+
+VIS_HIDDEN
+void launchProfileEnable(const char* path, bool startNewFile) {
+    if ( sLaunchProfileEnabled )
+        return;
+    if ( strlcpy(sLaunchProfilePath, path, PATH_MAX) >= PATH_MAX )
+        return;
+    vm_address_t buffer = 0;
+    if ( ::vm_allocate(mach_task_self(), &buffer, kLaunchProfileEventCount * sizeof(LaunchProfileEvent), VM_FLAGS_ANYWHERE) != KERN_SUCCESS )
+        return;
+    if ( startNewFile ) {
+        int fd = ::open(sLaunchProfilePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if ( fd == -1 ) {
+            ::vm_deallocate(mach_task_self(), buffer, kLaunchProfileEventCount * sizeof(LaunchProfileEvent));
+            return;
+        }
+        _simple_dprintf(fd, "[\n");
+        ::close(fd);
+    }
+    sLaunchProfileEvents  = (LaunchProfileEvent*)buffer;
+    sLaunchProfileEnabled = true;
+}
+
+VIS_HIDDEN
+bool launchProfileEnabled() {
+    return sLaunchProfileEnabled;
+}
+
+VIS_HIDDEN
+const char* launchProfilePath() {
+    return sLaunchProfileEnabled ? sLaunchProfilePath : nullptr;
+}
+
+// the current thread's port, without the mach_thread_self() trap and the reference it returns
+static uint32_t launchProfileThread() {
+#if BUILDING_DYLD
+    // dyld does not link libpthread, but the port is in the same TSD slot pthread_mach_thread_np() reads
+    return (uint32_t)(uintptr_t)_os_tsd_get_direct(__TSD_MACH_THREAD_SELF);
+#else
+    return pthread_mach_thread_np(pthread_self());
+#endif
+}
+
+VIS_HIDDEN
+void launchProfileRecord(uint32_t code, uint64_t startTime, uint64_t endTime, uint64_t data1, uint64_t data2, const char* str) {
+    if ( !sLaunchProfileEnabled )
+        return;
+    uint64_t index = sLaunchProfileNext.fetch_add(1, std::memory_order_relaxed);
+    LaunchProfileEvent& event = sLaunchProfileEvents[index % kLaunchProfileEventCount];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.code      = code;
+    event.thread    = launchProfileThread();
+    event.startTime = startTime;
+    event.endTime   = endTime;
+    event.data1     = data1;
+    event.data2     = data2;
+    // copy paths and symbol names now, as they may be gone by the time the profile is written
+    size_t len = 0;
+    if ( str != nullptr ) {
+        for ( ; (str[len] != '\0') && (len < sizeof(event.str)-1); ++len ) {
+            char c = str[len];
+            event.str[len] = ((c == '"') || (c == '\\') || ((unsigned char)c < ' ')) ? '?' : c;
+        }
+    }
+    event.str[len] = '\0';
+    event.sequence.store(index+1, std::memory_order_release);
+}
+
+static const char* launchProfileEventName(uint32_t code) {
+    switch ( code ) {
+        case DBG_DYLD_TIMING_STATIC_INITIALIZER:    return "static_init";
+        case DBG_DYLD_TIMING_LAUNCH_EXECUTABLE:     return "app_launch";
+        case DBG_DYLD_TIMING_MAP_IMAGE:             return "map_image";
+        case DBG_DYLD_TIMING_APPLY_FIXUPS:          return "apply_fixups";
+        case DBG_DYLD_TIMING_ATTACH_CODESIGNATURE:  return "attach_codesignature";
+        case DBG_DYLD_TIMING_BUILD_CLOSURE:         return "build_closure";
+        case DBG_DYLD_TIMING_FUNC_FOR_ADD_IMAGE:    return "add_image";
+        case DBG_DYLD_TIMING_FUNC_FOR_REMOVE_IMAGE: return "remove_image";
+        case DBG_DYLD_TIMING_OBJC_INIT:             return "objc_init";
+        case DBG_DYLD_TIMING_OBJC_MAP:              return "objc_map";
+        case DBG_DYLD_TIMING_APPLY_INTERPOSING:     return "apply_interposing";
+        case DBG_DYLD_GDB_IMAGE_NOTIFIER:           return "gdb_image_notifier";
+        case DBG_DYLD_REMOTE_IMAGE_NOTIFIER:        return "remote_image_notifier";
+        case DBG_DYLD_TIMING_DLOPEN:                return "dlopen";
+        case DBG_DYLD_TIMING_DLOPEN_PREFLIGHT:      return "dlopen_preflight";
+        case DBG_DYLD_TIMING_DLCLOSE:               return "dlclose";
+        case DBG_DYLD_TIMING_DLSYM:                 return "dlsym";
+        case DBG_DYLD_TIMING_DLADDR:                return "dladdr";
+    }
+    return "unknown";
+}
+
+VIS_HIDDEN
+void launchProfileWrite() {
+    if ( !sLaunchProfileEnabled )
+        return;
+    int fd = ::open(sLaunchProfilePath, O_WRONLY | O_APPEND, 0);
+    if ( fd == -1 )
+        return;
+
+    mach_timebase_info_data_t timebase;
+    if ( mach_timebase_info(&timebase) != KERN_SUCCESS ) {
+        timebase.numer = 1;
+        timebase.denom = 1;
+    }
+    const int pid = getpid();
+
+    // events older than the size of the ring buffer have been overwritten
+    uint64_t end   = sLaunchProfileNext.load(std::memory_order_acquire);
+    uint64_t start = sLaunchProfileWritten;
+    if ( end - start > kLaunchProfileEventCount )
+        start = end - kLaunchProfileEventCount;
+    for (uint64_t index = start; index < end; ++index) {
+        LaunchProfileEvent& slot = sLaunchProfileEvents[index % kLaunchProfileEventCount];
+        if ( slot.sequence.load(std::memory_order_acquire) != index+1 )
+            continue;
+        LaunchProfileEvent event;
+        event.code      = slot.code;
+        event.thread    = slot.thread;
+        event.startTime = slot.startTime;
+        event.endTime   = slot.endTime;
+        event.data1     = slot.data1;
+        event.data2     = slot.data2;
+        memcpy(event.str, slot.str, sizeof(event.str));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ( slot.sequence.load(std::memory_order_relaxed) != index+1 )
+            continue;
+        event.str[sizeof(event.str)-1] = '\0';
+
+        // Chrome traces are in microseconds
+        uint64_t startNanos    = (event.startTime * timebase.numer) / timebase.denom;
+        uint64_t durationNanos = ((event.endTime - event.startTime) * timebase.numer) / timebase.denom;
+        _simple_dprintf(fd, "{\"name\":\"%s\",\"cat\":\"dyld\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,",
+                        launchProfileEventName(event.code), pid, event.thread,
+                        startNanos / 1000, startNanos % 1000, durationNanos / 1000, durationNanos % 1000);
+        _simple_dprintf(fd, "\"args\":{\"data1\":\"0x%llx\",\"data2\":\"0x%llx\",\"str\":\"%s\"}},\n", event.data1, event.data2, event.str);
+    }
+    sLaunchProfileWritten = end;
+    ::close(fd);
+}
+
 void ScopedTimer::startTimer() {
     current_trace_id = kdebug_trace_dyld_duration_start(code, data1, data2, data3);
+    if ( sLaunchProfileEnabled )
+        profile_start_time = mach_absolute_time();
 }
 
 void ScopedTimer::endTimer() {
     kdebug_trace_dyld_duration_end(current_trace_id, code, data4, data5, data6);
+    if ( profile_start_time != 0 ) {
+        const char* str = data1.string();
+        if ( str == nullptr )
+            str = data2.string();
+        launchProfileRecord(code, profile_start_time, mach_absolute_time(), data1.value(), data2.value(), str);
+    }
 }
 
 void syntheticBacktrace(const char *reason, bool enableExternally) {
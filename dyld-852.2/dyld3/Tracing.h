@@ -104,6 +104,7 @@ private:
     friend uint64_t kdebug_trace_dyld_duration_start(uint32_t code, kt_arg data1, kt_arg data2, kt_arg data3);
     friend void kdebug_trace_dyld_duration_end(uint64_t pair_id, uint32_t code, kt_arg data4, kt_arg data5, kt_arg data6);
     friend void kdebug_trace_dyld_marker(uint32_t code, kt_arg data1, kt_arg data2, kt_arg data3, kt_arg data4);
+    const char* string() const { return _str; }
     uint64_t _value;
     const char* _str;
 };
@@ -140,6 +141,7 @@ private:
     kt_arg data5;
     kt_arg data6;
     uint64_t current_trace_id = 0;
+    uint64_t profile_start_time = 0;
 };
 
 VIS_HIDDEN
@@ -165,5 +167,27 @@ void kdebug_trace_dyld_duration_end(uint64_t trace_id, uint32_t code, kt_arg dat
 VIS_HIDDEN
 void syntheticBacktrace(const char *reason, bool enableExternally=false);
 
+//
+// In-process launch profiling, enabled by DYLD_PROFILE_TO_FILE.  While enabled every ScopedTimer
+// interval is also recorded into a fixed size ring buffer, which launchProfileWrite() appends to the
+// file in Chrome trace event format.  dyld and libdyld each have their own ring buffer.  dyld starts
+// the file, and both append to it, which the trace format allows because the closing ']' is optional.
+//
+VIS_HIDDEN
+void launchProfileEnable(const char* path, bool startNewFile);
+
+VIS_HIDDEN
+bool launchProfileEnabled();
+
+// the path dyld accepted from DYLD_PROFILE_TO_FILE and started, or nullptr, which libdyld looks up from dyld
+VIS_HIDDEN
+const char* launchProfilePath();
+
+VIS_HIDDEN
+void launchProfileRecord(uint32_t code, uint64_t startTime, uint64_t endTime, uint64_t data1, uint64_t data2, const char* str);
+
+VIS_HIDDEN
+void launchProfileWrite();
+
 };
 #endif /* Tracing_h */
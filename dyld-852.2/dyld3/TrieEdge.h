@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef TrieEdge_h
+#define TrieEdge_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if __SSE2__
+  #include <emmintrin.h>
+#elif __ARM_NEON
+  #include <arm_neon.h>
+#endif
+
+//
+// Helpers for the inner loop of export trie walking (MachOLoaded::trieWalk() and
+// ImageLoader::trieWalk()).  Each trie node has a list of child edges, each a NUL
+// terminated string followed by a uleb128 node offset.  Walking a node means comparing
+// each edge with the rest of the symbol name, and skipping to the next edge on mismatch.
+// Large frameworks have wide nodes and long edges, so edges are compared 16 bytes at a time.
+//
+// Vector loads never cross a page boundary, so they never fault even when they read past
+// the end of the symbol name or the edge.  In StrictBounds mode they also never read past
+// the end of the trie, which is what tools parsing untrusted files should use.
+//
+
+namespace dyld3 {
+
+#if __SSE2__ || __ARM_NEON
+
+    #if __SSE2__
+        typedef uint32_t TrieEdgeByteMask;
+        enum { kTrieEdgeMaskBitsPerByte = 1 };
+    #else
+        typedef uint64_t TrieEdgeByteMask;
+        enum { kTrieEdgeMaskBitsPerByte = 4 };
+    #endif
+
+    // sets bits in zeroMask for each zero byte in edge, and bits in diffMask for each byte where edge and str differ
+    static inline void trieEdgeCompare16(const uint8_t* edge, const uint8_t* str, TrieEdgeByteMask& zeroMask, TrieEdgeByteMask& diffMask)
+    {
+    #if __SSE2__
+        __m128i e  = _mm_loadu_si128((const __m128i*)edge);
+        __m128i s  = _mm_loadu_si128((const __m128i*)str);
+        zeroMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(e, _mm_setzero_si128()));
+        diffMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(e, s)) ^ 0xFFFF;
+    #else
+        uint8x16_t e  = vld1q_u8(edge);
+        uint8x16_t s  = vld1q_u8(str);
+        // narrow each 0x00/0xFF byte to a nibble, giving a 64-bit mask
+        zeroMask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(e, vdupq_n_u8(0))), 4)), 0);
+        diffMask = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(e, s)), 4)), 0);
+    #endif
+    }
+
+    static inline bool trieEdgeLoadCrossesPage(const void* p)
+    {
+        // use smallest page size, so check is correct on all platforms
+        return (((uintptr_t)p & 0xFFF) > (0x1000 - 16));
+    }
+
+#endif // __SSE2__ || __ARM_NEON
+
+
+//
+// Compares the NUL terminated edge string at 'edge' with the start of 'str'.
+// Returns a pointer to the edge's NUL terminator, or nullptr if the edge is not terminated before 'end'.
+// Sets 'matches' if the whole edge is a prefix of 'str'.
+//
+template <bool StrictBounds>
+static inline const uint8_t* trieMatchEdge(const uint8_t* edge, const uint8_t* end, const char* str, bool& matches)
+{
+    const uint8_t* p = edge;
+    const uint8_t* s = (const uint8_t*)str;
+    matches = true;
+#if __SSE2__ || __ARM_NEON
+    while ( (StrictBounds ? ((end - p) >= 16) : (p < end)) && !trieEdgeLoadCrossesPage(p) && !trieEdgeLoadCrossesPage(s) ) {
+        TrieEdgeByteMask zeroMask;
+        TrieEdgeByteMask diffMask;
+        trieEdgeCompare16(p, s, zeroMask, diffMask);
+        if ( zeroMask != 0 ) {
+            // edge ends in this chunk, it matches if there is no difference before its terminator
+            unsigned zeroBit = __builtin_ctzll(zeroMask);
+            const uint8_t* terminator = p + (zeroBit / kTrieEdgeMaskBitsPerByte);
+            if ( terminator >= end )
+                return nullptr;
+            if ( (diffMask & ((1ULL << zeroBit) - 1)) != 0 )
+                matches = false;
+            return terminator;
+        }
+        p += 16;
+        s += 16;
+        if ( diffMask != 0 ) {
+            // 'str' may have ended inside this chunk, so never read it again
+            matches = false;
+            break;
+        }
+    }
+#endif
+    if ( matches ) {
+        // compare rest of edge a byte at a time
+        while ( p < end ) {
+            const uint8_t c = *p;
+            if ( c == '\0' )
+                return p;
+            if ( c != *s ) {
+                matches = false;
+                break;
+            }
+            ++p;
+            ++s;
+        }
+    }
+    if ( p >= end )
+        return nullptr;
+    // edge does not match, just find its end
+    return (const uint8_t*)memchr(p, '\0', end - p);
+}
+
+//
+// Skips over the uleb128 at 'p'.  Returns the first byte after it, or nullptr if it extends past 'end'.
+//
+static inline const uint8_t* trieSkipUleb128(const uint8_t* p, const uint8_t* end)
+{
+    while ( p < end ) {
+        if ( (*p++ & 0x80) == 0 )
+            return p;
+    }
+    return nullptr;
+}
+
+} // namespace dyld3
+
+#endif // TrieEdge_h
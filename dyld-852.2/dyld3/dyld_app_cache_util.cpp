@@ -40,6 +40,7 @@
 #include "FileUtils.h"
 #include "JSONWriter.h"
 #include "MachOAppCache.h"
+#include "OSSerializeBinary.h"
 
 using namespace dyld3::json;
 
@@ -82,6 +83,7 @@ static void exit_usage(const char* missingOption = nullptr) {
     fprintf(stderr, "  -extensions                  path to the kernel extensions directory\n");
     fprintf(stderr, "  -bundle-id                   zero or more bundle-ids to link in to the kernel collection\n");
     fprintf(stderr, "  -sectcreate                  segment name, section name, and payload file path for more data to embed in the kernel\n");
+    fprintf(stderr, "  -binary-prelink-info         emit __PRELINK_INFO in the kernel's binary serialization format instead of XML\n");
     fprintf(stderr, "\n");
 
     fprintf(stderr, "Usage: dyld_app_cache_util -create-pageable-kernel-collection aux-kernel-collection -kernel-collection kernel-collection-path [-extensions path-to-extensions] [-bundle-id bundle-id]*\n");
@@ -145,6 +147,7 @@ struct CreateKernelCollectionOptions {
     StripMode                               stripMode               = unknownStripMode;
     std::vector<SectionData>                sections;
     const char*                             prelinkInfoExtraData    = nullptr;
+    bool                                    binaryPrelinkInfo       = false;
 };
 
 typedef std::variant<std::monostate, DumpOptions, ValidateOptions, ListBundlesOptions, CreateKernelCollectionOptions> OptionsVariants;
@@ -304,6 +307,10 @@ static bool parseArgs(int argc, const char* argv[], OptionsVariants& options) {
             exitOrGetState<CreateKernelCollectionOptions>(options, arg).prelinkInfoExtraData = payloadFilePath;
             continue;
         }
+        if (strcmp(arg, "-binary-prelink-info") == 0) {
+            exitOrGetState<CreateKernelCollectionOptions>(options, arg).binaryPrelinkInfo = true;
+            continue;
+        }
 
 
         fprintf(stderr, "unknown option: %s\n", arg);
@@ -717,18 +724,29 @@ static int dumpAppCache(const DumpOptions& options) {
             uint64_t prelinkInfoBufferSize = 0;
             prelinkInfoBuffer = (const uint8_t*)appCacheMA->findSectionContent("__PRELINK_INFO", "__info", prelinkInfoBufferSize);
             if ( prelinkInfoBuffer != nullptr ) {
-                CFReadStreamRef readStreamRef = CFReadStreamCreateWithBytesNoCopy(kCFAllocatorDefault, prelinkInfoBuffer, prelinkInfoBufferSize, kCFAllocatorNull);
-                if ( !CFReadStreamOpen(readStreamRef) ) {
-                    fprintf(stderr, "Could not open plist stream\n");
-                    exit(1);
-                }
-                CFErrorRef errorRef = nullptr;
-                CFPropertyListRef plistRef = CFPropertyListCreateWithStream(kCFAllocatorDefault, readStreamRef, prelinkInfoBufferSize, kCFPropertyListImmutable, nullptr, &errorRef);
-                if ( errorRef != nullptr ) {
-                    CFStringRef stringRef = CFErrorCopyFailureReason(errorRef);
-                    fprintf(stderr, "Could not read plist because: %s\n", CFStringGetCStringPtr(stringRef, kCFStringEncodingASCII));
-                    CFRelease(stringRef);
-                    exit(1);
+                CFReadStreamRef readStreamRef = nullptr;
+                CFPropertyListRef plistRef = nullptr;
+                if ( dyld3::isOSSerializeBinary(prelinkInfoBuffer, prelinkInfoBufferSize) ) {
+                    std::string failureReason;
+                    plistRef = dyld3::createCFObjectFromOSSerializeBinary(prelinkInfoBuffer, prelinkInfoBufferSize, failureReason);
+                    if ( plistRef == nullptr ) {
+                        fprintf(stderr, "Could not read plist because: %s\n", failureReason.c_str());
+                        exit(1);
+                    }
+                } else {
+                    readStreamRef = CFReadStreamCreateWithBytesNoCopy(kCFAllocatorDefault, prelinkInfoBuffer, prelinkInfoBufferSize, kCFAllocatorNull);
+                    if ( !CFReadStreamOpen(readStreamRef) ) {
+                        fprintf(stderr, "Could not open plist stream\n");
+                        exit(1);
+                    }
+                    CFErrorRef errorRef = nullptr;
+                    plistRef = CFPropertyListCreateWithStream(kCFAllocatorDefault, readStreamRef, prelinkInfoBufferSize, kCFPropertyListImmutable, nullptr, &errorRef);
+                    if ( errorRef != nullptr ) {
+                        CFStringRef stringRef = CFErrorCopyFailureReason(errorRef);
+                        fprintf(stderr, "Could not read plist because: %s\n", CFStringGetCStringPtr(stringRef, kCFStringEncodingASCII));
+                        CFRelease(stringRef);
+                        exit(1);
+                    }
                 }
                 assert(CFGetTypeID(plistRef) == CFDictionaryGetTypeID());
                 CFDataRef uuidDataRef = (CFDataRef)CFDictionaryGetValue((CFDictionaryRef)plistRef, keyName);
@@ -742,7 +760,8 @@ static int dumpAppCache(const DumpOptions& options) {
                     topNode.map[jsonNodeName] = uuidNode;
                 }
                 CFRelease(plistRef);
-                CFRelease(readStreamRef);
+                if ( readStreamRef != nullptr )
+                    CFRelease(readStreamRef);
             }
         };
 
@@ -953,8 +972,9 @@ createKernelCollectionForArch(const CreateKernelCollectionOptions& options, cons
     KernelCollectionBuilder* kcb = nullptr;
     {
         CFStringRef archStringRef = CFStringCreateWithCString(kCFAllocatorDefault, arch, kCFStringEncodingASCII);
-        BuildOptions_v1 buildOptions = { 1, options.collectionKind, options.stripMode, archStringRef, options.verbose };
-        kcb = createKernelCollectionBuilder(&buildOptions);
+        BuildOptions_v2 buildOptions = { 2, options.collectionKind, options.stripMode, archStringRef, options.verbose,
+                                         options.binaryPrelinkInfo };
+        kcb = createKernelCollectionBuilder((const BuildOptions_v1*)&buildOptions);
         CFRelease(archStringRef);
     }
 
@@ -22,6 +22,7 @@
  */
 
 #include <stdarg.h>
+#include <_simple.h>
 #include <mach-o/dyld_priv.h>
 #include <mach-o/dyld_images.h>
 
@@ -78,6 +79,13 @@ static void entry_setVars(const mach_header* mainMH, int argc, const char* argv[
 
     setLoggingFromEnvs(envp);
 
+    MachOLoaded::setExportCacheEnabled(_simple_getenv(envp, "DYLD_DISABLE_DLSYM_CACHE") == nullptr);
+
+    gAllImages.setParallelInitializers(_simple_getenv(envp, "DYLD_PARALLEL_INITIALIZERS") != nullptr);
+    gAllImages.setCompactImageInfoEnabled(_simple_getenv(envp, "DYLD_PUBLISH_COMPACT_IMAGE_INFO") != nullptr);
+
+    dyld3::setHasSubsystemRoot(_simple_getenv(apple, "subsystem_root_path") != nullptr);
+
     gEnableSharedCacheDataConst = enableSharedCacheDataConst;
 }
 
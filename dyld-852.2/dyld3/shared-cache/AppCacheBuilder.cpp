@@ -186,7 +186,7 @@ void AppCacheBuilder::forEachRegion(void (^callback)(const Region& region)) cons
         callback(region);
 
     // prelinkInfoRegion
-    if ( prelinkInfoDict != nullptr )
+    if ( hasPrelinkInfo() )
         callback(prelinkInfoRegion);
 
     // nonSplitSegRegions
@@ -281,6 +281,241 @@ uint64_t AppCacheBuilder::numBranchRelocationTargets() {
     return totalTargets;
 }
 
+bool AppCacheBuilder::hasPrelinkInfo() const {
+    return appCacheOptions.binaryPrelinkInfo || (prelinkInfoDict != nullptr);
+}
+
+// The path of a kext's executable relative to its bundle, for _PrelinkExecutableRelativePath
+static const char* prelinkExecutableRelativePath(std::string_view executablePath, std::string_view bundlePath)
+{
+    const char* relativePath = executablePath.data();
+    if ( strncmp(relativePath, bundlePath.data(), bundlePath.size()) == 0 ) {
+        relativePath = relativePath + bundlePath.size();
+        if ( relativePath[0] == '/' )
+            ++relativePath;
+    } else if ( const char* lastSlash = strrchr(relativePath, '/') )
+        relativePath = lastSlash+1;
+    return relativePath;
+}
+
+// _PrelinkExecutableSize.  This seems to be the file size of __TEXT
+static uint64_t prelinkExecutableSize(const dyld3::MachOAnalyzer* ma)
+{
+    __block uint64_t textSegFileSize = 0;
+    ma->forEachSegment(^(const dyld3::MachOFile::SegmentInfo& segInfo, bool& stop) {
+        if ( strcmp(segInfo.segName, "__TEXT") == 0 )
+            textSegFileSize = segInfo.fileSize;
+    });
+    return textSegFileSize;
+}
+
+// Finds the unslid address of a kext's _kmod_info, for _PrelinkKmodInfo
+static bool findKmodInfo(Diagnostics& diags, const dyld3::MachOAnalyzer* ma, uint64_t& kmodInfoAddress)
+{
+    // Check for a global first
+    dyld3::MachOAnalyzer::FoundSymbol foundInfo;
+    if ( ma->findExportedSymbol(diags, "_kmod_info", true, foundInfo, nullptr) ) {
+        kmodInfoAddress = ma->preferredLoadAddress() + foundInfo.value;
+        return true;
+    }
+
+    // And fall back to a local if we need to
+    __block bool     found          = false;
+    __block uint64_t localAddress   = 0;
+    ma->forEachLocalSymbol(diags, ^(const char* aSymbolName, uint64_t n_value, uint8_t n_type,
+                                    uint8_t n_sect, uint16_t n_desc, bool& stop) {
+        if ( strcmp(aSymbolName, "_kmod_info") == 0 ) {
+            localAddress = n_value;
+            found = true;
+            stop = true;
+        }
+    });
+    if ( found )
+        kmodInfoAddress = localAddress;
+    return found;
+}
+
+// Sets the address and size fields of a kext's kmod_info to its __TEXT.  Returns false if the kmod_info
+// is a version we don't know how to update
+static bool updateKmodInfo(const dyld3::MachOAnalyzer* ma, uint64_t kmodInfoAddress, Diagnostics& dylibDiag)
+{
+    uint64_t kmodInfoVMOffset = kmodInfoAddress - ma->preferredLoadAddress();
+    dyld3::MachOAppCache::KModInfo64_v1* kmodInfo = (dyld3::MachOAppCache::KModInfo64_v1*)((uint8_t*)ma + kmodInfoVMOffset);
+    if ( kmodInfo->info_version != 1 ) {
+        dylibDiag.error("unsupported kmod_info version of %d", kmodInfo->info_version);
+        return false;
+    }
+    __block uint64_t textSegmnentVMAddr = 0;
+    __block uint64_t textSegmnentVMSize = 0;
+    ma->forEachSegment(^(const dyld3::MachOAnalyzer::SegmentInfo &info, bool &stop) {
+        if ( !strcmp(info.segName, "__TEXT") ) {
+            textSegmnentVMAddr = info.vmAddr;
+            textSegmnentVMSize = info.vmSize;
+            stop = true;
+        }
+    });
+    kmodInfo->address   = textSegmnentVMAddr;
+    kmodInfo->size      = textSegmnentVMSize;
+    return true;
+}
+
+// Lays out __PRELINK_INFO in the OSSerializeBinary format.  This has the same content as the XML
+// prelink info, but is written straight from the kexts' info plists, without copying each of them in
+// to a new dictionary, and with fixed size placeholders which generatePrelinkInfo() and generateUUID()
+// patch in place, instead of serializing the whole plist again
+void AppCacheBuilder::buildBinaryPrelinkInfo()
+{
+    // Keys set by the builder replace any the inputs already have
+    static const char* const prelinkKeys[] = {
+        "_PrelinkBundlePath", "_PrelinkExecutableLoadAddr", "_PrelinkExecutableRelativePath",
+        "_PrelinkExecutableSize", "_PrelinkExecutableSourceAddr", "_PrelinkKmodInfo",
+        "_PrelinkInfoDictionary", "_PrelinkKCID", "_BootKCID", "_PageableKCID"
+    };
+    typedef std::vector<std::pair<std::string, CFTypeRef>> Entries;
+    auto getEntries = ^(CFDictionaryRef dict, Entries& entries) {
+        if ( !dyld3::getSortedCFDictionaryEntries(dict, entries) )
+            return false;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](const auto& entry) {
+            for (const char* prelinkKey : prelinkKeys) {
+                if ( entry.first == prelinkKey )
+                    return true;
+            }
+            return false;
+        }), entries.end());
+        return true;
+    };
+
+    auto addKext = ^(CFDictionaryRef infoPlist, const dyld3::MachOAnalyzer* ma, std::string_view bundleID,
+                     std::string_view bundlePath, std::string_view executablePath) {
+        Entries entries;
+        if ( !getEntries(infoPlist, entries) ) {
+            _diagnostics.error("Could not serialise info plist for '%s'", bundleID.data());
+            return;
+        }
+        const char* relativePath    = executablePath.empty() ? nullptr : prelinkExecutableRelativePath(executablePath, bundlePath);
+        uint64_t    textSegFileSize = (ma != nullptr) ? prelinkExecutableSize(ma) : 0;
+        uint64_t    kmodInfoAddress = 0;
+        bool        hasKmodInfo     = (ma != nullptr) && findKmodInfo(_diagnostics, ma, kmodInfoAddress);
+
+        uint32_t count = (uint32_t)entries.size() + 3;
+        count += (relativePath != nullptr) ? 1 : 0;
+        count += (textSegFileSize != 0) ? 1 : 0;
+        count += hasKmodInfo ? 1 : 0;
+        binaryPrelinkInfo.beginDictionary(count);
+        for (const auto& entry : entries) {
+            binaryPrelinkInfo.addKey(entry.first.c_str());
+            if ( !binaryPrelinkInfo.addCFObject(entry.second) ) {
+                _diagnostics.error("Could not serialise info plist for '%s' because: %s", bundleID.data(),
+                                   binaryPrelinkInfo.failureReason());
+                return;
+            }
+        }
+
+        BinaryPrelinkInfoKext kext;
+        kext.bundleID = bundleID;
+        binaryPrelinkInfo.addKey("_PrelinkBundlePath");
+        binaryPrelinkInfo.addString(bundlePath.data());
+        binaryPrelinkInfo.addKey("_PrelinkExecutableLoadAddr");
+        kext.loadAddrOffset = binaryPrelinkInfo.addNumber(0);
+        if ( relativePath != nullptr ) {
+            binaryPrelinkInfo.addKey("_PrelinkExecutableRelativePath");
+            binaryPrelinkInfo.addString(relativePath);
+        }
+        if ( textSegFileSize != 0 ) {
+            binaryPrelinkInfo.addKey("_PrelinkExecutableSize");
+            binaryPrelinkInfo.addNumber(textSegFileSize);
+        }
+        binaryPrelinkInfo.addKey("_PrelinkExecutableSourceAddr");
+        kext.sourceAddrOffset = binaryPrelinkInfo.addNumber(0);
+        if ( hasKmodInfo ) {
+            binaryPrelinkInfo.addKey("_PrelinkKmodInfo");
+            kext.kmodInfoOffset = binaryPrelinkInfo.addNumber(0);
+        }
+        // Codeless kexts have nothing to patch
+        if ( ma != nullptr )
+            binaryPrelinkInfoKexts.push_back(kext);
+    };
+
+    Entries extraEntries;
+    if ( (extraPrelinkInfo != nullptr) && !getEntries(extraPrelinkInfo, extraEntries) ) {
+        _diagnostics.error("Could not serialise extra prelink info");
+        return;
+    }
+
+    // The pageable/aux KCs should embed the UUID of the base kernel collection, and the aux KC
+    // the UUID of the pageable kernel collection if we have one
+    uuid_t bootUUID = {};
+    uuid_t pageableUUID = {};
+    if ( (existingKernelCollection != nullptr) && !existingKernelCollection->getUuid(bootUUID) ) {
+        _diagnostics.error("Could not find UUID in base kernel collection");
+        return;
+    }
+    if ( (pageableKernelCollection != nullptr) && !pageableKernelCollection->getUuid(pageableUUID) ) {
+        _diagnostics.error("Could not find UUID in pageable kernel collection");
+        return;
+    }
+
+    uint32_t count = (uint32_t)extraEntries.size() + 2;
+    count += (existingKernelCollection != nullptr) ? 1 : 0;
+    count += (pageableKernelCollection != nullptr) ? 1 : 0;
+    binaryPrelinkInfo.beginDictionary(count);
+
+    // First add any data from addPrelinkInfo()
+    for (const auto& entry : extraEntries) {
+        binaryPrelinkInfo.addKey(entry.first.c_str());
+        if ( !binaryPrelinkInfo.addCFObject(entry.second) ) {
+            _diagnostics.error("Could not serialise extra prelink info because: %s", binaryPrelinkInfo.failureReason());
+            return;
+        }
+    }
+
+    // This is populated with regular kexts and codeless kexts
+    uint32_t kextCount = (uint32_t)codelessKexts.size();
+    for (const AppCacheDylibInfo& dylib : sortedDylibs) {
+        if ( dylib.infoPlist != nullptr )
+            ++kextCount;
+    }
+    binaryPrelinkInfo.addKey("_PrelinkInfoDictionary");
+    binaryPrelinkInfo.beginArray(kextCount);
+    for (const AppCacheDylibInfo& dylib : sortedDylibs) {
+        if ( dylib.infoPlist == nullptr )
+            continue;
+        addKext(dylib.infoPlist, dylib.input->mappedFile.mh, dylib.dylibID, dylib.bundlePath, dylib.input->loadedFileInfo.path);
+        if ( _diagnostics.hasError() )
+            return;
+    }
+    for (const InputDylib& dylib : codelessKexts) {
+        addKext(dylib.infoPlist, nullptr, dylib.dylibID, dylib.bundlePath, "");
+        if ( _diagnostics.hasError() )
+            return;
+    }
+
+    // Add a placeholder for the collection UUID
+    uuid_t kcUUID = {};
+    binaryPrelinkInfo.addKey("_PrelinkKCID");
+    binaryPrelinkInfoKCIDOffset = binaryPrelinkInfo.addData(&kcUUID, sizeof(kcUUID));
+    if ( existingKernelCollection != nullptr ) {
+        binaryPrelinkInfo.addKey("_BootKCID");
+        binaryPrelinkInfo.addData(&bootUUID, sizeof(bootUUID));
+    }
+    if ( pageableKernelCollection != nullptr ) {
+        binaryPrelinkInfo.addKey("_PageableKCID");
+        binaryPrelinkInfo.addData(&pageableUUID, sizeof(pageableUUID));
+    }
+
+    if ( !binaryPrelinkInfo.complete() ) {
+        _diagnostics.error("Could not serialise prelink info because: %s", binaryPrelinkInfo.failureReason());
+        return;
+    }
+
+    // align region end
+    prelinkInfoRegion.bufferSize  = align(binaryPrelinkInfo.bytes().size(), 14);
+    prelinkInfoRegion.sizeInUse   = prelinkInfoRegion.bufferSize;
+    prelinkInfoRegion.initProt    = VM_PROT_READ | VM_PROT_WRITE;
+    prelinkInfoRegion.maxProt     = VM_PROT_READ | VM_PROT_WRITE;
+    prelinkInfoRegion.name        = "__PRELINK_INFO";
+}
+
 void AppCacheBuilder::assignSegmentRegionsAndOffsets()
 {
     // Segments can be re-ordered in memory relative to the order of the LC_SEGMENT load comamnds
@@ -661,7 +896,11 @@ void AppCacheBuilder::assignSegmentRegionsAndOffsets()
     }
 
     // __PRELINK_INFO
-    {
+    if ( appCacheOptions.binaryPrelinkInfo ) {
+        buildBinaryPrelinkInfo();
+        if ( _diagnostics.hasError() )
+            return;
+    } else {
         // This is populated with regular kexts and codeless kexts
         struct PrelinkInfo {
             CFDictionaryRef             infoPlist       = nullptr;
@@ -704,13 +943,7 @@ void AppCacheBuilder::assignSegmentRegionsAndOffsets()
 
             // _PrelinkExecutableRelativePath
             if ( info.executablePath != "" ) {
-                const char* relativePath = info.executablePath.data();
-                if ( strncmp(relativePath, info.bundlePath.data(), info.bundlePath.size()) == 0 ) {
-                    relativePath = relativePath + info.bundlePath.size();
-                    if ( relativePath[0] == '/' )
-                        ++relativePath;
-                } else if ( const char* lastSlash = strrchr(relativePath, '/') )
-                    relativePath = lastSlash+1;
+                const char* relativePath = prelinkExecutableRelativePath(info.executablePath, info.bundlePath);
                 CFStringRef executablePath = CFStringCreateWithCStringNoCopy(kCFAllocatorDefault, relativePath,
                                                                              kCFStringEncodingASCII, kCFAllocatorNull);
                 CFDictionarySetValue(dictCopyRef, CFSTR("_PrelinkExecutableRelativePath"), executablePath);
@@ -718,14 +951,7 @@ void AppCacheBuilder::assignSegmentRegionsAndOffsets()
             }
 
             // _PrelinkExecutableSize
-            // This seems to be the file size of __TEXT
-            __block uint64_t textSegFileSize = 0;
-            if ( info.ma != nullptr ) {
-                info.ma->forEachSegment(^(const dyld3::MachOFile::SegmentInfo& segInfo, bool& stop) {
-                    if ( strcmp(segInfo.segName, "__TEXT") == 0 )
-                        textSegFileSize = segInfo.fileSize;
-                });
-            }
+            uint64_t textSegFileSize = (info.ma != nullptr) ? prelinkExecutableSize(info.ma) : 0;
             if (textSegFileSize != 0) {
                 CFNumberRef fileSizeRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberLongLongType, &textSegFileSize);
                 CFDictionarySetValue(dictCopyRef, CFSTR("_PrelinkExecutableSize"), fileSizeRef);
@@ -740,27 +966,11 @@ void AppCacheBuilder::assignSegmentRegionsAndOffsets()
 
             // _PrelinkKmodInfo
             // Leave a placeholder for this for now just so that we have enough space for it later
-            dyld3::MachOAnalyzer::FoundSymbol foundInfo;
-            if ( (info.ma != nullptr) ) {
-                // Check for a global first
-                __block bool found = false;
-                found = info.ma->findExportedSymbol(_diagnostics, "_kmod_info", true, foundInfo, nullptr);
-                if ( !found ) {
-                    // And fall back to a local if we need to
-                    info.ma->forEachLocalSymbol(_diagnostics, ^(const char* aSymbolName, uint64_t n_value, uint8_t n_type,
-                                                                uint8_t n_sect, uint16_t n_desc, bool& stop) {
-                        if ( strcmp(aSymbolName, "_kmod_info") == 0 ) {
-                            found = true;
-                            stop = true;
-                        }
-                    });
-                }
-
-                if ( found ) {
-                    CFNumberRef kmodInfoAddrRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberLongLongType, &largeAddress);
-                    CFDictionarySetValue(dictCopyRef, CFSTR("_PrelinkKmodInfo"), kmodInfoAddrRef);
-                    CFRelease(kmodInfoAddrRef);
-                }
+            uint64_t kmodInfoAddress = 0;
+            if ( (info.ma != nullptr) && findKmodInfo(_diagnostics, info.ma, kmodInfoAddress) ) {
+                CFNumberRef kmodInfoAddrRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberLongLongType, &largeAddress);
+                CFDictionarySetValue(dictCopyRef, CFSTR("_PrelinkKmodInfo"), kmodInfoAddrRef);
+                CFRelease(kmodInfoAddrRef);
             }
 
             CFArrayAppendValue(bundlesArrayRef, dictCopyRef);
@@ -967,8 +1177,8 @@ void AppCacheBuilder::assignSegmentRegionsAndOffsets()
         if ( appCacheOptions.cacheKind == Options::AppCacheKind::kernel ) {
             if ( const DylibInfo* dylib = getKernelStaticExecutableInputFile() ) {
                 if ( dylib->input->mappedFile.mh->usesClassicRelocationsInKernelCollection() ) {
-                    dylib->input->mappedFile.mh->forEachRebase(_diagnostics, false, ^(uint64_t runtimeOffset, bool &stop) {
-                        numBytesForClassicRelocs += sizeof(relocation_info);
+                    dylib->input->mappedFile.mh->forEachRebaseBatch(_diagnostics, false, ^(const uint64_t runtimeOffsets[], uint32_t count, bool &stop) {
+                        numBytesForClassicRelocs += count * sizeof(relocation_info);
                     });
                 }
             }
@@ -2835,9 +3045,11 @@ void DylibFixups::processFixups(const std::map<std::string, DylibSymbols>& dylib
         return;
     }
 
-    ma->forEachRebase(dylibDiag, false, ^(uint64_t runtimeOffset, bool &stop) {
-        uint8_t* fixupLoc = (uint8_t*)ma+runtimeOffset;
-        fixupLocs[fixupLoc] = (uint8_t)~0U;
+    ma->forEachRebaseBatch(dylibDiag, false, ^(const uint64_t runtimeOffsets[], uint32_t count, bool &stop) {
+        for (uint32_t i=0; i < count; ++i) {
+            uint8_t* fixupLoc = (uint8_t*)ma+runtimeOffsets[i];
+            fixupLocs[fixupLoc] = (uint8_t)~0U;
+        }
     });
 }
 
@@ -3784,6 +3996,13 @@ void AppCacheBuilder::writeFixups()
         uint64_t                        numPagesToFixup     = 0;
     };
 
+    // Chained fixups are built in two passes.  Laying out the header and starts of each image only
+    // allocates from the fixups buffer, and is done serially, in a fixed order, so the output is the
+    // same from one build to the next.  Encoding the chains checks every byte of every page against
+    // the ASLR tracker, and patches the pages, so is done afterwards, concurrently, in batches of pages.
+    // A chain never leaves its page, and the tracker is only read here, so pages can be done in any order.
+    __block std::vector<SegmentFixups> segmentsToEncode;
+
     auto buildChainedFixups = ^(uint64_t baseAddress, uint64_t segmentCount, std::vector<SegmentFixups>& startsInSegments) {
 
         const uint8_t* chainedFixupsBufferStart = nullptr;
@@ -3820,9 +4039,7 @@ void AppCacheBuilder::writeFixups()
             startsInImage->seg_info_offset[segmentIndex] = (uint32_t)((uint8_t*)startsInSegment - (uint8_t*)startsInImage);
         }
 
-        const unsigned chainedPointerStride = dyld3::MachOAnalyzer::ChainedFixupPointerOnDisk::strideSize(chainedPointerFormat);
-
-        // Starts in segment
+        // Starts in segment.  The page starts are filled in when the pages are encoded
         for (const SegmentFixups& segmentFixups : startsInSegments) {
             dyld_chained_starts_in_segment* startsInSegment = segmentFixups.starts;
             startsInSegment->size               = (uint32_t)segmentFixups.startsByteSize;
@@ -3831,69 +4048,7 @@ void AppCacheBuilder::writeFixups()
             startsInSegment->segment_offset     = segmentFixups.unslidLoadAddress - baseAddress;
             startsInSegment->max_valid_pointer  = 0; // FIXME: Needed in 32-bit only
             startsInSegment->page_count         = (segmentFixups.sizeInUse + startsInSegment->page_size - 1) / startsInSegment->page_size;
-            for (uint64_t pageIndex = 0; pageIndex != startsInSegment->page_count; ++pageIndex) {
-                startsInSegment->page_start[pageIndex] = DYLD_CHAINED_PTR_START_NONE;
-                uint8_t* lastLoc = nullptr;
-                // Note we always walk in 1-byte at a time as x86_64 has unaligned fixups
-                for (uint64_t pageOffset = 0; pageOffset != startsInSegment->page_size; pageOffset += 1) {
-                    uint8_t* fixupLoc = segmentFixups.segmentBuffer + (pageIndex * startsInSegment->page_size) + pageOffset;
-                    uint8_t fixupLevel = currentLevel;
-                    if ( !_aslrTracker.has(fixupLoc, &fixupLevel) )
-                        continue;
-                    assert((pageOffset % chainedPointerStride) == 0);
-                    if ( lastLoc ) {
-                        // Patch last loc to point here
-                        assert(_is64);
-                        dyld_chained_ptr_64_kernel_cache_rebase* lastLocBits = (dyld_chained_ptr_64_kernel_cache_rebase*)lastLoc;
-                        assert(lastLocBits->next == 0);
-                        uint64_t next = (fixupLoc - lastLoc) / chainedPointerStride;
-                        lastLocBits->next = next;
-                        assert(lastLocBits->next == next && "next location truncated");
-                    } else {
-                        // First fixup on this page
-                        startsInSegment->page_start[pageIndex] = pageOffset;
-                    }
-                    lastLoc = fixupLoc;
-
-                    uint64_t targetVMAddr = *(uint64_t*)fixupLoc;
-
-                    uint8_t highByte = 0;
-                    if ( _aslrTracker.hasHigh8(fixupLoc, &highByte) ) {
-                        uint64_t tbi = (uint64_t)highByte << 56;
-                        targetVMAddr |= tbi;
-                    }
-
-                    assert(fixupLevel < numFixupLevels);
-                    uint64_t targetVMOffset = targetVMAddr - levelBaseAddresses[fixupLevel];
-
-                    // Pack the vmAddr on this location in to the fixup format
-                    dyld_chained_ptr_64_kernel_cache_rebase* locBits = (dyld_chained_ptr_64_kernel_cache_rebase*)fixupLoc;
-
-                    uint16_t diversity;
-                    bool     hasAddrDiv;
-                    uint8_t  key;
-                    if ( _aslrTracker.hasAuthData(fixupLoc, &diversity, &hasAddrDiv, &key) ) {
-                        locBits->target         = targetVMOffset;
-                        locBits->cacheLevel     = fixupLevel;
-                        locBits->diversity      = diversity;
-                        locBits->addrDiv        = hasAddrDiv;
-                        locBits->key            = key;
-                        locBits->next           = 0;
-                        locBits->isAuth         = 1;
-                        assert(locBits->target == targetVMOffset && "target truncated");
-                    }
-                    else {
-                        locBits->target         = targetVMOffset;
-                        locBits->cacheLevel     = fixupLevel;
-                        locBits->diversity      = 0;
-                        locBits->addrDiv        = 0;
-                        locBits->key            = 0;
-                        locBits->next           = 0;
-                        locBits->isAuth         = 0;
-                        assert(locBits->target == targetVMOffset && "target truncated");
-                    }
-                }
-            }
+            segmentsToEncode.push_back(segmentFixups);
         }
 
         chainedFixupsBufferEnd = byteBuffer.begin();
@@ -3910,6 +4065,75 @@ void AppCacheBuilder::writeFixups()
         return std::make_pair(chainedFixupsBufferStart, chainedFixupsBufferEnd);
     };
 
+    const unsigned chainedPointerStride = dyld3::MachOAnalyzer::ChainedFixupPointerOnDisk::strideSize(chainedPointerFormat);
+
+    auto encodeChainedFixupPages = ^(const SegmentFixups& segmentFixups, uint64_t firstPage, uint64_t endPage) {
+        dyld_chained_starts_in_segment* startsInSegment = segmentFixups.starts;
+        for (uint64_t pageIndex = firstPage; pageIndex != endPage; ++pageIndex) {
+            startsInSegment->page_start[pageIndex] = DYLD_CHAINED_PTR_START_NONE;
+            uint8_t* lastLoc = nullptr;
+            // Note we always walk in 1-byte at a time as x86_64 has unaligned fixups
+            for (uint64_t pageOffset = 0; pageOffset != startsInSegment->page_size; pageOffset += 1) {
+                uint8_t* fixupLoc = segmentFixups.segmentBuffer + (pageIndex * startsInSegment->page_size) + pageOffset;
+                uint8_t fixupLevel = currentLevel;
+                if ( !_aslrTracker.has(fixupLoc, &fixupLevel) )
+                    continue;
+                assert((pageOffset % chainedPointerStride) == 0);
+                if ( lastLoc ) {
+                    // Patch last loc to point here
+                    assert(_is64);
+                    dyld_chained_ptr_64_kernel_cache_rebase* lastLocBits = (dyld_chained_ptr_64_kernel_cache_rebase*)lastLoc;
+                    assert(lastLocBits->next == 0);
+                    uint64_t next = (fixupLoc - lastLoc) / chainedPointerStride;
+                    lastLocBits->next = next;
+                    assert(lastLocBits->next == next && "next location truncated");
+                } else {
+                    // First fixup on this page
+                    startsInSegment->page_start[pageIndex] = pageOffset;
+                }
+                lastLoc = fixupLoc;
+
+                uint64_t targetVMAddr = *(uint64_t*)fixupLoc;
+
+                uint8_t highByte = 0;
+                if ( _aslrTracker.hasHigh8(fixupLoc, &highByte) ) {
+                    uint64_t tbi = (uint64_t)highByte << 56;
+                    targetVMAddr |= tbi;
+                }
+
+                assert(fixupLevel < numFixupLevels);
+                uint64_t targetVMOffset = targetVMAddr - levelBaseAddresses[fixupLevel];
+
+                // Pack the vmAddr on this location in to the fixup format
+                dyld_chained_ptr_64_kernel_cache_rebase* locBits = (dyld_chained_ptr_64_kernel_cache_rebase*)fixupLoc;
+
+                uint16_t diversity;
+                bool     hasAddrDiv;
+                uint8_t  key;
+                if ( _aslrTracker.hasAuthData(fixupLoc, &diversity, &hasAddrDiv, &key) ) {
+                    locBits->target         = targetVMOffset;
+                    locBits->cacheLevel     = fixupLevel;
+                    locBits->diversity      = diversity;
+                    locBits->addrDiv        = hasAddrDiv;
+                    locBits->key            = key;
+                    locBits->next           = 0;
+                    locBits->isAuth         = 1;
+                    assert(locBits->target == targetVMOffset && "target truncated");
+                }
+                else {
+                    locBits->target         = targetVMOffset;
+                    locBits->cacheLevel     = fixupLevel;
+                    locBits->diversity      = 0;
+                    locBits->addrDiv        = 0;
+                    locBits->key            = 0;
+                    locBits->next           = 0;
+                    locBits->isAuth         = 0;
+                    assert(locBits->target == targetVMOffset && "target truncated");
+                }
+            }
+        }
+    };
+
     if ( fixupsArePerKext() ) {
         // The pageableKC (and sometimes auxKC) has one LC_DYLD_CHAINED_FIXUPS per kext, not 1 total
         forEachCacheDylib(^(const dyld3::MachOAnalyzer *ma, const std::string &dylibID,
@@ -4053,6 +4277,26 @@ void AppCacheBuilder::writeFixups()
         }
     }
 
+    // Encode the pages of every segment laid out above.  Batches are small enough that a few large
+    // kexts, or the kernel's own __DATA, are spread over all the workers
+    struct PageBatch {
+        size_t      segmentIndex;
+        uint64_t    firstPage;
+        uint64_t    endPage;
+    };
+    const uint64_t kPagesPerBatch = 16;
+    std::vector<PageBatch> pageBatches;
+    for (size_t segmentIndex = 0; segmentIndex != segmentsToEncode.size(); ++segmentIndex) {
+        uint64_t pageCount = segmentsToEncode[segmentIndex].starts->page_count;
+        for (uint64_t firstPage = 0; firstPage < pageCount; firstPage += kPagesPerBatch)
+            pageBatches.push_back({ segmentIndex, firstPage, std::min(firstPage + kPagesPerBatch, pageCount) });
+    }
+    const PageBatch* pageBatchesBase = pageBatches.data();
+    dispatch_apply(pageBatches.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+        const PageBatch& batch = pageBatchesBase[index];
+        encodeChainedFixupPages(segmentsToEncode[batch.segmentIndex], batch.firstPage, batch.endPage);
+    });
+
     // Move the fixups to the end of __LINKEDIT
     if ( classicRelocsBufferStart != classicRelocsBufferEnd ) {
         uint64_t fixupsOffset = (uint64_t)classicRelocsBufferStart - (uint64_t)fixupsSubRegion.buffer;
@@ -4135,7 +4379,7 @@ void AppCacheBuilder::allocateBuffer()
         // Add a section too
         sectionsToAddToRegions[&hibernateRegion] = 1;
     } else if ( dataRegionFirstInVMOrder ) {
-        if ( prelinkInfoDict != nullptr ) {
+        if ( hasPrelinkInfo() ) {
             numRegionVMBytes = align(numRegionVMBytes, 14);
             regionsVMOrder.push_back({ &prelinkInfoRegion, numRegionVMBytes });
             numRegionVMBytes += prelinkInfoRegion.bufferSize;
@@ -4246,7 +4490,7 @@ void AppCacheBuilder::allocateBuffer()
     // __PRELINK_INFO
     // Align to 16k
     numRegionFileBytes = align(numRegionFileBytes, 14);
-    if ( prelinkInfoDict != nullptr )
+    if ( hasPrelinkInfo() )
     {
         // File offset
         prelinkInfoRegion.cacheFileOffset = numRegionFileBytes;
@@ -4793,7 +5037,7 @@ void AppCacheBuilder::generateCacheHeader() {
 }
 
 void AppCacheBuilder::generatePrelinkInfo() {
-    if ( prelinkInfoDict == nullptr ) {
+    if ( !hasPrelinkInfo() ) {
         // The kernel doesn't need a prelink dictionary just for itself
         bool needsPrelink = true;
         if ( appCacheOptions.cacheKind == Options::AppCacheKind::kernel ) {
@@ -4806,13 +5050,6 @@ void AppCacheBuilder::generatePrelinkInfo() {
         return;
     }
 
-    CFMutableArrayRef arrayRef = (CFMutableArrayRef)CFDictionaryGetValue(prelinkInfoDict,
-                                                                         CFSTR("_PrelinkInfoDictionary"));
-    if ( arrayRef == nullptr ) {
-        _diagnostics.error("Expected prelink info dictionary array");
-        return;
-    }
-
     typedef std::pair<const dyld3::MachOAnalyzer*, Diagnostics*> DylibAndDiag;
     __block std::unordered_map<std::string_view, DylibAndDiag> dylibs;
     forEachCacheDylib(^(const dyld3::MachOAnalyzer *ma, const std::string &dylibID,
@@ -4824,6 +5061,50 @@ void AppCacheBuilder::generatePrelinkInfo() {
         dylibs[dylib.dylibID] = { nullptr, nullptr };
     }
 
+    if ( appCacheOptions.binaryPrelinkInfo ) {
+        bool badKext = false;
+        for (const BinaryPrelinkInfoKext& kext : binaryPrelinkInfoKexts) {
+            auto dylibIt = dylibs.find(kext.bundleID);
+            if ( dylibIt == dylibs.end() ) {
+                _diagnostics.error("Cannot get dylib for bundle ID %s", kext.bundleID.data());
+                return;
+            }
+            const dyld3::MachOAnalyzer *ma = dylibIt->second.first;
+            Diagnostics* dylibDiag = dylibIt->second.second;
+            uint64_t loadAddress = ma->preferredLoadAddress();
+
+            // _PrelinkExecutableLoadAddr and _PrelinkExecutableSourceAddr
+            binaryPrelinkInfo.patchNumber(kext.loadAddrOffset, loadAddress);
+            binaryPrelinkInfo.patchNumber(kext.sourceAddrOffset, loadAddress);
+
+            // _PrelinkKmodInfo
+            uint64_t kmodInfoAddress = 0;
+            if ( (kext.kmodInfoOffset != 0) && findKmodInfo(_diagnostics, ma, kmodInfoAddress) ) {
+                binaryPrelinkInfo.patchNumber(kext.kmodInfoOffset, kmodInfoAddress);
+                assert(_is64);
+                if ( !updateKmodInfo(ma, kmodInfoAddress, *dylibDiag) )
+                    badKext = true;
+            }
+        }
+
+        // Everything was laid out with its final size, so this always fits
+        const std::vector<uint8_t>& bytes = binaryPrelinkInfo.bytes();
+        assert(bytes.size() <= prelinkInfoRegion.bufferSize);
+        memcpy(prelinkInfoRegion.buffer, bytes.data(), bytes.size());
+
+        if ( badKext && _diagnostics.noError() ) {
+            _diagnostics.error("One or more binaries has an error which prevented linking.  See other errors.");
+        }
+        return;
+    }
+
+    CFMutableArrayRef arrayRef = (CFMutableArrayRef)CFDictionaryGetValue(prelinkInfoDict,
+                                                                         CFSTR("_PrelinkInfoDictionary"));
+    if ( arrayRef == nullptr ) {
+        _diagnostics.error("Expected prelink info dictionary array");
+        return;
+    }
+
     __block std::list<std::string> nonASCIIStrings;
     auto getString = ^(Diagnostics& diags, CFStringRef symbolNameRef) {
         const char* symbolName = CFStringGetCStringPtr(symbolNameRef, kCFStringEncodingUTF8);
@@ -4879,54 +5160,18 @@ void AppCacheBuilder::generatePrelinkInfo() {
         CFRelease(sourceAddrRef);
 
         // _PrelinkKmodInfo
-        __block uint64_t kmodInfoAddress = 0;
-
-        // Check for a global first
-        __block bool found = false;
-        {
-            dyld3::MachOAnalyzer::FoundSymbol foundInfo;
-            found = ma->findExportedSymbol(_diagnostics, "_kmod_info", true, foundInfo, nullptr);
-            if ( found ) {
-                kmodInfoAddress = loadAddress + foundInfo.value;
-            }
-        }
-        // And fall back to a local if we need to
-        if ( !found ) {
-            ma->forEachLocalSymbol(_diagnostics, ^(const char* aSymbolName, uint64_t n_value, uint8_t n_type,
-                                                   uint8_t n_sect, uint16_t n_desc, bool& stop) {
-                if ( strcmp(aSymbolName, "_kmod_info") == 0 ) {
-                    kmodInfoAddress = n_value;
-                    found = true;
-                    stop = true;
-                }
-            });
-        }
-
-        if ( found ) {
+        uint64_t kmodInfoAddress = 0;
+        if ( findKmodInfo(_diagnostics, ma, kmodInfoAddress) ) {
             CFNumberRef kmodInfoAddrRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberLongLongType, &kmodInfoAddress);
             CFDictionarySetValue(dictRef, CFSTR("_PrelinkKmodInfo"), kmodInfoAddrRef);
             CFRelease(kmodInfoAddrRef);
 
             // Since we have a reference to the kmod info anyway, set its address field to the correct value
             assert(_is64);
-            uint64_t kmodInfoVMOffset = kmodInfoAddress - loadAddress;
-            dyld3::MachOAppCache::KModInfo64_v1* kmodInfo = (dyld3::MachOAppCache::KModInfo64_v1*)((uint8_t*)ma + kmodInfoVMOffset);
-            if ( kmodInfo->info_version != 1 ) {
-                dylibDiag->error("unsupported kmod_info version of %d", kmodInfo->info_version);
+            if ( !updateKmodInfo(ma, kmodInfoAddress, *dylibDiag) ) {
                 badKext = true;
                 continue;
             }
-            __block uint64_t textSegmnentVMAddr = 0;
-            __block uint64_t textSegmnentVMSize = 0;
-            ma->forEachSegment(^(const dyld3::MachOAnalyzer::SegmentInfo &info, bool &stop) {
-                if ( !strcmp(info.segName, "__TEXT") ) {
-                    textSegmnentVMAddr = info.vmAddr;
-                    textSegmnentVMSize = info.vmSize;
-                    stop = true;
-                }
-            });
-            kmodInfo->address   = textSegmnentVMAddr;
-            kmodInfo->size      = textSegmnentVMSize;
         }
     }
 
@@ -5359,7 +5604,9 @@ void AppCacheBuilder::generateUUID() {
         return;
 
     // Update the prelink info dictionary too
-    if ( prelinkInfoDict != nullptr ) {
+    if ( appCacheOptions.binaryPrelinkInfo ) {
+        memcpy((uint8_t*)prelinkInfoRegion.buffer + binaryPrelinkInfoKCIDOffset, &cacheHeader.uuid->uuid[0], sizeof(cacheHeader.uuid->uuid));
+    } else if ( prelinkInfoDict != nullptr ) {
         CFDataRef dataRef = CFDataCreate(kCFAllocatorDefault, &cacheHeader.uuid->uuid[0], sizeof(cacheHeader.uuid->uuid));
         CFDictionarySetValue(prelinkInfoDict, CFSTR("_PrelinkKCID"), dataRef);
         CFRelease(dataRef);
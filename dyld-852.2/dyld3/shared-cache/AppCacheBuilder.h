@@ -27,6 +27,7 @@
 #include "CacheBuilder.h"
 #include "MachOFileAbstraction.hpp"
 #include "MachOAppCache.h"
+#include "OSSerializeBinary.h"
 
 #include <list>
 
@@ -51,6 +52,8 @@ public:
 
         AppCacheKind    cacheKind = AppCacheKind::none;
         StripMode       stripMode = StripMode::none;
+        // Emit __PRELINK_INFO in the OSSerializeBinary format instead of XML
+        bool            binaryPrelinkInfo = false;
     };
     AppCacheBuilder(const DyldSharedCache::CreateOptions& dyldCacheOptions, const Options& appCacheOptions,
                     const dyld3::closure::FileSystem& fileSystem);
@@ -130,7 +133,9 @@ private:
     void                                copyRawSegments();
     void                                assignSegmentAddresses();
     void                                generateCacheHeader();
+    void                                buildBinaryPrelinkInfo();
     void                                generatePrelinkInfo();
+    bool                                hasPrelinkInfo() const;
     uint32_t                            getCurrentFixupLevel() const;
     void                                processFixups();
     void                                writeFixups();
@@ -176,6 +181,18 @@ private:
     // The dictionary we ultimately store in the __PRELINK_INFO region
     CFMutableDictionaryRef              prelinkInfoDict = nullptr;
 
+    // With Options::binaryPrelinkInfo, the __PRELINK_INFO is written directly instead of via prelinkInfoDict.
+    // The numbers which depend on the final layout are placeholders, patched in place once it is known
+    struct BinaryPrelinkInfoKext {
+        std::string_view                    bundleID;
+        size_t                              loadAddrOffset      = 0;
+        size_t                              sourceAddrOffset    = 0;
+        size_t                              kmodInfoOffset      = 0;    // 0 if the kext has no kmod_info
+    };
+    dyld3::OSSerializeBinaryWriter      binaryPrelinkInfo;
+    std::vector<BinaryPrelinkInfoKext>  binaryPrelinkInfoKexts;
+    size_t                              binaryPrelinkInfoKCIDOffset = 0;
+
     // Cache header fields
     // FIXME: 32-bit
 
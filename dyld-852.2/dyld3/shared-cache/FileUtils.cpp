@@ -36,10 +36,14 @@
 #include <sys/mount.h>
 #include <sys/mman.h>
 #include <dispatch/dispatch.h>
+#include <os/lock.h>
 #include <mach-o/dyld.h>
 #include <System/sys/csr.h>
 #include <rootless.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -91,6 +95,126 @@ void iterateDirectoryTree(const std::string& pathPrefix, const std::string& path
 }
 
 
+namespace {
+
+// Each worker reads directories off the back of its own queue, so it mostly walks depth first through
+// directories it just found.  A worker whose queue is empty steals from the front of another's, which
+// is where the shallowest, and so probably largest, unread subtrees are.
+struct CrawlWorker
+{
+    os_unfair_lock              lock = OS_UNFAIR_LOCK_INIT;
+    std::deque<std::string>     directories;
+};
+
+} // anonymous namespace
+
+static bool takeDirectory(CrawlWorker workers[], size_t workerCount, size_t workerIndex, std::string& dirPath)
+{
+    CrawlWorker& self = workers[workerIndex];
+    os_unfair_lock_lock(&self.lock);
+    bool found = !self.directories.empty();
+    if ( found ) {
+        dirPath = std::move(self.directories.back());
+        self.directories.pop_back();
+    }
+    os_unfair_lock_unlock(&self.lock);
+    for (size_t i=1; !found && (i < workerCount); ++i) {
+        CrawlWorker& victim = workers[(workerIndex + i) % workerCount];
+        os_unfair_lock_lock(&victim.lock);
+        found = !victim.directories.empty();
+        if ( found ) {
+            dirPath = std::move(victim.directories.front());
+            victim.directories.pop_front();
+        }
+        os_unfair_lock_unlock(&victim.lock);
+    }
+    return found;
+}
+
+static void crawlDirectory(const std::string& pathPrefix, const std::string& dirPath, bool (^dirFilter)(const std::string& dirPath),
+                           void (^callback)(const std::string& path, const struct stat& statBuf),
+                           CrawlWorker& self, std::atomic<size_t>& pendingCount)
+{
+    std::string fullDirPath = pathPrefix + dirPath;
+    int dirFd = ::open(fullDirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if ( dirFd == -1 )
+        return;
+    DIR* dir = ::fdopendir(dirFd);
+    if ( dir == nullptr ) {
+        ::close(dirFd);
+        return;
+    }
+    const std::string dirPrefix = dirPath + (dirPath.back() != '/' ? "/" : "");
+    while (dirent* entry = ::readdir(dir)) {
+        // files are stat()ed relative to the directory, so the kernel does not walk the whole path again
+        struct stat statBuf;
+        bool        haveStat = false;
+        uint8_t     type     = entry->d_type;
+        if ( type == DT_UNKNOWN ) {
+            // some network file systems do not fill in d_type
+            if ( ::fstatat(dirFd, entry->d_name, &statBuf, AT_SYMLINK_NOFOLLOW) == -1 )
+                continue;
+            haveStat = true;
+            type     = IFTODT(statBuf.st_mode);
+        }
+        switch ( type ) {
+            case DT_REG:
+                if ( !haveStat && (::fstatat(dirFd, entry->d_name, &statBuf, AT_SYMLINK_NOFOLLOW) == -1) )
+                    break;
+                if ( ! S_ISREG(statBuf.st_mode) )
+                    break;
+                callback(dirPrefix + entry->d_name, statBuf);
+                break;
+            case DT_DIR: {
+                if ( strcmp(entry->d_name, ".") == 0 )
+                    break;
+                if ( strcmp(entry->d_name, "..") == 0 )
+                    break;
+                std::string subDirPath = dirPrefix + entry->d_name;
+                if ( dirFilter(subDirPath) )
+                    break;
+                pendingCount.fetch_add(1, std::memory_order_relaxed);
+                os_unfair_lock_lock(&self.lock);
+                self.directories.push_back(std::move(subDirPath));
+                os_unfair_lock_unlock(&self.lock);
+                break;
+            }
+            case DT_LNK:
+                // don't follow symlinks, dylib will be found through absolute path
+                break;
+        }
+    }
+    ::closedir(dir);
+}
+
+void iterateDirectoryTreeConcurrently(const std::string& pathPrefix, const std::string& path, bool (^dirFilter)(const std::string& dirPath),
+                                      void (^callback)(const std::string& path, const struct stat& statBuf))
+{
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t workerCount = (size_t)std::max(cpuCount, 1L);
+    std::vector<CrawlWorker> workers(workerCount);
+    CrawlWorker* workersBase = workers.data();
+    workers[0].directories.push_back(path);
+
+    // directories queued or being read.  Once it is zero, no worker can find any more
+    std::atomic<size_t> pendingCount(1);
+    std::atomic<size_t>* pendingCountPtr = &pendingCount;
+
+    dispatch_apply(workerCount, DISPATCH_APPLY_AUTO, ^(size_t workerIndex) {
+        std::string dirPath;
+        while ( pendingCountPtr->load(std::memory_order_acquire) != 0 ) {
+            if ( !takeDirectory(workersBase, workerCount, workerIndex, dirPath) ) {
+                // the other workers are still reading directories, which may have subdirectories
+                usleep(100);
+                continue;
+            }
+            crawlDirectory(pathPrefix, dirPath, dirFilter, callback, workersBase[workerIndex], *pendingCountPtr);
+            pendingCountPtr->fetch_sub(1, std::memory_order_acq_rel);
+        }
+    });
+}
+
+
 bool safeSave(const void* buffer, size_t bufferLen, const std::string& path)
 {
     std::string pathTemplate = path + "-XXXXXX";
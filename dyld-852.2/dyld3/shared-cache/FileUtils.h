@@ -64,6 +64,15 @@ extern FileCache fileCache;
 void iterateDirectoryTree(const std::string& pathPrefix, const std::string& path, bool (^dirFilter)(const std::string& dirPath),
                           void (^callback)(const std::string& path, const struct stat& statBuf), bool processFiles=true, bool recurse=true);
 
+//
+// like iterateDirectoryTree(), but directories are read by one worker per cpu, which steal
+// unread directories from each other.  The callback is called on each file as soon as it is
+// found, so that work on it overlaps with the rest of the walk.  dirFilter and callback are
+// called concurrently on many threads, and files are found in no particular order
+//
+void iterateDirectoryTreeConcurrently(const std::string& pathPrefix, const std::string& path, bool (^dirFilter)(const std::string& dirPath),
+                                      void (^callback)(const std::string& path, const struct stat& statBuf));
+
 
 //
 // writes the buffer to a temp file, then renames the file to the final path
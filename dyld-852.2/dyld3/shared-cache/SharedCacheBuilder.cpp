@@ -35,6 +35,7 @@
 #include <mach/shared_region.h>
 #include <apfs/apfs_fsctl.h>
 #include <iostream>
+#include <atomic>
 
 #include <CommonCrypto/CommonHMAC.h>
 #include <CommonCrypto/CommonDigest.h>
@@ -2717,35 +2718,59 @@ void SharedCacheBuilder::addClosures(const std::vector<LoadedMachO>& osExecutabl
     osExecutablesDiags.resize(osExecutables.size());
     osExecutablesClosures.resize(osExecutables.size());
 
-    dispatch_apply(osExecutables.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
-        const LoadedMachO& loadedMachO = osExecutables[index];
-        // don't pre-build closures for staged apps into dyld cache, since they won't run from that location
-        if ( startsWith(loadedMachO.mappedFile.runtimePath, "/private/var/staged_system_apps/") ) {
-            return;
-        }
+    // Each worker has its own arena for the temporary image writers, and its own list of warnings,
+    // so workers share nothing while building closures.  Warnings are merged once all are done.
+    struct ClosureWorker
+    {
+        dyld3::closure::WriterArena arena;
+        std::vector<std::string>    warnings;
+    };
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t workerCount = std::min(osExecutables.size(), (size_t)std::max(cpuCount, 1L));
+    std::vector<ClosureWorker> workers(workerCount);
+    ClosureWorker* workersBase = workers.data();
+    std::atomic<size_t> nextExecutableIndex(0);
+    std::atomic<size_t>* nextExecutableIndexPtr = &nextExecutableIndex;
+
+    dispatch_apply(workerCount, DISPATCH_APPLY_AUTO, ^(size_t workerIndex) {
+        ClosureWorker& worker = workersBase[workerIndex];
+        for (size_t index = (*nextExecutableIndexPtr)++; index < osExecutables.size(); index = (*nextExecutableIndexPtr)++) {
+            const LoadedMachO& loadedMachO = osExecutables[index];
+            // don't pre-build closures for staged apps into dyld cache, since they won't run from that location
+            if ( startsWith(loadedMachO.mappedFile.runtimePath, "/private/var/staged_system_apps/") ) {
+                continue;
+            }
 
-        // prebuilt closures use the cdhash of the dylib to verify that the dylib is still the same
-        // at runtime as when the shared cache processed it.  We must have a code signature to record this information
-        uint32_t codeSigFileOffset;
-        uint32_t codeSigSize;
-        if ( !loadedMachO.mappedFile.mh->hasCodeSignature(codeSigFileOffset, codeSigSize) ) {
-            return;
-        }
+            // prebuilt closures use the cdhash of the dylib to verify that the dylib is still the same
+            // at runtime as when the shared cache processed it.  We must have a code signature to record this information
+            uint32_t codeSigFileOffset;
+            uint32_t codeSigSize;
+            if ( !loadedMachO.mappedFile.mh->hasCodeSignature(codeSigFileOffset, codeSigSize) ) {
+                continue;
+            }
 
-        dyld3::closure::PathOverrides pathOverrides;
-        dyld3::RootsChecker rootsChecker;
-        dyld3::closure::ClosureBuilder builder(dyld3::closure::kFirstLaunchClosureImageNum, _fileSystem, rootsChecker, dyldCache, false, *_options.archs, pathOverrides,
-                                               dyld3::closure::ClosureBuilder::AtPath::all, false, nullptr, _options.platform, nullptr);
-        bool issetuid = false;
-        if ( this->_options.platform == dyld3::Platform::macOS || dyld3::MachOFile::isSimulatorPlatform(this->_options.platform) )
-            _fileSystem.fileExists(loadedMachO.loadedFileInfo.path, nullptr, nullptr, &issetuid, nullptr);
-        const dyld3::closure::LaunchClosure* mainClosure = builder.makeLaunchClosure(loadedMachO.loadedFileInfo, issetuid);
-        if ( builder.diagnostics().hasError() ) {
-           osExecutablesDiags[index].error("%s", builder.diagnostics().errorMessage().c_str());
-        }
-        else {
-            assert(mainClosure != nullptr);
-            osExecutablesClosures[index] = mainClosure;
+            dyld3::closure::PathOverrides pathOverrides;
+            dyld3::RootsChecker rootsChecker;
+            dyld3::closure::ClosureBuilder builder(dyld3::closure::kFirstLaunchClosureImageNum, _fileSystem, rootsChecker, dyldCache, false, *_options.archs, pathOverrides,
+                                                   dyld3::closure::ClosureBuilder::AtPath::all, false, nullptr, _options.platform, nullptr);
+            builder.setWriterArena(&worker.arena);
+            bool issetuid = false;
+            if ( this->_options.platform == dyld3::Platform::macOS || dyld3::MachOFile::isSimulatorPlatform(this->_options.platform) )
+                _fileSystem.fileExists(loadedMachO.loadedFileInfo.path, nullptr, nullptr, &issetuid, nullptr);
+            const dyld3::closure::LaunchClosure* mainClosure = builder.makeLaunchClosure(loadedMachO.loadedFileInfo, issetuid);
+            if ( builder.diagnostics().hasError() ) {
+               osExecutablesDiags[index].error("%s", builder.diagnostics().errorMessage().c_str());
+               if ( _options.verbose ) {
+                   for (const std::string& warn : builder.diagnostics().warnings() )
+                       worker.warnings.push_back(loadedMachO.mappedFile.runtimePath + ": " + warn);
+               }
+            }
+            else {
+                assert(mainClosure != nullptr);
+                osExecutablesClosures[index] = mainClosure;
+            }
+            // the closure was copied out of the arena, so its scratch space can be reused for the next one
+            worker.arena.reset();
         }
     });
 
@@ -2756,8 +2781,6 @@ void SharedCacheBuilder::addClosures(const std::vector<LoadedMachO>& osExecutabl
         if (diag.hasError()) {
             if ( _options.verbose ) {
                 _diagnostics.warning("building closure for '%s': %s", loadedMachO.mappedFile.runtimePath.c_str(), diag.errorMessage().c_str());
-                for (const std::string& warn : diag.warnings() )
-                    _diagnostics.warning("%s", warn.c_str());
             }
             if ( loadedMachO.inputFile && (loadedMachO.inputFile->mustBeIncluded()) ) {
                 loadedMachO.inputFile->diag.error("%s", diag.errorMessage().c_str());
@@ -2768,6 +2791,10 @@ void SharedCacheBuilder::addClosures(const std::vector<LoadedMachO>& osExecutabl
                 closures[loadedMachO.mappedFile.runtimePath] = osExecutablesClosures[i];
         }
     }
+    for (const ClosureWorker& worker : workers) {
+        for (const std::string& warn : worker.warnings)
+            _diagnostics.warning("%s", warn.c_str());
+    }
 
     osExecutablesDiags.clear();
     osExecutablesClosures.clear();
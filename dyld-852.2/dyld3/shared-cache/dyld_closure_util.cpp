@@ -37,8 +37,10 @@
 #include <mach-o/dyld_priv.h>
 #include <bootstrap.h>
 #include <mach/mach.h>
+#include <mach/mach_time.h>
 #include <dispatch/dispatch.h>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -104,6 +106,183 @@ static const DyldSharedCache* mapCacheFile(const char* path)
     return (DyldSharedCache*)result;
 }
 
+// quick check of first page, so building closures is only attempted for likely main executables
+static bool mightBeMainExecutable(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if ( fd == -1 )
+        return false;
+    uint8_t firstPage[4096];
+    ssize_t amount = ::pread(fd, firstPage, sizeof(firstPage), 0);
+    ::close(fd);
+    if ( amount < (ssize_t)sizeof(mach_header_64) )
+        return false;
+    if ( dyld3::FatFile::isFatFile(firstPage) )
+        return true;
+    const dyld3::MachOFile* mf = (dyld3::MachOFile*)firstPage;
+    return mf->hasMachOMagic() && mf->isMainExecutable();
+}
+
+// compares the size and decode time of the compact fixup patterns in a closure with the fixed width form they replace
+static void printFixupEncodingStats(const dyld3::closure::ImageArray* images)
+{
+    __block uint64_t compactSize     = 0;
+    __block uint64_t fixedWidthSize  = 0;
+    __block std::vector<Image::RebasePattern> rebasePatterns;
+    __block std::vector<Image::BindPattern>   bindPatterns;
+    images->forEachImage(^(const Image* image, bool& stop) {
+        image->forEachAttribute(^(const dyld3::closure::TypedBytes* typedBytes, bool& stopAttr) {
+            if ( (typedBytes->type == dyld3::closure::TypedBytes::Type::compactRebaseFixups)
+                || (typedBytes->type == dyld3::closure::TypedBytes::Type::compactBindFixups) )
+                compactSize += sizeof(dyld3::closure::TypedBytes) + typedBytes->payloadLength;
+        });
+        size_t rebaseCount = rebasePatterns.size();
+        size_t bindCount   = bindPatterns.size();
+        image->forEachRebasePattern(^(const Image::RebasePattern& pattern, bool& stopPatterns) {
+            rebasePatterns.push_back(pattern);
+        });
+        image->forEachBindPattern(^(const Image::BindPattern& pattern, bool& stopPatterns) {
+            bindPatterns.push_back(pattern);
+        });
+        fixedWidthSize += 2*sizeof(dyld3::closure::TypedBytes) + (rebasePatterns.size() - rebaseCount) * sizeof(Image::RebasePattern)
+                                                               + (bindPatterns.size() - bindCount) * sizeof(Image::BindPattern);
+    });
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    __block uint64_t compactChecksum = 0;
+    uint64_t t1 = mach_absolute_time();
+    images->forEachImage(^(const Image* image, bool& stop) {
+        image->forEachRebasePattern(^(const Image::RebasePattern& pattern, bool& stopPatterns) {
+            compactChecksum += pattern.repeatCount + pattern.contigCount + pattern.skipCount;
+        });
+        image->forEachBindPattern(^(const Image::BindPattern& pattern, bool& stopPatterns) {
+            compactChecksum += pattern.target.raw + pattern.startVmOffset + pattern.repeatCount + pattern.skipCount;
+        });
+    });
+    uint64_t t2 = mach_absolute_time();
+    uint64_t fixedWidthChecksum = 0;
+    for (const Image::RebasePattern& pattern : rebasePatterns)
+        fixedWidthChecksum += pattern.repeatCount + pattern.contigCount + pattern.skipCount;
+    for (const Image::BindPattern& pattern : bindPatterns)
+        fixedWidthChecksum += pattern.target.raw + pattern.startVmOffset + pattern.repeatCount + pattern.skipCount;
+    uint64_t t3 = mach_absolute_time();
+
+    fprintf(stderr, "rebase patterns:   %lu\n", rebasePatterns.size());
+    fprintf(stderr, "bind patterns:     %lu\n", bindPatterns.size());
+    fprintf(stderr, "fixed width size:  %llu bytes\n", fixedWidthSize);
+    fprintf(stderr, "compact size:      %llu bytes\n", compactSize);
+    fprintf(stderr, "compact decode:    %lluus\n", (t2 - t1) * timebase.numer / timebase.denom / 1000);
+    fprintf(stderr, "fixed width walk:  %lluus\n", (t3 - t2) * timebase.numer / timebase.denom / 1000);
+    if ( compactChecksum != fixedWidthChecksum )
+        fprintf(stderr, "error: compact and fixed width patterns differ\n");
+}
+
+// compares the per-fixup rebase and bind decoders with the batched ones, over the images a closure loads from disk
+static void printFixupDecodeStats(const std::vector<dyld3::closure::LoadedFileInfo>& diskImages)
+{
+    std::vector<const dyld3::MachOAnalyzer*> images;
+    for (const dyld3::closure::LoadedFileInfo& info : diskImages)
+        images.push_back((const dyld3::MachOAnalyzer*)info.fileContent);
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    __block uint64_t rebaseCount      = 0;
+    __block uint64_t batchRebaseCount = 0;
+    __block uint64_t bindCount        = 0;
+    __block uint64_t batchBindCount   = 0;
+    uint64_t t1 = mach_absolute_time();
+    for (const dyld3::MachOAnalyzer* ma : images) {
+        Diagnostics diag;
+        ma->forEachRebase(diag, false, ^(uint64_t runtimeOffset, bool& stop) {
+            ++rebaseCount;
+        });
+    }
+    uint64_t t2 = mach_absolute_time();
+    for (const dyld3::MachOAnalyzer* ma : images) {
+        Diagnostics diag;
+        ma->forEachRebaseBatch(diag, false, ^(const uint64_t runtimeOffsets[], uint32_t count, bool& stop) {
+            batchRebaseCount += count;
+        });
+    }
+    uint64_t t3 = mach_absolute_time();
+    for (const dyld3::MachOAnalyzer* ma : images) {
+        Diagnostics diag;
+        ma->forEachBind(diag, ^(uint64_t runtimeOffset, int libOrdinal, uint8_t type, const char* symbolName,
+                                bool weakImport, bool lazyBind, uint64_t addend, bool& stop) {
+            ++bindCount;
+        }, ^(const char* symbolName) {
+        });
+    }
+    uint64_t t4 = mach_absolute_time();
+    for (const dyld3::MachOAnalyzer* ma : images) {
+        Diagnostics diag;
+        ma->forEachBindBatch(diag, ^(const dyld3::MachOAnalyzer::PackedBind binds[], uint32_t count,
+                                     const dyld3::MachOAnalyzer::BindTarget targets[], uint32_t targetCount, bool& stop) {
+            batchBindCount += count;
+        });
+    }
+    uint64_t t5 = mach_absolute_time();
+
+    uint64_t rebaseNanos      = (t2 - t1) * timebase.numer / timebase.denom;
+    uint64_t batchRebaseNanos = (t3 - t2) * timebase.numer / timebase.denom;
+    uint64_t bindNanos        = (t4 - t3) * timebase.numer / timebase.denom;
+    uint64_t batchBindNanos   = (t5 - t4) * timebase.numer / timebase.denom;
+    fprintf(stderr, "images:              %lu\n", images.size());
+    fprintf(stderr, "rebases:             %llu\n", rebaseCount);
+    fprintf(stderr, "binds:               %llu\n", bindCount);
+    fprintf(stderr, "per-fixup rebases:   %lluus (%lluns per rebase)\n", rebaseNanos / 1000, rebaseNanos / std::max(rebaseCount, 1ULL));
+    fprintf(stderr, "batched rebases:     %lluus (%lluns per rebase)\n", batchRebaseNanos / 1000, batchRebaseNanos / std::max(batchRebaseCount, 1ULL));
+    fprintf(stderr, "per-fixup binds:     %lluus (%lluns per bind)\n", bindNanos / 1000, bindNanos / std::max(bindCount, 1ULL));
+    fprintf(stderr, "batched binds:       %lluus (%lluns per bind)\n", batchBindNanos / 1000, batchBindNanos / std::max(batchBindCount, 1ULL));
+    if ( (rebaseCount != batchRebaseCount) || (bindCount != batchBindCount) )
+        fprintf(stderr, "error: per-fixup and batched decoders found different fixups\n");
+}
+
+// times mach-o validation, as done by MachOAnalyzer::load(), over the images a closure loads from disk
+static void printValidationStats(const std::vector<dyld3::closure::LoadedFileInfo>& diskImages, const dyld3::GradedArchs& archs, dyld3::Platform platform)
+{
+    // each validation takes microseconds, so repeat it enough to measure
+    const unsigned kRepeatCount = 100;
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    __block uint64_t segmentCount = 0;
+    uint64_t         failures     = 0;
+    uint64_t         machoTime    = 0;
+    uint64_t         linkeditTime = 0;
+    for (const dyld3::closure::LoadedFileInfo& info : diskImages) {
+        const dyld3::MachOAnalyzer* ma = (const dyld3::MachOAnalyzer*)info.fileContent;
+        ma->forEachSegment(^(const dyld3::MachOAnalyzer::SegmentInfo& segInfo, bool& stop) {
+            ++segmentCount;
+        });
+        uint64_t t1 = mach_absolute_time();
+        for (unsigned i=0; i < kRepeatCount; ++i) {
+            Diagnostics diag;
+            if ( !ma->validMachOForArchAndPlatform(diag, (size_t)info.sliceLen, info.path, archs, platform, info.isOSBinary) )
+                ++failures;
+        }
+        uint64_t t2 = mach_absolute_time();
+        for (unsigned i=0; i < kRepeatCount; ++i) {
+            Diagnostics diag;
+            if ( !ma->validLinkedit(diag, info.path) )
+                ++failures;
+        }
+        uint64_t t3 = mach_absolute_time();
+        machoTime    += (t2 - t1);
+        linkeditTime += (t3 - t2);
+    }
+
+    uint64_t imageCount    = std::max((uint64_t)diskImages.size(), 1ULL);
+    uint64_t machoNanos    = machoTime * timebase.numer / timebase.denom / kRepeatCount;
+    uint64_t linkeditNanos = linkeditTime * timebase.numer / timebase.denom / kRepeatCount;
+    fprintf(stderr, "images:              %lu\n", diskImages.size());
+    fprintf(stderr, "segments:            %llu\n", segmentCount);
+    // validMachOForArchAndPlatform() covers the load commands and validSegments()
+    fprintf(stderr, "validate mach-o:     %lluus (%lluns per image)\n", machoNanos / 1000, machoNanos / imageCount);
+    fprintf(stderr, "validate linkedit:   %lluus (%lluns per image)\n", linkeditNanos / 1000, linkeditNanos / imageCount);
+    if ( failures != 0 )
+        fprintf(stderr, "error: %llu validations failed\n", failures);
+}
+
 static void usage()
 {
     printf("dyld_closure_util program to create or view dyld3 closures\n");
@@ -115,6 +294,7 @@ static void usage()
     printf("    -print_dyld_cache_dylib <dylib-path>   # print specified cached dylib as JSON\n");
     printf("    -print_dyld_cache_dylibs               # print all cached dylibs as JSON\n");
     printf("    -print_dyld_cache_dlopen <path>        # print specified dlopen closure as JSON\n");
+    printf("    -time_closures <dir-path>              # build closures for all programs in directory tree and print timing\n");
     printf("  options:\n");
     printf("    -cache_file <cache-path>               # path to cache file to use (default is current cache)\n");
     printf("    -build_root <path-prefix>              # when building a closure, the path prefix when runtime volume is not current boot volume\n");
@@ -125,6 +305,10 @@ static void usage()
     printf("    -no_fallback_paths                     # when building a closure, simulate security not allowing default fallback paths\n");
     printf("    -allow_insertion_failures              # when building a closure, simulate security allowing unloadable DYLD_INSERT_LIBRARIES to be ignored\n");
     printf("    -force_invalid_cache_version           # when building a closure, simulate security the cache version mismatching the builder\n");
+    printf("    -path_probe_stats                      # for use with -create_closure to print how many file system probes were avoided\n");
+    printf("    -fixup_encoding_stats                  # for use with -create_closure to compare compact and fixed width fixup patterns\n");
+    printf("    -fixup_decode_stats                    # for use with -create_closure to time per-fixup and batched rebase/bind decoding\n");
+    printf("    -validation_stats                      # for use with -create_closure to time mach-o and LINKEDIT validation\n");
 }
 
 int main(int argc, const char* argv[])
@@ -134,6 +318,7 @@ int main(int argc, const char* argv[])
     const char*               printCacheClosure = nullptr;
     const char*               printCachedDylib = nullptr;
     const char*               printOtherDylib = nullptr;
+    const char*               timeClosuresDir = nullptr;
     const char*               fsRootPath = nullptr;
     const char*               fsOverlayPath = nullptr;
     bool                      listCacheClosures = false;
@@ -145,6 +330,10 @@ int main(int argc, const char* argv[])
     bool                      allowInsertionFailures = false;
     bool                      forceInvalidFormatVersion = false;
     bool                      printRaw = false;
+    bool                      printPathProbeStats = false;
+    bool                      fixupEncodingStats = false;
+    bool                      fixupDecodeStats = false;
+    bool                      validationStats = false;
     std::vector<const char*>  envArgs;
     std::vector<const char*>  dlopens;
     char                      fsRootRealPath[PATH_MAX];
@@ -221,6 +410,18 @@ int main(int argc, const char* argv[])
         else if ( strcmp(arg, "-force_invalid_cache_version") == 0 ) {
             forceInvalidFormatVersion = true;
         }
+        else if ( strcmp(arg, "-path_probe_stats") == 0 ) {
+            printPathProbeStats = true;
+        }
+        else if ( strcmp(arg, "-fixup_encoding_stats") == 0 ) {
+            fixupEncodingStats = true;
+        }
+        else if ( strcmp(arg, "-fixup_decode_stats") == 0 ) {
+            fixupDecodeStats = true;
+        }
+        else if ( strcmp(arg, "-validation_stats") == 0 ) {
+            validationStats = true;
+        }
         else if ( strcmp(arg, "-list_dyld_cache_closures") == 0 ) {
             listCacheClosures = true;
         }
@@ -251,6 +452,13 @@ int main(int argc, const char* argv[])
                 return 1;
             }
         }
+        else if ( strcmp(arg, "-time_closures") == 0 ) {
+            timeClosuresDir = argv[++i];
+            if ( timeClosuresDir == nullptr ) {
+                fprintf(stderr, "-time_closures option requires a path \n");
+                return 1;
+            }
+        }
         else if ( strcmp(arg, "-env") == 0 ) {
             const char* envArg = argv[++i];
             if ( (envArg == nullptr) || (strchr(envArg, '=') == nullptr) ) {
@@ -308,8 +516,31 @@ int main(int argc, const char* argv[])
         if ( !dlopens.empty() )
             printf("[\n");
         imagesArrays.push_back(mainClosure->images());
-        dyld3::closure::printClosureAsJSON(mainClosure, imagesArrays, verboseFixups, printRaw, dyldCache);
+        dyld3::closure::printClosureAsJSON(mainClosure, imagesArrays, verboseFixups, printRaw, dyldCache, std::cout,
+                                           printPathProbeStats ? &builder.pathProbeStats() : nullptr);
         ClosureBuilder::buildLoadOrder(loadedArray, imagesArrays, mainClosure);
+        if ( fixupEncodingStats )
+            printFixupEncodingStats(mainClosure->images());
+        if ( fixupDecodeStats || validationStats ) {
+            // cached dylibs were fixed up and validated by the cache builder, so only time the ones loaded from disk
+            std::vector<dyld3::closure::LoadedFileInfo> diskImages;
+            for (const dyld3::LoadedImage& li : loadedArray) {
+                if ( li.image()->inDyldCache() )
+                    continue;
+                Diagnostics diag;
+                char realerPath[MAXPATHLEN];
+                dyld3::closure::LoadedFileInfo loadedFileInfo = dyld3::MachOAnalyzer::load(diag, fileSystem, li.image()->path(), archs, builder.platform(), realerPath);
+                if ( loadedFileInfo.fileContent == nullptr )
+                    continue;
+                // the file system's path may not outlive load(), the closure's does
+                loadedFileInfo.path = li.image()->path();
+                diskImages.push_back(loadedFileInfo);
+            }
+            if ( fixupDecodeStats )
+                printFixupDecodeStats(diskImages);
+            if ( validationStats )
+                printValidationStats(diskImages, archs, builder.platform());
+        }
 
         for (const char* path : dlopens) {
             printf(",\n");
@@ -350,13 +581,66 @@ int main(int argc, const char* argv[])
             else {
                 nextNum += dlopenClosure->images()->imageCount();
                 imagesArrays.push_back(dlopenClosure->images());
-                dyld3::closure::printClosureAsJSON(dlopenClosure, imagesArrays, verboseFixups, printRaw);
+                dyld3::closure::printClosureAsJSON(dlopenClosure, imagesArrays, verboseFixups, printRaw, nullptr, std::cout,
+                                                   printPathProbeStats ? &dlopenBuilder.pathProbeStats() : nullptr);
                 ClosureBuilder::buildLoadOrder(loadedArray, imagesArrays, dlopenClosure);
             }
         }
         if ( !dlopens.empty() )
             printf("]\n");
     }
+    else if ( timeClosuresDir != nullptr ) {
+        // find all programs in the directory tree, then build a launch closure for each, as the cache builder does for OS programs
+        const char* pathPrefix = (fsRootPath != nullptr) ? fsRootPath : "";
+        __block std::vector<std::string> programPaths;
+        iterateDirectoryTree(pathPrefix, timeClosuresDir, ^(const std::string& dirPath) { return false; },
+                             ^(const std::string& path, const struct stat& statBuf) {
+            if ( mightBeMainExecutable(pathPrefix + path) )
+                programPaths.push_back(path);
+        });
+
+        PathOverrides pathOverrides;
+        pathOverrides.setFallbackPathHandling(allowFallbackPaths ? dyld3::closure::PathOverrides::FallbackPathMode::classic : dyld3::closure::PathOverrides::FallbackPathMode::none);
+        pathOverrides.setEnvVars(&envArgs[0], nullptr, nullptr);
+        dyld3::closure::FileSystemPhysical fileSystem(fsRootPath, fsOverlayPath);
+        dyld3::RootsChecker rootsChecker;
+        ClosureBuilder::AtPath atPathHanding = allowAtPaths ? ClosureBuilder::AtPath::all : ClosureBuilder::AtPath::none;
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        uint64_t    totalTime       = 0;
+        uint64_t    slowestTime     = 0;
+        std::string slowestPath;
+        unsigned    closuresBuilt   = 0;
+        unsigned    closuresFailed  = 0;
+        for (const std::string& path : programPaths) {
+            ClosureBuilder builder(dyld3::closure::kFirstLaunchClosureImageNum, fileSystem, rootsChecker, dyldCache, dyldCacheIsLive, archs, pathOverrides, atPathHanding, true, nullptr, platform, nullptr);
+            uint64_t t1 = mach_absolute_time();
+            const LaunchClosure* closure = builder.makeLaunchClosure(path.c_str(), allowInsertionFailures);
+            uint64_t t2 = mach_absolute_time();
+            if ( closure != nullptr ) {
+                ++closuresBuilt;
+                closure->deallocate();
+            }
+            else {
+                ++closuresFailed;
+            }
+            totalTime += (t2 - t1);
+            if ( (t2 - t1) > slowestTime ) {
+                slowestTime = t2 - t1;
+                slowestPath = path;
+            }
+        }
+        uint64_t totalMicroseconds   = totalTime * timebase.numer / timebase.denom / 1000;
+        uint64_t slowestMicroseconds = slowestTime * timebase.numer / timebase.denom / 1000;
+        printf("programs found:    %lu\n", programPaths.size());
+        printf("closures built:    %u\n", closuresBuilt);
+        printf("closures failed:   %u\n", closuresFailed);
+        printf("total build time:  %llums\n", totalMicroseconds / 1000);
+        if ( !programPaths.empty() ) {
+            printf("average per program: %lluus\n", totalMicroseconds / programPaths.size());
+            printf("slowest: %lluus %s\n", slowestMicroseconds, slowestPath.c_str());
+        }
+    }
     else if ( listCacheClosures ) {
         dyldCache->forEachLaunchClosure(^(const char* runtimePath, const dyld3::closure::LaunchClosure* closure) {
             printf("%6lu  %s\n", closure->size(), runtimePath);
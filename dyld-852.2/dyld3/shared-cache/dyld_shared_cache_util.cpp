@@ -34,6 +34,7 @@
 #include <sys/syslimits.h>
 #include <mach-o/arch.h>
 #include <mach-o/loader.h>
+#include <mach-o/nlist.h>
 #include <mach-o/dyld_priv.h>
 #include <bootstrap.h>
 #include <mach/mach.h>
@@ -51,6 +52,7 @@
 #include "DyldSharedCache.h"
 #include "ClosureFileSystemPhysical.h"
 #include "JSONWriter.h"
+#include "SymbolicationIndex.h"
 #include "Trie.hpp"
 #include "dsc_extractor.h"
 
@@ -131,7 +133,10 @@ enum Mode {
     modeObjCSelectors,
     modeExtract,
     modePatchTable,
-    modeListDylibsWithSection
+    modeListDylibsWithSection,
+    modeQuery,
+    modeBuildSymbolIndex,
+    modeSymbolicate
 };
 
 struct Options {
@@ -140,6 +145,7 @@ struct Options {
     const char*     extractionDir;
     const char*     segmentName;
     const char*     sectionName;
+    const char*     symbolIndexPath;
     bool            printUUIDs;
     bool            printVMAddrs;
     bool            printDylibVersions;
@@ -148,7 +154,7 @@ struct Options {
 
 
 void usage() {
-    fprintf(stderr, "Usage: dyld_shared_cache_util -list [ -uuid ] [-vmaddr] | -dependents <dylib-path> [ -versions ] | -linkedit | -map | -slide_info | -verbose_slide_info | -info | -extract <dylib-dir>  [ shared-cache-file ] \n");
+    fprintf(stderr, "Usage: dyld_shared_cache_util -list [ -uuid ] [-vmaddr] | -dependents <dylib-path> [ -versions ] | -linkedit | -map | -slide_info | -verbose_slide_info | -info | -extract <dylib-dir> | -query | -build_symbol_index <index-file>  [ shared-cache-file ] | -symbolicate <index-file>\n");
 }
 
 static void checkMode(Mode mode) {
@@ -386,6 +392,667 @@ static void findImageAndSegment(const DyldSharedCache* dyldCache, const std::vec
 }
 
 
+//
+// -query mode answers newline delimited JSON queries on stdin, one JSON line per query on stdout, so
+// scripts which make thousands of queries map and parse the cache once.  Each query is an object
+// with a "query" key, and an optional "id" which is echoed back in the answer:
+//
+//   {"query":"export", "name":"_malloc"}                   where each image exporting a symbol defines it
+//   {"query":"address", "address":"0x180004000"}           the image, segment and nearest export at an address
+//   {"query":"objc-class", "name":"NSObject"}              where each image defining a class has it
+//   {"query":"selector", "name":"alloc"}                   where a selector is in the selector table
+//   {"query":"dependents", "path":"/usr/lib/libc++.1.dylib"}
+//   {"query":"images"}
+//
+// Addresses are unslid.  The tables for each kind of query are built the first time it is made.
+//
+typedef std::map<std::string, dyld3::json::Node> CacheQuery;
+
+// Parses an object whose values are strings, numbers, booleans or null, which is all a query needs
+static bool parseCacheQuery(const std::string& line, CacheQuery& query, std::string& error)
+{
+    size_t pos = 0;
+    auto skipSpaces = [&]() {
+        while ( (pos < line.size()) && isspace((unsigned char)line[pos]) )
+            ++pos;
+    };
+    auto nextIs = [&](char c) {
+        return (pos < line.size()) && (line[pos] == c);
+    };
+    auto parseString = [&](std::string& str) {
+        if ( !nextIs('"') )
+            return false;
+        ++pos;
+        while ( pos < line.size() ) {
+            char c = line[pos++];
+            if ( c == '"' )
+                return true;
+            if ( c != '\\' ) {
+                str += c;
+                continue;
+            }
+            if ( pos >= line.size() )
+                return false;
+            c = line[pos++];
+            switch ( c ) {
+                case 'b': str += '\b'; break;
+                case 'f': str += '\f'; break;
+                case 'n': str += '\n'; break;
+                case 'r': str += '\r'; break;
+                case 't': str += '\t'; break;
+                case 'u': {
+                    if ( pos + 4 > line.size() )
+                        return false;
+                    std::string digits = line.substr(pos, 4);
+                    char* end;
+                    unsigned long code = strtoul(digits.c_str(), &end, 16);
+                    if ( end != digits.c_str() + 4 )
+                        return false;
+                    pos += 4;
+                    // to UTF-8.  Surrogate pairs are not handled, symbol and path names don't need them
+                    if ( code < 0x80 ) {
+                        str += (char)code;
+                    }
+                    else if ( code < 0x800 ) {
+                        str += (char)(0xC0 | (code >> 6));
+                        str += (char)(0x80 | (code & 0x3F));
+                    }
+                    else {
+                        str += (char)(0xE0 | (code >> 12));
+                        str += (char)(0x80 | ((code >> 6) & 0x3F));
+                        str += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:
+                    // \" \\ and \/
+                    str += c;
+                    break;
+            }
+        }
+        return false;
+    };
+
+    skipSpaces();
+    if ( !nextIs('{') ) {
+        error = "query is not a JSON object";
+        return false;
+    }
+    ++pos;
+    skipSpaces();
+    bool done = nextIs('}');
+    if ( done )
+        ++pos;
+    while ( !done ) {
+        std::string key;
+        skipSpaces();
+        if ( !parseString(key) ) {
+            error = "malformed key in query";
+            return false;
+        }
+        skipSpaces();
+        if ( !nextIs(':') ) {
+            error = "expected ':' after \"" + key + "\"";
+            return false;
+        }
+        ++pos;
+        skipSpaces();
+        dyld3::json::Node value;
+        if ( nextIs('"') ) {
+            if ( !parseString(value.value) ) {
+                error = "malformed string for \"" + key + "\"";
+                return false;
+            }
+            value.type = dyld3::json::NodeValueType::String;
+        }
+        else {
+            // numbers, true, false and null are kept as their text
+            while ( (pos < line.size()) && (isalnum((unsigned char)line[pos]) || (strchr("+-.", line[pos]) != nullptr)) )
+                value.value += line[pos++];
+            if ( value.value.empty() ) {
+                error = "only strings, numbers, booleans and null are supported, for \"" + key + "\"";
+                return false;
+            }
+            value.type = dyld3::json::NodeValueType::RawValue;
+        }
+        query[key] = value;
+        skipSpaces();
+        if ( nextIs(',') ) {
+            ++pos;
+        }
+        else if ( nextIs('}') ) {
+            ++pos;
+            done = true;
+        }
+        else {
+            error = "expected ',' or '}' after \"" + key + "\"";
+            return false;
+        }
+    }
+    skipSpaces();
+    if ( pos != line.size() ) {
+        error = "unexpected text after query";
+        return false;
+    }
+    return true;
+}
+
+class CacheQueryServer
+{
+public:
+                    CacheQueryServer(const DyldSharedCache* dyldCache, bool onDiskCache);
+
+    void            serve(std::istream& in, std::ostream& out);
+
+private:
+    struct Export
+    {
+        const char*     installName;
+        uint64_t        vmAddr;
+        uint64_t        flags;
+        std::string     importName;
+    };
+
+    struct Symbol
+    {
+        uint64_t            vmAddr;
+        const std::string*  name;
+    };
+
+    struct ObjCClass
+    {
+        const char*     installName;
+        uint64_t        vmAddr;
+    };
+
+    dyld3::json::Node   answer(const CacheQuery& query);
+    dyld3::json::Node   exportQuery(const std::string& name);
+    dyld3::json::Node   addressQuery(uint64_t vmAddr);
+    dyld3::json::Node   objcClassQuery(const std::string& name);
+    dyld3::json::Node   selectorQuery(const std::string& name);
+    dyld3::json::Node   dependentsQuery(const std::string& path);
+    dyld3::json::Node   imagesQuery();
+    void                buildExports();
+    void                buildSegments();
+    void                buildObjCClasses();
+
+    const DyldSharedCache*                                          _dyldCache;
+    bool                                                            _onDiskCache;
+    bool                                                            _exportsBuilt       = false;
+    bool                                                            _segmentsBuilt      = false;
+    bool                                                            _objcClassesBuilt   = false;
+    std::unordered_map<std::string, std::vector<Export>>            _exports;
+    std::unordered_map<const char*, std::vector<Symbol>>            _symbolsByImage;    // sorted by address
+    std::vector<SegmentInfo>                                        _segments;
+    std::unordered_map<std::string, std::vector<ObjCClass>>         _objcClasses;
+};
+
+CacheQueryServer::CacheQueryServer(const DyldSharedCache* dyldCache, bool onDiskCache)
+    : _dyldCache(dyldCache), _onDiskCache(onDiskCache)
+{
+}
+
+void CacheQueryServer::serve(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    while ( std::getline(in, line) ) {
+        if ( line.find_first_not_of(" \t\r") == std::string::npos )
+            continue;
+        CacheQuery        query;
+        std::string       error;
+        dyld3::json::Node result;
+        if ( parseCacheQuery(line, query, error) )
+            result = answer(query);
+        else
+            result.map["error"] = dyld3::json::Node{error};
+        auto id = query.find("id");
+        if ( id != query.end() )
+            result.map["id"] = id->second;
+        dyld3::json::printJSONLine(result, out);
+        // whoever is waiting on this answer may not send another query until they have it
+        out.flush();
+    }
+}
+
+dyld3::json::Node CacheQueryServer::answer(const CacheQuery& query)
+{
+    auto stringArg = [&](const char* key, std::string& value) {
+        auto it = query.find(key);
+        if ( it == query.end() )
+            return false;
+        value = it->second.value;
+        return true;
+    };
+
+    dyld3::json::Node result;
+    std::string kind;
+    std::string arg;
+    if ( !stringArg("query", kind) ) {
+        result.map["error"] = dyld3::json::Node{"missing \"query\""};
+    }
+    else if ( (kind == "export") || (kind == "objc-class") || (kind == "selector") ) {
+        if ( !stringArg("name", arg) )
+            result.map["error"] = dyld3::json::Node{"missing \"name\""};
+        else if ( kind == "export" )
+            result = exportQuery(arg);
+        else if ( kind == "objc-class" )
+            result = objcClassQuery(arg);
+        else
+            result = selectorQuery(arg);
+    }
+    else if ( kind == "address" ) {
+        char* end = nullptr;
+        if ( stringArg("address", arg) ) {
+            uint64_t vmAddr = strtoull(arg.c_str(), &end, 0);
+            if ( (end != arg.c_str()) && (*end == '\0') )
+                return addressQuery(vmAddr);
+        }
+        result.map["error"] = dyld3::json::Node{"missing or malformed \"address\""};
+    }
+    else if ( kind == "dependents" ) {
+        if ( !stringArg("path", arg) )
+            result.map["error"] = dyld3::json::Node{"missing \"path\""};
+        else
+            result = dependentsQuery(arg);
+    }
+    else if ( kind == "images" ) {
+        result = imagesQuery();
+    }
+    else {
+        result.map["error"] = dyld3::json::Node{"unknown query \"" + kind + "\""};
+    }
+    return result;
+}
+
+void CacheQueryServer::buildExports()
+{
+    if ( _exportsBuilt )
+        return;
+    _exportsBuilt = true;
+    _dyldCache->forEachImage(^(const mach_header* mh, const char* installName) {
+        const dyld3::MachOAnalyzer* ma = (dyld3::MachOAnalyzer*)mh;
+        uint32_t exportTrieRuntimeOffset;
+        uint32_t exportTrieSize;
+        if ( !ma->hasExportTrie(exportTrieRuntimeOffset, exportTrieSize) )
+            return;
+        const uint8_t* start = (uint8_t*)mh + exportTrieRuntimeOffset;
+        const uint8_t* end = start + exportTrieSize;
+        std::vector<ExportInfoTrie::Entry> exports;
+        if ( !ExportInfoTrie::parseTrie(start, end, exports) )
+            return;
+        const uint64_t loadAddress = ma->preferredLoadAddress();
+        std::vector<Symbol>& symbols = _symbolsByImage[installName];
+        for (const ExportInfoTrie::Entry& entry : exports) {
+            const uint64_t flags = entry.info.flags;
+            uint64_t vmAddr = 0;
+            if ( (flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) == EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE )
+                vmAddr = entry.info.address;
+            else if ( (flags & EXPORT_SYMBOL_FLAGS_REEXPORT) == 0 )
+                vmAddr = loadAddress + entry.info.address;
+            auto pos = _exports.emplace(entry.name, std::vector<Export>()).first;
+            pos->second.push_back({ installName, vmAddr, flags, entry.info.importName });
+            // only symbols in this image are useful when symbolicating an address in it
+            if ( (vmAddr != 0) && ((flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) != EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE) )
+                symbols.push_back({ vmAddr, &pos->first });
+        }
+        std::sort(symbols.begin(), symbols.end(), [](const Symbol& l, const Symbol& r) {
+            return l.vmAddr < r.vmAddr;
+        });
+    });
+}
+
+void CacheQueryServer::buildSegments()
+{
+    if ( _segmentsBuilt )
+        return;
+    _segmentsBuilt = true;
+    buildSegmentInfo(_dyldCache, _segments);
+}
+
+void CacheQueryServer::buildObjCClasses()
+{
+    if ( _objcClassesBuilt )
+        return;
+    _objcClassesBuilt = true;
+    dyld3::MachOAnalyzer::VMAddrConverter vmAddrConverter = _dyldCache->makeVMAddrConverter(false);
+    _dyldCache->forEachImage(^(const mach_header* mh, const char* installName) {
+        const dyld3::MachOAnalyzer* ma = (const dyld3::MachOAnalyzer*)mh;
+        const uint32_t pointerSize = ma->pointerSize();
+        Diagnostics diag;
+        ma->forEachObjCClass(diag, vmAddrConverter, ^(Diagnostics& classDiag, uint64_t classVMAddr,
+                                                      uint64_t classSuperclassVMAddr, uint64_t classDataVMAddr,
+                                                      const dyld3::MachOAnalyzer::ObjCClassInfo& objcClass, bool isMetaClass) {
+            if ( isMetaClass )
+                return;
+            dyld3::MachOAnalyzer::PrintableStringResult result;
+            const char* className = ma->getPrintableString(objcClass.nameVMAddr(pointerSize), result);
+            if ( result == dyld3::MachOAnalyzer::PrintableStringResult::CanPrint )
+                _objcClasses[className].push_back({ installName, classVMAddr });
+        });
+    });
+}
+
+dyld3::json::Node CacheQueryServer::exportQuery(const std::string& name)
+{
+    buildExports();
+    dyld3::json::Node result;
+    auto it = _exports.find(name);
+    result.map["found"] = dyld3::json::Node{it != _exports.end()};
+    if ( it == _exports.end() )
+        return result;
+    for (const Export& exp : it->second) {
+        dyld3::json::Node definition;
+        definition.map["image"] = dyld3::json::Node{exp.installName};
+        if ( exp.flags & EXPORT_SYMBOL_FLAGS_REEXPORT ) {
+            definition.map["reExport"] = dyld3::json::Node{true};
+            definition.map["importName"] = dyld3::json::Node{exp.importName.empty() ? name : exp.importName};
+        }
+        else {
+            definition.map["address"] = dyld3::json::Node{dyld3::json::hex(exp.vmAddr)};
+            if ( (exp.flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) == EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE )
+                definition.map["absolute"] = dyld3::json::Node{true};
+            if ( (exp.flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) == EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL )
+                definition.map["threadLocal"] = dyld3::json::Node{true};
+            if ( exp.flags & EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION )
+                definition.map["weak"] = dyld3::json::Node{true};
+        }
+        result.map["definitions"].array.push_back(definition);
+    }
+    return result;
+}
+
+dyld3::json::Node CacheQueryServer::addressQuery(uint64_t vmAddr)
+{
+    buildSegments();
+    dyld3::json::Node result;
+    // the last segment starting at or before the address
+    auto it = std::upper_bound(_segments.begin(), _segments.end(), vmAddr, [](uint64_t addr, const SegmentInfo& seg) {
+        return addr < seg.vmAddr;
+    });
+    if ( (it == _segments.begin()) || (vmAddr >= (it-1)->vmAddr + (it-1)->vmSize) ) {
+        result.map["found"] = dyld3::json::Node{false};
+        return result;
+    }
+    const SegmentInfo& seg = *(it-1);
+    result.map["found"]         = dyld3::json::Node{true};
+    result.map["image"]         = dyld3::json::Node{seg.installName};
+    result.map["segment"]       = dyld3::json::Node{std::string(seg.segName, strnlen(seg.segName, 16))};
+    result.map["segmentOffset"] = dyld3::json::Node{dyld3::json::hex(vmAddr - seg.vmAddr)};
+
+    buildExports();
+    auto symbols = _symbolsByImage.find(seg.installName);
+    if ( symbols != _symbolsByImage.end() ) {
+        const std::vector<Symbol>& sorted = symbols->second;
+        auto sym = std::upper_bound(sorted.begin(), sorted.end(), vmAddr, [](uint64_t addr, const Symbol& s) {
+            return addr < s.vmAddr;
+        });
+        // an export before the start of the segment is not what the address is in
+        if ( (sym != sorted.begin()) && ((sym-1)->vmAddr >= seg.vmAddr) ) {
+            result.map["symbol"]       = dyld3::json::Node{*(sym-1)->name};
+            result.map["symbolOffset"] = dyld3::json::Node{dyld3::json::hex(vmAddr - (sym-1)->vmAddr)};
+        }
+    }
+    return result;
+}
+
+dyld3::json::Node CacheQueryServer::objcClassQuery(const std::string& name)
+{
+    dyld3::json::Node result;
+    if ( !_onDiskCache ) {
+        result.map["error"] = dyld3::json::Node{"objc-class queries need the path to an on-disk cache file"};
+        return result;
+    }
+    buildObjCClasses();
+    auto it = _objcClasses.find(name);
+    result.map["found"] = dyld3::json::Node{it != _objcClasses.end()};
+    if ( it == _objcClasses.end() )
+        return result;
+    for (const ObjCClass& objcClass : it->second) {
+        dyld3::json::Node definition;
+        definition.map["image"]   = dyld3::json::Node{objcClass.installName};
+        definition.map["address"] = dyld3::json::Node{dyld3::json::hex(objcClass.vmAddr)};
+        result.map["definitions"].array.push_back(definition);
+    }
+    return result;
+}
+
+dyld3::json::Node CacheQueryServer::selectorQuery(const std::string& name)
+{
+    dyld3::json::Node result;
+    const objc_opt::objc_selopt_t* selectors = (_dyldCache->objcOpt() != nullptr) ? _dyldCache->objcOpt()->selopt() : nullptr;
+    if ( selectors == nullptr ) {
+        result.map["error"] = dyld3::json::Node{"cache has no optimized objc selectors"};
+        return result;
+    }
+    // the selector table is already a perfect hash table, so there is nothing to build
+    const char* selName = selectors->get(name.c_str());
+    result.map["found"] = dyld3::json::Node{selName != nullptr};
+    if ( selName == nullptr )
+        return result;
+    uint64_t cacheOffset = (uint64_t)selName - (uint64_t)_dyldCache;
+    result.map["offset"]  = dyld3::json::Node{dyld3::json::hex(cacheOffset)};
+    result.map["address"] = dyld3::json::Node{dyld3::json::hex(_dyldCache->unslidLoadAddress() + cacheOffset)};
+    return result;
+}
+
+dyld3::json::Node CacheQueryServer::dependentsQuery(const std::string& path)
+{
+    dyld3::json::Node result;
+    uint32_t imageIndex;
+    const bool found = _dyldCache->hasImagePath(path.c_str(), imageIndex);
+    result.map["found"] = dyld3::json::Node{found};
+    if ( !found )
+        return result;
+    uint64_t mTime;
+    uint64_t inode;
+    const dyld3::MachOFile* mf = (dyld3::MachOFile*)_dyldCache->getIndexedImageEntry(imageIndex, mTime, inode);
+    auto version = [](uint32_t vers) {
+        return dyld3::json::Node{dyld3::json::decimal(vers >> 16) + "." + dyld3::json::decimal((vers >> 8) & 0xff) + "." + dyld3::json::decimal(vers & 0xff)};
+    };
+    result.map["installName"] = dyld3::json::Node{mf->installName()};
+    __block dyld3::json::Node dependents;
+    mf->forEachDependentDylib(^(const char* loadPath, bool isWeak, bool isReExport, bool isUpward, uint32_t compatVersion, uint32_t curVersion, bool& stop) {
+        dyld3::json::Node dependent;
+        dependent.map["path"]       = dyld3::json::Node{loadPath};
+        dependent.map["weak"]       = dyld3::json::Node{isWeak};
+        dependent.map["reExport"]   = dyld3::json::Node{isReExport};
+        dependent.map["upward"]     = dyld3::json::Node{isUpward};
+        if ( compatVersion != 0xFFFFFFFF ) {
+            dependent.map["compatVersion"]  = version(compatVersion);
+            dependent.map["currentVersion"] = version(curVersion);
+        }
+        dependents.array.push_back(dependent);
+    });
+    if ( !dependents.array.empty() )
+        result.map["dependents"] = dependents;
+    return result;
+}
+
+dyld3::json::Node CacheQueryServer::imagesQuery()
+{
+    __block dyld3::json::Node images;
+    _dyldCache->forEachImageTextSegment(^(uint64_t loadAddressUnslid, uint64_t textSegmentSize, const unsigned char* dylibUUID, const char* installName, bool& stop) {
+        uuid_string_t uuidString;
+        uuid_unparse_upper(dylibUUID, uuidString);
+        dyld3::json::Node image;
+        image.map["path"]    = dyld3::json::Node{installName};
+        image.map["address"] = dyld3::json::Node{dyld3::json::hex(loadAddressUnslid)};
+        image.map["uuid"]    = dyld3::json::Node{uuidString};
+        images.array.push_back(image);
+    });
+    dyld3::json::Node result;
+    result.map["images"] = images;
+    return result;
+}
+
+
+// Writes an address to symbol index of every global symbol in the cache, and every local symbol, which
+// are in the part of the cache file which is not mapped.
+static int buildSymbolIndex(const DyldSharedCache* dyldCache, const char* sharedCachePath, const char* indexPath)
+{
+    __block dyld3::SymbolicationIndexBuilder builder;
+    __block std::unordered_map<uint64_t, uint32_t> imageIndexForOffset;
+    dyldCache->forEachImage(^(const mach_header* mh, const char* installName) {
+        const dyld3::MachOAnalyzer* ma = (const dyld3::MachOAnalyzer*)mh;
+        const uint32_t imageIndex = builder.addImage(installName, ma->preferredLoadAddress());
+        // images are in the first mapping, which starts at the start of the file
+        imageIndexForOffset[ma->preferredLoadAddress() - dyldCache->unslidLoadAddress()] = imageIndex;
+        ma->forEachSection(^(const dyld3::MachOAnalyzer::SectionInfo& sectInfo, bool malformedSectionRange, bool& stop) {
+            if ( !malformedSectionRange )
+                builder.addRange(imageIndex, sectInfo.sectAddr, sectInfo.sectSize);
+        });
+        Diagnostics diag;
+        ma->forEachGlobalSymbol(diag, ^(const char* symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop) {
+            if ( (n_type & N_TYPE) == N_SECT )
+                builder.addSymbol(n_value, symbolName);
+        });
+        ma->forEachLocalSymbol(diag, ^(const char* symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop) {
+            if ( ((n_type & N_TYPE) == N_SECT) && ((n_type & N_STAB) == 0) )
+                builder.addSymbol(n_value, symbolName);
+        });
+    });
+
+    const dyld_cache_header& header = dyldCache->header;
+    if ( !dyldCache->hasLocalSymbolsInfo() ) {
+        fprintf(stderr, "Warning: dyld shared cache does not contain local symbols info, only global symbols will be indexed\n");
+    }
+    else if ( sharedCachePath == nullptr ) {
+        fprintf(stderr, "Warning: local symbols are only in the cache file, only global symbols will be indexed\n");
+    }
+    else {
+        // added after the global symbols, so a global symbol is kept where both have the same address
+        int fd = ::open(sharedCachePath, O_RDONLY);
+        if ( fd == -1 ) {
+            fprintf(stderr, "Error: could not open %s, errno=%d\n", sharedCachePath, errno);
+            return 1;
+        }
+        const uint64_t mapOffset = header.localSymbolsOffset & ~((uint64_t)vm_page_size - 1);
+        const size_t   mapSize   = (size_t)(header.localSymbolsOffset + header.localSymbolsSize - mapOffset);
+        void* mapping = ::mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, mapOffset);
+        ::close(fd);
+        if ( mapping == MAP_FAILED ) {
+            fprintf(stderr, "Error: could not map local symbols of %s, errno=%d\n", sharedCachePath, errno);
+            return 1;
+        }
+        const dyld_cache_local_symbols_info* localInfo = (dyld_cache_local_symbols_info*)((uint8_t*)mapping + (header.localSymbolsOffset - mapOffset));
+        const bool                           is64      = (strstr(dyldCache->archName(), "64") != NULL);
+        const uint64_t                       nlistSize = is64 ? sizeof(struct nlist_64) : sizeof(struct nlist);
+        if ( (header.localSymbolsSize < sizeof(dyld_cache_local_symbols_info))
+            || ((uint64_t)localInfo->nlistOffset + (uint64_t)localInfo->nlistCount * nlistSize > header.localSymbolsSize)
+            || ((uint64_t)localInfo->stringsOffset + localInfo->stringsSize > header.localSymbolsSize)
+            || ((uint64_t)localInfo->entriesOffset + (uint64_t)localInfo->entriesCount * sizeof(dyld_cache_local_symbols_entry) > header.localSymbolsSize)
+            || ((localInfo->stringsSize != 0) && (((char*)localInfo)[localInfo->stringsOffset + localInfo->stringsSize - 1] != '\0')) ) {
+            fprintf(stderr, "Error: malformed local symbols info in %s\n", sharedCachePath);
+            ::munmap(mapping, mapSize);
+            return 1;
+        }
+        const uint8_t*                       nlists    = (uint8_t*)localInfo + localInfo->nlistOffset;
+        const char*                          strings   = (char*)localInfo + localInfo->stringsOffset;
+        const dyld_cache_local_symbols_entry* entries  = (dyld_cache_local_symbols_entry*)((uint8_t*)localInfo + localInfo->entriesOffset);
+        for (uint32_t e=0; e < localInfo->entriesCount; ++e) {
+            const dyld_cache_local_symbols_entry& entry = entries[e];
+            if ( (imageIndexForOffset.count(entry.dylibOffset) == 0) || (entry.nlistStartIndex > localInfo->nlistCount)
+                || (entry.nlistCount > localInfo->nlistCount - entry.nlistStartIndex) )
+                continue;
+            for (uint32_t i=entry.nlistStartIndex; i < entry.nlistStartIndex + entry.nlistCount; ++i) {
+                uint32_t strx;
+                uint8_t  type;
+                uint64_t value;
+                if ( is64 ) {
+                    const struct nlist_64* sym = &((struct nlist_64*)nlists)[i];
+                    strx  = sym->n_un.n_strx;
+                    type  = sym->n_type;
+                    value = sym->n_value;
+                }
+                else {
+                    const struct nlist* sym = &((struct nlist*)nlists)[i];
+                    strx  = sym->n_un.n_strx;
+                    type  = sym->n_type;
+                    value = sym->n_value;
+                }
+                if ( ((type & N_TYPE) == N_SECT) && ((type & N_STAB) == 0) && (strx < localInfo->stringsSize) )
+                    builder.addSymbol(value, &strings[strx]);
+            }
+        }
+        ::munmap(mapping, mapSize);
+    }
+
+    std::vector<uint8_t> bytes;
+    builder.write(header.uuid, bytes);
+    FILE* out = ::fopen(indexPath, "w");
+    if ( out == nullptr ) {
+        fprintf(stderr, "Error: could not create %s, errno=%d\n", indexPath, errno);
+        return 1;
+    }
+    bool written = (::fwrite(bytes.data(), bytes.size(), 1, out) == 1);
+    if ( ::fclose(out) != 0 )
+        written = false;
+    if ( !written ) {
+        fprintf(stderr, "Error: could not write %s, errno=%d\n", indexPath, errno);
+        ::unlink(indexPath);
+        return 1;
+    }
+    return 0;
+}
+
+// Reads unslid addresses from stdin, one per line, and prints what each is in the order given,
+// as: address image symbol + offset
+static int symbolicateAddresses(const char* indexPath)
+{
+    int fd = ::open(indexPath, O_RDONLY);
+    struct stat statBuf;
+    if ( (fd == -1) || (::fstat(fd, &statBuf) != 0) ) {
+        fprintf(stderr, "Error: could not open symbol index %s, errno=%d\n", indexPath, errno);
+        return 1;
+    }
+    void* bytes = ::mmap(nullptr, (size_t)statBuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if ( bytes == MAP_FAILED ) {
+        fprintf(stderr, "Error: could not map symbol index %s, errno=%d\n", indexPath, errno);
+        return 1;
+    }
+    dyld3::SymbolicationIndex index;
+    std::string failureReason;
+    if ( !index.init(bytes, (size_t)statBuf.st_size, failureReason) ) {
+        fprintf(stderr, "Error: %s: %s\n", indexPath, failureReason.c_str());
+        return 1;
+    }
+
+    std::vector<uint64_t> addresses;
+    std::string line;
+    while ( std::getline(std::cin, line) ) {
+        if ( line.empty() )
+            continue;
+        addresses.push_back(strtoull(line.c_str(), nullptr, 0));
+    }
+    // sort, keeping where each came from, so the index is walked once
+    __block std::vector<std::pair<uint64_t, size_t>> sorted;
+    sorted.reserve(addresses.size());
+    for (size_t i=0; i < addresses.size(); ++i)
+        sorted.push_back({ addresses[i], i });
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<uint64_t> sortedAddresses;
+    sortedAddresses.reserve(sorted.size());
+    for (const auto& entry : sorted)
+        sortedAddresses.push_back(entry.first);
+    __block std::vector<dyld3::SymbolicationIndex::Result> results(addresses.size());
+    index.symbolicateSorted(sortedAddresses.data(), sortedAddresses.size(), ^(size_t i, const dyld3::SymbolicationIndex::Result& result) {
+        results[sorted[i].second] = result;
+    });
+
+    for (size_t i=0; i < addresses.size(); ++i) {
+        const dyld3::SymbolicationIndex::Result& result = results[i];
+        if ( result.imagePath == nullptr )
+            printf("0x%08llX ???\n", addresses[i]);
+        else if ( result.symbolName == nullptr )
+            printf("0x%08llX %s + 0x%llX\n", addresses[i], result.imagePath, addresses[i] - result.imageLoadAddress);
+        else
+            printf("0x%08llX %s %s + %llu\n", addresses[i], result.imagePath, result.symbolName, addresses[i] - result.symbolAddress);
+    }
+    return 0;
+}
+
+
 int main (int argc, const char* argv[]) {
 
     const char* sharedCachePath = nullptr;
@@ -398,6 +1065,7 @@ int main (int argc, const char* argv[]) {
     options.printInodes = false;
     options.dependentsOfPath = NULL;
     options.extractionDir = NULL;
+    options.symbolIndexPath = NULL;
 
     bool printStrings = false;
     bool printExports = false;
@@ -501,6 +1169,20 @@ int main (int argc, const char* argv[]) {
                     exit(1);
                 }
             }
+            else if (strcmp(opt, "-query") == 0) {
+                checkMode(options.mode);
+                options.mode = modeQuery;
+            }
+            else if ( (strcmp(opt, "-build_symbol_index") == 0) || (strcmp(opt, "-symbolicate") == 0) ) {
+                checkMode(options.mode);
+                options.mode = (strcmp(opt, "-symbolicate") == 0) ? modeSymbolicate : modeBuildSymbolIndex;
+                options.symbolIndexPath = argv[++i];
+                if ( i >= argc ) {
+                    fprintf(stderr, "Error: option %s requires an index file argument\n", opt);
+                    usage();
+                    exit(1);
+                }
+            }
             else if (strcmp(opt, "-uuid") == 0) {
                 options.printUUIDs = true;
             }
@@ -560,6 +1242,10 @@ int main (int argc, const char* argv[]) {
         }
     }
 
+    // symbolicating only needs the index
+    if ( options.mode == modeSymbolicate )
+        return symbolicateAddresses(options.symbolIndexPath);
+
     const DyldSharedCache* dyldCache = nullptr;
     if ( sharedCachePath != nullptr ) {
         dyldCache = mapCacheFile(sharedCachePath);
@@ -1400,6 +2086,13 @@ int main (int argc, const char* argv[]) {
     else if ( options.mode == modeExtract ) {
         return dyld_shared_cache_extract_dylibs(sharedCachePath, options.extractionDir);
     }
+    else if ( options.mode == modeQuery ) {
+        CacheQueryServer server(dyldCache, sharedCachePath != nullptr);
+        server.serve(std::cin, std::cout);
+    }
+    else if ( options.mode == modeBuildSymbolIndex ) {
+        return buildSymbolIndex(dyldCache, sharedCachePath, options.symbolIndexPath);
+    }
     else if ( options.mode == modeObjCImpCaches ) {
         if (sharedCachePath == nullptr) {
             fprintf(stderr, "Cannot emit imp caches with live cache.  Run again with the path to the cache file\n");
@@ -1786,6 +2479,9 @@ int main (int argc, const char* argv[]) {
             case modeObjCClasses:
             case modeObjCSelectors:
             case modeExtract:
+            case modeQuery:
+            case modeBuildSymbolIndex:
+            case modeSymbolicate:
                 break;
         }
     }
@@ -34,10 +34,10 @@
 #include <vector>
 
 static const uint64_t kMinBuildVersion = 1; //The minimum version BuildOptions struct we can support
-static const uint64_t kMaxBuildVersion = 1; //The maximum version BuildOptions struct we can support
+static const uint64_t kMaxBuildVersion = 2; //The maximum version BuildOptions struct we can support
 
 static const uint32_t MajorVersion = 1;
-static const uint32_t MinorVersion = 0;
+static const uint32_t MinorVersion = 1;
 
 struct KernelCollectionBuilder {
 
@@ -56,6 +56,7 @@ struct KernelCollectionBuilder {
 
     const char*                                 arch = "";
     BuildOptions_v1                             options;
+    bool                                        binaryPrelinkInfo = false;
     std::list<Diagnostics>                      inputFileDiags;
     std::vector<AppCacheBuilder::InputDylib>    inputFiles;
     dyld3::closure::LoadedFileInfo              kernelCollectionFileInfo;
@@ -113,6 +114,8 @@ void getVersion(uint32_t *major, uint32_t *minor) {
 KernelCollectionBuilder::KernelCollectionBuilder(const BuildOptions_v1* options)
     : options(*options) {
     retain(this->options.arch);
+    if ( options->version >= 2 )
+        binaryPrelinkInfo = ((const BuildOptions_v2*)options)->binaryPrelinkInfo;
 }
 
 // Returns a valid object on success, or NULL on failure.
@@ -546,6 +549,7 @@ bool runKernelCollectionBuilder(struct KernelCollectionBuilder* builder) {
     AppCacheBuilder::Options appCacheOptions;
     appCacheOptions.cacheKind = cacheKind(builder->options.collectionKind);
     appCacheOptions.stripMode = stripMode(builder->options.stripMode);
+    appCacheOptions.binaryPrelinkInfo = builder->binaryPrelinkInfo;
 
     const dyld3::closure::FileSystemNull builderFileSystem;
 
@@ -90,6 +90,19 @@ struct BuildOptions_v1
     bool                                        verboseDiagnostics;
 };
 
+// This is available when getVersion() returns 1.1 or higher
+struct BuildOptions_v2
+{
+    uint64_t                                    version;                        // Future proofing, set to 2
+    CollectionKind                              collectionKind;
+    StripMode                                   stripMode;
+// Valid archs are one of: "arm64", "arm64e", "x86_64", "x86_64h"
+    const CFStringRef                           arch;
+    bool                                        verboseDiagnostics;
+    // Added in v2
+    bool                                        binaryPrelinkInfo;              // Emit __PRELINK_INFO as OSSerializeBinary, not XML
+};
+
 
 struct CollectionFileResult_v1
 {
@@ -47,6 +47,7 @@
 #include <rootless.h>
 #include <dscsym.h>
 #include <dispatch/dispatch.h>
+#include <os/lock.h>
 #include <pthread/pthread.h>
 #include <CoreFoundation/CoreFoundation.h>
 
@@ -100,6 +101,9 @@ static const char* sMacOSBinaries[] = {
 
 static bool verbose = false;
 
+// guards the file lists while findAllFiles() sniffs files concurrently
+static os_unfair_lock sFilesLock = OS_UNFAIR_LOCK_INIT;
+
 
 static bool addIfMachO(const dyld3::closure::FileSystem& fileSystem, const std::string& runtimePath, const struct stat& statBuf, std::vector<MappedMachOsByCategory>& files, dyld3::Platform platform, Diagnostics& diag)
 {
@@ -129,7 +133,9 @@ static bool addIfMachO(const dyld3::closure::FileSystem& fileSystem, const std::
             else if ( ma->canBePlacedInDyldCache(runtimePath.c_str(), ^(const char* msg) {
                 diag.error("Dylib located at '%s' cannot be placed in cache because: '%s'", loadedFileInfo.path, msg);
             }) ) {
+                os_unfair_lock_lock(&sFilesLock);
                 file.dylibsForCache.emplace_back(runtimePath, ma, sliceLen, issetuid, sipProtected, loadedFileInfo.sliceOffset, statBuf.st_mtime, statBuf.st_ino);
+                os_unfair_lock_unlock(&sFilesLock);
                 result = true;
            }
         }
@@ -145,11 +151,13 @@ static void findAllFiles(const dyld3::closure::FileSystem& fileSystem, const std
         skipDirs.insert(s);
     
     __block std::unordered_set<std::string> alreadyUsed;
+    __block std::unordered_set<std::string> usedByThisPrefix;
     bool multiplePrefixes = (pathPrefixes.size() > 1);
     for (const std::string& prefix : pathPrefixes) {
-        // get all files from overlay for this search dir
+        // get all files from overlay for this search dir.  Files are sniffed by the workers walking
+        // the tree, so mapping and parsing starts long before the walk of a large root has finished
         for (const char* searchDir : sAllowedPrefixes ) {
-            iterateDirectoryTree(prefix, searchDir, ^(const std::string& dirPath) { return (skipDirs.count(dirPath) != 0); }, ^(const std::string& path, const struct stat& statBuf) {
+            iterateDirectoryTreeConcurrently(prefix, searchDir, ^(const std::string& dirPath) { return (skipDirs.count(dirPath) != 0); }, ^(const std::string& path, const struct stat& statBuf) {
                 // ignore files that don't have 'x' bit set (all runnable mach-o files do)
                 const bool hasXBit = ((statBuf.st_mode & S_IXOTH) == S_IXOTH);
                 if ( !hasXBit && !endsWith(path, ".dylib") )
@@ -171,11 +179,25 @@ static void findAllFiles(const dyld3::closure::FileSystem& fileSystem, const std
                 // if the file is mach-o, add to list
                 Diagnostics diag;
                 if ( addIfMachO(fileSystem, path, statBuf, files, platform, diag) ) {
-                    if ( multiplePrefixes )
-                        alreadyUsed.insert(path);
+                    if ( multiplePrefixes ) {
+                        os_unfair_lock_lock(&sFilesLock);
+                        usedByThisPrefix.insert(path);
+                        os_unfair_lock_unlock(&sFilesLock);
+                    }
                 }
             });
         }
+        // paths found under this prefix hide those under later prefixes, but not each other
+        alreadyUsed.insert(usedByThisPrefix.begin(), usedByThisPrefix.end());
+        usedByThisPrefix.clear();
+    }
+
+    // files are found in no particular order, so sort them to keep the cache the same from one run to the next
+    for (MappedMachOsByCategory& fileSet : files) {
+        std::sort(fileSet.dylibsForCache.begin(), fileSet.dylibsForCache.end(),
+                  [](const DyldSharedCache::MappedMachO& a, const DyldSharedCache::MappedMachO& b) {
+            return a.runtimePath < b.runtimePath;
+        });
     }
 }
 
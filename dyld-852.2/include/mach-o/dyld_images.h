@@ -160,10 +160,13 @@ struct dyld_all_image_infos {
 	const char*						dyldPath;
 	mach_port_t						notifyPorts[DYLD_MAX_PROCESS_INFO_NOTIFY_COUNT];
 #if __LP64__
-	uintptr_t						reserved[13-(DYLD_MAX_PROCESS_INFO_NOTIFY_COUNT/2)];
+	uintptr_t						reserved[11-(DYLD_MAX_PROCESS_INFO_NOTIFY_COUNT/2)];
 #else
-	uintptr_t						reserved[13-DYLD_MAX_PROCESS_INFO_NOTIFY_COUNT];
+	uintptr_t						reserved[11-DYLD_MAX_PROCESS_INFO_NOTIFY_COUNT];
 #endif
+	/* the following fields are private to dyld and libdyld, and zero unless DYLD_PUBLISH_COMPACT_IMAGE_INFO is set */
+	uintptr_t						compactImageListAddr;
+	uintptr_t						compactImageListSize;
 	/* the following field is only in version 16 (macOS 10.13, iOS 11.0) and later */
     uintptr_t                       compact_dyld_image_info_addr;
     size_t                          compact_dyld_image_info_size;
@@ -126,6 +126,21 @@ extern void _dyld_process_info_for_each_segment(dyld_process_info info, uint64_t
 // returns 0 if the platform cannot be determined, otherwise returns the platform of the remote process
 extern dyld_platform_t _dyld_process_info_get_platform(dyld_process_info info) SPI_AVAILABLE(macos(10.15), ios(13.0), tvos(13.0), watchos(6.0), bridgeos(4.0));
 
+//
+// Catch up with the image list of a task without gathering the full process info.  The timestamp parameter is
+// the timestamp of an image list the caller already has, from _dyld_process_info_get_state() or from a previous
+// call to this function.  The callback is called for each image loaded or unloaded since then, oldest first, and
+// the timestamp of the current image list is returned, to be passed to the next call.  If nothing changed, the
+// callback is not called and timestamp is returned.  Returns 0 if the target process no longer has a record of
+// every change since timestamp (or never had one), in which case use _dyld_process_info_create() instead.
+// Changes are only recorded if the target process was launched with DYLD_PUBLISH_COMPACT_IMAGE_INFO set, so
+// otherwise this always returns 0.
+// The kernelError parameter can be NULL for clients that don't care why it failed.
+//
+extern uint64_t _dyld_process_info_for_each_change_since(task_t task, uint64_t timestamp,
+                                                         void (^callback)(bool unload, uint64_t timestamp, uint64_t machHeader, const uuid_t uuid, const char* path),
+                                                         kern_return_t* kernelError) SPI_AVAILABLE(macos(11.3), ios(14.5), tvos(14.5), watchos(7.4), bridgeos(5.3));
+
 typedef const struct dyld_process_info_notify_base* dyld_process_info_notify;
 
 //
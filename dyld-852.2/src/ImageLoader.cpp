@@ -38,9 +38,11 @@
 #include <libkern/OSAtomic.h>
 #include <string_view>
 
+#include <algorithm>
 #include <atomic>
 
 #include "Tracing.h"
+#include "TrieEdge.h"
 
 #include "ImageLoader.h"
 
@@ -67,6 +69,10 @@ uint64_t								ImageLoader::fgTotalWeakBindTime;
 uint64_t								ImageLoader::fgTotalDOF;
 uint64_t								ImageLoader::fgTotalInitTime;
 uint16_t								ImageLoader::fgLoadOrdinal = 0;
+uint32_t								ImageLoader::fgDenseIndexLimit = 0;
+uint32_t*								ImageLoader::fgFreeDenseIndexes = NULL;
+uint32_t								ImageLoader::fgFreeDenseIndexCount = 0;
+uint32_t								ImageLoader::fgFreeDenseIndexCapacity = 0;
 uint32_t								ImageLoader::fgSymbolTrieSearchs = 0;
 std::vector<ImageLoader::InterposeTuple>ImageLoader::fgInterposingTuples;
 uintptr_t								ImageLoader::fgNextPIEDylibAddress = 0;
@@ -76,7 +82,7 @@ uintptr_t								ImageLoader::fgNextPIEDylibAddress = 0;
 ImageLoader::ImageLoader(const char* path, unsigned int libCount)
 	: fPath(path), fRealPath(NULL), fDevice(0), fInode(0), fLastModified(0),
 	fPathHash(0), fDlopenReferenceCount(0), fInitializerRecursiveLock(NULL), 
-	fLoadOrder(fgLoadOrdinal++), fDepth(0), fObjCMappedNotified(false), fState(0), fLibraryCount(libCount),
+	fDependents(NULL), fDependentCount(0), fDenseIndex(0), fInitDepth(0), fBoundForLockFreeReaders(false), fLoadOrder(fgLoadOrdinal++), fDepth(0), fObjCMappedNotified(false), fState(0), fLibraryCount(libCount),
 	fMadeReadOnly(false), fAllLibraryChecksumsAndLoadAddressesMatch(false), fLeaveMapped(false), fNeverUnload(false),
 	fHideSymbols(false), fMatchByInstallName(false),
 	fInterposed(false), fRegisteredDOF(false), fAllLazyPointersBound(false), 
@@ -91,6 +97,7 @@ ImageLoader::ImageLoader(const char* path, unsigned int libCount)
 		fPathHash = hash(fPath);
 	if ( libCount > 512 )
 		dyld::throwf("too many dependent dylibs in %s", path);
+	fDenseIndex = allocDenseIndex();
 }
 
 
@@ -110,6 +117,31 @@ ImageLoader::~ImageLoader()
 	if ( fAotPath != NULL )
 		delete [] fAotPath;
 #endif
+	if ( fDependents != NULL )
+		free((void*)fDependents);
+	freeDenseIndex(fDenseIndex);
+}
+
+// Indexes are reused once their image is deleted, so bitmaps of images stay about as small as the image list.
+// Images are only created and deleted with the dyld lock held.
+uint32_t ImageLoader::allocDenseIndex()
+{
+	if ( fgFreeDenseIndexCount != 0 )
+		return fgFreeDenseIndexes[--fgFreeDenseIndexCount];
+	return fgDenseIndexLimit++;
+}
+
+void ImageLoader::freeDenseIndex(uint32_t index)
+{
+	if ( fgFreeDenseIndexCount == fgFreeDenseIndexCapacity ) {
+		uint32_t newCapacity = (fgFreeDenseIndexCapacity == 0) ? 32 : 2*fgFreeDenseIndexCapacity;
+		uint32_t* newIndexes = (uint32_t*)realloc(fgFreeDenseIndexes, newCapacity*sizeof(uint32_t));
+		if ( newIndexes == NULL )
+			return;		// just don't reuse this index
+		fgFreeDenseIndexes = newIndexes;
+		fgFreeDenseIndexCapacity = newCapacity;
+	}
+	fgFreeDenseIndexes[fgFreeDenseIndexCount++] = index;
 }
 
 void ImageLoader::setFileInfo(dev_t device, ino_t inode, time_t modDate)
@@ -296,20 +328,26 @@ void ImageLoader::getMappedRegions(MappedRegion*& regions) const
 
 
 bool ImageLoader::dependsOn(ImageLoader* image) {
-	for(unsigned int i=0; i < libraryCount(); ++i) {
-		if ( libImage(i) == image )
+	for(unsigned int i=0; i < fDependentCount; ++i) {
+		if ( fDependents[i].image == image )
 			return true;
 	}
 	return false;
 }
 
 
-static bool notInImgageList(const ImageLoader* image, const ImageLoader** dsiStart, const ImageLoader** dsiCur)
+// Images made after a search started have an index past its bitmap.  None of them can be a dependent
+// of an image being searched, so they count as already searched.
+static bool alreadySearched(const uint32_t searched[], uint32_t searchedLimit, uint32_t index)
 {
-	for (const ImageLoader** p = dsiStart; p < dsiCur; ++p)
-		if ( *p == image )
-			return false;
-	return true;
+	if ( index >= searchedLimit )
+		return true;
+	return (searched[index/32] & (1U << (index%32))) != 0;
+}
+
+static void markSearched(uint32_t searched[], uint32_t index)
+{
+	searched[index/32] |= (1U << (index%32));
 }
 
 bool ImageLoader::findExportedSymbolAddress(const LinkContext& context, const char* symbolName,
@@ -327,33 +365,33 @@ bool ImageLoader::findExportedSymbolAddress(const LinkContext& context, const ch
 
 // private method that handles circular dependencies by only search any image once
 const ImageLoader::Symbol* ImageLoader::findExportedSymbolInDependentImagesExcept(const char* name, 
-			const ImageLoader** dsiStart, const ImageLoader**& dsiCur, const ImageLoader** dsiEnd, const ImageLoader** foundIn) const
+			uint32_t searched[], uint32_t searchedLimit, const ImageLoader** foundIn) const
 {
 	const ImageLoader::Symbol* sym;
 	// search self
-	if ( notInImgageList(this, dsiStart, dsiCur) ) {
+	if ( !alreadySearched(searched, searchedLimit, fDenseIndex) ) {
 		sym = this->findExportedSymbol(name, false, this->getPath(), foundIn);
 		if ( sym != NULL )
 			return sym;
-		*dsiCur++ = this;
+		markSearched(searched, fDenseIndex);
 	}
 
 	// search directly dependent libraries
-	for(unsigned int i=0; i < libraryCount(); ++i) {
-		ImageLoader* dependentImage = libImage(i);
-		if ( (dependentImage != NULL) && notInImgageList(dependentImage, dsiStart, dsiCur) ) {
-			sym = dependentImage->findExportedSymbol(name, false, libPath(i), foundIn);
+	for(unsigned int i=0; i < fDependentCount; ++i) {
+		const Dependent& dependent = fDependents[i];
+		if ( !alreadySearched(searched, searchedLimit, dependent.image->fDenseIndex) ) {
+			sym = dependent.image->findExportedSymbol(name, false, dependent.path, foundIn);
 			if ( sym != NULL )
 				return sym;
 		}
 	}
 	
 	// search indirectly dependent libraries
-	for(unsigned int i=0; i < libraryCount(); ++i) {
-		ImageLoader* dependentImage = libImage(i);
-		if ( (dependentImage != NULL) && notInImgageList(dependentImage, dsiStart, dsiCur) ) {
-			*dsiCur++ = dependentImage; 
-			sym = dependentImage->findExportedSymbolInDependentImagesExcept(name, dsiStart, dsiCur, dsiEnd, foundIn);
+	for(unsigned int i=0; i < fDependentCount; ++i) {
+		const ImageLoader* dependentImage = fDependents[i].image;
+		if ( !alreadySearched(searched, searchedLimit, dependentImage->fDenseIndex) ) {
+			markSearched(searched, dependentImage->fDenseIndex);
+			sym = dependentImage->findExportedSymbolInDependentImagesExcept(name, searched, searchedLimit, foundIn);
 			if ( sym != NULL )
 				return sym;
 		}
@@ -365,19 +403,19 @@ const ImageLoader::Symbol* ImageLoader::findExportedSymbolInDependentImagesExcep
 
 const ImageLoader::Symbol* ImageLoader::findExportedSymbolInDependentImages(const char* name, const LinkContext& context, const ImageLoader** foundIn) const
 {
-	unsigned int imageCount = context.imageCount()+2;
-	const ImageLoader* dontSearchImages[imageCount];
-	dontSearchImages[0] = this; // don't search this image
-	const ImageLoader** cur = &dontSearchImages[1];
-	return this->findExportedSymbolInDependentImagesExcept(name, &dontSearchImages[0], cur, &dontSearchImages[imageCount], foundIn);
+	const uint32_t searchedLimit = fgDenseIndexLimit;
+	uint32_t searched[(searchedLimit+31)/32];
+	bzero(searched, sizeof(searched));
+	markSearched(searched, fDenseIndex); // don't search this image
+	return this->findExportedSymbolInDependentImagesExcept(name, searched, searchedLimit, foundIn);
 }
 
 const ImageLoader::Symbol* ImageLoader::findExportedSymbolInImageOrDependentImages(const char* name, const LinkContext& context, const ImageLoader** foundIn) const
 {
-	unsigned int imageCount = context.imageCount()+2;
-	const ImageLoader* dontSearchImages[imageCount];
-	const ImageLoader** cur = &dontSearchImages[0];
-	return this->findExportedSymbolInDependentImagesExcept(name, &dontSearchImages[0], cur, &dontSearchImages[imageCount], foundIn);
+	const uint32_t searchedLimit = fgDenseIndexLimit;
+	uint32_t searched[(searchedLimit+31)/32];
+	bzero(searched, sizeof(searched));
+	return this->findExportedSymbolInDependentImagesExcept(name, searched, searchedLimit, foundIn);
 }
 
 // this is called by initializeMainExecutable() to interpose on the initial set of images
@@ -726,6 +764,39 @@ unsigned int ImageLoader::recursiveUpdateDepth(unsigned int maxDepth, dyld3::Arr
 }
 
 
+// Copies what setLibImage() recorded into one array, so symbol searches don't have to decode
+// each library slot or walk the load commands for each library's path.
+void ImageLoader::setDependents()
+{
+	if ( fDependents != NULL ) {
+		free((void*)fDependents);
+		fDependents = NULL;
+		fDependentCount = 0;
+	}
+	unsigned int count = 0;
+	for(unsigned int i=0; i < libraryCount(); ++i) {
+		if ( libImage(i) != NULL )
+			++count;
+	}
+	if ( count == 0 )
+		return;
+	Dependent* dependents = (Dependent*)malloc(count*sizeof(Dependent));
+	if ( dependents == NULL )
+		throw "malloc failure for dependents";
+	unsigned int index = 0;
+	for(unsigned int i=0; i < libraryCount(); ++i) {
+		if ( ImageLoader* dependentImage = libImage(i) ) {
+			dependents[index].image      = dependentImage;
+			dependents[index].path       = libPath(i);
+			dependents[index].reExported = libReExported(i);
+			++index;
+		}
+	}
+	fDependents = dependents;
+	fDependentCount = count;
+}
+
+
 void ImageLoader::recursiveLoadLibraries(const LinkContext& context, bool preflightOnly, const RPathChain& loaderRPaths, const char* loadPath)
 {
 	if ( fState < dyld_image_state_dependents_mapped ) {
@@ -829,6 +900,7 @@ void ImageLoader::recursiveLoadLibraries(const LinkContext& context, bool prefli
 			setLibImage(i, dependentLib, depLibReExported, requiredLibInfo.upward);
 		}
 		fAllLibraryChecksumsAndLoadAddressesMatch = canUsePrelinkingInfo;
+		this->setDependents();
 
 		// tell each to load its dependents
 		for(unsigned int i=0; i < libraryCount(); ++i) {
@@ -1057,6 +1129,8 @@ void ImageLoader::weakBind(const LinkContext& context)
 #if TARGET_OS_OSX
 	  // only do alternate algorithm for dlopen(). Use traditional algorithm for launch
 	  if ( !context.linkingMainExecutable ) {
+		  if ( context.verboseWeakBind )
+			  dyld::log("dyld: weak binding dlopen using weak def map\n");
 		  // Don't take the memory hit of weak defs on the launch path until we hit a dlopen with more weak symbols to bind
 		  if (!context.weakDefMapProcessedLaunchDefs) {
 			  context.weakDefMapProcessedLaunchDefs = true;
@@ -1139,6 +1213,8 @@ void ImageLoader::weakBind(const LinkContext& context)
 						//  already coalesced.  Only images outside cache can potentially override something in cache.
 						if ( anImageInCache && imageBeingFixedUpInCache )
 							continue;
+						if ( !anImage->mightExportSymbol(nameToCoalesce) )
+							continue;
 
 						//dyld::log("looking for %s in %s\n", nameToCoalesce, anImage->getPath());
 						const ImageLoader* foundIn;
@@ -1157,20 +1233,29 @@ void ImageLoader::weakBind(const LinkContext& context)
 						patcher.makeWriteable();
 					coalIterator.image->updateUsesCoalIterator(coalIterator, targetAddr, (ImageLoader*)targetImage, 0, context);
 					if (weakDefIt == context.weakDefMap.end()) {
+						// nameToCoalesce points into the LINKEDIT of the image being fixed up, which might be dlclose()d
+						// without removeImage() knowing about this key, so the map needs its own copy
 						if (targetImage->neverUnload()) {
 							// Add never unload defs to the map for next time
-							context.weakDefMap.insert({ nameToCoalesce, { targetImage, targetAddr } });
+							context.weakDefMap.insert({ strdup(nameToCoalesce), { targetImage, targetAddr } });
 							if ( context.verboseWeakBind ) {
 								dyld::log("dyld: weak binding adding %s to map\n", nameToCoalesce);
 							}
 						} else {
 							// Add a placeholder for unloadable symbols which makes us fall back to the regular search
-							context.weakDefMap.insert({ nameToCoalesce, { targetImage, targetAddr } });
+							context.weakDefMap.insert({ strdup(nameToCoalesce), { targetImage, targetAddr } });
 							if ( context.verboseWeakBind ) {
 								dyld::log("dyld: weak binding adding unloadable placeholder %s to map\n", nameToCoalesce);
 							}
 						}
 					}
+					else if ( weakDefIt->second.first == nullptr ) {
+						// previous definition was unloaded, record the new one so later dlopens don't have to re-scan
+						weakDefIt->second = { targetImage, targetAddr };
+						if ( context.verboseWeakBind ) {
+							dyld::log("dyld: weak binding replacing unloaded %s in map\n", nameToCoalesce);
+						}
+					}
 					if ( context.verboseWeakBind )
 						dyld::log("dyld:     adjusting uses of %s in %s to use definition from %s\n", nameToCoalesce, coalIterator.image->getPath(), targetImage->getPath());
 				}
@@ -1267,9 +1352,11 @@ void ImageLoader::weakBind(const LinkContext& context)
 							iterators[i].symbolMatches = false; 
 						}
 					}
-					if (targetImage->neverUnload()) {
-						// Add never unload defs to the map for next time
-						context.weakDefMap.insert({ nameToCoalesce, { targetImage, targetAddr } });
+					if (targetImage->neverUnload() && (context.weakDefMap.find(nameToCoalesce) == context.weakDefMap.end())) {
+						// Add never unload defs to the map for next time.  Images linked at launch are never unloaded,
+						// but after launch the name may be in an image which could be dlclose()d
+						const char* mapName = context.linkingMainExecutable ? nameToCoalesce : strdup(nameToCoalesce);
+						context.weakDefMap.insert({ mapName, { targetImage, targetAddr } });
 						if ( context.verboseWeakBind ) {
 							dyld::log("dyld: weak binding adding %s to map\n",
 										nameToCoalesce);
@@ -1582,6 +1669,25 @@ void ImageLoader::setNeverUnloadRecursive() {
 	}
 }
 
+// Lock-free dlsym() only looks at an image once this is set, so it must be called after weak binding, interposing,
+// and hiding exports are all done.  Dependents are marked before the images that link against them.
+void ImageLoader::setBoundForLockFreeReadersRecursive(std::vector<const ImageLoader*>& visiting)
+{
+	if ( this->isBoundForLockFreeReaders() )
+		return;
+	// break cycles
+	if ( std::find(visiting.begin(), visiting.end(), this) != visiting.end() )
+		return;
+	visiting.push_back(this);
+	for(unsigned int i=0; i < libraryCount(); ++i) {
+		ImageLoader* dependentImage = libImage(i);
+		if ( dependentImage != NULL )
+			dependentImage->setBoundForLockFreeReadersRecursive(visiting);
+	}
+	visiting.pop_back();
+	__atomic_store_n(&fBoundForLockFreeReaders, true, __ATOMIC_RELEASE);
+}
+
 void ImageLoader::recursiveSpinLock(recursive_lock& rlock)
 {
 	// try to set image's ivar fInitializerRecursiveLock to point to this lock_info
@@ -1629,6 +1735,7 @@ void ImageLoader::recursiveInitialization(const LinkContext& context, mach_port_
 		fState = dyld_image_state_dependents_initialized-1;
 		try {
 			// initialize lower level libraries first
+			uint16_t initDepth = 0;
 			for(unsigned int i=0; i < libraryCount(); ++i) {
 				ImageLoader* dependentImage = libImage(i);
 				if ( dependentImage != NULL ) {
@@ -1637,11 +1744,15 @@ void ImageLoader::recursiveInitialization(const LinkContext& context, mach_port_
 						uninitUps.imagesAndPaths[uninitUps.count] = { dependentImage, libPath(i) };
 						uninitUps.count++;
 					}
-					else if ( dependentImage->fDepth >= fDepth ) {
-						dependentImage->recursiveInitialization(context, this_thread, libPath(i), timingInfo, uninitUps);
+					else {
+						if ( dependentImage->fDepth >= fDepth )
+							dependentImage->recursiveInitialization(context, this_thread, libPath(i), timingInfo, uninitUps);
+						if ( dependentImage->fInitDepth + 1 > initDepth )
+							initDepth = dependentImage->fInitDepth + 1;
 					}
                 }
 			}
+			fInitDepth = initDepth;
 			
 			// record termination order
 			if ( this->needsTermination() )
@@ -1664,6 +1775,13 @@ void ImageLoader::recursiveInitialization(const LinkContext& context, mach_port_
 			if ( hasInitializers ) {
 				uint64_t t2 = mach_absolute_time();
 				timingInfo.addTime(this->getShortName(), t2-t1);
+				if ( context.verboseInitTimes ) {
+					static mach_timebase_info_data_t sTimebaseInfo;
+					if ( sTimebaseInfo.denom == 0 )
+						mach_timebase_info(&sTimebaseInfo);
+					uint64_t micros = ((t2 - t1) * sTimebaseInfo.numer) / (sTimebaseInfo.denom * 1000);
+					dyld::log("dyld: initializers in %s took %llu us, dependency depth %u\n", this->getPath(), micros, fInitDepth);
+				}
 			}
 		}
 		catch (const char* msg) {
@@ -1831,7 +1949,7 @@ void ImageLoader::addSuffix(const char* path, const char* suffix, char* result)
 const uint8_t* ImageLoader::trieWalk(const uint8_t* start, const uint8_t* end, const char* s)
 {
 	//dyld::log("trieWalk(%p, %p, %s)\n", start, end, s);
-	++fgSymbolTrieSearchs;
+	__atomic_fetch_add(&fgSymbolTrieSearchs, 1, __ATOMIC_RELAXED);
 	const uint8_t* p = start;
 	while ( p != NULL ) {
 		uintptr_t terminalSize = *p++;
@@ -1854,29 +1972,20 @@ const uint8_t* ImageLoader::trieWalk(const uint8_t* start, const uint8_t* end, c
 		p = children;
 		uintptr_t nodeOffset = 0;
 		for (; childrenRemaining > 0; --childrenRemaining) {
-			const char* ss = s;
 			//dyld::log("trieWalk(%p) child str=%s\n", start, (char*)p);
-			bool wrongEdge = false;
-			// scan whole edge to get to next edge
-			// if edge is longer than target symbol name, don't read past end of symbol name
-			char c = *p;
-			while ( c != '\0' ) {
-				if ( !wrongEdge ) {
-					if ( c != *ss )
-						wrongEdge = true;
-					++ss;
-				}
-				++p;
-				c = *p;
+			// compare whole edge with symbol, and find end of edge
+			bool edgeMatches;
+			const uint8_t* edgeEnd = dyld3::trieMatchEdge<false>(p, end, s, edgeMatches);
+			if ( edgeEnd == NULL ) {
+				dyld::log("trieWalk() malformed trie node, child node extends past end of trie\n");
+				return NULL;
 			}
-			if ( wrongEdge ) {
+			const size_t edgeLength = edgeEnd - p;
+			p = edgeEnd + 1; // skip over zero terminator
+			if ( !edgeMatches ) {
 				// advance to next child
-				++p; // skip over zero terminator
-				// skip over uleb128 until last byte is found
-				while ( (*p & 0x80) != 0 )
-					++p;
-				++p; // skip over last byte of uleb128
-				if ( p > end ) {
+				p = dyld3::trieSkipUleb128(p, end);
+				if ( p == NULL ) {
 					dyld::log("trieWalk() malformed trie node, child node extends past end of trie\n");
 					return NULL;
 				}
@@ -1884,13 +1993,12 @@ const uint8_t* ImageLoader::trieWalk(const uint8_t* start, const uint8_t* end, c
 			else {
  				// the symbol so far matches this edge (child)
 				// so advance to the child's node
-				++p;
 				nodeOffset = read_uleb128(p, end);
 				if ( (nodeOffset == 0) || ( &start[nodeOffset] > end) ) {
 					dyld::log("trieWalk() malformed trie child, nodeOffset=0x%lx out of range\n", nodeOffset);
 					return NULL;
 				}
-				s = ss;
+				s += edgeLength;
 				//dyld::log("trieWalk() found matching edge advancing to node 0x%lx\n", nodeOffset);
 				break;
 			}
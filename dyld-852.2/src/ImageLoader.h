@@ -332,6 +332,7 @@ public:
 		bool			verboseBind;
 		bool			verboseWeakBind;
 		bool			verboseInit;
+		bool			verboseInitTimes;
 		bool			verboseDOF;
 		bool			verbosePrebinding;
 		bool			verboseCoreSymbolication;
@@ -464,6 +465,9 @@ public:
 																const ImageLoader* requestorImage, int requestorOrdinalOfDef,
 																bool runResolver, const ImageLoader** foundIn, uintptr_t* address) const;
 
+										// quick check used by flat lookups to skip images, false means image definitely does not export name
+	virtual bool						mightExportSymbol(const char* name) const { return true; }
+
 										// search symbol table of definitions in this image for requested name
 	virtual const Symbol*				findExportedSymbol(const char* name, bool searchReExports, const char* thisPath, const ImageLoader** foundIn) const = 0;
 	
@@ -648,6 +652,8 @@ public:
 
 	void								setNeverUnload() { fNeverUnload = true; fLeaveMapped = true; }
 	void								setNeverUnloadRecursive();
+
+	void								setBoundForLockFreeReadersRecursive(std::vector<const ImageLoader*>& visiting);
 	
 	void								forEachReExportDependent( void (^callback)(const ImageLoader*, bool& stop)) const;
 
@@ -697,6 +703,9 @@ public:
 			void						setAddFuncNotified() { fAddFuncNotified = true; }
 			bool						addFuncNotified() const { return fAddFuncNotified; }
 	
+			// set once linking this image is completely done, with release ordering, so lock-free dlsym() can tell dlopen() is done with it
+			bool						isBoundForLockFreeReaders() const { return __atomic_load_n(&fBoundForLockFreeReaders, __ATOMIC_ACQUIRE); }
+
 			void						setObjCMappedNotified() { fObjCMappedNotified = true; }
 			bool						objCMappedNotified() const { return fObjCMappedNotified; }
 
@@ -748,7 +757,16 @@ protected:
 	
 
 
+	struct Dependent {
+		ImageLoader*	image;
+		const char*		path;			// install name this image links against it by
+		bool			reExported;
+	};
+
 	unsigned int			libraryCount() const { return fLibraryCount; }
+						// the loaded dependents, in load command order, missing weak libraries left out
+	const Dependent*		dependents() const { return fDependents; }
+	unsigned int			dependentCount() const { return fDependentCount; }
 	virtual ImageLoader*	libImage(unsigned int) const = 0;
 	virtual bool			libReExported(unsigned int) const = 0;
 	virtual bool			libIsUpward(unsigned int) const = 0;
@@ -870,8 +888,11 @@ protected:
 	void						recursiveSpinUnLock();
 
 private:
-	const ImageLoader::Symbol*	findExportedSymbolInDependentImagesExcept(const char* name, const ImageLoader** dsiStart, 
-										const ImageLoader**& dsiCur, const ImageLoader** dsiEnd, const ImageLoader** foundIn) const;
+	const ImageLoader::Symbol*	findExportedSymbolInDependentImagesExcept(const char* name, uint32_t searched[], uint32_t searchedLimit,
+										const ImageLoader** foundIn) const;
+	void						setDependents();
+	static uint32_t				allocDenseIndex();
+	static void					freeDenseIndex(uint32_t index);
 
 	void						processInitializers(const LinkContext& context, mach_port_t this_thread,
 													InitializerTimingList& timingInfo, ImageLoader::UninitedUpwards& ups);
@@ -880,6 +901,11 @@ private:
 
 
 	recursive_lock*				fInitializerRecursiveLock;
+	const Dependent*			fDependents;
+	uint32_t					fDependentCount;
+	uint32_t					fDenseIndex;	// small number unique among live images, for bitmaps of images
+	uint16_t					fInitDepth;		// longest chain of non-upward dependents, set when initialized
+	bool						fBoundForLockFreeReaders;	// not in the bit fields below, so it can be read atomically
 	union {
 		struct {
 			uint16_t					fLoadOrder;
@@ -908,6 +934,10 @@ private:
 	static_assert(sizeof(sizeOfData) == 8, "Bad data size");
 
 	static uint16_t				fgLoadOrdinal;
+	static uint32_t				fgDenseIndexLimit;
+	static uint32_t*			fgFreeDenseIndexes;
+	static uint32_t				fgFreeDenseIndexCount;
+	static uint32_t				fgFreeDenseIndexCapacity;
 
 };
 
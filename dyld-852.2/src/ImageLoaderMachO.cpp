@@ -87,6 +87,7 @@ extern "C" long __stack_chk_guard;
 #endif
 
 uint32_t ImageLoaderMachO::fgSymbolTableBinarySearchs = 0;
+uint32_t ImageLoaderMachO::fgSymbolTrieSearchsAvoided = 0;
 
 
 ImageLoaderMachO::ImageLoaderMachO(const macho_header* mh, const char* path, unsigned int segCount, 
@@ -1683,15 +1684,12 @@ const ImageLoader::Symbol* ImageLoaderMachO::findExportedSymbol(const char* name
 		return result;
 	
 	if ( searchReExports ) {
-		for(unsigned int i=0; i < libraryCount(); ++i){
-			if ( libReExported(i) ) {
-				ImageLoader* image = libImage(i);
-				if ( image != NULL ) {
-					const char* reExPath = libPath(i);
-					result = image->findExportedSymbol(name, searchReExports, reExPath, foundIn);
-					if ( result != NULL )
-						return result;
-				}
+		const Dependent* deps = dependents();
+		for(unsigned int i=0; i < dependentCount(); ++i){
+			if ( deps[i].reExported ) {
+				result = deps[i].image->findExportedSymbol(name, searchReExports, deps[i].path, foundIn);
+				if ( result != NULL )
+					return result;
 			}
 		}
 	}
@@ -2485,6 +2483,7 @@ void ImageLoaderMachO::printStatisticsDetails(unsigned int imageCount, const Ini
 {
 	ImageLoader::printStatisticsDetails(imageCount, timingInfo);
 	dyld::log("total symbol trie searches:    %d\n", fgSymbolTrieSearchs);
+	dyld::log("total symbol trie searches avoided by export filter:    %d\n", fgSymbolTrieSearchsAvoided);
 	dyld::log("total symbol table binary searches:    %d\n", fgSymbolTableBinarySearchs);
 	dyld::log("total images defining weak symbols:  %u\n", fgImagesHasWeakDefinitions);
 	dyld::log("total images using weak symbols:  %u\n", fgImagesRequiringCoalescing);
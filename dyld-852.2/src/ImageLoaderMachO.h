@@ -288,6 +288,7 @@ protected:
 
 											
 	static uint32_t					fgSymbolTableBinarySearchs;
+	static uint32_t					fgSymbolTrieSearchsAvoided;
 };
 
 
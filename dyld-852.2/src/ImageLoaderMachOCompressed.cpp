@@ -39,6 +39,7 @@
 #include <mach/thread_status.h>
 #include <mach-o/loader.h> 
 #include <mach-o/dyld_images.h>
+#include <libkern/OSAtomic.h>
 
 #include "dyld2.h"
 #include "ImageLoaderMachOCompressed.h"
@@ -261,14 +262,17 @@ ImageLoaderMachOCompressed* ImageLoaderMachOCompressed::instantiateFromMemory(co
 
 ImageLoaderMachOCompressed::ImageLoaderMachOCompressed(const macho_header* mh, const char* path, unsigned int segCount, 
 																		uint32_t segOffsets[], unsigned int libCount)
- : ImageLoaderMachO(mh, path, segCount, segOffsets, libCount), fDyldInfo(NULL), fChainedFixups(NULL), fExportsTrie(NULL)
+ : ImageLoaderMachO(mh, path, segCount, segOffsets, libCount), fDyldInfo(NULL), fChainedFixups(NULL), fExportsTrie(NULL), fExportFilter(NULL)
 {
 }
 
+static void freeExportFilter(const ImageLoaderMachOCompressed::ExportFilter* filter);
+
 ImageLoaderMachOCompressed::~ImageLoaderMachOCompressed()
 {
 	// don't do clean up in ~ImageLoaderMachO() because virtual call to segmentCommandOffsets() won't work
 	destroy();
+	freeExportFilter(fExportFilter);
 }
 
 
@@ -481,7 +485,7 @@ const ImageLoader::Symbol* ImageLoaderMachOCompressed::findShallowExportedSymbol
 #if LOG_BINDINGS
 	dyld::logBindings("%s: %s\n", this->getShortName(), symbol);
 #endif
-	++ImageLoaderMachO::fgSymbolTrieSearchs;
+	__atomic_fetch_add(&ImageLoaderMachO::fgSymbolTrieSearchs, 1, __ATOMIC_RELAXED);
 	const uint8_t* start = &fLinkEditBase[trieFileOffset];
 	const uint8_t* end = &start[trieFileSize];
 	const uint8_t* foundNodeStart = this->trieWalk(start, end, symbol); 
@@ -521,6 +525,159 @@ const ImageLoader::Symbol* ImageLoaderMachOCompressed::findShallowExportedSymbol
 }
 
 
+//
+// Flat namespace lookups, dlsym(RTLD_DEFAULT), and weak coalescing probe every image for
+// a symbol name, which costs a trie walk per image even though most images do not export it.
+// To make those misses cheap, the first time an image is probed that way, a bloom filter of
+// all names in its export trie is built.  A clear bit means the name is definitely not exported.
+//
+struct ImageLoaderMachOCompressed::ExportFilter
+{
+	uint32_t	wordMask;		// word count - 1, word count is a power of 2
+	uint32_t	alwaysMatch;	// set if trie could not be parsed
+	uint64_t	words[1];
+};
+
+static const uint32_t kExportFilterBitsPerName   = 10;
+static const uint32_t kExportFilterHashCount     = 3;
+static const unsigned kExportFilterMaxTrieDepth  = 256;
+
+static ImageLoaderMachOCompressed::ExportFilter sAlwaysMatchExportFilter = { 0, 1, { 0 } };
+
+// FNV-1a, which can be computed incrementally along trie edges
+static inline uint64_t exportFilterHashStep(uint64_t hash, uint8_t c)
+{
+	return (hash ^ c) * 0x100000001B3ULL;
+}
+
+static uint64_t exportFilterHash(const char* name)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (const uint8_t* p = (uint8_t*)name; *p != '\0'; ++p)
+		hash = exportFilterHashStep(hash, *p);
+	return hash;
+}
+
+static bool exportFilterMightContain(const ImageLoaderMachOCompressed::ExportFilter* filter, uint64_t hash, bool add)
+{
+	const uint64_t bitMask = ((uint64_t)filter->wordMask << 6) | 0x3F;
+	const uint64_t delta = (hash >> 32) | 1;
+	bool allSet = true;
+	for (uint32_t i=0; i < kExportFilterHashCount; ++i) {
+		const uint64_t bit = hash & bitMask;
+		uint64_t* word = const_cast<uint64_t*>(&filter->words[bit >> 6]);
+		const uint64_t wordBit = 1ULL << (bit & 0x3F);
+		if ( add )
+			*word |= wordBit;
+		else if ( (*word & wordBit) == 0 )
+			allSet = false;
+		hash += delta;
+	}
+	return allSet;
+}
+
+static void freeExportFilter(const ImageLoaderMachOCompressed::ExportFilter* filter)
+{
+	if ( (filter != NULL) && (filter != &sAlwaysMatchExportFilter) )
+		free((void*)filter);
+}
+
+// walks all terminal nodes in trie, counting them and adding them to filter (if not NULL)
+// returns false if trie is malformed
+static bool addExportTrieToFilter(const uint8_t* start, const uint8_t* end, const uint8_t* node, uint64_t prefixHash, unsigned depth,
+								  uintptr_t& nodesRemaining, uint32_t& exportCount, ImageLoaderMachOCompressed::ExportFilter* filter)
+{
+	if ( (depth > kExportFilterMaxTrieDepth) || (nodesRemaining == 0) || (node >= end) )
+		return false;
+	--nodesRemaining;
+	const uint8_t* p = node;
+	const uintptr_t terminalSize = ImageLoader::read_uleb128(p, end);
+	if ( terminalSize != 0 ) {
+		++exportCount;
+		if ( filter != NULL )
+			exportFilterMightContain(filter, prefixHash, true);
+	}
+	const uint8_t* children = p + terminalSize;
+	if ( children >= end )
+		return false;
+	uint8_t childrenRemaining = *children++;
+	p = children;
+	for (; childrenRemaining > 0; --childrenRemaining) {
+		uint64_t edgeHash = prefixHash;
+		while ( (p < end) && (*p != '\0') )
+			edgeHash = exportFilterHashStep(edgeHash, *p++);
+		if ( p >= end )
+			return false;
+		++p; // skip over zero terminator
+		const uintptr_t childOffset = ImageLoader::read_uleb128(p, end);
+		if ( (childOffset == 0) || (childOffset >= (uintptr_t)(end - start)) )
+			return false;
+		if ( !addExportTrieToFilter(start, end, &start[childOffset], edgeHash, depth+1, nodesRemaining, exportCount, filter) )
+			return false;
+	}
+	return true;
+}
+
+const ImageLoaderMachOCompressed::ExportFilter* ImageLoaderMachOCompressed::buildExportFilter() const
+{
+	uint32_t trieFileOffset = fDyldInfo ? fDyldInfo->export_off  : fExportsTrie->dataoff;
+	uint32_t trieFileSize   = fDyldInfo ? fDyldInfo->export_size : fExportsTrie->datasize;
+	const uint8_t* start = &fLinkEditBase[trieFileOffset];
+	const uint8_t* end = &start[trieFileSize];
+	ExportFilter* filter = NULL;
+	try {
+		// first pass counts names, so filter can be sized
+		uint32_t exportCount = 0;
+		uintptr_t nodesRemaining = trieFileSize;
+		if ( (trieFileSize == 0) || addExportTrieToFilter(start, end, start, exportFilterHash(""), 0, nodesRemaining, exportCount, NULL) ) {
+			uint32_t wordCount = 1;
+			while ( (wordCount * 64) < (exportCount * kExportFilterBitsPerName) )
+				wordCount *= 2;
+			filter = (ExportFilter*)calloc(offsetof(ExportFilter, words[wordCount]), 1);
+			if ( filter != NULL ) {
+				filter->wordMask = wordCount - 1;
+				exportCount = 0;
+				nodesRemaining = trieFileSize;
+				if ( (trieFileSize != 0) && !addExportTrieToFilter(start, end, start, exportFilterHash(""), 0, nodesRemaining, exportCount, filter) ) {
+					free(filter);
+					filter = NULL;
+				}
+			}
+		}
+	}
+	catch (const char* msg) {
+		// malformed uleb128
+		free((void*)msg);
+		free(filter);
+		filter = NULL;
+	}
+	if ( filter == NULL )
+		filter = &sAlwaysMatchExportFilter;
+
+	// flat lookups are done with the dyld lock held, but make sure readers never see a partial filter
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+	if ( !OSAtomicCompareAndSwapPtrBarrier(NULL, (void*)filter, (void* volatile*)&fExportFilter) ) {
+		freeExportFilter(filter);
+		filter = fExportFilter;
+	}
+#pragma clang diagnostic pop
+	return filter;
+}
+
+bool ImageLoaderMachOCompressed::mightExportSymbol(const char* name) const
+{
+	const ExportFilter* filter = fExportFilter;
+	if ( filter == NULL )
+		filter = this->buildExportFilter();
+	if ( filter->alwaysMatch || exportFilterMightContain(filter, exportFilterHash(name), false) )
+		return true;
+	// flat lookups call this without the dyld lock, e.g. from dlsym(RTLD_DEFAULT) on many threads
+	__atomic_fetch_add(&ImageLoaderMachO::fgSymbolTrieSearchsAvoided, 1, __ATOMIC_RELAXED);
+	return false;
+}
+
+
 bool ImageLoaderMachOCompressed::containsSymbol(const void* addr) const
 {
 	uint32_t trieFileOffset = fDyldInfo ? fDyldInfo->export_off  : fExportsTrie->dataoff;
@@ -1145,45 +1302,59 @@ void ImageLoaderMachOCompressed::registerInterposing(const LinkContext& context)
 			const InterposeData* interposeArray = (InterposeData*)(fMachOData+vmOffset);
 			if ( context.verboseInterposing )
 				dyld::log("dyld: found %lu interposing tuples in %s\n", count, getPath());
+			// decode the binds once, noting which one sets each tuple's replacee
+			struct ReplaceeBind { const char* symbolName; int libOrdinal; bool weakImport; };
+			std::vector<ReplaceeBind> replacees(count, ReplaceeBind{ NULL, 0, false });
+			ReplaceeBind* replaceeBinds = replacees.data();
+			ma->forEachBindBatch(diag, ^(const dyld3::MachOAnalyzer::PackedBind binds[], uint32_t bindCount,
+										 const dyld3::MachOAnalyzer::BindTarget targets[], uint32_t targetCount, bool& stopBinds) {
+				for (uint32_t i=0; i < bindCount; ++i) {
+					if ( binds[i].runtimeOffset < vmOffset )
+						continue;
+					const uint64_t offsetInSection = binds[i].runtimeOffset - vmOffset;
+					const uint64_t j = offsetInSection / sizeof(InterposeData);
+					if ( (j >= count) || ((offsetInSection % sizeof(InterposeData)) != offsetof(InterposeData, replacee)) )
+						continue;
+					if ( replaceeBinds[j].symbolName != NULL )
+						continue;
+					const dyld3::MachOAnalyzer::BindTarget& target = targets[binds[i].targetIndex];
+					replaceeBinds[j] = { target.symbolName, target.libOrdinal, target.weakImport };
+				}
+			});
 			for (size_t j=0; j < count; ++j) {
-				uint64_t bindOffset = ((uint8_t*)&(interposeArray[j].replacee)) - fMachOData;
-				ma->forEachBind(diag, ^(uint64_t runtimeOffset, int libOrdinal, const char* symbolName, bool weakImport, bool lazyBind, uint64_t addend, bool& stopBinds) {
-					if ( bindOffset != runtimeOffset )
-						return;
-					stopBinds = true;
-					LastLookup* last = NULL;
-					const ImageLoader* targetImage;
-					uintptr_t targetBindAddress = 0;
-					try {
-						targetBindAddress = this->resolve(context, symbolName, 0, libOrdinal, &targetImage, *patcherPtr, last, false);
-					}
-					catch (const char* msg) {
-						if ( !weakImport )
-							throw msg;
-						targetBindAddress = 0;
-					}
-					ImageLoader::InterposeTuple tuple;
-					tuple.replacement     = interposeArray[j].replacement;
-					tuple.neverImage      = this;
-					tuple.onlyImage       = NULL;
-					tuple.replacee        = targetBindAddress;
-					// <rdar://problem/25686570> ignore interposing on a weak function that does not exist
-					if ( tuple.replacee == 0 )
-						return;
-					// <rdar://problem/7937695> verify that replacement is in this image
-					if ( this->containsAddress((void*)tuple.replacement) ) {
-						if ( context.verboseInterposing )
-							dyld::log("dyld:   interposing 0x%lx with 0x%lx\n", tuple.replacee, tuple.replacement);
-						// chain to any existing interpositions
-						for (std::vector<InterposeTuple>::iterator it=fgInterposingTuples.begin(); it != fgInterposingTuples.end(); it++) {
-							if ( it->replacee == tuple.replacee ) {
-								tuple.replacee = it->replacement;
-							}
+				if ( replacees[j].symbolName == NULL )
+					continue;
+				LastLookup* last = NULL;
+				const ImageLoader* targetImage;
+				uintptr_t targetBindAddress = 0;
+				try {
+					targetBindAddress = this->resolve(context, replacees[j].symbolName, 0, replacees[j].libOrdinal, &targetImage, *patcherPtr, last, false);
+				}
+				catch (const char* msg) {
+					if ( !replacees[j].weakImport )
+						throw msg;
+					targetBindAddress = 0;
+				}
+				ImageLoader::InterposeTuple tuple;
+				tuple.replacement     = interposeArray[j].replacement;
+				tuple.neverImage      = this;
+				tuple.onlyImage       = NULL;
+				tuple.replacee        = targetBindAddress;
+				// <rdar://problem/25686570> ignore interposing on a weak function that does not exist
+				if ( tuple.replacee == 0 )
+					continue;
+				// <rdar://problem/7937695> verify that replacement is in this image
+				if ( this->containsAddress((void*)tuple.replacement) ) {
+					if ( context.verboseInterposing )
+						dyld::log("dyld:   interposing 0x%lx with 0x%lx\n", tuple.replacee, tuple.replacement);
+					// chain to any existing interpositions
+					for (std::vector<InterposeTuple>::iterator it=fgInterposingTuples.begin(); it != fgInterposingTuples.end(); it++) {
+						if ( it->replacee == tuple.replacee ) {
+							tuple.replacee = it->replacement;
 						}
-						ImageLoader::fgInterposingTuples.push_back(tuple);
 					}
-				}, ^(const char* symbolName){
-				});
+					ImageLoader::fgInterposingTuples.push_back(tuple);
+				}
 			}
 		}
 	});
@@ -71,6 +71,8 @@ public:
 	virtual bool						usesChainedFixups() const;
 	virtual void						makeDataReadOnly() const;
 
+	struct ExportFilter;
+
 protected:
 	virtual void						doInterpose(const LinkContext& context);
 	virtual void						dynamicInterpose(const LinkContext& context);
@@ -83,6 +85,7 @@ protected:
 	virtual uint32_t*					segmentCommandOffsets() const;
 	virtual	void						rebase(const LinkContext& context, uintptr_t slide);
 	virtual const ImageLoader::Symbol*	findShallowExportedSymbol(const char* name, const ImageLoader** foundIn) const;
+	virtual bool						mightExportSymbol(const char* name) const;
 	virtual bool						containsSymbol(const void* addr) const;
 	virtual uintptr_t					exportedSymbolAddress(const LinkContext& context, const Symbol* symbol, const ImageLoader* requestor, bool runResolver) const;
 	virtual bool						exportedSymbolIsWeakDefintion(const Symbol* symbol) const;
@@ -152,10 +155,12 @@ private:
 	void								registerEncryption(const struct encryption_info_command* encryptCmd, const LinkContext& context);
 	void								doApplyFixups(const LinkContext& context, const dyld_chained_fixups_header* fixupsHeader,
 												      DyldSharedCache::DataConstLazyScopedWriter& patcher);
+	const ExportFilter*					buildExportFilter() const;
 
 	const struct dyld_info_command*			fDyldInfo;
 	const struct linkedit_data_command*		fChainedFixups;
 	const struct linkedit_data_command*		fExportsTrie;
+	mutable const ExportFilter*				fExportFilter;
 };
 
 
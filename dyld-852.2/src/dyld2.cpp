@@ -35,6 +35,7 @@
 #include <mach/mach_time.h> // mach_absolute_time()
 #include <mach/mach_init.h>
 #include <mach/mach_traps.h>
+#include <mach/thread_switch.h>
 #include <sys/types.h>
 #include <sys/stat.h> 
 #include <sys/syscall.h>
@@ -148,6 +149,7 @@ extern "C" int __fork();
 #include "BootArgs.h"
 #include "Defines.h"
 #include "RootsChecker.h"
+#include "BulkFileInfo.h"
 
 #ifndef MH_HAS_OBJC
   #define MH_HAS_OBJC			0x40000000
@@ -185,6 +187,7 @@ extern void addImagesToAllImages(uint32_t infoCount, const dyld_image_info info[
 extern void addAotImagesToAllAotImages(uint32_t aotInfoCount, const dyld_aot_image_info aotInfo[]);
 extern void removeImageFromAllImages(const mach_header* mh);
 extern void addNonSharedCacheImageUUID(const dyld_uuid_info& info);
+extern void setCompactImageInfoEnabled(bool enabled);
 extern const char* notifyGDB(enum dyld_image_states state, uint32_t infoCount, const dyld_image_info info[]);
 extern size_t allImagesCount();
 
@@ -251,6 +254,7 @@ struct EnvironmentVariables {
 							//	DYLD_PRINT_ENV					==> gLinkContext.verboseEnv
 							//	DYLD_FORCE_FLAT_NAMESPACE		==> gLinkContext.bindFlat
 							//	DYLD_PRINT_INITIALIZERS			==> gLinkContext.verboseInit
+							//	DYLD_PRINT_INITIALIZER_TIMES	==> gLinkContext.verboseInitTimes
 							//	DYLD_PRINT_SEGMENTS				==> gLinkContext.verboseMapping
 							//	DYLD_PRINT_BINDINGS				==> gLinkContext.verboseBind
 							//  DYLD_PRINT_WEAK_BINDINGS		==> gLinkContext.verboseWeakBind
@@ -265,6 +269,8 @@ struct EnvironmentVariables {
 							//	DYLD_PRINT_RPATHS				==> gLinkContext.verboseRPaths
 							//	DYLD_PRINT_INTERPOSING			==> gLinkContext.verboseInterposing
 							//  DYLD_PRINT_LIBRARIES			==> gLinkContext.verboseLoading
+							//  DYLD_LEGACY_WEAK_BIND			==> gLinkContext.useNewWeakBind
+							//  DYLD_PUBLISH_COMPACT_IMAGE_INFO	==> setCompactImageInfoEnabled()
 };
 
 
@@ -390,6 +396,7 @@ static ClosureMode					sClosureMode = ClosureMode::Unset;
 static ClosureKind					sClosureKind = ClosureKind::unset;
 static bool							sForceInvalidSharedCacheClosureFormat = false;
 static uint64_t						launchTraceID = 0;
+static uint64_t						launchStartTime = 0;
 
 // These flags are the values in the 64-bit _COMM_PAGE_DYLD_SYSTEM_FLAGS entry
 // Note we own this and can write it from PID 1
@@ -410,100 +417,269 @@ enum CommPageFlags : uint64_t {
 	fileSystemCanBeModified				= 1ULL << 35
 };
 
+//
+// dlsym(), dladdr() and the image list queries look at the loaded images without taking the
+// global dyld lock.  A lock-free reader does so inside a LockFreeReadScope, which counts it in
+// sLockFreeReaders.  Writers hold the dyld lock (or are launching), so there is only ever one,
+// and they never change anything a reader might be using: the sMappedRanges and sImageList
+// tables are replaced, with the old copy retired until no reader is active, and a removed image
+// is only deleted after waiting out the readers which might have found it.
+//
+
 //
 // The MappedRanges structure is used for fast address->image lookups.
-// The table is only updated when the dyld lock is held, so we don't
-// need to worry about multiple writers.  But readers may look at this
-// data without holding the lock. Therefore, all updates must be done
-// in an order that will never cause readers to see inconsistent data.
-// The general rule is that if the image field is non-NULL then
-// the other fields are valid.
+// It is an array of non-overlapping [start,end) ranges sorted by address,
+// so lookups are a binary search.  A published table is never modified.
+// Instead, writers build a new sorted table and swap it in with a barrier,
+// so readers always see a consistent snapshot.
 //
+struct MappedRange
+{
+	uintptr_t		start;
+	uintptr_t		end;
+	ImageLoader*	image;
+};
+
 struct MappedRanges
 {
-	MappedRanges*		next;
+	MappedRanges*		retiredNext;
+	unsigned long		count;
+	MappedRange			array[1];
+};
+
+//
+// The ImageList structure is the lock-free copy of sAllImages, in the same order.
+// Images are appended in place while there is capacity, which is safe because
+// readers only look at the first count entries.  Anything else makes a new list.
+//
+struct ImageList
+{
+	ImageList*			retiredNext;
 	unsigned long		count;
-	struct {
-		ImageLoader*	image;
-		uintptr_t		start;
-		uintptr_t		end;
-	} array[1];
+	unsigned long		capacity;
+	ImageLoader*		images[1];
+};
+
+//
+// Other lock-free readable tables, such as the image info copy in dyld_debugger.cpp, are
+// retired through retireLockFreeTable().  They start with the same retiredNext link.
+//
+struct RetiredTable
+{
+	RetiredTable*		retiredNext;
 };
 
-static MappedRanges*	sMappedRangesStart;
+static MappedRanges* volatile	sMappedRanges;
+static MappedRanges*			sRetiredMappedRanges;
+static ImageList* volatile		sImageList;
+static ImageList*				sRetiredImageLists;
+static RetiredTable*			sRetiredTables;
+static volatile int32_t			sLockFreeReaders;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-void addMappedRange(ImageLoader* image, uintptr_t start, uintptr_t end)
-{
-	//dyld::log("addMappedRange(0x%lX->0x%lX) for %s\n", start, end, image->getShortName());
-	for (MappedRanges* p = sMappedRangesStart; p != NULL; p = p->next) {
-		for (unsigned long i=0; i < p->count; ++i) {
-			if ( p->array[i].image == NULL ) {
-				p->array[i].start = start;
-				p->array[i].end = end;
-				// add image field last with a barrier so that any reader will see consistent records
-				OSMemoryBarrier();
-				p->array[i].image = image;
-				return;
-			}
-		}
+LockFreeReadScope::LockFreeReadScope()
+{
+	OSAtomicIncrement32Barrier(&sLockFreeReaders);
+}
+
+LockFreeReadScope::~LockFreeReadScope()
+{
+	OSAtomicDecrement32Barrier(&sLockFreeReaders);
+}
+
+void waitForLockFreeReaders()
+{
+	OSMemoryBarrier();
+	while ( sLockFreeReaders != 0 )
+		thread_switch(MACH_PORT_NULL, SWITCH_OPTION_DEPRESS, 1);
+}
+
+static void freeRetiredTables()
+{
+	// readers bump sLockFreeReaders before loading sMappedRanges or sImageList, so if there are
+	// no readers now, any later reader can only see the current tables and retired ones are unreachable
+	if ( sLockFreeReaders != 0 )
+		return;
+	while ( sRetiredMappedRanges != NULL ) {
+		MappedRanges* next = sRetiredMappedRanges->retiredNext;
+		free(sRetiredMappedRanges);
+		sRetiredMappedRanges = next;
 	}
-	// table must be full, chain another
-#if SUPPORT_ACCELERATE_TABLES
-	unsigned count = (sAllCacheImagesProxy != NULL) ? 16 : 400;
-#else
-	unsigned count = 400;
-#endif
-	size_t allocationSize = sizeof(MappedRanges) + (count-1)*3*sizeof(void*);
-	MappedRanges* newRanges = (MappedRanges*)malloc(allocationSize);
-	bzero(newRanges, allocationSize);
-	newRanges->count = count;
-	newRanges->array[0].start = start;
-	newRanges->array[0].end = end;
-	newRanges->array[0].image = image;
+	while ( sRetiredImageLists != NULL ) {
+		ImageList* next = sRetiredImageLists->retiredNext;
+		free(sRetiredImageLists);
+		sRetiredImageLists = next;
+	}
+	while ( sRetiredTables != NULL ) {
+		RetiredTable* next = sRetiredTables->retiredNext;
+		free(sRetiredTables);
+		sRetiredTables = next;
+	}
+}
+
+void retireLockFreeTable(void* table)
+{
+	RetiredTable* retired = (RetiredTable*)table;
+	retired->retiredNext = sRetiredTables;
+	sRetiredTables = retired;
+	freeRetiredTables();
+}
+
+static MappedRanges* allocMappedRanges(unsigned long count)
+{
+	MappedRanges* ranges = (MappedRanges*)malloc(offsetof(MappedRanges, array[count]));
+	ranges->retiredNext = NULL;
+	ranges->count = count;
+	return ranges;
+}
+
+// returns index of first range that ends after addr, or count if there is none
+static unsigned long mappedRangeIndexAfter(const MappedRanges* ranges, uintptr_t addr)
+{
+	unsigned long low  = 0;
+	unsigned long high = ranges->count;
+	while ( low < high ) {
+		unsigned long mid = low + (high - low)/2;
+		if ( ranges->array[mid].end <= addr )
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+static void publishMappedRanges(MappedRanges* newRanges)
+{
+	MappedRanges* oldRanges = sMappedRanges;
+	// make sure the content of the new table is visible before the table itself
+	OSMemoryBarrier();
+	sMappedRanges = newRanges;
 	OSMemoryBarrier();
-	if ( sMappedRangesStart == NULL ) {
-		sMappedRangesStart = newRanges;
+	if ( oldRanges != NULL ) {
+		oldRanges->retiredNext = sRetiredMappedRanges;
+		sRetiredMappedRanges = oldRanges;
 	}
-	else {
-		for (MappedRanges* p = sMappedRangesStart; p != NULL; p = p->next) {
-			if ( p->next == NULL ) {
-				OSMemoryBarrier();
-				p->next = newRanges;
-				break;
-			}
+	freeRetiredTables();
+}
+
+static void addMappedRanges(ImageLoader* image, MappedRange newRanges[], unsigned long newCount)
+{
+	//for (unsigned long i=0; i < newCount; ++i)
+	//	dyld::log("addMappedRange(0x%lX->0x%lX) for %s\n", newRanges[i].start, newRanges[i].end, image->getShortName());
+	std::sort(&newRanges[0], &newRanges[newCount], [](const MappedRange& a, const MappedRange& b) {
+		return a.start < b.start;
+	});
+
+	// merge new ranges into copy of current table
+	const MappedRanges* oldRanges = sMappedRanges;
+	unsigned long oldCount = (oldRanges != NULL) ? oldRanges->count : 0;
+	MappedRanges* mergedRanges = allocMappedRanges(oldCount + newCount);
+	unsigned long oldIndex = 0;
+	unsigned long newIndex = 0;
+	for (unsigned long i=0; i < mergedRanges->count; ++i) {
+		if ( (newIndex == newCount) || ((oldIndex < oldCount) && (oldRanges->array[oldIndex].start < newRanges[newIndex].start)) ) {
+			mergedRanges->array[i] = oldRanges->array[oldIndex++];
+		}
+		else {
+			mergedRanges->array[i] = newRanges[newIndex++];
+			mergedRanges->array[i].image = image;
 		}
 	}
+	publishMappedRanges(mergedRanges);
 }
 
 void removedMappedRanges(ImageLoader* image)
 {
-	for (MappedRanges* p = sMappedRangesStart; p != NULL; p = p->next) {
-		for (unsigned long i=0; i < p->count; ++i) {
-			if ( p->array[i].image == image ) {
-				// clear with a barrier so that any reader will see consistent records
-				OSMemoryBarrier();
-				p->array[i].image = NULL;
-			}
-		}
+	const MappedRanges* oldRanges = sMappedRanges;
+	if ( oldRanges == NULL )
+		return;
+	unsigned long keepCount = 0;
+	for (unsigned long i=0; i < oldRanges->count; ++i) {
+		if ( oldRanges->array[i].image != image )
+			++keepCount;
 	}
+	if ( keepCount == oldRanges->count )
+		return;
+	if ( keepCount == 0 ) {
+		publishMappedRanges(NULL);
+		return;
+	}
+	MappedRanges* newRanges = allocMappedRanges(keepCount);
+	unsigned long newIndex = 0;
+	for (unsigned long i=0; i < oldRanges->count; ++i) {
+		if ( oldRanges->array[i].image != image )
+			newRanges->array[newIndex++] = oldRanges->array[i];
+	}
+	publishMappedRanges(newRanges);
 }
-#pragma clang diagnostic pop
 
 ImageLoader* findMappedRange(uintptr_t target)
 {
-	for (MappedRanges* p = sMappedRangesStart; p != NULL; p = p->next) {
-		for (unsigned long i=0; i < p->count; ++i) {
-			if ( p->array[i].image != NULL ) {
-				if ( (p->array[i].start <= target) && (target < p->array[i].end) )
-					return p->array[i].image;
-			}
-		}
+	LockFreeReadScope readScope;
+	if ( const MappedRanges* ranges = sMappedRanges ) {
+		unsigned long index = mappedRangeIndexAfter(ranges, target);
+		if ( (index < ranges->count) && (ranges->array[index].start <= target) )
+			return ranges->array[index].image;
 	}
 	return NULL;
 }
 
+static ImageList* allocImageList(unsigned long capacity)
+{
+	ImageList* list = (ImageList*)malloc(offsetof(ImageList, images[capacity]));
+	list->retiredNext = NULL;
+	list->count = 0;
+	list->capacity = capacity;
+	return list;
+}
+
+static void publishImageList(ImageList* newList)
+{
+	ImageList* oldList = sImageList;
+	// make sure the content of the new list is visible before the list itself
+	OSMemoryBarrier();
+	sImageList = newList;
+	OSMemoryBarrier();
+	if ( oldList != NULL ) {
+		oldList->retiredNext = sRetiredImageLists;
+		sRetiredImageLists = oldList;
+	}
+	freeRetiredTables();
+}
+
+static void appendToImageList(ImageLoader* image)
+{
+	ImageList* list = sImageList;
+	if ( (list == NULL) || (list->count == list->capacity) ) {
+		unsigned long count = (list != NULL) ? list->count : 0;
+		ImageList* newList = allocImageList((count < INITIAL_IMAGE_COUNT) ? INITIAL_IMAGE_COUNT : count*2);
+		if ( count != 0 )
+			memcpy(newList->images, list->images, count*sizeof(ImageLoader*));
+		newList->count = count;
+		publishImageList(newList);
+		list = newList;
+	}
+	list->images[list->count] = image;
+	// make sure the new entry is visible before the count that covers it
+	OSMemoryBarrier();
+	list->count = list->count + 1;
+}
+
+static void removeFromImageList(ImageLoader* image)
+{
+	const ImageList* oldList = sImageList;
+	if ( oldList == NULL )
+		return;
+	ImageList* newList = allocImageList(oldList->capacity);
+	for (unsigned long i=0; i < oldList->count; ++i) {
+		if ( oldList->images[i] != image )
+			newList->images[newList->count++] = oldList->images[i];
+	}
+	publishImageList(newList);
+}
+#pragma clang diagnostic pop
+
 
 
 const char* mkstringf(const char* format, ...)
@@ -1524,9 +1700,12 @@ static void addImage(ImageLoader* image)
 	// add to master list
     allImagesLock();
         sAllImages.push_back(image);
+        appendToImageList(image);
     allImagesUnlock();
 	
 	// update mapped ranges
+	MappedRange imageRanges[image->segmentCount()];
+	unsigned long imageRangeCount = 0;
 	uintptr_t lastSegStart = 0;
 	uintptr_t lastSegEnd = 0;
 	for(unsigned int i=0, e=image->segmentCount(); i < e; ++i) {
@@ -1541,13 +1720,15 @@ static void addImage(ImageLoader* image)
 		else {
 			// non-contiguous segments, record last (if any)
 			if ( lastSegEnd != 0 )
-				addMappedRange(image, lastSegStart, lastSegEnd);
+				imageRanges[imageRangeCount++] = { lastSegStart, lastSegEnd, image };
 			lastSegStart = start;
 			lastSegEnd = end;
 		}		
 	}
 	if ( lastSegEnd != 0 )
-		addMappedRange(image, lastSegStart, lastSegEnd);
+		imageRanges[imageRangeCount++] = { lastSegStart, lastSegEnd, image };
+	if ( imageRangeCount != 0 )
+		addMappedRanges(image, imageRanges, imageRangeCount);
 
 	
 	if ( gLinkContext.verboseLoading || (sEnv.DYLD_PRINT_LIBRARIES_POST_LAUNCH && (sMainExecutable!=NULL) && sMainExecutable->isLinked()) ) {
@@ -1622,6 +1803,7 @@ void removeImage(ImageLoader* image)
                 break;
             }
         }
+        removeFromImageList(image);
     allImagesUnlock();
 	
 #pragma clang diagnostic push
@@ -1653,9 +1835,9 @@ void removeImage(ImageLoader* image)
 			if ( it == gLinkContext.weakDefMap.end() )
 				return;
 			it->second = { nullptr, 0 };
-			if ( !isFromExportTrie ) {
-				// The string was already duplicated if we are an export trie
-				// so only strdup as we are the nlist
+			if ( image->containsAddress(it->first) ) {
+				// The key is only in this image if it came from its nlist.  Names from the export trie, and
+				// names added when binding references, were already duplicated
 				size_t hash1 = ImageLoader::HashCString::hash(it->first);
 				it->first = strdup(it->first);
 				size_t hash2 = ImageLoader::HashCString::hash(it->first);
@@ -1682,6 +1864,13 @@ void removeImage(ImageLoader* image)
 	removeImageFromAllImages(image->machHeader());
 }
 
+// a lock-free reader may have found the image before it was removed, so wait for those to finish
+static void deleteRemovedImage(ImageLoader* image)
+{
+	waitForLockFreeReaders();
+	ImageLoader::deleteImage(image);
+}
+
 
 void runImageStaticTerminators(ImageLoader* image)
 {
@@ -1729,6 +1918,7 @@ static void runAllStaticTerminators(void* extra)
 		}
 		sImageFilesNeedingTermination.clear();
 		notifyBatch(dyld_image_state_terminated, false);
+		dyld3::launchProfileWrite();
 	}
 	catch (const char* msg) {
 		halt(msg);
@@ -2173,6 +2363,9 @@ void processDyldEnvironmentVariable(const char* key, const char* value, const ch
 	else if ( strcmp(key, "DYLD_PRINT_INITIALIZERS") == 0 ) {
 		gLinkContext.verboseInit = true;
 	}
+	else if ( strcmp(key, "DYLD_PRINT_INITIALIZER_TIMES") == 0 ) {
+		gLinkContext.verboseInitTimes = true;
+	}
 	else if ( strcmp(key, "DYLD_PRINT_DOFS") == 0 ) {
 		gLinkContext.verboseDOF = true;
 	}
@@ -2201,6 +2394,12 @@ void processDyldEnvironmentVariable(const char* key, const char* value, const ch
 	else if ( strcmp(key, "DYLD_PRINT_WEAK_BINDINGS") == 0 ) {
 		gLinkContext.verboseWeakBind = true;
 	}
+	else if ( strcmp(key, "DYLD_LEGACY_WEAK_BIND") == 0 ) {
+		gLinkContext.useNewWeakBind = false;
+	}
+	else if ( strcmp(key, "DYLD_PUBLISH_COMPACT_IMAGE_INFO") == 0 ) {
+		setCompactImageInfoEnabled(true);
+	}
 	else if ( strcmp(key, "DYLD_PRINT_REBASINGS") == 0 ) {
 		gLinkContext.verboseRebase = true;
 	}
@@ -2299,6 +2498,12 @@ void processDyldEnvironmentVariable(const char* key, const char* value, const ch
 			dyld::log("dyld: could not open DYLD_PRINT_TO_FILE='%s', errno=%d\n", value, errno);
 		}
 	}
+	else if ( (strcmp(key, "DYLD_PROFILE_TO_FILE") == 0) && (mainExecutableDir == NULL) && gLinkContext.allowEnvVarsSharedCache ) {
+		// libdyld appends its own intervals to the same file
+		dyld3::launchProfileEnable(value, true);
+		if ( !dyld3::launchProfileEnabled() )
+			dyld::log("dyld: could not start DYLD_PROFILE_TO_FILE='%s', errno=%d\n", value, errno);
+	}
 	else if ( (strcmp(key, "DYLD_SKIP_MAIN") == 0)) {
 		if ( dyld3::internalInstall() )
 			sSkipMain = true;
@@ -2646,24 +2851,28 @@ static void checkSharedRegionDisable(const dyld3::MachOLoaded* mainExecutableMH,
 
 bool validImage(const ImageLoader* possibleImage)
 {
-    const size_t imageCount = sAllImages.size();
-    for(size_t i=0; i < imageCount; ++i) {
-        if ( possibleImage == sAllImages[i] ) {
-            return true;
-        }
-    }
+	LockFreeReadScope readScope;
+	if ( const ImageList* list = sImageList ) {
+		for (unsigned long i=0; i < list->count; ++i) {
+			if ( possibleImage == list->images[i] )
+				return true;
+		}
+	}
 	return false;
 }
 
 uint32_t getImageCount()
 {
-	return (uint32_t)sAllImages.size();
+	const ImageList* list = sImageList;
+	return (list != NULL) ? (uint32_t)list->count : 0;
 }
 
 ImageLoader* getIndexedImage(unsigned int index)
 {
-	if ( index < sAllImages.size() )
-		return sAllImages[index];
+	LockFreeReadScope readScope;
+	const ImageList* list = sImageList;
+	if ( (list != NULL) && (index < list->count) )
+		return list->images[index];
 	return NULL;
 }
 
@@ -3268,7 +3477,7 @@ static ImageLoader* checkandAddImage(ImageLoader* image, const LoadContext& cont
 				if ( strcmp(loadedImageInstallPath, installPath) == 0 ) {
 					//dyld::log("duplicate(%s) => %p\n", installPath, anImage);
 					removeImage(image);
-					ImageLoader::deleteImage(image);
+					deleteRemovedImage(image);
 					return anImage;
 				}
 			}
@@ -4554,26 +4763,31 @@ static void undefinedHandler(const char* symboName)
 	}
 }
 
-static bool findExportedSymbol(const char* name, bool onlyInCoalesced, const ImageLoader::Symbol** sym, const ImageLoader** image, ImageLoader::CoalesceNotifier notifier=NULL)
+static bool findExportedSymbol(const char* name, bool onlyInCoalesced, bool onlyBoundImages, const ImageLoader::Symbol** sym, const ImageLoader** image, ImageLoader::CoalesceNotifier notifier=NULL)
 {
-	// search all images in order
+	// search all images in order, using the lock-free list so dlsym() can do this without the dyld lock
+	LockFreeReadScope readScope;
+	const ImageList* list = sImageList;
 	const ImageLoader* firstWeakImage = NULL;
 	const ImageLoader::Symbol* firstWeakSym = NULL;
 	const ImageLoader* firstNonWeakImage = NULL;
 	const ImageLoader::Symbol* firstNonWeakSym = NULL;
-	const size_t imageCount = sAllImages.size();
+	const size_t imageCount = (list != NULL) ? list->count : 0;
 	for(size_t i=0; i < imageCount; ++i) {
-		ImageLoader* anImage = sAllImages[i];
+		ImageLoader* anImage = list->images[i];
 		// the use of inserted libraries alters search order
 		// so that inserted libraries are found before the main executable
 		if ( sInsertedDylibCount > 0 ) {
 			if ( i < sInsertedDylibCount )
-				anImage = sAllImages[i+1];
+				anImage = list->images[i+1];
 			else if ( i == sInsertedDylibCount )
-				anImage = sAllImages[0];
+				anImage = list->images[0];
 		}
+		// an image another thread is still loading may not have its dependents set up yet
+		if ( onlyBoundImages && !anImage->isBoundForLockFreeReaders() )
+			continue;
 		//dyld::log("findExportedSymbol(%s) looking at %s\n", name, anImage->getPath());
-		if ( ! anImage->hasHiddenExports() && (!onlyInCoalesced || anImage->hasCoalescedExports()) ) {
+		if ( ! anImage->hasHiddenExports() && (!onlyInCoalesced || anImage->hasCoalescedExports()) && anImage->mightExportSymbol(name) ) {
 			const ImageLoader* foundInImage;
 			*sym = anImage->findExportedSymbol(name, false, &foundInImage);
 			//dyld::log("findExportedSymbol(%s) found: sym=%p, anImage=%p, foundInImage=%p\n", name, *sym, anImage, foundInImage /*, (foundInImage ? foundInImage->getPath() : "")*/);
@@ -4626,12 +4840,17 @@ static bool findExportedSymbol(const char* name, bool onlyInCoalesced, const Ima
 
 bool flatFindExportedSymbol(const char* name, const ImageLoader::Symbol** sym, const ImageLoader** image)
 {
-	return findExportedSymbol(name, false, sym, image);
+	return findExportedSymbol(name, false, false, sym, image);
+}
+
+bool flatFindExportedSymbolInBoundImages(const char* name, const ImageLoader::Symbol** sym, const ImageLoader** image)
+{
+	return findExportedSymbol(name, false, true, sym, image);
 }
 
 bool findCoalescedExportedSymbol(const char* name, const ImageLoader::Symbol** sym, const ImageLoader** image, ImageLoader::CoalesceNotifier notifier)
 {
-	return findExportedSymbol(name, true, sym, image, notifier);
+	return findExportedSymbol(name, true, false, sym, image, notifier);
 }
 
 
@@ -4642,7 +4861,7 @@ bool flatFindExportedSymbolWithHint(const char* name, const char* librarySubstri
 	for(size_t i=0; i < imageCount; ++i){
 		ImageLoader* anImage = sAllImages[i];
 		// only look at images whose paths contain the hint string (NULL hint string is wildcard)
-		if ( ! anImage->isBundle() && ((librarySubstring==NULL) || (strstr(anImage->getPath(), librarySubstring) != NULL)) ) {
+		if ( ! anImage->isBundle() && ((librarySubstring==NULL) || (strstr(anImage->getPath(), librarySubstring) != NULL)) && anImage->mightExportSymbol(name) ) {
 			*sym = anImage->findExportedSymbol(name, false, image);
 			if ( *sym != NULL ) {
 				return true;
@@ -4944,6 +5163,7 @@ static void setContext(const macho_header* mainExecutableMH, int argc, const cha
 	gLinkContext.dynamicInterposeCount	= 0;
 	gLinkContext.prebindUsage			= ImageLoader::kUseAllPrebinding;
 	gLinkContext.sharedRegionMode		= ImageLoader::kUseSharedRegion;
+	gLinkContext.useNewWeakBind			= true;
 }
 
 
@@ -5099,7 +5319,7 @@ static void printAllImages()
 }
 #endif
 
-void link(ImageLoader* image, bool forceLazysBound, bool neverUnload, const ImageLoader::RPathChain& loaderRPaths, unsigned cacheIndex)
+void link(ImageLoader* image, bool forceLazysBound, bool neverUnload, const ImageLoader::RPathChain& loaderRPaths, unsigned cacheIndex, bool hideExports)
 {
 	// add to list of known images.  This did not happen at creation time for bundles
 	if ( image->isBundle() && !image->isLinked() )
@@ -5122,6 +5342,16 @@ void link(ImageLoader* image, bool forceLazysBound, bool neverUnload, const Imag
 		garbageCollectImages();
 		throw;
 	}
+
+	// hide RTLD_LOCAL exports before lock-free dlsym() can see the image
+	if ( hideExports )
+		image->setHideExports(true);
+
+	// images linked at launch are not bound until the main executable is, so they are marked then
+	if ( !gLinkContext.linkingMainExecutable ) {
+		std::vector<const ImageLoader*> visiting;
+		image->setBoundForLockFreeReadersRecursive(visiting);
+	}
 }
 
 
@@ -5232,7 +5462,7 @@ void garbageCollectImages()
 					try {
 						if (gLogAPIs) dyld::log("dlclose(), deleting %p %s\n", image, image->getShortName());
 						removeImage(image);
-						ImageLoader::deleteImage(image);
+						deleteRemovedImage(image);
 						mightBeMore = true;
 						break;  // interator in invalidated by this removal
 					}
@@ -5254,7 +5484,7 @@ static void preflight_finally(ImageLoader* image)
 {
 	if ( image->isBundle() ) {
 		removeImageFromAllImages(image->machHeader());
-		ImageLoader::deleteImage(image);
+		deleteRemovedImage(image);
 	}
 	sBundleBeingLoaded = NULL;
 	dyld::garbageCollectImages();
@@ -5854,6 +6084,66 @@ void getCDHashString(const uint8_t cdHash[20], char* cdHashBuffer) {
 	}
 }
 
+// Finds which of the files recorded in the closure exist, and their inodes and mtimes.  Plugin heavy apps
+// record hundreds of them, mostly in a few directories, so they are looked up a directory at a time.
+static void getClosureFileInfo(const dyld3::closure::LaunchClosure* mainClosure, dyld3::OverflowSafeArray<dyld3::BulkFileInfo>& files)
+{
+	mainClosure->images()->forEachImage(^(const dyld3::closure::Image* image, bool& stop) {
+		uint64_t expectedInode;
+		uint64_t expectedMtime;
+		if ( image->hasFileModTimeAndInode(expectedInode, expectedMtime) )
+			files.push_back({ image->path() });
+	});
+	mainClosure->forEachMustBeMissingFile(^(const char* path, bool& stop) {
+		files.push_back({ path });
+	});
+	mainClosure->forEachSkipIfExistsFile(^(const dyld3::closure::LaunchClosure::SkippedFile& file, bool& stop) {
+		files.push_back({ file.path });
+	});
+
+	// a directory listing does not show files which stat() finds in a subsystem root, and dyld_sim
+	// can only make the syscalls the host dyld passes it
+#if TARGET_OS_SIMULATOR
+	const bool allowListings = false;
+#else
+	const bool allowListings = !dyld3::hasSubsystemRoot();
+#endif
+	dyld3::BulkFileInfoStats stats;
+	dyld3::getBulkFileInfo(files.begin(), (uint32_t)files.count(), allowListings, &dyld3::stat, stats);
+	if ( gLinkContext.verboseWarnings )
+		dyld::log("dyld: closure %p validated %lu files with %u stat(), %u directory opens, %u getattrlistbulk()\n",
+				  mainClosure, files.count(), stats.stats, stats.directoriesRead, stats.bulkReads);
+}
+
+// Looks up path in the results of getClosureFileInfo(), returning true if it exists.  Anything which would
+// invalidate the closure is confirmed with stat(), so a listing is only ever used to show things are as expected.
+// Paths are looked up in the order they were added, so the search starts where the last one was found.
+static bool closureFileInfo(const dyld3::Array<dyld3::BulkFileInfo>& files, uint32_t& hint, const char* path, bool allowMissing,
+							bool allowExisting, uint64_t expectedInode, uint64_t expectedMtime, uint64_t& inode, uint64_t& mtime)
+{
+	for (uint32_t i=0; i < files.count(); ++i) {
+		const uint32_t index = (hint + i) % files.count();
+		const dyld3::BulkFileInfo& file = files[index];
+		if ( file.path != path )
+			continue;
+		hint = index + 1;
+		if ( !file.exists && allowMissing )
+			return false;
+		if ( file.exists && allowExisting && (file.inode == expectedInode) && (file.mtime == expectedMtime) ) {
+			inode = file.inode;
+			mtime = file.mtime;
+			return true;
+		}
+		break;
+	}
+	struct stat statBuf;
+	if ( dyld3::stat(path, &statBuf) != 0 )
+		return false;
+	inode = statBuf.st_ino;
+	mtime = statBuf.st_mtime;
+	return true;
+}
+
 static bool closureValid(const dyld3::closure::LaunchClosure* mainClosure, const dyld3::closure::LoadedFileInfo& mainFileInfo,
 						 const uint8_t* mainExecutableCDHash, bool closureInCache, const char* envp[])
 {
@@ -5899,15 +6189,21 @@ static bool closureValid(const dyld3::closure::LaunchClosure* mainClosure, const
 		}
 	}
 
+	// look up every file the closure recorded at once
+	STACK_ALLOC_OVERFLOW_SAFE_ARRAY(dyld3::BulkFileInfo, files, 256);
+	getClosureFileInfo(mainClosure, files);
+	__block uint32_t fileHint = 0;
+
 	// verify all mach-o files have not changed since closure was built
 	__block bool foundFileThatInvalidatesClosure = false;
 	mainClosure->images()->forEachImage(^(const dyld3::closure::Image* image, bool& stop) {
 		__block uint64_t expectedInode;
 		__block uint64_t expectedMtime;
 		if ( image->hasFileModTimeAndInode(expectedInode, expectedMtime) ) {
-			struct stat statBuf;
-			if ( dyld3::stat(image->path(), &statBuf) == 0 ) {
-				if ( (statBuf.st_mtime != expectedMtime) || (statBuf.st_ino != expectedInode) ) {
+			uint64_t inode;
+			uint64_t mtime;
+			if ( closureFileInfo(files, fileHint, image->path(), false, true, expectedInode, expectedMtime, inode, mtime) ) {
+				if ( (mtime != expectedMtime) || (inode != expectedInode) ) {
 					if ( gLinkContext.verboseWarnings )
 						dyld::log("dyld: closure %p not used because mtime/inode for '%s' has changed since closure was built\n", mainClosure, image->path());
 					foundFileThatInvalidatesClosure = true;
@@ -5988,8 +6284,9 @@ static bool closureValid(const dyld3::closure::LaunchClosure* mainClosure, const
 
 	// verify files that are supposed to be missing actually are missing
 	mainClosure->forEachMustBeMissingFile(^(const char* path, bool& stop) {
-		struct stat statBuf;
-		if ( dyld3::stat(path, &statBuf) == 0 ) {
+		uint64_t inode;
+		uint64_t mtime;
+		if ( closureFileInfo(files, fileHint, path, true, false, 0, 0, inode, mtime) ) {
 			stop = true;
 			foundFileThatInvalidatesClosure = true;
 			if ( gLinkContext.verboseWarnings )
@@ -5999,9 +6296,10 @@ static bool closureValid(const dyld3::closure::LaunchClosure* mainClosure, const
 
 	// verify files that are supposed to exist are there with the
 	mainClosure->forEachSkipIfExistsFile(^(const dyld3::closure::LaunchClosure::SkippedFile &file, bool &stop) {
-		struct stat statBuf;
-		if ( dyld3::stat(file.path, &statBuf) == 0 ) {
-			if ( (statBuf.st_mtime != file.mtime) || (statBuf.st_ino != file.inode) ) {
+		uint64_t inode;
+		uint64_t mtime;
+		if ( closureFileInfo(files, fileHint, file.path, true, true, file.inode, file.mtime, inode, mtime) ) {
+			if ( (mtime != file.mtime) || (inode != file.inode) ) {
 				if ( gLinkContext.verboseWarnings )
 					dyld::log("dyld: closure %p not used because mtime/inode for '%s' has changed since closure was built\n", mainClosure, file.path);
 				foundFileThatInvalidatesClosure = true;
@@ -6043,6 +6341,19 @@ static bool dolog(const char* format, ...)
 	return true;
 }
 
+static void noteLaunchFinished(uint64_t launchMode)
+{
+	if (dyld3::kdebug_trace_dyld_enabled(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE)) {
+		dyld3::kdebug_trace_dyld_duration_end(launchTraceID, DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, 0, 0, launchMode);
+	}
+	if ( dyld3::launchProfileEnabled() ) {
+		dyld3::launchProfileRecord(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, launchStartTime, mach_absolute_time(),
+								   (uint64_t)sMainExecutableMachHeader, launchMode, sExecPath);
+		// in dyld3 mode nothing more is recorded here, so write out the launch now
+		dyld3::launchProfileWrite();
+	}
+}
+
 static bool launchWithClosure(const dyld3::closure::LaunchClosure* mainClosure,
 							  const DyldSharedCache* dyldCache,
 							  const dyld3::MachOLoaded* mainExecutableMH, uintptr_t mainExecutableSlide,
@@ -6186,9 +6497,7 @@ static bool launchWithClosure(const dyld3::closure::LaunchClosure* mainClosure,
 	libDyldEntry->runInitialzersBottomUp((mach_header*)mainExecutableMH);
 	//dyld::log("returned from runInitialzersBottomUp()\n");
 
-	if (dyld3::kdebug_trace_dyld_enabled(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE)) {
-		dyld3::kdebug_trace_dyld_duration_end(launchTraceID, DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, 0, 0, 3);
-	}
+	noteLaunchFinished(3);
 #if TARGET_OS_OSX
 	if ( gLinkContext.driverKit ) {
 		if (libDyldEntry->vectorVersion >= 10)
@@ -6499,6 +6808,7 @@ _main(const macho_header* mainExecutableMH, uintptr_t mainExecutableSlide,
 		int argc, const char* argv[], const char* envp[], const char* apple[], 
 		uintptr_t* startGlue)
 {
+	launchStartTime = mach_absolute_time();
 	if (dyld3::kdebug_trace_dyld_enabled(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE)) {
 		launchTraceID = dyld3::kdebug_trace_dyld_duration_start(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, (uint64_t)mainExecutableMH, 0, 0);
 	}
@@ -6506,6 +6816,9 @@ _main(const macho_header* mainExecutableMH, uintptr_t mainExecutableSlide,
 	//Check and see if there are any kernel flags
 	dyld3::BootArgs::setFlags(hexToUInt64(_simple_getenv(apple, "dyld_flags"), nullptr));
 
+	// stat() and open() fall back to the subsystem root, so closure building and validation cannot trust directory listings
+	dyld3::setHasSubsystemRoot(_simple_getenv(apple, "subsystem_root_path") != nullptr);
+
 #if __has_feature(ptrauth_calls)
 	// Check and see if kernel disabled JOP pointer signing (which lets us load plain arm64 binaries)
 	if ( const char* disableStr = _simple_getenv(apple, "ptrauth_disabled") ) {
@@ -7289,6 +7602,7 @@ reloadAllImages:
 			}
 			// note: we don't need to worry about inserted images because if DYLD_INSERT_LIBRARIES was set we would not be using the accelerator table
 			sAllImages.clear();
+			publishImageList(NULL);
 			sImageRoots.clear();
 			sImageFilesNeedingTermination.clear();
 			sImageFilesNeedingDOFUnregistration.clear();
@@ -7298,7 +7612,7 @@ reloadAllImages:
 			sAddBulkLoadImageCallbacks.clear();
 			sDisableAcceleratorTables = true;
 			sAllCacheImagesProxy = NULL;
-			sMappedRangesStart = NULL;
+			publishMappedRanges(NULL);
 			mainExcutableAlreadyRebased = true;
 			gLinkContext.linkingMainExecutable = false;
 			resetAllImages();
@@ -7331,6 +7645,13 @@ reloadAllImages:
 		sMainExecutable->weakBind(gLinkContext);
 		gLinkContext.linkingMainExecutable = false;
 
+		// now lock-free dlsym() can look at the images linked at launch
+		{
+			std::vector<const ImageLoader*> visiting;
+			for (ImageLoader* root : sImageRoots)
+				root->setBoundForLockFreeReadersRecursive(visiting);
+		}
+
 		sMainExecutable->recursiveMakeDataReadOnly(gLinkContext);
 
 		CRSetCrashLogMessage("dyld: launch, running initializers");
@@ -7345,9 +7666,7 @@ reloadAllImages:
 
 		// notify any montoring proccesses that this process is about to enter main()
 		notifyMonitoringDyldMain();
-		if (dyld3::kdebug_trace_dyld_enabled(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE)) {
-			dyld3::kdebug_trace_dyld_duration_end(launchTraceID, DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, 0, 0, 2);
-		}
+		noteLaunchFinished(2);
 		ARIADNEDBG_CODE(220, 1);
 
 #if TARGET_OS_OSX
@@ -7394,9 +7713,7 @@ reloadAllImages:
 
 	if (sSkipMain) {
 		notifyMonitoringDyldMain();
-		if (dyld3::kdebug_trace_dyld_enabled(DBG_DYLD_TIMING_LAUNCH_EXECUTABLE)) {
-			dyld3::kdebug_trace_dyld_duration_end(launchTraceID, DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, 0, 0, 2);
-		}
+		noteLaunchFinished(2);
 		ARIADNEDBG_CODE(220, 1);
 		result = (uintptr_t)&fake_main;
 		*startGlue = (uintptr_t)gLibSystemHelpers->startGlueToCallExit;
@@ -53,6 +53,14 @@ namespace dyld {
 		const ImageLoader::RPathChain*	rpath;			// paths for expanding @rpath
 	};
 
+	// Lets a thread look at the image list without the dyld lock.  While any of these
+	// is alive, images removed from the list are not deleted (see waitForLockFreeReaders()).
+	struct LockFreeReadScope
+	{
+						LockFreeReadScope();
+						~LockFreeReadScope();
+	};
+
 
 
 	typedef void		 (*ImageCallback)(const struct mach_header* mh, intptr_t slide);
@@ -81,7 +89,7 @@ namespace dyld {
     extern void                 registerBulkLoadCallback(LoadImageBulkCallback func);
 	extern void					initializeMainExecutable();
 	extern void					preflight(ImageLoader* image, const ImageLoader::RPathChain& loaderRPaths, unsigned cacheIndex);
-	extern void					link(ImageLoader* image, bool forceLazysBound, bool neverUnload, const ImageLoader::RPathChain& loaderRPaths, unsigned cacheIndex);
+	extern void					link(ImageLoader* image, bool forceLazysBound, bool neverUnload, const ImageLoader::RPathChain& loaderRPaths, unsigned cacheIndex, bool hideExports=false);
 	extern void					runInitializers(ImageLoader* image);
 	extern void					runImageStaticTerminators(ImageLoader* image);	
 	extern const char*			getExecutablePath();
@@ -94,6 +102,7 @@ namespace dyld {
 	extern ImageLoader*			findImageByName(const char* path);
 	extern ImageLoader*			findLoadedImageByInstallPath(const char* path);
 	extern bool					flatFindExportedSymbol(const char* name, const ImageLoader::Symbol** sym, const ImageLoader** image);
+	extern bool					flatFindExportedSymbolInBoundImages(const char* name, const ImageLoader::Symbol** sym, const ImageLoader** image);
 	extern bool					flatFindExportedSymbolWithHint(const char* name, const char* librarySubstring, const ImageLoader::Symbol** sym, const ImageLoader** image);
 	extern ImageLoader*			load(const char* path, const LoadContext& context, unsigned& cacheIndex);
 	extern ImageLoader*			loadFromMemory(const uint8_t* mem, uint64_t len, const char* moduleName);
@@ -114,6 +123,8 @@ namespace dyld {
 	extern void					registerObjCNotifiers(_dyld_objc_notify_mapped, _dyld_objc_notify_init, _dyld_objc_notify_unmapped);
 	extern bool					sharedCacheUUID(uuid_t uuid);
 	extern void					garbageCollectImages();
+	extern void					waitForLockFreeReaders();
+	extern void					retireLockFreeTable(void* table);	// table is malloc()ed and starts with a retiredNext pointer
 	extern const void*			imMemorySharedCacheHeader();
 	extern uintptr_t			fastBindLazySymbol(ImageLoader** imageLoaderCache, uintptr_t lazyBindingInfoOffset);
 	extern bool					inSharedCache(const char* path);
@@ -55,6 +55,7 @@
 #include "dyldLibSystemInterface.h"
 #include "DyldSharedCache.h"
 #include "MachOFile.h"
+#include "Tracing.h"
 
 #undef _POSIX_C_SOURCE
 #include <dlfcn.h>
@@ -209,6 +210,7 @@ static const struct dyld_func dyld_funcs[] = {
     {"__dyld_register_for_bulk_image_loads",			(void*)_dyld_register_for_bulk_image_loads },
     {"__dyld_register_driverkit_main",					(void*)_dyld_register_driverkit_main },
     {"__dyld_halt",										(void*)dyld::halt },
+    {"__dyld_launch_profile_path",						(void*)dyld3::launchProfilePath },
 
 #if DEPRECATED_APIS_SUPPORTED
 #pragma clang diagnostic push
@@ -362,6 +364,7 @@ const struct mach_header* _dyld_get_image_header(uint32_t image_index)
 {
 	if ( dyld::gLogAPIs )
 		dyld::log("%s(%u)\n", __func__, image_index);
+	dyld::LockFreeReadScope readScope;
 	return allImagesIndexedMachHeader(image_index);
 }
 
@@ -369,6 +372,8 @@ intptr_t _dyld_get_image_vmaddr_slide(uint32_t image_index)
 {
 	if ( dyld::gLogAPIs )
 		dyld::log("%s(%u)\n", __func__, image_index);
+	// the image cannot be unmapped while its header is being looked at
+	dyld::LockFreeReadScope readScope;
 	const struct mach_header* mh = allImagesIndexedMachHeader(image_index);
 	if ( mh != NULL )
 		return ImageLoaderMachO::computeSlide(mh);
@@ -388,6 +393,7 @@ const char* _dyld_get_image_name(uint32_t image_index)
 {
 	if ( dyld::gLogAPIs )
 		dyld::log("%s(%u)\n", __func__, image_index);
+	dyld::LockFreeReadScope readScope;
 	return allImagesIndexedPath(image_index);
 }
 
@@ -1617,17 +1623,14 @@ void* dlopen_internal(const char* path, int mode, void* callerAddress)
 			if ( (mode & RTLD_NOLOAD) == 0 ) {
 				bool alreadyLinked = image->isLinked();
 				bool forceLazysBound = ( (mode & RTLD_NOW) != 0 );
-				dyld::link(image, forceLazysBound, false, callersRPaths, cacheIndex);
+				// only hide exports if image is not already in use
+				bool hideExports = !alreadyLinked && ((mode & RTLD_LOCAL) != 0);
+				dyld::link(image, forceLazysBound, false, callersRPaths, cacheIndex, hideExports);
 				if ( alreadyLinked ) {
 					// upgrade
 					if ( ((mode & RTLD_LOCAL) == 0) && image->hasHiddenExports() )
 						image->setHideExports(false);
 				}
-				else {
-					// only hide exports if image is not already in use
-					if ( (mode & RTLD_LOCAL) != 0 )
-						image->setHideExports(true);
-				}
 			}
 			
 			// RTLD_NODELETE means don't unmap image even after dlclosed. This is what dlcompat did on Mac OS X 10.3
@@ -1749,6 +1752,9 @@ int dladdr(const void* address, Dl_info* info)
 
 	address = stripPointer(address);
 
+	// libSystem calls this without the dyld lock, so keep dlclose() from deleting the image found until done with it
+	dyld::LockFreeReadScope readScope;
+
 	CRSetCrashLogMessage("dyld: in dladdr()");
 #if SUPPORT_ACCELERATE_TABLES
 	if ( dyld::dladdrFromCache(address, info) ) {
@@ -1816,99 +1822,50 @@ char* dlerror()
 	return NULL;
 }
 
-void* dlsym_internal(void* handle, const char* symbolName, void* callerAddress)
+#if __has_feature(ptrauth_calls)
+// Sign the pointer if it points to a function
+// Note we only do this if the main executable is arm64e as otherwise we
+// may end up calling containsAddress on the accelerator tables.
+static void* dlsymSignIfFunction(const ImageLoader* image, void* result)
 {
-	if ( dyld::gLogAPIs )
-		dyld::log("%s(%p, %s)\n", __func__, handle, symbolName);
-
-#if SUPPORT_ACCELERATE_TABLES
-	if ( dyld::gLogAppAPIs ) {
-		const char* shortName;
-		if ( callerIsNonOSApp(callerAddress, &shortName) ) {
-			dyld::log("%s: %s(%p, %s)\n", shortName, __func__, handle, symbolName);
+	if ( result && ((dyld::gLinkContext.mainExecutable->machHeader()->cpusubtype & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E) ) {
+		const ImageLoader* symbolImage = image;
+		if (!symbolImage->containsAddress(result)) {
+			symbolImage = dyld::findImageContainingAddress(result);
 		}
+		const macho_section *sect = symbolImage ? symbolImage->findSection(result) : NULL;
+		if ( sect && ((sect->flags & S_ATTR_PURE_INSTRUCTIONS) || (sect->flags & S_ATTR_SOME_INSTRUCTIONS)) )
+			result = __builtin_ptrauth_sign_unauthenticated(result, ptrauth_key_asia, 0);
 	}
+	return result;
+}
 #endif
 
-	CRSetCrashLogMessage("dyld: in dlsym()");
-	dlerrorClear();
+enum DlsymOutcome { dlsymFound, dlsymNotFound, dlsymInvalidHandle, dlsymAnsweredByCache };
 
+// Finds the address of underscoredName for dlsym().  This has no side effects and never calls
+// out of dyld: resolvers are not run (dlsym() returns the stub), nothing is allocated, and dlerror()
+// and logging are left to the caller.  So it may be called inside a LockFreeReadScope, where any
+// code which could re-enter dlopen() or dlclose() would deadlock waiting for the reader itself.
+static DlsymOutcome dlsym_find(void* handle, const char* underscoredName, void* callerAddress, void** result)
+{
 	const ImageLoader* image;
 	const ImageLoader::Symbol* sym;
-	void* result;
 
-	// dlsym() assumes symbolName passed in is same as in C source code
-	// dyld assumes all symbol names have an underscore prefix
-	char underscoredName[strlen(symbolName)+2];
-	underscoredName[0] = '_';
-	strcpy(&underscoredName[1], symbolName);
-	
 	// magic "search all" handle
 	if ( handle == RTLD_DEFAULT ) {
-		if ( dyld::flatFindExportedSymbol(underscoredName, &sym, &image) ) {
-			CRSetCrashLogMessage(NULL);
-			result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, NULL, false, underscoredName);
-#if __has_feature(ptrauth_calls)
-			// Sign the pointer if it points to a function
-			// Note we only do this if the main executable is arm64e as otherwise we
-			// may end up calling containsAddress on the accelerator tables.
-			if ( result && ((dyld::gLinkContext.mainExecutable->machHeader()->cpusubtype  & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E) ) {
-				const ImageLoader* symbolImage = image;
-				if (!symbolImage->containsAddress(result)) {
-					symbolImage = dyld::findImageContainingAddress(result);
-				}
-				const macho_section *sect = symbolImage ? symbolImage->findSection(result) : NULL;
-				if ( sect && ((sect->flags & S_ATTR_PURE_INSTRUCTIONS) || (sect->flags & S_ATTR_SOME_INSTRUCTIONS)) )
-					result = __builtin_ptrauth_sign_unauthenticated(result, ptrauth_key_asia, 0);
-			}
-#endif
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(RTLD_DEFAULT, %s) ==> %p\n", __func__, symbolName, result);
-			return result;
-		}
-		const char* str = dyld::mkstringf("dlsym(RTLD_DEFAULT, %s): symbol not found", symbolName);
-		dlerrorSet(str);
-		free((void*)str);
-		CRSetCrashLogMessage(NULL);
-		if ( dyld::gLogAPIs )
-			dyld::log("  %s(RTLD_DEFAULT, %s) ==> NULL\n", __func__, symbolName);
-		return NULL;
+		if ( !dyld::flatFindExportedSymbolInBoundImages(underscoredName, &sym, &image) )
+			return dlsymNotFound;
+		*result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, NULL, false, underscoredName);
 	}
-	
 	// magic "search only main executable" handle
 	else if ( handle == RTLD_MAIN_ONLY ) {
 		image = dyld::mainExecutable();
 		sym = image->findExportedSymbol(underscoredName, true, &image); // search RTLD_FIRST way
-		if ( sym != NULL ) {
-			CRSetCrashLogMessage(NULL);
-			result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, NULL, false, underscoredName);
-#if __has_feature(ptrauth_calls)
-			// Sign the pointer if it points to a function
-			// Note we only do this if the main executable is arm64e as otherwise we
-			// may end up calling containsAddress on the accelerator tables.
-			if ( result && ((dyld::gLinkContext.mainExecutable->machHeader()->cpusubtype  & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E) ) {
-				const ImageLoader* symbolImage = image;
-				if (!symbolImage->containsAddress(result)) {
-					symbolImage = dyld::findImageContainingAddress(result);
-				}
-				const macho_section *sect = symbolImage ? symbolImage->findSection(result) : NULL;
-				if ( sect && ((sect->flags & S_ATTR_PURE_INSTRUCTIONS) || (sect->flags & S_ATTR_SOME_INSTRUCTIONS)) )
-					result = __builtin_ptrauth_sign_unauthenticated(result, ptrauth_key_asia, 0);
-			}
-#endif
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(RTLD_MAIN_ONLY, %s) ==> %p\n", __func__, symbolName, result);
-			return result;
-		}
-		const char* str = dyld::mkstringf("dlsym(RTLD_MAIN_ONLY, %s): symbol not found", symbolName);
-		dlerrorSet(str);
-		free((void*)str);
-		CRSetCrashLogMessage(NULL);
-		if ( dyld::gLogAPIs )
-			dyld::log("  %s(RTLD_MAIN_ONLY, %s) ==> NULL\n", __func__, symbolName);
-		return NULL;
+		if ( sym == NULL )
+			return dlsymNotFound;
+		*result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, NULL, false, underscoredName);
 	}
-	
 	// magic "search what I would see" handle
 	else if ( handle == RTLD_NEXT ) {
 #if SUPPORT_ACCELERATE_TABLES
@@ -1917,42 +1874,15 @@ void* dlsym_internal(void* handle, const char* symbolName, void* callerAddress)
 		unsigned index;
 		if ( dyld::addressInCache(callerAddress, &mh, &path, &index) ) {
 			// if dylib in cache is calling dlsym(RTLD_NEXT,xxx) handle search differently
-			result = dyld::dlsymFromCache(RTLD_NEXT, underscoredName, index);
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(RTLD_NEXT, %s) ==> %p\n", __func__, symbolName, result);
-			return result;
+			*result = dyld::dlsymFromCache(RTLD_NEXT, underscoredName, index);
+			return dlsymAnsweredByCache;
 		}
 #endif
 		ImageLoader* callerImage = dyld::findImageContainingAddress(callerAddress);
 		sym = callerImage->findExportedSymbolInDependentImages(underscoredName, dyld::gLinkContext, &image); // don't search image, but do search what it links against
-		if ( sym != NULL ) {
-			CRSetCrashLogMessage(NULL);
-			result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext , callerImage, false, underscoredName);
-#if __has_feature(ptrauth_calls)
-			// Sign the pointer if it points to a function
-			// Note we only do this if the main executable is arm64e as otherwise we
-			// may end up calling containsAddress on the accelerator tables.
-			if ( result && ((dyld::gLinkContext.mainExecutable->machHeader()->cpusubtype  & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E) ) {
-				const ImageLoader* symbolImage = image;
-				if (!symbolImage->containsAddress(result)) {
-					symbolImage = dyld::findImageContainingAddress(result);
-				}
-				const macho_section *sect = symbolImage ? symbolImage->findSection(result) : NULL;
-				if ( sect && ((sect->flags & S_ATTR_PURE_INSTRUCTIONS) || (sect->flags & S_ATTR_SOME_INSTRUCTIONS)) )
-					result = __builtin_ptrauth_sign_unauthenticated(result, ptrauth_key_asia, 0);
-			}
-#endif
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(RTLD_NEXT, %s) ==> %p\n", __func__, symbolName, result);
-			return result;
-		}
-		const char* str = dyld::mkstringf("dlsym(RTLD_NEXT, %s): symbol not found", symbolName);
-		dlerrorSet(str);
-		free((void*)str);
-		CRSetCrashLogMessage(NULL);
-		if ( dyld::gLogAPIs )
-			dyld::log("  %s(RTLD_NEXT, %s) ==> NULL\n", __func__, symbolName);
-		return NULL;
+		if ( sym == NULL )
+			return dlsymNotFound;
+		*result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext , callerImage, false, underscoredName);
 	}
 	// magic "search me, then what I would see" handle
 	else if ( handle == RTLD_SELF ) {
@@ -1962,96 +1892,167 @@ void* dlsym_internal(void* handle, const char* symbolName, void* callerAddress)
 		unsigned index;
 		if ( dyld::addressInCache(callerAddress, &mh, &path, &index) ) {
 			// if dylib in cache is calling dlsym(RTLD_SELF,xxx) handle search differently
-			result = dyld::dlsymFromCache(RTLD_SELF, underscoredName, index);
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(RTLD_SELF, %s) ==> %p\n", __func__, symbolName, result);
-			return result;
+			*result = dyld::dlsymFromCache(RTLD_SELF, underscoredName, index);
+			return dlsymAnsweredByCache;
 		}
 #endif
 		ImageLoader* callerImage = dyld::findImageContainingAddress(callerAddress);
 		sym = callerImage->findExportedSymbolInImageOrDependentImages(underscoredName, dyld::gLinkContext, &image); // search image and what it links against
-		if ( sym != NULL ) {
-			CRSetCrashLogMessage(NULL);
-			result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, callerImage, false, underscoredName);
-#if __has_feature(ptrauth_calls)
-			// Sign the pointer if it points to a function
-			// Note we only do this if the main executable is arm64e as otherwise we
-			// may end up calling containsAddress on the accelerator tables.
-			if ( result && ((dyld::gLinkContext.mainExecutable->machHeader()->cpusubtype & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E) ) {
-				const ImageLoader* symbolImage = image;
-				if (!symbolImage->containsAddress(result)) {
-					symbolImage = dyld::findImageContainingAddress(result);
-				}
-				const macho_section *sect = symbolImage ? symbolImage->findSection(result) : NULL;
-				if ( sect && ((sect->flags & S_ATTR_PURE_INSTRUCTIONS) || (sect->flags & S_ATTR_SOME_INSTRUCTIONS)) )
-					result = __builtin_ptrauth_sign_unauthenticated(result, ptrauth_key_asia, 0);
-			}
-#endif
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(RTLD_SELF, %s) ==> %p\n", __func__, symbolName, result);
-			return result;
-		}
-		const char* str = dyld::mkstringf("dlsym(RTLD_SELF, %s): symbol not found", symbolName);
-		dlerrorSet(str);
-		free((void*)str);
-		CRSetCrashLogMessage(NULL);
-		if ( dyld::gLogAPIs )
-			dyld::log("  %s(RTLD_SELF, %s) ==> NULL\n", __func__, symbolName);
-		return NULL;
+		if ( sym == NULL )
+			return dlsymNotFound;
+		*result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, callerImage, false, underscoredName);
 	}
 #if SUPPORT_ACCELERATE_TABLES
 	// check for mega dylib handle
 	else if ( dyld::isCacheHandle(handle) ) {
-		result = dyld::dlsymFromCache(handle, underscoredName, 0);
-		if ( dyld::gLogAPIs )
-			dyld::log("  %s(%p, %s) ==> %p\n", __func__, handle, symbolName, result);
-		return result;
+		*result = dyld::dlsymFromCache(handle, underscoredName, 0);
+		return dlsymAnsweredByCache;
 	}
 #endif
 	// real handle
-	image = (ImageLoader*)(((uintptr_t)handle) & (-4));	// clear mode bits
-	if ( dyld::validImage(image) ) {
+	else {
+		image = (ImageLoader*)(((uintptr_t)handle) & (-4));	// clear mode bits
+		if ( !dyld::validImage(image) )
+			return dlsymInvalidHandle;
 		if ( (((uintptr_t)handle) & 1) != 0 )
 			sym = image->findExportedSymbol(underscoredName, true, &image); // search RTLD_FIRST way
 		else
 			sym = image->findExportedSymbolInImageOrDependentImages(underscoredName, dyld::gLinkContext, &image); // search image and what it links against
-		
-		if ( sym != NULL ) {
-			CRSetCrashLogMessage(NULL);
-			ImageLoader* callerImage = NULL;
-			if ( sDynamicInterposing ) {
-				// only take time to look up caller, if dynamic interposing in use
-				callerImage = dyld::findImageContainingAddress(callerAddress);
-			}
-			result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, callerImage, false, underscoredName);
+		if ( sym == NULL )
+			return dlsymNotFound;
+		ImageLoader* callerImage = NULL;
+		if ( sDynamicInterposing ) {
+			// only take time to look up caller, if dynamic interposing in use
+			callerImage = dyld::findImageContainingAddress(callerAddress);
+		}
+		*result = (void*)image->getExportedSymbolAddress(sym, dyld::gLinkContext, callerImage, false, underscoredName);
+	}
 #if __has_feature(ptrauth_calls)
-			// Sign the pointer if it points to a function
-			// Note we only do this if the main executable is arm64e as otherwise we
-			// may end up calling containsAddress on the accelerator tables.
-			if ( result && ((dyld::gLinkContext.mainExecutable->machHeader()->cpusubtype & ~CPU_SUBTYPE_MASK) == CPU_SUBTYPE_ARM64E) ) {
-				const ImageLoader* symbolImage = image;
-				if (!symbolImage->containsAddress(result)) {
-					symbolImage = dyld::findImageContainingAddress(result);
-				}
-				const macho_section *sect = symbolImage ? symbolImage->findSection(result) : NULL;
-				if ( sect && ((sect->flags & S_ATTR_PURE_INSTRUCTIONS) || (sect->flags & S_ATTR_SOME_INSTRUCTIONS)) )
-					result = __builtin_ptrauth_sign_unauthenticated(result, ptrauth_key_asia, 0);
-			}
+	*result = dlsymSignIfFunction(image, *result);
 #endif
-			if ( dyld::gLogAPIs )
-				dyld::log("  %s(%p, %s) ==> %p\n", __func__, handle, symbolName, result);
-			return result;
-		}
-		const char* str = dyld::mkstringf("dlsym(%p, %s): symbol not found", handle, symbolName);
-		dlerrorSet(str);
-		free((void*)str);
+	return dlsymFound;
+}
+
+// returns true if dlsym() can look up this handle without the global dyld lock
+static bool dlsymCanSkipLock(void* handle, void* callerAddress)
+{
+#if SUPPORT_ACCELERATE_TABLES
+	// the cache image proxy is only ever searched with the dyld lock held
+	return false;
+#else
+	// the lookup reads the interposing tuples, which dyld_dynamic_interpose() may add to.
+	// Pairs with the barrier dyld_dynamic_interpose() issues after setting it.
+	if ( __atomic_load_n(&sDynamicInterposing, __ATOMIC_ACQUIRE) )
+		return false;
+	if ( (handle == RTLD_DEFAULT) || (handle == RTLD_MAIN_ONLY) )
+		return true;
+	const ImageLoader* image;
+	if ( (handle == RTLD_NEXT) || (handle == RTLD_SELF) ) {
+		image = dyld::findImageContainingAddress(callerAddress);
 	}
 	else {
-		dlerrorSet("invalid handle passed to dlsym()");
+		image = (ImageLoader*)(((uintptr_t)handle) & (-4));
+		// an invalid handle just sets dlerror()
+		if ( !dyld::validImage(image) )
+			return true;
 	}
-	CRSetCrashLogMessage(NULL);
+	// dlopen() must be done setting up the image and what it links against
+	return (image != NULL) && image->isBoundForLockFreeReaders();
+#endif
+}
+
+void* dlsym_internal(void* handle, const char* symbolName, void* callerAddress)
+{
 	if ( dyld::gLogAPIs )
-		dyld::log("  %s(%p, %s) ==> NULL\n", __func__, handle, symbolName);
+		dyld::log("%s(%p, %s)\n", __func__, handle, symbolName);
+
+#if SUPPORT_ACCELERATE_TABLES
+	if ( dyld::gLogAppAPIs ) {
+		const char* shortName;
+		if ( callerIsNonOSApp(callerAddress, &shortName) ) {
+			dyld::log("%s: %s(%p, %s)\n", shortName, __func__, handle, symbolName);
+		}
+	}
+#endif
+
+	CRSetCrashLogMessage("dyld: in dlsym()");
+	dlerrorClear();
+
+	// dlsym() assumes symbolName passed in is same as in C source code
+	// dyld assumes all symbol names have an underscore prefix
+	char underscoredName[strlen(symbolName)+2];
+	underscoredName[0] = '_';
+	strcpy(&underscoredName[1], symbolName);
+
+	// libSystem does not take the global dyld lock for dlsym(), because most lookups only read
+	// the image list.  The LockFreeReadScope keeps dlclose() from deleting the images found, and
+	// is closed before anything below, such as dlerror() buffer allocation, can call out of dyld.
+	void*			result = NULL;
+	DlsymOutcome	outcome = dlsymNotFound;
+	bool			lockFree;
+	{
+		dyld::LockFreeReadScope readScope;
+		lockFree = dlsymCanSkipLock(handle, callerAddress);
+		if ( lockFree )
+			outcome = dlsym_find(handle, underscoredName, callerAddress, &result);
+	}
+
+	// The rest are serialized with dlopen() and dlclose().  This must be outside the read scope,
+	// because dlclose() holds the lock while it waits for lock-free readers to finish.
+	if ( !lockFree ) {
+		bool lockHeld = false;
+		if ( (dyld::gLibSystemHelpers != NULL) && (dyld::gLibSystemHelpers->version >= 4) ) {
+			dyld::gLibSystemHelpers->acquireGlobalDyldLock();
+			lockHeld = true;
+		}
+		outcome = dlsym_find(handle, underscoredName, callerAddress, &result);
+		if ( lockHeld )
+			dyld::gLibSystemHelpers->releaseGlobalDyldLock();
+	}
+
+	const char* handleName = NULL;
+	if ( handle == RTLD_DEFAULT )
+		handleName = "RTLD_DEFAULT";
+	else if ( handle == RTLD_MAIN_ONLY )
+		handleName = "RTLD_MAIN_ONLY";
+	else if ( handle == RTLD_NEXT )
+		handleName = "RTLD_NEXT";
+	else if ( handle == RTLD_SELF )
+		handleName = "RTLD_SELF";
+
+	switch ( outcome ) {
+		case dlsymFound:
+			CRSetCrashLogMessage(NULL);
+			// fall through
+		case dlsymAnsweredByCache:
+			if ( dyld::gLogAPIs ) {
+				if ( handleName != NULL )
+					dyld::log("  %s(%s, %s) ==> %p\n", __func__, handleName, symbolName, result);
+				else
+					dyld::log("  %s(%p, %s) ==> %p\n", __func__, handle, symbolName, result);
+			}
+			return result;
+		case dlsymNotFound: {
+			const char* str;
+			if ( handleName != NULL )
+				str = dyld::mkstringf("dlsym(%s, %s): symbol not found", handleName, symbolName);
+			else
+				str = dyld::mkstringf("dlsym(%p, %s): symbol not found", handle, symbolName);
+			dlerrorSet(str);
+			free((void*)str);
+			break;
+		}
+		case dlsymInvalidHandle:
+			dlerrorSet("invalid handle passed to dlsym()");
+			break;
+	}
+	CRSetCrashLogMessage(NULL);
+	if ( dyld::gLogAPIs ) {
+		if ( handleName != NULL )
+			dyld::log("  %s(%s, %s) ==> NULL\n", __func__, handleName, symbolName);
+		else
+			dyld::log("  %s(%p, %s) ==> NULL\n", __func__, handle, symbolName);
+	}
 	return NULL;
 }
 
@@ -2150,6 +2151,11 @@ void dyld_dynamic_interpose(const struct mach_header* mh, const struct dyld_inte
 	// make the cache writable for this block
 	DyldSharedCache::DataConstScopedWriter patcher(dyld::gLinkContext.dyldCache, mach_task_self(), (dyld::gLinkContext.verboseMapping ? &dyld::log : nullptr));
 	
+	// lock-free dlsym() lookups read the interposing tuples, so move them to the locked path first.
+	// The release pairs with the acquire load in dlsymCanSkipLock().
+	__atomic_store_n(&sDynamicInterposing, true, __ATOMIC_RELEASE);
+	dyld::waitForLockFreeReaders();
+
 	// make pass at bound references in this image and update them
 	dyld::gLinkContext.dynamicInterposeArray = array;
 	dyld::gLinkContext.dynamicInterposeCount = count;
@@ -2159,8 +2165,6 @@ void dyld_dynamic_interpose(const struct mach_header* mh, const struct dyld_inte
 	
 	// leave interposing info so any future (lazy) binding will get it too
 	image->addDynamicInterposingTuples(array, count);
-	
-	sDynamicInterposing = true;
 }
 
 
@@ -77,7 +77,7 @@ extern "C" int _dyld_func_lookup(const char* dyld_func_name, void **address);
 
 template<typename T>
 static void dyld_func_lookup_and_resign(const char *dyld_func_name, T *__ptrauth_dyld_function_ptr* address) {
-    void *funcAsVoidPtr;
+    void *funcAsVoidPtr = nullptr;
     int res = _dyld_func_lookup(dyld_func_name, &funcAsVoidPtr);
     (void)res;
 
@@ -1555,6 +1555,11 @@ template<typename FTy> static FTy *resign_for_dyld(FTy *func) {
 }
 
 
+static void writeLaunchProfile(void*)
+{
+	dyld3::launchProfileWrite();
+}
+
 // the table passed to dyld containing thread helpers
 static dyld::LibSystemHelpers sHelpers = { 13 };
 
@@ -1613,6 +1618,18 @@ void _dyld_initializer()
 			p(&sHelpers);
 	}
 
+	// only profile if dyld allowed DYLD_PROFILE_TO_FILE and started the file, then just append to it
+	typedef const char* (*profilePathFuncType)(void);
+	static profilePathFuncType __ptrauth_dyld_function_ptr profilePathFunc = NULL;
+	dyld_func_lookup_and_resign("__dyld_launch_profile_path", &profilePathFunc);
+	if ( profilePathFunc != NULL ) {
+		if ( const char* profilePath = profilePathFunc() ) {
+			dyld3::launchProfileEnable(profilePath, false);
+			if ( dyld3::launchProfileEnabled() )
+				__cxa_atexit(&writeLaunchProfile, nullptr, nullptr);
+		}
+	}
+
 	tlv_initializer();
 }
 
@@ -1623,7 +1640,8 @@ int dladdr(const void* addr, Dl_info* info)
     if ( gUseDyld3 ) {
         result = dyld3::dladdr(addr, info);
     } else {
-        DYLD_LOCK_THIS_BLOCK;
+        // dladdr only reads the image list, which dyld allows without the lock
+        DYLD_NO_LOCK_THIS_BLOCK;
         typedef int (*funcType)(const void* , Dl_info*);
         static funcType __ptrauth_dyld_function_ptr p = NULL;
 
@@ -1758,7 +1776,8 @@ void* dlsym(void* handle, const char* symbol)
         return result;
     }
 
-    DYLD_LOCK_THIS_BLOCK;
+    // dlsym is special. dyld only takes the lock for the lookups which need it
+    DYLD_NO_LOCK_THIS_BLOCK;
     typedef void* (*funcType)(void* handle, const char* symbol, void *callerAddress);
     static funcType __ptrauth_dyld_function_ptr p = NULL;
 
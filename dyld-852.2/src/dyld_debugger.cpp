@@ -31,10 +31,12 @@
 #include <mach-o/dyld_process_info.h>
 
 #include <vector>
+#include <atomic>
 
 #include "Tracing.h"
 #include "ImageLoader.h"
 #include "dyld2.h"
+#include "dyld_process_info_internal.h"
 
 extern "C" 	void _dyld_debugger_notification(enum dyld_notify_mode mode, unsigned long count, uint64_t machHeaders[]);
 
@@ -47,35 +49,77 @@ extern "C" 	void _dyld_debugger_notification(enum dyld_notify_mode mode, unsigne
 VECTOR_NEVER_DESTRUCTED(dyld_image_info);
 VECTOR_NEVER_DESTRUCTED(dyld_uuid_info);
 
+//
+// _dyld_get_image_header() and friends read a copy of sImageInfos without the dyld lock.
+// A published copy is never modified.  Each change to sImageInfos publishes a new copy and
+// retires the old one until no lock-free reader can still be using it.
+//
+struct ImageInfoList
+{
+	ImageInfoList*		retiredNext;
+	uint32_t			count;
+	dyld_image_info		infos[1];
+};
+
 static std::vector<dyld_image_info> sImageInfos;
 static std::vector<dyld_uuid_info>  sImageUUIDs;
+static CompactImageInfoPublisher    sCompactImageInfo;
+static std::atomic<ImageInfoList*>  sImageInfoList;
 
 #if __x86_64__
 static std::vector<dyld_aot_image_info> sAotImageInfos;
 #endif
 
+// called with the dyld lock held, after every change to sImageInfos
+static void publishImageInfoList()
+{
+	ImageInfoList* newList = NULL;
+	uint32_t count = (uint32_t)sImageInfos.size();
+	if ( count != 0 ) {
+		newList = (ImageInfoList*)malloc(offsetof(ImageInfoList, infos[count]));
+		newList->retiredNext = NULL;
+		newList->count = count;
+		memcpy(newList->infos, &sImageInfos[0], count*sizeof(dyld_image_info));
+	}
+	ImageInfoList* oldList = sImageInfoList.exchange(newList, std::memory_order_acq_rel);
+	if ( oldList != NULL )
+		dyld::retireLockFreeTable(oldList);
+}
+
 size_t allImagesCount()
 {
-	return sImageInfos.size();
+	dyld::LockFreeReadScope readScope;
+	const ImageInfoList* list = sImageInfoList.load(std::memory_order_acquire);
+	return (list != NULL) ? list->count : 0;
 }
 
 const mach_header* allImagesIndexedMachHeader(uint32_t index)
 {
-	if ( index < sImageInfos.size() )
-		return sImageInfos[index].imageLoadAddress;
+	dyld::LockFreeReadScope readScope;
+	const ImageInfoList* list = sImageInfoList.load(std::memory_order_acquire);
+	if ( (list != NULL) && (index < list->count) )
+		return list->infos[index].imageLoadAddress;
 	else
 		return NULL;
 }
 
 const char* allImagesIndexedPath(uint32_t index)
 {
-	if ( index < sImageInfos.size() )
-		return sImageInfos[index].imageFilePath;
+	dyld::LockFreeReadScope readScope;
+	const ImageInfoList* list = sImageInfoList.load(std::memory_order_acquire);
+	if ( (list != NULL) && (index < list->count) )
+		return list->infos[index].imageFilePath;
 	else
 		return NULL;
 }
 
 
+void setCompactImageInfoEnabled(bool enabled)
+{
+	sCompactImageInfo.setEnabled(enabled);
+}
+
+
 void addImagesToAllImages(uint32_t infoCount, const dyld_image_info info[])
 {
 	// make initial size large enough that we probably won't need to re-alloc it
@@ -85,7 +129,7 @@ void addImagesToAllImages(uint32_t infoCount, const dyld_image_info info[])
 		sImageUUIDs.reserve(4);
 	// set infoArray to NULL to denote it is in-use
 	dyld::gProcessInfo->infoArray = NULL;
-	
+
 	// append all new images
 	for (uint32_t i=0; i < infoCount; ++i)
 		sImageInfos.push_back(info[i]);
@@ -94,6 +138,12 @@ void addImagesToAllImages(uint32_t infoCount, const dyld_image_info info[])
 
 	// set infoArray back to base address of vector (other process can now read)
 	dyld::gProcessInfo->infoArray = &sImageInfos[0];
+
+	// republish single buffer snapshot of image list
+	sCompactImageInfo.publish(dyld::gProcessInfo, &sImageInfos[0], (uint32_t)sImageInfos.size());
+
+	// and the copy for in-process lock-free readers
+	publishImageInfoList();
 }
 
 #if __x86_64__
@@ -129,6 +179,7 @@ void syncProcessInfo()
 			}
 			dyld::gProcessInfo->infoArray = &sImageInfos[0];
 			dyld::gProcessInfo->infoArrayCount = (uint32_t)sImageInfos.size();
+			publishImageInfoList();
 		}
 	}
 	dyld::gProcessInfo->notification(dyld_image_info_change, 0, NULL);
@@ -202,6 +253,10 @@ void removeImageFromAllImages(const struct mach_header* loadAddress)
 	// set infoArray back to base address of vector
 	dyld::gProcessInfo->uuidArray = &sImageUUIDs[0];
 
+	// republish single buffer snapshot of image list
+	sCompactImageInfo.publish(dyld::gProcessInfo, &sImageInfos[0], (uint32_t)sImageInfos.size());
+	publishImageInfoList();
+
 	// tell gdb that about the new images
 	dyld::gProcessInfo->notification(dyld_image_removing, 1, &goingAway);
 }
@@ -244,6 +299,7 @@ void removeImageFromAllImages(const struct mach_header* loadAddress)
 	{
 		sImageInfos.clear();
 		sImageUUIDs.clear();
+		publishImageInfoList();
 		_dyld_debugger_notification(dyld_notify_remove_all, 0, NULL);
 	}
 
@@ -256,7 +312,7 @@ void removeImageFromAllImages(const struct mach_header* loadAddress)
 									17, 0, {NULL}, &gdb_image_notifier, false, false, (const mach_header*)&__dso_handle, NULL,
 									XSTR(DYLD_VERSION), NULL, 0, NULL, 0, 0, NULL, &dyld_all_image_infos,
 									0, 0, NULL, NULL, NULL, 0, {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,},
-									0, {0}, "/usr/lib/dyld", {0}, {0}, 0, 0, NULL, 0
+									0, {0}, "/usr/lib/dyld", {0}, {0}, 0, 0, 0, 0, NULL, 0
 									};
 
 	struct dyld_shared_cache_ranges dyld_shared_cache_ranges;
@@ -180,6 +180,8 @@ struct __attribute__((visibility("hidden"))) dyld_process_info_base {
     static dyld_process_info_ptr make(task_t task, const T1& allImageInfo, uint64_t timestamp, kern_return_t* kr);
     template<typename T>
     static dyld_process_info_ptr makeSuspended(task_t task, const T& allImageInfo, kern_return_t* kr);
+    template<typename T>
+    static dyld_process_info_ptr makeFromCompactInfo(task_t task, const T& allImageInfo, uint64_t timestamp, bool& changed);
 
     std::atomic<uint32_t>&       retainCount() const { return _retainCount; }
     dyld_process_cache_info*     cacheInfo() const { return (dyld_process_cache_info*)(((char*)this) + _cacheInfoOffset); }
@@ -229,6 +231,9 @@ private:
                                 dyld_process_info_base(dyld_platform_t platform, unsigned imageCount, unsigned aotImageCount, size_t totalSize);
     void*                       operator new (size_t, void* buf) { return buf; }
 
+    template<typename T>
+    void                        setBaseInfo(const T& allImageInfo, uint64_t timestamp, uint32_t imageCount);
+
     static bool                 inCache(uint64_t addr) { return (addr > SHARED_REGION_BASE) && (addr < SHARED_REGION_BASE+SHARED_REGION_SIZE); }
     bool                        addImage(task_t task, bool sameCacheAsThisProcess, uint64_t imageAddress, uint64_t imagePath, const char* imagePathLocal);
 
@@ -331,110 +336,92 @@ dyld_process_info_ptr dyld_process_info_base::make(task_t task, const T1& allIma
         return  nullptr;
     };
 
-    // For the moment we are going to truncate any image list longer than 8192 because some programs do
-    // terrible things that corrupt their own image lists and we need to stop clients from crashing
-    // reading them. We can try to do something more advanced in the future. rdar://27446361
-    uint32_t imageCount = allImageInfo.infoArrayCount;
-    imageCount = MIN(imageCount, 8192);
-    size_t imageArraySize = imageCount * sizeof(T2);
-
-    withRemoteBuffer(task, infoArray, imageArraySize, false, kr, ^(void *buffer, size_t size) {
-        // figure out how many path strings will need to be copied and their size
-        T2* imageArray = (T2 *)buffer;
-        const dyld_all_image_infos* myInfo = _dyld_get_all_image_infos();
-        bool sameCacheAsThisProcess = !allImageInfo.processDetachedFromSharedRegion
-            && !myInfo->processDetachedFromSharedRegion
-            && ((memcmp(myInfo->sharedCacheUUID, &allImageInfo.sharedCacheUUID[0], 16) == 0)
-            && (myInfo->sharedCacheSlide == allImageInfo.sharedCacheSlide));
-        unsigned countOfPathsNeedingCopying = 0;
-        if ( sameCacheAsThisProcess ) {
-            for (uint32_t i=0; i < imageCount; ++i) {
-                if ( !inCache(imageArray[i].imageFilePath) )
-                    ++countOfPathsNeedingCopying;
-            }
-        }
-        else {
-            countOfPathsNeedingCopying = imageCount+1;
-        }
-        unsigned imageCountWithDyld = imageCount+1;
+    // if the process publishes a compact image list, one remote read gets everything
+    bool compactInfoChanged = false;
+    result = makeFromCompactInfo<T1>(task, allImageInfo, currentTimestamp, compactInfoChanged);
+    if ( compactInfoChanged ) {
+        // dyld updated the image list while it was being copied, so start again from the new one
+        *kr = KERN_RESOURCE_SHORTAGE;
+        return nullptr;
+    }
 
-        // allocate result object
-        size_t allocationSize = sizeof(dyld_process_info_base)
-                                    + sizeof(dyld_process_cache_info)
-                                    + sizeof(dyld_process_aot_cache_info)
-                                    + sizeof(dyld_process_state_info)
-                                    + sizeof(ImageInfo)*(imageCountWithDyld)
-                                    + sizeof(dyld_aot_image_info_64)*(allImageInfo.aotInfoCount) // add the size necessary for aot info to this buffer
-                                    + sizeof(SegmentInfo)*imageCountWithDyld*10
-                                    + countOfPathsNeedingCopying*PATH_MAX;
-        void* storage = malloc(allocationSize);
-        if (storage == nullptr) {
-            *kr = KERN_NO_SPACE;
-            result = nullptr;
-            return;
-        }
-        auto info = dyld_process_info_ptr(new (storage) dyld_process_info_base(allImageInfo.platform, imageCountWithDyld, allImageInfo.aotInfoCount, allocationSize), deleter);
-        (void)info->reserveSpace(sizeof(dyld_process_info_base)+sizeof(dyld_process_cache_info)+sizeof(dyld_process_state_info)+sizeof(dyld_process_aot_cache_info));
-        (void)info->reserveSpace(sizeof(ImageInfo)*imageCountWithDyld);
-
-        // fill in base info
-        dyld_process_cache_info* cacheInfo = info->cacheInfo();
-        memcpy(cacheInfo->cacheUUID, &allImageInfo.sharedCacheUUID[0], 16);
-        cacheInfo->cacheBaseAddress    = allImageInfo.sharedCacheBaseAddress;
-        cacheInfo->privateCache        = allImageInfo.processDetachedFromSharedRegion;
-        // if no cache is used, allImageInfo has all zeros for cache UUID
-        cacheInfo->noCache = true;
-        for (int i=0; i < 16; ++i) {
-            if ( cacheInfo->cacheUUID[i] != 0 ) {
-                cacheInfo->noCache = false;
+    // otherwise read the image info array, then each path and each image's load commands
+    if ( !result ) {
+        // For the moment we are going to truncate any image list longer than 8192 because some programs do
+        // terrible things that corrupt their own image lists and we need to stop clients from crashing
+        // reading them. We can try to do something more advanced in the future. rdar://27446361
+        uint32_t imageCount = allImageInfo.infoArrayCount;
+        imageCount = MIN(imageCount, 8192);
+        size_t imageArraySize = imageCount * sizeof(T2);
+
+        withRemoteBuffer(task, infoArray, imageArraySize, false, kr, ^(void *buffer, size_t size) {
+            // figure out how many path strings will need to be copied and their size
+            T2* imageArray = (T2 *)buffer;
+            const dyld_all_image_infos* myInfo = _dyld_get_all_image_infos();
+            bool sameCacheAsThisProcess = !allImageInfo.processDetachedFromSharedRegion
+                && !myInfo->processDetachedFromSharedRegion
+                && ((memcmp(myInfo->sharedCacheUUID, &allImageInfo.sharedCacheUUID[0], 16) == 0)
+                && (myInfo->sharedCacheSlide == allImageInfo.sharedCacheSlide));
+            unsigned countOfPathsNeedingCopying = 0;
+            if ( sameCacheAsThisProcess ) {
+                for (uint32_t i=0; i < imageCount; ++i) {
+                    if ( !inCache(imageArray[i].imageFilePath) )
+                        ++countOfPathsNeedingCopying;
+                }
             }
-        }
-
-        // fill in aot shared cache info
-        dyld_process_aot_cache_info* aotCacheInfo = info->aotCacheInfo();
-        memcpy(aotCacheInfo->cacheUUID, &allImageInfo.aotSharedCacheUUID[0], 16);
-        aotCacheInfo->cacheBaseAddress = allImageInfo.aotSharedCacheBaseAddress;
-
-        dyld_process_state_info* stateInfo = info->stateInfo();
-        stateInfo->timestamp           = currentTimestamp;
-        stateInfo->imageCount          = imageCountWithDyld;
-        stateInfo->initialImageCount   = (uint32_t)(allImageInfo.initialImageCount+1);
-        stateInfo->dyldState = dyld_process_state_dyld_initialized;
-
-        if ( allImageInfo.libSystemInitialized != 0 ) {
-            stateInfo->dyldState = dyld_process_state_libSystem_initialized;
-            if ( allImageInfo.initialImageCount != imageCount ) {
-                stateInfo->dyldState = dyld_process_state_program_running;
+            else {
+                countOfPathsNeedingCopying = imageCount+1;
             }
-        }
-        if ( allImageInfo.errorMessage != 0 ) {
-            stateInfo->dyldState = allImageInfo.terminationFlags ? dyld_process_state_terminated_before_inits : dyld_process_state_dyld_terminated;
-        }
-        // fill in info for dyld
-        if ( allImageInfo.dyldPath != 0 ) {
-            if ((*kr = info->addDyldImage(task, allImageInfo.dyldImageLoadAddress, allImageInfo.dyldPath, NULL))) {
-                *kr = KERN_FAILURE;
+            unsigned imageCountWithDyld = imageCount+1;
+
+            // allocate result object
+            size_t allocationSize = sizeof(dyld_process_info_base)
+                                        + sizeof(dyld_process_cache_info)
+                                        + sizeof(dyld_process_aot_cache_info)
+                                        + sizeof(dyld_process_state_info)
+                                        + sizeof(ImageInfo)*(imageCountWithDyld)
+                                        + sizeof(dyld_aot_image_info_64)*(allImageInfo.aotInfoCount) // add the size necessary for aot info to this buffer
+                                        + sizeof(SegmentInfo)*imageCountWithDyld*10
+                                        + countOfPathsNeedingCopying*PATH_MAX;
+            void* storage = malloc(allocationSize);
+            if (storage == nullptr) {
+                *kr = KERN_NO_SPACE;
                 result = nullptr;
                 return;
             }
-        }
-        // fill in info for each image
-        for (uint32_t i=0; i < imageCount; ++i) {
-            if (!info->addImage(task, sameCacheAsThisProcess, imageArray[i].imageLoadAddress, imageArray[i].imageFilePath, NULL)) {
+            auto info = dyld_process_info_ptr(new (storage) dyld_process_info_base(allImageInfo.platform, imageCountWithDyld, allImageInfo.aotInfoCount, allocationSize), deleter);
+            (void)info->reserveSpace(sizeof(dyld_process_info_base)+sizeof(dyld_process_cache_info)+sizeof(dyld_process_state_info)+sizeof(dyld_process_aot_cache_info));
+            (void)info->reserveSpace(sizeof(ImageInfo)*imageCountWithDyld);
+
+            // fill in base info
+            info->setBaseInfo(allImageInfo, currentTimestamp, imageCount);
+
+            // fill in info for dyld
+            if ( allImageInfo.dyldPath != 0 ) {
+                if ((*kr = info->addDyldImage(task, allImageInfo.dyldImageLoadAddress, allImageInfo.dyldPath, NULL))) {
+                    *kr = KERN_FAILURE;
+                    result = nullptr;
+                    return;
+                }
+            }
+            // fill in info for each image
+            for (uint32_t i=0; i < imageCount; ++i) {
+                if (!info->addImage(task, sameCacheAsThisProcess, imageArray[i].imageLoadAddress, imageArray[i].imageFilePath, NULL)) {
+                    *kr = KERN_FAILURE;
+                    result = nullptr;
+                    return;
+                }
+            }
+            // sanity check internal data did not overflow
+            if ( info->invalid() ) {
                 *kr = KERN_FAILURE;
                 result = nullptr;
                 return;
             }
-        }
-        // sanity check internal data did not overflow
-        if ( info->invalid() ) {
-            *kr = KERN_FAILURE;
-            result = nullptr;
-            return;
-        }
 
-        result = std::move(info);
-    });
+            result = std::move(info);
+        });
+    }
 
     mach_vm_address_t aotImageArray = allImageInfo.aotInfoArray;
     // shortcircuit this code path if aotImageArray == 0 (32 vs 64 bit struct difference)
@@ -457,6 +444,150 @@ dyld_process_info_ptr dyld_process_info_base::make(task_t task, const T1& allIma
     return std::move(result);
 }
 
+template<typename T>
+void dyld_process_info_base::setBaseInfo(const T& allImageInfo, uint64_t timestamp, uint32_t imageCount)
+{
+    dyld_process_cache_info* cacheInfo = this->cacheInfo();
+    memcpy(cacheInfo->cacheUUID, &allImageInfo.sharedCacheUUID[0], 16);
+    cacheInfo->cacheBaseAddress    = allImageInfo.sharedCacheBaseAddress;
+    cacheInfo->privateCache        = allImageInfo.processDetachedFromSharedRegion;
+    // if no cache is used, allImageInfo has all zeros for cache UUID
+    cacheInfo->noCache = true;
+    for (int i=0; i < 16; ++i) {
+        if ( cacheInfo->cacheUUID[i] != 0 ) {
+            cacheInfo->noCache = false;
+        }
+    }
+
+    // fill in aot shared cache info
+    dyld_process_aot_cache_info* aotCacheInfo = this->aotCacheInfo();
+    memcpy(aotCacheInfo->cacheUUID, &allImageInfo.aotSharedCacheUUID[0], 16);
+    aotCacheInfo->cacheBaseAddress = allImageInfo.aotSharedCacheBaseAddress;
+
+    dyld_process_state_info* stateInfo = this->stateInfo();
+    stateInfo->timestamp           = timestamp;
+    stateInfo->imageCount          = imageCount+1;
+    stateInfo->initialImageCount   = (uint32_t)(allImageInfo.initialImageCount+1);
+    stateInfo->dyldState = dyld_process_state_dyld_initialized;
+
+    if ( allImageInfo.libSystemInitialized != 0 ) {
+        stateInfo->dyldState = dyld_process_state_libSystem_initialized;
+        if ( allImageInfo.initialImageCount != imageCount ) {
+            stateInfo->dyldState = dyld_process_state_program_running;
+        }
+    }
+    if ( allImageInfo.errorMessage != 0 ) {
+        stateInfo->dyldState = allImageInfo.terminationFlags ? dyld_process_state_terminated_before_inits : dyld_process_state_dyld_terminated;
+    }
+}
+
+// dyld zeroes the timestamp of a compact image list before rewriting it, and stamps it again when done.
+// So, like a seqlock, a copy whose header had the expected timestamp is only consistent if the timestamp
+// still matches once the copy has been made.
+static bool compactInfoUnchanged(task_t task, mach_vm_address_t compactInfoAddr, uint64_t timestamp)
+{
+    __block bool unchanged = false;
+    withRemoteObject(task, compactInfoAddr + offsetof(dyld_process_info_compact_header, timestamp), nullptr, ^(uint64_t currentTimestamp) {
+        unchanged = (currentTimestamp == timestamp);
+    });
+    return unchanged;
+}
+
+// Returns nullptr if the process has no usable compact image list, in which case the caller falls back to the slow path.
+// Sets changed if the list was updated while being read, in which case the caller should start again.
+template<typename T>
+dyld_process_info_ptr dyld_process_info_base::makeFromCompactInfo(task_t task, const T& allImageInfo, uint64_t timestamp, bool& changed)
+{
+    __block dyld_process_info_ptr result = nullptr;
+    if ( (allImageInfo.version < 16) || (allImageInfo.compactImageListAddr == 0) )
+        return nullptr;
+    size_t compactSize = (size_t)allImageInfo.compactImageListSize;
+    if ( (compactSize < sizeof(dyld_process_info_compact_header)) || (compactSize > 64*1024*1024) )
+        return nullptr;
+
+    __block bool torn = false;
+    withRemoteBuffer(task, allImageInfo.compactImageListAddr, compactSize, false, nullptr, ^(void *buffer, size_t size) {
+        // validate, the blob may have been replaced since allImageInfo was read
+        const uint8_t* start = (uint8_t*)buffer;
+        const dyld_process_info_compact_header* header = (dyld_process_info_compact_header*)buffer;
+        if ( (header->magic != DYLD_PROCESS_INFO_COMPACT_MAGIC) || (header->version != DYLD_PROCESS_INFO_COMPACT_VERSION) )
+            return;
+        if ( (header->timestamp != timestamp) || !compactInfoUnchanged(task, allImageInfo.compactImageListAddr, timestamp) ) {
+            torn = true;
+            return;
+        }
+        if ( header->totalSize > size )
+            return;
+        if ( (header->imageCount == 0) || (header->imageCount > 8192+1) || (header->stringsSize == 0) )
+            return;
+        if ( ((uint64_t)header->imagesOffset + (uint64_t)header->imageCount*sizeof(dyld_process_info_compact_image)) > header->totalSize )
+            return;
+        if ( ((uint64_t)header->segmentsOffset + (uint64_t)header->segmentCount*sizeof(dyld_process_info_compact_segment)) > header->totalSize )
+            return;
+        if ( ((uint64_t)header->stringsOffset + header->stringsSize) > header->totalSize )
+            return;
+        const dyld_process_info_compact_image*   images   = (dyld_process_info_compact_image*)(start + header->imagesOffset);
+        const dyld_process_info_compact_segment* segments = (dyld_process_info_compact_segment*)(start + header->segmentsOffset);
+        const char*                              strings  = (char*)(start + header->stringsOffset);
+        if ( strings[header->stringsSize-1] != '\0' )
+            return;
+        for (uint32_t i=0; i < header->imageCount; ++i) {
+            if ( images[i].pathStringOffset >= header->stringsSize )
+                return;
+            if ( ((uint64_t)images[i].segmentStartIndex + images[i].segmentsCount) > header->segmentCount )
+                return;
+        }
+
+        // allocate result object, with room for every path and for every segment name not being a standard one
+        size_t allocationSize = sizeof(dyld_process_info_base)
+                                    + sizeof(dyld_process_cache_info)
+                                    + sizeof(dyld_process_aot_cache_info)
+                                    + sizeof(dyld_process_state_info)
+                                    + sizeof(ImageInfo)*header->imageCount
+                                    + sizeof(dyld_aot_image_info_64)*(allImageInfo.aotInfoCount)
+                                    + sizeof(SegmentInfo)*header->segmentCount
+                                    + header->stringsSize
+                                    + 17*header->segmentCount;
+        void* storage = malloc(allocationSize);
+        if (storage == nullptr)
+            return;
+        auto info = dyld_process_info_ptr(new (storage) dyld_process_info_base(allImageInfo.platform, header->imageCount, allImageInfo.aotInfoCount, allocationSize), deleter);
+        (void)info->reserveSpace(sizeof(dyld_process_info_base)+sizeof(dyld_process_cache_info)+sizeof(dyld_process_state_info)+sizeof(dyld_process_aot_cache_info));
+        (void)info->reserveSpace(sizeof(ImageInfo)*header->imageCount);
+        info->setBaseInfo(allImageInfo, timestamp, header->imageCount-1);
+
+        for (uint32_t i=0; i < header->imageCount; ++i) {
+            const dyld_process_info_compact_image& image = images[i];
+            ImageInfo* curImage = info->_curImage;
+            memcpy(curImage->uuid, image.uuid, sizeof(uuid_t));
+            curImage->loadAddress       = image.loadAddress;
+            curImage->path              = info->addString(&strings[image.pathStringOffset], PATH_MAX);
+            curImage->segmentStartIndex = info->_curSegmentIndex;
+            for (uint32_t s=0; s < image.segmentsCount; ++s) {
+                const dyld_process_info_compact_segment& segment = segments[image.segmentStartIndex+s];
+                if ( !info->reserveSpace(sizeof(SegmentInfo)) )
+                    return;
+                char segName[17];
+                memcpy(segName, segment.name, 16);
+                segName[16] = '\0';
+                info->_curSegment->name = info->copySegmentName(segName);
+                info->_curSegment->addr = segment.addr;
+                info->_curSegment->size = segment.size;
+                info->_curSegment++;
+                info->_curSegmentIndex++;
+            }
+            curImage->segmentsCount = info->_curSegmentIndex - curImage->segmentStartIndex;
+            info->_curImage++;
+        }
+        if ( info->invalid() )
+            return;
+
+        result = std::move(info);
+    });
+    changed = torn;
+    return std::move(result);
+}
+
 template<typename T>
 dyld_process_info_ptr dyld_process_info_base::makeSuspended(task_t task, const T& allImageInfo, kern_return_t* kr)
 {
@@ -841,11 +972,100 @@ dyld_process_info _dyld_process_info_create(task_t task, uint64_t timestamp, ker
                 result = base.release();
             }
         });
-        if (kr == KERN_SUCCESS) { break; }
+        if (*kr == KERN_SUCCESS) { break; }
     }
     return  result;
 }
 
+template<typename T>
+static uint64_t forEachChangeSince(task_t task, const T& allImageInfo, uint64_t timestamp,
+                                   void (^callback)(bool unload, uint64_t timestamp, uint64_t machHeader, const uuid_t uuid, const char* path),
+                                   kern_return_t* kr)
+{
+    uint64_t currentTimestamp = allImageInfo.infoArrayChangeTimestamp;
+    if ( currentTimestamp == timestamp )
+        return timestamp;
+    if ( (allImageInfo.version < 16) || (allImageInfo.compactImageListAddr == 0) )
+        return 0;
+
+    // read just the header, then just the change log, not the image list after it
+    __block uint32_t logSize = 0;
+    withRemoteObject(task, allImageInfo.compactImageListAddr, kr, ^(dyld_process_info_compact_header header) {
+        if ( (header.magic != DYLD_PROCESS_INFO_COMPACT_MAGIC) || (header.version != DYLD_PROCESS_INFO_COMPACT_VERSION) )
+            return;
+        if ( (header.timestamp != currentTimestamp) || (timestamp < header.changesSince) )
+            return;
+        if ( (header.imagesOffset < sizeof(dyld_process_info_compact_header)) || (header.imagesOffset > header.totalSize) )
+            return;
+        logSize = header.imagesOffset;
+    });
+    if ( logSize == 0 )
+        return 0;
+
+    __block uint64_t result = 0;
+    withRemoteBuffer(task, allImageInfo.compactImageListAddr, logSize, false, kr, ^(void* buffer, size_t size) {
+        const uint8_t* start = (uint8_t*)buffer;
+        const dyld_process_info_compact_header* header = (dyld_process_info_compact_header*)buffer;
+        // blob may have been replaced between the two reads, or while the second was being made
+        if ( (header->magic != DYLD_PROCESS_INFO_COMPACT_MAGIC) || (header->timestamp != currentTimestamp) || (header->imagesOffset != size) )
+            return;
+        if ( !compactInfoUnchanged(task, allImageInfo.compactImageListAddr, currentTimestamp) )
+            return;
+        if ( ((uint64_t)header->changesOffset + (uint64_t)header->changeCount*sizeof(dyld_process_info_compact_change)) > size )
+            return;
+        if ( ((uint64_t)header->changeStringsOffset + header->changeStringsSize) > size )
+            return;
+        const dyld_process_info_compact_change* changes = (dyld_process_info_compact_change*)(start + header->changesOffset);
+        const char*                             strings = (char*)(start + header->changeStringsOffset);
+        if ( (header->changeStringsSize != 0) && (strings[header->changeStringsSize-1] != '\0') )
+            return;
+        for (uint32_t i=0; i < header->changeCount; ++i) {
+            if ( (changes[i].timestamp > timestamp) && (changes[i].pathStringOffset >= header->changeStringsSize) )
+                return;
+        }
+        for (uint32_t i=0; i < header->changeCount; ++i) {
+            const dyld_process_info_compact_change& change = changes[i];
+            if ( change.timestamp > timestamp )
+                callback(change.unload != 0, change.timestamp, change.loadAddress, change.uuid, &strings[change.pathStringOffset]);
+        }
+        result = currentTimestamp;
+    });
+    return result;
+}
+
+uint64_t _dyld_process_info_for_each_change_since(task_t task, uint64_t timestamp,
+                                                  void (^callback)(bool unload, uint64_t timestamp, uint64_t machHeader, const uuid_t uuid, const char* path),
+                                                  kern_return_t* kr)
+{
+    __block uint64_t result = 0;
+    kern_return_t krSink = KERN_SUCCESS;
+    if (kr == nullptr) {
+        kr = &krSink;
+    }
+    *kr = KERN_SUCCESS;
+    if ( timestamp == 0 )
+        return 0;
+
+    task_dyld_info_data_t task_dyld_info;
+    mach_msg_type_number_t count = TASK_DYLD_INFO_COUNT;
+    if ( kern_return_t r = task_info(task, TASK_DYLD_INFO, (task_info_t)&task_dyld_info, &count) ) {
+        *kr = r;
+        return 0;
+    }
+    if (task_dyld_info.all_image_info_addr == MACH_VM_MIN_ADDRESS) {
+        *kr = KERN_FAILURE;
+        return 0;
+    }
+
+    withRemoteBuffer(task, task_dyld_info.all_image_info_addr, (size_t)task_dyld_info.all_image_info_size, false, kr, ^(void *buffer, size_t size) {
+        if (task_dyld_info.all_image_info_format == TASK_DYLD_ALL_IMAGE_INFO_32 )
+            result = forEachChangeSince(task, *(const dyld_all_image_infos_32*)buffer, timestamp, callback, kr);
+        else
+            result = forEachChangeSince(task, *(const dyld_all_image_infos_64*)buffer, timestamp, callback, kr);
+    });
+    return result;
+}
+
 void _dyld_process_info_get_state(dyld_process_info info, dyld_process_state_info* stateInfo)
 {
     *stateInfo = *info->stateInfo();
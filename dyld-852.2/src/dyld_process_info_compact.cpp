@@ -0,0 +1,292 @@
+/* -*- mode: C++; c-basic-offset: 4; tab-width: 4 -*-
+ *
+ * Copyright (c) 2020 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <uuid/uuid.h>
+#include <mach/mach.h>
+#include <mach-o/loader.h>
+
+#include <atomic>
+
+#include <mach-o/dyld_images.h>
+
+#include "dyld_process_info_internal.h"
+
+#if BUILDING_DYLD || BUILDING_LIBDYLD
+
+static void forEachLoadCommand(const mach_header* mh, void (^handler)(const load_command* cmd))
+{
+    if ( mh == nullptr )
+        return;
+    const load_command* cmd;
+    if ( mh->magic == MH_MAGIC_64 )
+        cmd = (load_command*)((char*)mh + sizeof(mach_header_64));
+    else if ( mh->magic == MH_MAGIC )
+        cmd = (load_command*)((char*)mh + sizeof(mach_header));
+    else
+        return;
+    for (uint32_t i = 0; i < mh->ncmds; ++i) {
+        handler(cmd);
+        cmd = (load_command*)((char*)cmd + cmd->cmdsize);
+    }
+}
+
+static void forEachSegment(const mach_header* mh, void (^handler)(const char* segName, uint64_t vmAddr, uint64_t vmSize))
+{
+    forEachLoadCommand(mh, ^(const load_command* cmd) {
+        if ( cmd->cmd == LC_SEGMENT ) {
+            const segment_command* segCmd = (segment_command*)cmd;
+            handler(segCmd->segname, segCmd->vmaddr, segCmd->vmsize);
+        }
+        else if ( cmd->cmd == LC_SEGMENT_64 ) {
+            const segment_command_64* segCmd = (segment_command_64*)cmd;
+            handler(segCmd->segname, segCmd->vmaddr, segCmd->vmsize);
+        }
+    });
+}
+
+static void getUUID(const mach_header* mh, uuid_t uuid)
+{
+    forEachLoadCommand(mh, ^(const load_command* cmd) {
+        if ( cmd->cmd == LC_UUID )
+            memcpy(uuid, ((uuid_command*)cmd)->uuid, sizeof(uuid_t));
+    });
+}
+
+static int compareAddresses(const void* l, const void* r)
+{
+    uint64_t left  = *(const uint64_t*)l;
+    uint64_t right = *(const uint64_t*)r;
+    return (left < right) ? -1 : ((left > right) ? 1 : 0);
+}
+
+void CompactImageInfoPublisher::publish(dyld_all_image_infos* allInfo, const dyld_image_info infos[], uint32_t infoCount)
+{
+    if ( !_enabled )
+        return;
+
+    // mark as in-use while rebuilding
+    allInfo->compactImageListAddr = 0;
+    allInfo->compactImageListSize = 0;
+
+    uint64_t timestamp = allInfo->infoArrayChangeTimestamp;
+    recordChanges(timestamp, infos, infoCount);
+    _published = false;
+
+    // size everything first
+    uint32_t         imageCount   = infoCount + 1;
+    __block uint32_t segmentCount = 0;
+    uint32_t         stringsSize  = (uint32_t)strlen(allInfo->dyldPath ? allInfo->dyldPath : "") + 1;
+    forEachSegment(allInfo->dyldImageLoadAddress, ^(const char*, uint64_t, uint64_t) { ++segmentCount; });
+    for (uint32_t i=0; i < infoCount; ++i) {
+        stringsSize += (uint32_t)strlen(infos[i].imageFilePath ? infos[i].imageFilePath : "") + 1;
+        forEachSegment(infos[i].imageLoadAddress, ^(const char*, uint64_t, uint64_t) { ++segmentCount; });
+    }
+    uint32_t changeStringsSize = 0;
+    for (uint32_t i=0; i < _changeCount; ++i)
+        changeStringsSize += (uint32_t)strlen(changeAt(i).path) + 1;
+    size_t changesOffset       = sizeof(dyld_process_info_compact_header);
+    size_t changeStringsOffset = changesOffset + _changeCount*sizeof(dyld_process_info_compact_change);
+    size_t imagesOffset        = (changeStringsOffset + changeStringsSize + 7) & (-8);
+    size_t segmentsOffset      = imagesOffset + imageCount*sizeof(dyld_process_info_compact_image);
+    size_t stringsOffset       = segmentsOffset + segmentCount*sizeof(dyld_process_info_compact_segment);
+    size_t totalSize           = (stringsOffset + stringsSize + 7) & (-8);
+    if ( totalSize > UINT32_MAX )
+        return;
+
+    // fill in whichever buffer is not currently published
+    _current = 1 - _current;
+    if ( _bufferSizes[_current] < totalSize ) {
+        ::free(_buffers[_current]);
+        size_t allocSize = totalSize + totalSize/4;
+        _buffers[_current] = ::malloc(allocSize);
+        if ( _buffers[_current] == nullptr ) {
+            _bufferSizes[_current] = 0;
+            return;
+        }
+        _bufferSizes[_current] = allocSize;
+    }
+    uint8_t* buffer = (uint8_t*)_buffers[_current];
+    dyld_process_info_compact_header* header = (dyld_process_info_compact_header*)buffer;
+    // a reader still copying this buffer re-reads the timestamp afterwards, so it must be zeroed before anything changes
+    __atomic_store_n(&header->timestamp, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    header->magic               = DYLD_PROCESS_INFO_COMPACT_MAGIC;
+    header->version             = DYLD_PROCESS_INFO_COMPACT_VERSION;
+    header->changesSince        = _changesSince;
+    header->totalSize           = (uint32_t)totalSize;
+    header->changeCount         = _changeCount;
+    header->changesOffset       = (uint32_t)changesOffset;
+    header->changeStringsOffset = (uint32_t)changeStringsOffset;
+    header->changeStringsSize   = changeStringsSize;
+    header->imageCount          = imageCount;
+    header->imagesOffset        = (uint32_t)imagesOffset;
+    header->segmentCount        = segmentCount;
+    header->segmentsOffset      = (uint32_t)segmentsOffset;
+    header->stringsOffset       = (uint32_t)stringsOffset;
+    header->stringsSize         = stringsSize;
+    header->padding             = 0;
+
+    // change log, oldest first
+    dyld_process_info_compact_change* change = (dyld_process_info_compact_change*)(buffer + changesOffset);
+    char*    changeStrings      = (char*)(buffer + changeStringsOffset);
+    uint32_t changeStringOffset = 0;
+    for (uint32_t i=0; i < _changeCount; ++i, ++change) {
+        const ChangeRecord& record = changeAt(i);
+        size_t pathLen = strlen(record.path) + 1;
+        memcpy(&changeStrings[changeStringOffset], record.path, pathLen);
+        change->timestamp        = record.timestamp;
+        change->loadAddress      = record.loadAddress;
+        memcpy(change->uuid, record.uuid, sizeof(uuid_t));
+        change->unload           = record.unload;
+        change->pathStringOffset = changeStringOffset;
+        changeStringOffset += pathLen;
+    }
+
+    __block dyld_process_info_compact_image*   image   = (dyld_process_info_compact_image*)(buffer + imagesOffset);
+    __block dyld_process_info_compact_segment* segment = (dyld_process_info_compact_segment*)(buffer + segmentsOffset);
+    __block char*                              strings = (char*)(buffer + stringsOffset);
+    __block uint32_t                           stringOffset = 0;
+    __block uint32_t                           segmentIndex = 0;
+    void (^addImage)(const mach_header*, const char*) = ^(const mach_header* mh, const char* path) {
+        if ( path == nullptr )
+            path = "";
+        size_t pathLen = strlen(path) + 1;
+        memcpy(&strings[stringOffset], path, pathLen);
+        bzero(image->uuid, sizeof(uuid_t));
+        getUUID(mh, image->uuid);
+        image->loadAddress       = (uint64_t)(uintptr_t)mh;
+        image->pathStringOffset  = stringOffset;
+        image->segmentStartIndex = segmentIndex;
+        image->padding           = 0;
+        stringOffset += pathLen;
+        forEachSegment(mh, ^(const char* segName, uint64_t vmAddr, uint64_t vmSize) {
+            strncpy(segment->name, segName, sizeof(segment->name));
+            segment->addr = vmAddr;
+            segment->size = vmSize;
+            ++segment;
+            ++segmentIndex;
+        });
+        image->segmentsCount = segmentIndex - image->segmentStartIndex;
+        ++image;
+    };
+    addImage(allInfo->dyldImageLoadAddress, allInfo->dyldPath);
+    for (uint32_t i=0; i < infoCount; ++i)
+        addImage(infos[i].imageLoadAddress, infos[i].imageFilePath);
+
+    // stamp and publish
+    __atomic_store_n(&header->timestamp, timestamp, __ATOMIC_RELEASE);
+    _published = true;
+    allInfo->compactImageListSize = totalSize;
+    allInfo->compactImageListAddr = (uintptr_t)buffer;
+}
+
+void CompactImageInfoPublisher::forgetChanges(uint64_t timestamp)
+{
+    for (uint32_t i=0; i < _changeCount; ++i)
+        ::free(changeAt(i).path);
+    _changeStart  = 0;
+    _changeCount  = 0;
+    _changesSince = timestamp;
+}
+
+void CompactImageInfoPublisher::addChange(uint64_t timestamp, bool unload, uint64_t loadAddress, const uint8_t uuid[16], const char* path)
+{
+    if ( _changeCount == kMaxChanges ) {
+        // drop oldest, clients older than it now need a full snapshot
+        ChangeRecord& oldest = changeAt(0);
+        ::free(oldest.path);
+        _changesSince = oldest.timestamp;
+        _changeStart  = (_changeStart + 1) % kMaxChanges;
+        --_changeCount;
+    }
+    ChangeRecord& record = changeAt(_changeCount);
+    record.timestamp   = timestamp;
+    record.loadAddress = loadAddress;
+    memcpy(record.uuid, uuid, sizeof(uuid_t));
+    record.unload      = unload;
+    record.path        = ::strdup(path ? path : "");
+    if ( record.path == nullptr ) {
+        forgetChanges(timestamp);
+        return;
+    }
+    ++_changeCount;
+}
+
+// diffs the new image list against the last one published and logs what was loaded and unloaded
+void CompactImageInfoPublisher::recordChanges(uint64_t timestamp, const dyld_image_info infos[], uint32_t infoCount)
+{
+    if ( !_published ) {
+        // nothing to diff against, so changes are only known from this list onwards
+        forgetChanges(timestamp);
+        return;
+    }
+    if ( _changes == nullptr ) {
+        _changes = (ChangeRecord*)::calloc(kMaxChanges, sizeof(ChangeRecord));
+        if ( _changes == nullptr ) {
+            _changesSince = timestamp;
+            return;
+        }
+    }
+    const uint8_t* previous = (uint8_t*)_buffers[_current];
+    const dyld_process_info_compact_header* prevHeader  = (dyld_process_info_compact_header*)previous;
+    const dyld_process_info_compact_image*  prevImages  = (dyld_process_info_compact_image*)(previous + prevHeader->imagesOffset);
+    const char*                             prevStrings = (char*)(previous + prevHeader->stringsOffset);
+    uint32_t  prevCount = prevHeader->imageCount - 1;  // skip dyld
+    uint64_t* oldAddrs  = (uint64_t*)::malloc(sizeof(uint64_t)*(prevCount+1));
+    uint64_t* newAddrs  = (uint64_t*)::malloc(sizeof(uint64_t)*(infoCount+1));
+    if ( (oldAddrs == nullptr) || (newAddrs == nullptr) ) {
+        ::free(oldAddrs);
+        ::free(newAddrs);
+        forgetChanges(timestamp);
+        return;
+    }
+    for (uint32_t i=0; i < prevCount; ++i)
+        oldAddrs[i] = prevImages[i+1].loadAddress;
+    for (uint32_t i=0; i < infoCount; ++i)
+        newAddrs[i] = (uint64_t)(uintptr_t)infos[i].imageLoadAddress;
+    ::qsort(oldAddrs, prevCount, sizeof(uint64_t), &compareAddresses);
+    ::qsort(newAddrs, infoCount, sizeof(uint64_t), &compareAddresses);
+
+    for (uint32_t i=0; i < prevCount; ++i) {
+        const dyld_process_info_compact_image& prev = prevImages[i+1];
+        if ( ::bsearch(&prev.loadAddress, newAddrs, infoCount, sizeof(uint64_t), &compareAddresses) == nullptr )
+            addChange(timestamp, true, prev.loadAddress, prev.uuid, &prevStrings[prev.pathStringOffset]);
+    }
+    for (uint32_t i=0; i < infoCount; ++i) {
+        uint64_t loadAddress = (uint64_t)(uintptr_t)infos[i].imageLoadAddress;
+        if ( ::bsearch(&loadAddress, oldAddrs, prevCount, sizeof(uint64_t), &compareAddresses) == nullptr ) {
+            uuid_t uuid;
+            bzero(uuid, sizeof(uuid_t));
+            getUUID(infos[i].imageLoadAddress, uuid);
+            addChange(timestamp, false, loadAddress, uuid, infos[i].imageFilePath);
+        }
+    }
+    ::free(oldAddrs);
+    ::free(newAddrs);
+}
+
+#endif // BUILDING_DYLD || BUILDING_LIBDYLD
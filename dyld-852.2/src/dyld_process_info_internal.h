@@ -32,6 +32,8 @@
 #include <limits.h>
 #include <stdio.h>
 #include <uuid/uuid.h>
+#include <mach-o/loader.h>
+#include <mach-o/dyld_images.h>
 
 #include <array>
 
@@ -63,7 +65,9 @@ struct dyld_all_image_infos_32 {
     std::atomic<uint64_t>           infoArrayChangeTimestamp;
     uint32_t                        dyldPath;
     uint32_t                        notifyMachPorts[8];
-    uint32_t                        reserved[5];
+    uint32_t                        reserved[3];
+    uint32_t                        compactImageListAddr;
+    uint32_t                        compactImageListSize;
     uint32_t                        compact_dyld_image_info_addr;
     uint32_t                        compact_dyld_image_info_size;
     uint32_t                        platform;
@@ -104,7 +108,9 @@ struct dyld_all_image_infos_64 {
     std::atomic<uint64_t>   infoArrayChangeTimestamp;
     uint64_t                dyldPath;
     uint32_t                notifyMachPorts[8];
-    uint64_t                reserved[9];
+    uint64_t                reserved[7];
+    uint64_t                compactImageListAddr;
+    uint64_t                compactImageListSize;
     uint64_t                compact_dyld_image_info_addr;
     uint64_t                compact_dyld_image_info_size;
     uint32_t                platform;
@@ -156,6 +162,104 @@ struct dyld_process_info_notify_header {
     uint64_t                    timestamp;
 };
 
+//
+// Compact image list published by dyld through dyld_all_image_infos.compactImageListAddr/Size, when the process
+// was launched with DYLD_PUBLISH_COMPACT_IMAGE_INFO set.
+// It holds everything _dyld_process_info_create() needs (load addresses, uuids, paths and segment ranges,
+// including dyld itself) in one buffer, so snapshotting another process is one remote read instead of
+// one per image path and one or two per image's load commands.  The blob is only used if its timestamp
+// matches infoArrayChangeTimestamp, otherwise the reader falls back to walking the infoArray.
+//
+// The blob starts with a bounded log of recent loads and unloads, each tagged with the
+// infoArrayChangeTimestamp of the update that made it.  A client that already knows the image list as of
+// some timestamp can read just the header and the log (everything before imagesOffset) to catch up.
+//
+#define DYLD_PROCESS_INFO_COMPACT_MAGIC     0x64706963  // 'dpic'
+#define DYLD_PROCESS_INFO_COMPACT_VERSION   2
+
+struct dyld_process_info_compact_header {
+    uint32_t                    magic;
+    uint32_t                    version;
+    uint64_t                    timestamp;          // written last, zero while the blob is being filled in
+    uint64_t                    changesSince;       // log has every change with a timestamp after this
+    uint32_t                    totalSize;
+    uint32_t                    changeCount;
+    uint32_t                    changesOffset;
+    uint32_t                    changeStringsOffset;
+    uint32_t                    changeStringsSize;
+    uint32_t                    imageCount;         // includes dyld as the first image
+    uint32_t                    imagesOffset;
+    uint32_t                    segmentCount;
+    uint32_t                    segmentsOffset;
+    uint32_t                    stringsOffset;
+    uint32_t                    stringsSize;
+    uint32_t                    padding;
+};
+
+struct dyld_process_info_compact_change {
+    uint64_t                    timestamp;
+    uint64_t                    loadAddress;
+    uuid_t                      uuid;
+    uint32_t                    unload;
+    uint32_t                    pathStringOffset;   // into change strings
+};
+
+struct dyld_process_info_compact_image {
+    uuid_t                      uuid;
+    uint64_t                    loadAddress;
+    uint32_t                    pathStringOffset;
+    uint32_t                    segmentStartIndex;
+    uint32_t                    segmentsCount;
+    uint32_t                    padding;
+};
+
+struct dyld_process_info_compact_segment {
+    uint64_t                    addr;               // unslid vmaddr, as in the load command
+    uint64_t                    size;
+    char                        name[16];
+};
+
+#if BUILDING_DYLD || BUILDING_LIBDYLD
+//
+// Owns the two buffers the compact image list alternates between.  A reader that raced with one update
+// still sees the buffer it was pointed at intact; only the update after that one reuses it.
+// Also owns the change log, which is found by diffing each new image list against the last one published.
+// Nothing is built or published unless enabled, which dyld does if DYLD_PUBLISH_COMPACT_IMAGE_INFO is set.
+//
+struct VIS_HIDDEN CompactImageInfoPublisher {
+    void    setEnabled(bool enabled) { _enabled = enabled; }
+
+    // call with the infoArray already updated and infoArrayChangeTimestamp set
+    void    publish(dyld_all_image_infos* allInfo, const dyld_image_info infos[], uint32_t infoCount);
+
+private:
+    enum { kMaxChanges = 256 };
+
+    struct ChangeRecord {
+        uint64_t    timestamp;
+        uint64_t    loadAddress;
+        uuid_t      uuid;
+        bool        unload;
+        char*       path;
+    };
+
+    ChangeRecord&   changeAt(uint32_t i) const { return _changes[(_changeStart + i) % kMaxChanges]; }
+    void            forgetChanges(uint64_t timestamp);
+    void            addChange(uint64_t timestamp, bool unload, uint64_t loadAddress, const uint8_t uuid[16], const char* path);
+    void            recordChanges(uint64_t timestamp, const dyld_image_info infos[], uint32_t infoCount);
+
+    void*           _buffers[2]     = { nullptr, nullptr };
+    size_t          _bufferSizes[2] = { 0, 0 };
+    uint32_t        _current        = 0;
+    bool            _enabled        = false;
+    bool            _published      = false;
+    ChangeRecord*   _changes        = nullptr;
+    uint32_t        _changeStart    = 0;
+    uint32_t        _changeCount    = 0;
+    uint64_t        _changesSince   = 0;
+};
+#endif // BUILDING_DYLD || BUILDING_LIBDYLD
+
 //FIXME: Refactor this out into a seperate file
 struct VIS_HIDDEN RemoteBuffer {
     RemoteBuffer();
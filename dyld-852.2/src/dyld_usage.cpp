@@ -61,13 +61,18 @@ bool wideflag = false;
 bool RAW_flag = false;
 bool JSON_flag = false;
 bool JSON_Tracing_flag = false;
+bool Aggregate_flag = false;
+uint64_t summary_interval_ns = 0;
 dispatch_source_t sigwinch_source;
 static void
 exit_usage(void)
 {
-    fprintf(stderr, "Usage: dyld_usage [-e] [-f mode] [-t seconds] [-R rawfile [-S start_time] [-E end_time]] [pid | cmd [pid | cmd] ...]\n");
+    fprintf(stderr, "Usage: dyld_usage [-e] [-f mode] [-t seconds] [-a [-i seconds]] [-R rawfile [-S start_time] [-E end_time]] [pid | cmd [pid | cmd] ...]\n");
     fprintf(stderr, "  -e    exclude the specified list of pids from the sample\n");
     fprintf(stderr, "        and exclude dyld_usage by default\n");
+    fprintf(stderr, "  -a    aggregate operations into per process latency histograms and\n");
+    fprintf(stderr, "        print JSON summaries instead of individual events\n");
+    fprintf(stderr, "  -i    with -a, print a summary every interval of trace time in seconds\n");
     fprintf(stderr, "  -t    specifies timeout in seconds (for use in automated tools)\n");
     fprintf(stderr, "  -R    specifies a raw trace file to process\n");
     fprintf(stderr, "  pid   selects process(s) to sample\n");
@@ -122,6 +127,201 @@ std::string safeStringFromCString(const char *str) {
     return "";
 }
 
+//
+// HDR style histogram of latencies.  Values below 2^kSubBucketBits each get their own
+// bucket.  Above that each power of two range is split into 2^kSubBucketBits linear
+// sub-buckets, so every recorded value is kept to within 1/16th of its magnitude no
+// matter how widely values range, while the bucket array stays small.
+//
+struct LatencyHistogram {
+    void record(uint64_t nanos) {
+        uint32_t index = bucketIndex(nanos);
+        if (index >= _buckets.size())
+            _buckets.resize(index + 1, 0);
+        ++_buckets[index];
+        if ((_count == 0) || (nanos < _min))
+            _min = nanos;
+        if (nanos > _max)
+            _max = nanos;
+        _total += nanos;
+        ++_count;
+    }
+
+    // highest value equivalent to the bucket holding the given percentile
+    uint64_t percentile(double pct) const {
+        uint64_t target = (uint64_t)((pct / 100.0) * _count + 0.5);
+        if (target == 0)
+            target = 1;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < _buckets.size(); ++i) {
+            seen += _buckets[i];
+            if (seen >= target)
+                return std::min(bucketHighValue(i), _max);
+        }
+        return _max;
+    }
+
+    void outputJSON(std::ostringstream& sstr) const {
+        sstr << std::dec << "{\"count\":\"" << _count << "\",\"min_nano\":\"" << _min << "\",\"max_nano\":\"" << _max;
+        sstr << "\",\"total_nano\":\"" << _total << "\",\"mean_nano\":\"" << (_count ? _total / _count : 0);
+        sstr << "\",\"p50_nano\":\"" << percentile(50.0) << "\",\"p90_nano\":\"" << percentile(90.0);
+        sstr << "\",\"p99_nano\":\"" << percentile(99.0) << "\",\"buckets\":[";
+        bool firstBucket = true;
+        for (uint32_t i = 0; i < _buckets.size(); ++i) {
+            if (_buckets[i] == 0)
+                continue;
+            if (!firstBucket)
+                sstr << ",";
+            firstBucket = false;
+            sstr << "{\"low_nano\":\"" << bucketLowValue(i) << "\",\"high_nano\":\"" << bucketHighValue(i);
+            sstr << "\",\"count\":\"" << _buckets[i] << "\"}";
+        }
+        sstr << "]}";
+    }
+
+private:
+    enum { kSubBucketBits = 4, kSubBucketCount = (1 << kSubBucketBits) };
+
+    static uint32_t bucketIndex(uint64_t value) {
+        if (value < kSubBucketCount)
+            return (uint32_t)value;
+        uint32_t shift = (63 - __builtin_clzll(value)) - kSubBucketBits;
+        return ((shift + 1) << kSubBucketBits) + (uint32_t)((value >> shift) & (kSubBucketCount - 1));
+    }
+
+    static uint64_t bucketLowValue(uint32_t index) {
+        if (index < kSubBucketCount)
+            return index;
+        uint32_t shift = (index >> kSubBucketBits) - 1;
+        return ((uint64_t)(kSubBucketCount + (index & (kSubBucketCount - 1)))) << shift;
+    }
+
+    static uint64_t bucketHighValue(uint32_t index) {
+        if (index < kSubBucketCount)
+            return index;
+        uint32_t shift = (index >> kSubBucketBits) - 1;
+        return bucketLowValue(index) + ((1ULL << shift) - 1);
+    }
+
+    std::vector<uint64_t> _buckets;
+    uint64_t _count = 0;
+    uint64_t _min = 0;
+    uint64_t _max = 0;
+    uint64_t _total = 0;
+};
+
+//
+// Collects the intervals of every completed root event when -a is used.  Intervals are
+// grouped by command name, then by phase, and then by image where the event identifies
+// one.  Summaries are cut on trace time rather than wall time, so replaying a raw file
+// with -R produces the same summaries as watching the same activity live.
+//
+struct LatencyAggregator {
+    void forgetImages(pid_t pid) {
+        _imagePaths.erase(pid);
+    }
+
+    void noteImage(pid_t pid, uint64_t loadAddress, const std::string& path) {
+        if (loadAddress != 0)
+            _imagePaths[pid][loadAddress] = path;
+    }
+
+    std::string imageName(pid_t pid, uint64_t loadAddress) {
+        auto pi = _imagePaths.find(pid);
+        if (pi != _imagePaths.end()) {
+            auto ii = pi->second.find(loadAddress);
+            if (ii != pi->second.end())
+                return ii->second;
+        }
+        // images in the shared cache are never mapped, so are only known by address
+        std::ostringstream result;
+        result << "0x" << std::hex << loadAddress;
+        return result.str();
+    }
+
+    void record(const std::string& command, const std::string& phase, const std::string& image,
+                uint64_t startNanos, uint64_t endNanos) {
+        if (summary_interval_ns != 0) {
+            if (_windowStart == 0)
+                _windowStart = startNanos;
+            while (endNanos >= _windowStart + summary_interval_ns) {
+                emitSummary(_windowStart + summary_interval_ns);
+                _windowStart += summary_interval_ns;
+            }
+        } else if ((_windowStart == 0) || (startNanos < _windowStart)) {
+            _windowStart = startNanos;
+        }
+        if (endNanos > _windowEnd)
+            _windowEnd = endNanos;
+
+        PhaseStats& stats = _processes[command][phase];
+        uint64_t nanos = endNanos - startNanos;
+        stats.all.record(nanos);
+        if (!image.empty())
+            stats.images[image].record(nanos);
+    }
+
+    void flush() {
+        emitSummary(_windowEnd);
+    }
+
+private:
+    struct PhaseStats {
+        LatencyHistogram                        all;
+        std::map<std::string, LatencyHistogram> images;
+    };
+
+    void emitSummary(uint64_t endNanos) {
+        if (_processes.empty())
+            return;
+        std::ostringstream ostream;
+        ostream << std::dec << "{\"summary\":{\"start_nano\":\"" << _windowStart << "\",\"end_nano\":\"" << endNanos;
+        ostream << "\",\"processes\":[";
+        bool firstProcess = true;
+        for (const auto& process : _processes) {
+            if (!firstProcess)
+                ostream << ",";
+            firstProcess = false;
+            ostream << "{\"command\":\"" << process.first << "\",\"phases\":[";
+            bool firstPhase = true;
+            for (const auto& phase : process.second) {
+                if (!firstPhase)
+                    ostream << ",";
+                firstPhase = false;
+                ostream << "{\"phase\":\"" << phase.first << "\",\"latency\":";
+                phase.second.all.outputJSON(ostream);
+                if (!phase.second.images.empty()) {
+                    ostream << ",\"images\":[";
+                    bool firstImage = true;
+                    for (const auto& image : phase.second.images) {
+                        if (!firstImage)
+                            ostream << ",";
+                        firstImage = false;
+                        ostream << "{\"image\":\"" << image.first << "\",\"latency\":";
+                        image.second.outputJSON(ostream);
+                        ostream << "}";
+                    }
+                    ostream << "]";
+                }
+                ostream << "}";
+            }
+            ostream << "]}";
+        }
+        ostream << "]}}" << std::endl;
+        std::cout << ostream.str();
+        if (!RAW_flag)
+            fflush(stdout);
+        _processes.clear();
+    }
+
+    std::map<std::string, std::map<std::string, PhaseStats>> _processes;
+    std::map<pid_t, std::map<uint64_t, std::string>>         _imagePaths;
+    uint64_t                                                 _windowStart = 0;
+    uint64_t                                                 _windowEnd = 0;
+};
+
+static LatencyAggregator sLatencyAggregator;
+
 struct output_renderer {
     output_renderer(ktrace_session_t S, ktrace_event_t E) :
     _commandName(safeStringFromCString(ktrace_get_execname_for_thread(s, E->threadid))),
@@ -451,13 +651,70 @@ public:
         }
     }
 
+    void aggregate(std::shared_ptr<event_pair> node, LatencyAggregator& aggregator) {
+        std::string phase;
+        std::string image;
+        if (auto dlopenNode = dynamic_cast<dlopen *>(node.get())) {
+            phase = "dlopen";
+            image = dlopenNode->path;
+        } else if (auto dlopenPreflightNode = dynamic_cast<dlopen_preflight *>(node.get())) {
+            phase = "dlopen_preflight";
+            image = dlopenPreflightNode->path;
+        } else if (auto dlsymNode = dynamic_cast<dlsym *>(node.get())) {
+            phase = "dlsym";
+        } else if (auto mapImageNode = dynamic_cast<map_image *>(node.get())) {
+            phase = "map_image";
+            image = mapImageNode->path;
+            aggregator.noteImage(_pid, mapImageNode->result, mapImageNode->path);
+        } else if (auto sigNode = dynamic_cast<attach_signature *>(node.get())) {
+            phase = "attach_codesignature";
+        } else if (auto buildClosureNode = dynamic_cast<build_closure *>(node.get())) {
+            phase = "build_closure";
+        } else if (auto launchNode = dynamic_cast<app_launch *>(node.get())) {
+            phase = "app_launch";
+            // pids are reused on exec, so drop the images of the old program
+            aggregator.forgetImages(_pid);
+        } else if (auto initNode  = dynamic_cast<static_init *>(node.get())) {
+            phase = "static_init";
+            image = aggregator.imageName(_pid, initNode->libraryAddress);
+        } else if (auto fixupNode  = dynamic_cast<apply_fixups *>(node.get())) {
+            phase = "apply_fixups";
+        } else if (auto dlcloseNode  = dynamic_cast<dlclose *>(node.get())) {
+            phase = "dlclose";
+        } else if (auto dladdrNode  = dynamic_cast<dladdr *>(node.get())) {
+            phase = "dladdr";
+        } else if (auto addImageNode  = dynamic_cast<add_image_callback *>(node.get())) {
+            phase = "add_image";
+            image = aggregator.imageName(_pid, addImageNode->libraryAddress);
+        } else if (auto removeImageNode  = dynamic_cast<remove_image_callback *>(node.get())) {
+            phase = "remove_image";
+            image = aggregator.imageName(_pid, removeImageNode->libraryAddress);
+        } else if (auto objcInitNode  = dynamic_cast<objc_image_init *>(node.get())) {
+            phase = "objc_init";
+            image = aggregator.imageName(_pid, objcInitNode->libraryAddress);
+        } else if (auto objcMapNode  = dynamic_cast<objc_images_map *>(node.get())) {
+            phase = "objc_map";
+        } else {
+            phase = "unknown";
+        }
+        aggregator.record(_commandName, phase, image, mach_to_nano(node->startTimestamp()), mach_to_nano(node->endTimestamp()));
+
+        // children are visited in order, so images are mapped before their initializers run
+        for (const auto& child : node->children()) {
+            aggregate(child, aggregator);
+        }
+    }
+
     const std::vector<std::shared_ptr<event_pair>>& rootEvents() const { return _rootEvents; }
 
 private:
 
     void output(std::shared_ptr<event_pair> root) {
         std::ostringstream ostream;
-        if (JSON_flag) {
+        if (Aggregate_flag) {
+            aggregate(root, sLatencyAggregator);
+            return;
+        } else if (JSON_flag) {
             ostream << "{\"command\":\"" << _commandName << "\",\"pid\":\"" << _pid << "\",\"thread\":\"";
             ostream << _threadid << "\", \"event\":";
             outputJSON(root, ostream);
@@ -631,7 +888,9 @@ struct OutputManager {
     std::map<unsigned long, std::unique_ptr<output_renderer>> sOutputRenders;
 
     void flush() {
-        if (JSON_Tracing_flag) {
+        if (Aggregate_flag) {
+            sLatencyAggregator.flush();
+        } else if (JSON_Tracing_flag) {
             std::ostringstream ostream;
             ostream << "{\"displayTimeUnit\":\"ns\"";
             ostream << ", \"traceEvents\": [";
@@ -729,8 +988,19 @@ main(int argc, char *argv[])
     s = ktrace_session_create();
     assert(s);
 
-    while ((ch = getopt(argc, argv, "hjJeR:t:")) != -1) {
+    while ((ch = getopt(argc, argv, "hjJaei:R:t:")) != -1) {
         switch (ch) {
+            case 'a':
+                Aggregate_flag = true;
+                break;
+            case 'i':
+                summary_interval_ns = (uint64_t)(NSEC_PER_SEC * atof(optarg));
+                if (summary_interval_ns == 0) {
+                    fprintf(stderr, "ERROR: could not set summary interval to %s\n",
+                            optarg);
+                    exit(1);
+                }
+                break;
             case 'j':
                 JSON_flag = true;
                 break;
@@ -765,6 +1035,10 @@ main(int argc, char *argv[])
     argc -= optind;
     argv += optind;
 
+    if (summary_interval_ns > 0 && !Aggregate_flag) {
+        fprintf(stderr, "NOTE: summary interval ignored without -a\n");
+    }
+
     if (time_limit_ns > 0) {
         if (RAW_flag) {
             fprintf(stderr, "NOTE: time limit ignored when a raw file is specified\n");
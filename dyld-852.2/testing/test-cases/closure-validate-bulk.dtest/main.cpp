@@ -0,0 +1,110 @@
+
+// BUILD:  $CXX main.cpp -I$SRCROOT/dyld3 -o $BUILD_DIR/closure-validate-bulk.exe
+
+// RUN:  ./closure-validate-bulk.exe
+
+// Checks that looking up closure files a directory at a time gives the same answers as stat()ing each
+// one, for a plugin heavy layout with present, missing, symlinked and differently cased files, then
+// compares the syscalls made and time taken by each.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <mach/mach_time.h>
+
+#include <string>
+#include <vector>
+
+#include "test_support.h"
+#include "BulkFileInfo.h"
+
+static const int kDirCount          = 4;
+static const int kPluginsPerDir     = 100;
+static const int kIterations        = 50;
+
+static void createFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_CREAT | O_WRONLY, 0644);
+    if ( fd == -1 )
+        FAIL("could not create %s", path.c_str());
+    close(fd);
+}
+
+static uint64_t timeLookups(std::vector<dyld3::BulkFileInfo>& infos, bool allowListings, dyld3::BulkFileInfoStats& stats)
+{
+    uint64_t t1 = mach_absolute_time();
+    for (int i=0; i < kIterations; ++i) {
+        stats = dyld3::BulkFileInfoStats();
+        dyld3::getBulkFileInfo(infos.data(), (uint32_t)infos.size(), allowListings, &::stat, stats);
+    }
+    return mach_absolute_time() - t1;
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    char tempDir[] = "/tmp/closure-validate-bulk.XXXXXX";
+    if ( mkdtemp(tempDir) == nullptr )
+        FAIL("mkdtemp failed");
+
+    // each plugin directory has the plugins, plus the must-be-missing paths a closure records for @rpath searches
+    std::vector<std::string> paths;
+    for (int d=0; d < kDirCount; ++d) {
+        std::string dir = std::string(tempDir) + "/PlugIns" + std::to_string(d);
+        mkdir(dir.c_str(), 0755);
+        for (int p=0; p < kPluginsPerDir; ++p) {
+            std::string plugin = dir + "/libplugin" + std::to_string(p) + ".dylib";
+            createFile(plugin);
+            paths.push_back(plugin);
+            paths.push_back(dir + "/libmissing" + std::to_string(p) + ".dylib");
+        }
+        createFile(dir + "/libTarget.dylib");
+        symlink("libTarget.dylib", (dir + "/liblink.dylib").c_str());
+        symlink("libnowhere.dylib", (dir + "/libdangling.dylib").c_str());
+        paths.push_back(dir + "/liblink.dylib");
+        paths.push_back(dir + "/libdangling.dylib");
+        paths.push_back(dir + "/libtarget.dylib");
+        paths.push_back(dir + "/libTarget.dylib");
+        paths.push_back(dir + "/libnon\xc3\xa9ascii.dylib");
+    }
+    // a missing directory, and a lone file which is not worth listing its directory for
+    for (int p=0; p < 10; ++p)
+        paths.push_back(std::string(tempDir) + "/NotThere/lib" + std::to_string(p) + ".dylib");
+    createFile(std::string(tempDir) + "/lone.dylib");
+    paths.push_back(std::string(tempDir) + "/lone.dylib");
+
+    std::vector<dyld3::BulkFileInfo> perFile;
+    std::vector<dyld3::BulkFileInfo> bulk;
+    for (const std::string& path : paths) {
+        perFile.push_back({ path.c_str() });
+        bulk.push_back({ path.c_str() });
+    }
+
+    dyld3::BulkFileInfoStats perFileStats;
+    dyld3::BulkFileInfoStats bulkStats;
+    dyld3::getBulkFileInfo(perFile.data(), (uint32_t)perFile.size(), false, &::stat, perFileStats);
+    dyld3::getBulkFileInfo(bulk.data(), (uint32_t)bulk.size(), true, &::stat, bulkStats);
+    for (size_t i=0; i < paths.size(); ++i) {
+        if ( perFile[i].exists != bulk[i].exists )
+            FAIL("%s exists mismatch: stat() %d, bulk %d", paths[i].c_str(), perFile[i].exists, bulk[i].exists);
+        if ( perFile[i].exists && ((perFile[i].inode != bulk[i].inode) || (perFile[i].mtime != bulk[i].mtime)) )
+            FAIL("%s inode/mtime mismatch", paths[i].c_str());
+    }
+    if ( bulkStats.directoriesRead == 0 )
+        FAIL("no directories were listed");
+    LOG("checked %lu paths", paths.size());
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint64_t perFileNanos = timeLookups(perFile, false, perFileStats) * timebase.numer / timebase.denom;
+    uint64_t bulkNanos    = timeLookups(bulk, true, bulkStats)        * timebase.numer / timebase.denom;
+
+    std::string rmCommand = std::string("/bin/rm -rf ") + tempDir;
+    system(rmCommand.c_str());
+
+    PASS("%lu paths: stat() each %u calls %lluus, by directory %u calls (%u stat, %u open, %u getattrlistbulk) %lluus",
+         paths.size(), perFileStats.stats, perFileNanos/kIterations/1000,
+         bulkStats.stats + bulkStats.directoriesRead + bulkStats.bulkReads, bulkStats.stats, bulkStats.directoriesRead,
+         bulkStats.bulkReads, bulkNanos/kIterations/1000);
+}
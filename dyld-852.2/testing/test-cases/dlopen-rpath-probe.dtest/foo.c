@@ -0,0 +1,2 @@
+
+int foo() { return 42; }
@@ -0,0 +1,47 @@
+
+// BUILD:  $CC foo.c -dynamiclib -install_name @rpath/libprobe.dylib -o $BUILD_DIR/dir5/libprobe.dylib
+// BUILD:  $CC foo.c -dynamiclib -install_name @rpath/libempty.dylib -o $BUILD_DIR/dir2/libempty.dylib
+// BUILD:  $CC main.c -o $BUILD_DIR/dlopen-rpath-probe.exe -DRUN_DIR="$RUN_DIR" -rpath @loader_path/dir1 -rpath @loader_path/dir2 -rpath @loader_path/dir3 -rpath @loader_path/dir4 -rpath @loader_path/dir5
+
+// RUN:  ./dlopen-rpath-probe.exe
+// RUN:  DYLD_USE_CLOSURES=1 ./dlopen-rpath-probe.exe
+
+#include <stdio.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#include "test_support.h"
+
+/// test that rpath searches through missing and unrelated directories find the right dylib,
+/// and that names which only exist with different case are found iff the volume allows it
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    void* handle = dlopen("@rpath/libprobe.dylib", RTLD_LAZY);
+    if ( handle == NULL ) {
+        FAIL("dlopen(\"@rpath/libprobe.dylib\") failed: %s", dlerror());
+    }
+    int (*fooPtr)() = (int (*)())dlsym(handle, "foo");
+    if ( (fooPtr == NULL) || (fooPtr() != 42) ) {
+        FAIL("foo not found in libprobe.dylib");
+    }
+
+    // same directories again, now that they have been looked at
+    if ( dlopen("@rpath/libmissing.dylib", RTLD_LAZY) != NULL ) {
+        FAIL("dlopen(\"@rpath/libmissing.dylib\") should have failed");
+    }
+    void* emptyHandle = dlopen("@rpath/libempty.dylib", RTLD_LAZY);
+    if ( emptyHandle == NULL ) {
+        FAIL("dlopen(\"@rpath/libempty.dylib\") failed: %s", dlerror());
+    }
+
+    bool caseInsensitive = (access(RUN_DIR "/dir5/LIBPROBE.dylib", F_OK) == 0);
+    void* upperHandle = dlopen("@rpath/LIBPROBE.dylib", RTLD_LAZY);
+    if ( caseInsensitive && (upperHandle == NULL) ) {
+        FAIL("dlopen(\"@rpath/LIBPROBE.dylib\") failed on case insensitive volume: %s", dlerror());
+    }
+    if ( !caseInsensitive && (upperHandle != NULL) ) {
+        FAIL("dlopen(\"@rpath/LIBPROBE.dylib\") succeeded on case sensitive volume");
+    }
+
+    PASS("Success");
+}
@@ -0,0 +1,4 @@
+int churnValue()
+{
+    return 42;
+}
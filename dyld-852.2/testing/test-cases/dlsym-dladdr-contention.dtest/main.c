@@ -0,0 +1,97 @@
+
+// BUILD:  $CC churn.c -dynamiclib -install_name $RUN_DIR/libchurn.dylib -o $BUILD_DIR/libchurn.dylib
+// BUILD:  $CC main.c -o $BUILD_DIR/dlsym-dladdr-contention.exe -DRUN_DIR="$RUN_DIR"
+
+// RUN:  DYLD_USE_CLOSURES=0 ./dlsym-dladdr-contention.exe
+// RUN:  ./dlsym-dladdr-contention.exe
+
+// Calls dlsym() and dladdr() from many threads at once while another thread keeps dlopen()ing and
+// dlclose()ing a dylib, checking every answer.  Then compares the time per lookup on one thread
+// against the time per lookup with all the threads contending.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <mach/mach_time.h>
+
+#include "test_support.h"
+
+#define kThreadCount    8
+#define kIterations     20000
+
+int contentionTarget()
+{
+    return 1;
+}
+
+static atomic_bool sStopChurn;
+
+static void* churn(void* arg)
+{
+    while ( !atomic_load(&sStopChurn) ) {
+        void* handle = dlopen(RUN_DIR "/libchurn.dylib", RTLD_LAZY);
+        if ( handle == NULL )
+            FAIL("dlopen(libchurn.dylib) failed: %s", dlerror());
+        if ( dlsym(handle, "churnValue") == NULL )
+            FAIL("dlsym(churnValue) failed");
+        dlclose(handle);
+    }
+    return NULL;
+}
+
+static void* lookups(void* arg)
+{
+    void* mainHandle = dlopen(NULL, RTLD_LAZY);
+    for (int i=0; i < kIterations; ++i) {
+        void* sym = dlsym(RTLD_DEFAULT, "contentionTarget");
+        if ( sym != (void*)&contentionTarget )
+            FAIL("dlsym(RTLD_DEFAULT, contentionTarget) returned %p instead of %p", sym, &contentionTarget);
+        if ( dlsym(mainHandle, "contentionTarget") != sym )
+            FAIL("dlsym(main handle, contentionTarget) returned a different address");
+        if ( dlsym(RTLD_DEFAULT, "contentionNotThere") != NULL )
+            FAIL("dlsym(RTLD_DEFAULT, contentionNotThere) found something");
+        Dl_info info;
+        if ( dladdr(sym, &info) == 0 )
+            FAIL("dladdr(%p) failed", sym);
+        if ( (info.dli_sname == NULL) || (strcmp(info.dli_sname, "contentionTarget") != 0) )
+            FAIL("dladdr(%p) returned symbol %s", sym, info.dli_sname);
+    }
+    return NULL;
+}
+
+static uint64_t nanosPerLookup(uint64_t machTime, int threadCount)
+{
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    // each iteration does three dlsym() calls and one dladdr()
+    return machTime * timebase.numer / timebase.denom / ((uint64_t)kIterations * threadCount * 4);
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    // uncontended
+    uint64_t t1 = mach_absolute_time();
+    lookups(NULL);
+    uint64_t t2 = mach_absolute_time();
+
+    // contended, with images coming and going
+    pthread_t churnThread;
+    if ( pthread_create(&churnThread, NULL, &churn, NULL) != 0 )
+        FAIL("pthread_create() failed");
+    pthread_t threads[kThreadCount];
+    uint64_t t3 = mach_absolute_time();
+    for (int i=0; i < kThreadCount; ++i) {
+        if ( pthread_create(&threads[i], NULL, &lookups, NULL) != 0 )
+            FAIL("pthread_create() failed");
+    }
+    for (int i=0; i < kThreadCount; ++i)
+        pthread_join(threads[i], NULL);
+    uint64_t t4 = mach_absolute_time();
+    atomic_store(&sStopChurn, true);
+    pthread_join(churnThread, NULL);
+
+    PASS("%llu ns per lookup on one thread, %llu ns per lookup with %d threads (wall time / total lookups)",
+         nanosPerLookup(t2 - t1, 1), nanosPerLookup(t4 - t3, kThreadCount), kThreadCount);
+}
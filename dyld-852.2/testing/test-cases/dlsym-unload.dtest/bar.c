@@ -0,0 +1,3 @@
+int whichLib() { return 2; }
+
+int barOnly() { return 3; }
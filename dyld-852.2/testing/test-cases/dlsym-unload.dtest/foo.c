@@ -0,0 +1 @@
+int whichLib() { return 1; }
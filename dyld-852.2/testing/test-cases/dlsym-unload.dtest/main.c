@@ -0,0 +1,60 @@
+
+// BUILD:  $CC foo.c  -dynamiclib -install_name $RUN_DIR/libfoo.dylib  -o $BUILD_DIR/libfoo.dylib
+// BUILD:  $CC bar.c  -dynamiclib -install_name $RUN_DIR/libbar.dylib  -o $BUILD_DIR/libbar.dylib
+// BUILD:  $CC main.c -o $BUILD_DIR/dlsym-unload.exe -DRUN_DIR="$RUN_DIR"
+
+// RUN:  ./dlsym-unload.exe
+// RUN:  DYLD_DISABLE_DLSYM_CACHE=1 ./dlsym-unload.exe
+
+#include <stdio.h>
+#include <dlfcn.h>
+
+#include "test_support.h"
+
+// verify dlsym() results, including cached ones, do not outlive dlclose()
+
+typedef int (*IntFunc)(void);
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    void* fooHandle = dlopen(RUN_DIR "/libfoo.dylib", RTLD_LAZY);
+    if ( fooHandle == NULL ) {
+        FAIL("libfoo.dylib could not be loaded, %s", dlerror());
+    }
+
+    // look up twice so the second lookup can come from the cache
+    for (int i=0; i < 2; ++i) {
+        IntFunc func = (IntFunc)dlsym(RTLD_DEFAULT, "whichLib");
+        if ( func == NULL ) {
+            FAIL("whichLib not found with libfoo.dylib loaded");
+        }
+        if ( func() != 1 ) {
+            FAIL("whichLib did not come from libfoo.dylib");
+        }
+        if ( dlsym(RTLD_DEFAULT, "barOnly") != NULL ) {
+            FAIL("barOnly found before libbar.dylib was loaded");
+        }
+    }
+
+    if ( dlclose(fooHandle) != 0 ) {
+        FAIL("dlclose(libfoo.dylib) failed, %s", dlerror());
+    }
+
+    void* barHandle = dlopen(RUN_DIR "/libbar.dylib", RTLD_LAZY);
+    if ( barHandle == NULL ) {
+        FAIL("libbar.dylib could not be loaded, %s", dlerror());
+    }
+
+    IntFunc func = (IntFunc)dlsym(RTLD_DEFAULT, "whichLib");
+    if ( func == NULL ) {
+        FAIL("whichLib not found with libbar.dylib loaded");
+    }
+    if ( func() != 2 ) {
+        FAIL("whichLib did not come from libbar.dylib");
+    }
+    if ( dlsym(barHandle, "barOnly") == NULL ) {
+        FAIL("barOnly not found with barHandle");
+    }
+
+    PASS("Success");
+}
+
@@ -4,6 +4,7 @@
 // BUILD:  $TASK_FOR_PID_ENABLE  $BUILD_DIR/dyld_process_info.exe
 
 // RUN:  $SUDO ./dyld_process_info.exe
+// RUN:  $SUDO env DYLD_PUBLISH_COMPACT_IMAGE_INFO=1 ./dyld_process_info.exe
 
 #include <Block.h>
 #include <stdio.h>
@@ -20,6 +21,7 @@
 #include <mach/mach.h>
 #include <mach/machine.h>
 #include <mach-o/dyld_priv.h>
+#include <mach-o/dyld_images.h>
 #include <mach-o/dyld_process_info.h>
 #include <Availability.h>
 
@@ -86,6 +88,54 @@ static void inspectProcess(task_t task, bool launchedSuspended, bool expectCF, b
 }
 
 
+// When run with DYLD_PUBLISH_COMPACT_IMAGE_INFO this process publishes a compact image list, check snapshots built from it match the live image list
+static void checkCompactImageInfo()
+{
+    bool publishing = (getenv("DYLD_PUBLISH_COMPACT_IMAGE_INFO") != NULL);
+    task_dyld_info_data_t taskDyldInfo;
+    mach_msg_type_number_t count = TASK_DYLD_INFO_COUNT;
+    if ( task_info(mach_task_self(), TASK_DYLD_INFO, (task_info_t)&taskDyldInfo, &count) != KERN_SUCCESS ) {
+        FAIL("task_info(TASK_DYLD_INFO) failed");
+    }
+    const struct dyld_all_image_infos* allInfo = (const struct dyld_all_image_infos*)taskDyldInfo.all_image_info_addr;
+    if ( !publishing ) {
+        if ( allInfo->compactImageListAddr != 0 ) {
+            FAIL("compact image list should only be published when DYLD_PUBLISH_COMPACT_IMAGE_INFO is set");
+        }
+        return;
+    }
+    if ( allInfo->compactImageListAddr == 0 ) {
+        FAIL("compact image list should be published");
+    }
+
+    kern_return_t result;
+    dyld_process_info info = _dyld_process_info_create(mach_task_self(), 0, &result);
+    if ( info == NULL ) {
+        FAIL("_dyld_process_info_create(mach_task_self()) failed");
+    }
+    __block uint32_t imageCount = 0;
+    _dyld_process_info_for_each_image(info, ^(uint64_t machHeaderAddress, const uuid_t uuid, const char* path) {
+        ++imageCount;
+        __block bool foundText = false;
+        _dyld_process_info_for_each_segment(info, machHeaderAddress, ^(uint64_t segmentAddress, uint64_t segmentSize, const char* segmentName) {
+            if ( strcmp(segmentName, "__TEXT") == 0 ) {
+                foundText = true;
+                if ( segmentAddress != machHeaderAddress ) {
+                    FAIL("__TEXT of %s should start at its mach_header", path);
+                }
+            }
+        });
+        if ( !foundText ) {
+            FAIL("%s should have a __TEXT segment", path);
+        }
+    });
+    // snapshot includes dyld, the live image list does not
+    if ( imageCount != _dyld_image_count() + 1 ) {
+        FAIL("snapshot has %u images, expected %u", imageCount, _dyld_image_count() + 1);
+    }
+    _dyld_process_info_release(info);
+}
+
 
 #if __x86_64__
 cpu_type_t otherArch[] = { CPU_TYPE_I386 };
@@ -160,6 +210,7 @@ int main(int argc, const char* argv[], const char* envp[], const char* apple[])
 #endif
     dispatch_async( dispatch_get_main_queue(), ^{
         inspectProcess(mach_task_self(), false, false, false);
+        checkCompactImageInfo();
         PASS("Success");
     });
     dispatch_main();
@@ -0,0 +1,75 @@
+
+// BUILD:  $CC foo.c          -o $BUILD_DIR/libfoo.dylib -dynamiclib -install_name $RUN_DIR/libfoo.dylib
+// BUILD:  $CC main.c         -o $BUILD_DIR/dyld_process_info_changes.exe -DRUN_DIR="$RUN_DIR"
+
+// RUN:  DYLD_PUBLISH_COMPACT_IMAGE_INFO=1 ./dyld_process_info_changes.exe
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <mach/mach.h>
+#include <mach-o/dyld_priv.h>
+#include <mach-o/dyld_process_info.h>
+
+#include "test_support.h"
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    kern_return_t result;
+    dyld_process_info info = _dyld_process_info_create(mach_task_self(), 0, &result);
+    if ( info == NULL ) {
+        FAIL("_dyld_process_info_create() failed");
+    }
+    dyld_process_state_info stateInfo;
+    _dyld_process_info_get_state(info, &stateInfo);
+    _dyld_process_info_release(info);
+    uint64_t timestamp = stateInfo.timestamp;
+
+    // nothing has changed yet
+    __block int changeCount = 0;
+    uint64_t newTimestamp = _dyld_process_info_for_each_change_since(mach_task_self(), timestamp, ^(bool unload, uint64_t ts, uint64_t machHeader, const uuid_t uuid, const char* path) {
+        ++changeCount;
+    }, &result);
+    if ( (newTimestamp != timestamp) || (changeCount != 0) ) {
+        FAIL("no changes expected, got %d, timestamp 0x%llX -> 0x%llX", changeCount, timestamp, newTimestamp);
+    }
+
+    void* handle = dlopen(RUN_DIR "/libfoo.dylib", RTLD_LAZY);
+    if ( handle == NULL ) {
+        FAIL("dlopen(libfoo.dylib) failed: %s", dlerror());
+    }
+    Dl_info fooInfo;
+    if ( dladdr(dlsym(handle, "foo"), &fooInfo) == 0 ) {
+        FAIL("dladdr(foo) failed");
+    }
+    __block uint64_t loadedAt = 0;
+    newTimestamp = _dyld_process_info_for_each_change_since(mach_task_self(), timestamp, ^(bool unload, uint64_t ts, uint64_t machHeader, const uuid_t uuid, const char* path) {
+        LOG("%s 0x%llX %s", unload ? "unload" : "load", machHeader, path);
+        if ( !unload && (strstr(path, "/libfoo.dylib") != NULL) )
+            loadedAt = machHeader;
+    }, &result);
+    if ( newTimestamp == 0 ) {
+        FAIL("changes since launch should all be recorded");
+    }
+    if ( loadedAt != (uint64_t)fooInfo.dli_fbase ) {
+        FAIL("load of libfoo.dylib at %p not reported", fooInfo.dli_fbase);
+    }
+
+    dlclose(handle);
+    __block uint64_t unloadedAt = 0;
+    __block bool     sawOldChange = false;
+    uint64_t lastTimestamp = _dyld_process_info_for_each_change_since(mach_task_self(), newTimestamp, ^(bool unload, uint64_t ts, uint64_t machHeader, const uuid_t uuid, const char* path) {
+        if ( ts <= newTimestamp )
+            sawOldChange = true;
+        if ( unload )
+            unloadedAt = machHeader;
+    }, &result);
+    if ( sawOldChange ) {
+        FAIL("changes before the passed timestamp should not be reported");
+    }
+    if ( (lastTimestamp == 0) || (unloadedAt != loadedAt) ) {
+        FAIL("unload of libfoo.dylib not reported");
+    }
+
+    PASS("Success");
+}
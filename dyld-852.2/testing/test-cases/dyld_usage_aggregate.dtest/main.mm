@@ -0,0 +1,292 @@
+
+// BUILD(macos):  $CXX main.mm     -o $BUILD_DIR/dyld_usage_aggregate.exe -I$SRCROOT/dyld3 -std=c++14 -framework Foundation
+
+// BUILD(ios,tvos,watchos,bridgeos):
+
+// RUN:  ./dyld_usage_aggregate.exe
+
+// Writes a small raw trace of one thread doing a dlopen and some dlsyms, then replays it through dyld_usage -a,
+// with and without -i, and checks the histograms and windows it summarizes them into.  Replaying a file does not
+// need root, and unlike tracing live the latencies are known exactly.
+
+#import <Foundation/Foundation.h>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <mach/mach_time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Tracing.h"
+#include "test_support.h"
+
+// layout of a RAW_VERSION1 trace file from a 64-bit kernel: a header, the thread map, padding to 4KB, then events
+struct RawHeader {
+    int32_t     version_no;
+    int32_t     thread_count;
+    uint64_t    TOD_secs;
+    uint32_t    TOD_usecs;
+};
+
+struct RawThreadMap {
+    uint64_t    thread;
+    int32_t     valid;
+    char        command[20];
+};
+
+struct RawEvent {
+    uint64_t    timestamp;
+    uint64_t    arg1;
+    uint64_t    arg2;
+    uint64_t    arg3;
+    uint64_t    arg4;
+    uint64_t    arg5;
+    uint32_t    debugid;
+    uint32_t    cpuid;
+    uint64_t    unused;
+};
+
+static_assert(sizeof(RawHeader) == 24, "RAW_header layout");
+static_assert(sizeof(RawThreadMap) == 32, "kd_threadmap layout");
+static_assert(sizeof(RawEvent) == 64, "kd_buf layout");
+
+static const uint32_t kRawVersion1  = 0x55aa0101;
+static const uint64_t kThread       = 0x1234;
+static const char     kCommand[]    = "aggregate_target";
+static const char     kImagePath[]  = "/usr/local/lib/libaggregate.dylib";
+
+// all times are whole microseconds, so they convert to and from mach ticks exactly with both timebases
+static const uint64_t kTraceStartNanos  = 1000000000ULL;
+static const uint64_t kDlopenNanos      = 300000;
+struct Dlsym { uint64_t startNanos; uint64_t nanos; };
+static const Dlsym    kDlsyms[]         = { {   1000000,  10000 }, {    2000000,  20000 }, {    3000000,  40000 },
+                                            {1500000000,  80000 }, { 2500000000, 160000 } };
+
+struct TraceWriter {
+    TraceWriter() {
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        _numer = timebase.numer;
+        _denom = timebase.denom;
+    }
+
+    void event(uint64_t nanos, uint32_t debugid, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4) {
+        RawEvent e;
+        bzero(&e, sizeof(e));
+        e.timestamp = (nanos * _denom) / _numer;
+        e.arg1      = arg1;
+        e.arg2      = arg2;
+        e.arg3      = arg3;
+        e.arg4      = arg4;
+        e.arg5      = kThread;
+        e.debugid   = debugid;
+        _events.push_back(e);
+    }
+
+    // strings are traced as a start event holding the id and the first 16 chars, then 32 chars per event
+    void string(uint64_t nanos, uint64_t stringID, const char* str) {
+        const uint32_t code = TRACEDBG_CODE(DBG_TRACE_STRING, TRACE_STRING_GLOBAL);
+        size_t len = strlen(str);
+        char chars[32];
+        bzero(chars, sizeof(chars));
+        memcpy(chars, str, std::min(len, (size_t)16));
+        event(nanos, code | DBG_FUNC_START | ((len <= 16) ? DBG_FUNC_END : 0), 0, stringID, word(chars, 0), word(chars, 1));
+        for (size_t offset = 16; offset < len; offset += 32) {
+            bzero(chars, sizeof(chars));
+            memcpy(chars, &str[offset], std::min(len - offset, (size_t)32));
+            event(nanos, code | ((offset + 32 >= len) ? DBG_FUNC_END : 0), word(chars, 0), word(chars, 1), word(chars, 2), word(chars, 3));
+        }
+    }
+
+    void write(const char* path) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if ( fd == -1 )
+            FAIL("could not create %s", path);
+        RawHeader header;
+        bzero(&header, sizeof(header));
+        header.version_no   = kRawVersion1;
+        header.thread_count = 1;
+        RawThreadMap thread;
+        bzero(&thread, sizeof(thread));
+        thread.thread       = kThread;
+        thread.valid        = 4242;
+        strlcpy(thread.command, kCommand, sizeof(thread.command));
+        char padding[4096 - sizeof(header) - sizeof(thread)];
+        bzero(padding, sizeof(padding));
+        if (    (::write(fd, &header, sizeof(header)) != sizeof(header))
+             || (::write(fd, &thread, sizeof(thread)) != sizeof(thread))
+             || (::write(fd, padding, sizeof(padding)) != sizeof(padding))
+             || (::write(fd, _events.data(), _events.size() * sizeof(RawEvent)) != (ssize_t)(_events.size() * sizeof(RawEvent))) )
+            FAIL("could not write %s", path);
+        close(fd);
+    }
+
+private:
+    static uint64_t word(const char chars[32], int index) {
+        uint64_t result;
+        memcpy(&result, &chars[index * 8], sizeof(result));
+        return result;
+    }
+
+    uint32_t                _numer;
+    uint32_t                _denom;
+    std::vector<RawEvent>   _events;
+};
+
+static void writeTrace(const char* path)
+{
+    TraceWriter trace;
+    trace.string(kTraceStartNanos, 1, kImagePath);
+    trace.event(kTraceStartNanos, DBG_DYLD_TIMING_DLOPEN | DBG_FUNC_START, 0, 1, RTLD_NOW, 0);
+    trace.event(kTraceStartNanos + kDlopenNanos, DBG_DYLD_TIMING_DLOPEN | DBG_FUNC_END, 0, 0x1000, 0, 0);
+    for (const Dlsym& dlsym : kDlsyms) {
+        trace.event(kTraceStartNanos + dlsym.startNanos, DBG_DYLD_TIMING_DLSYM | DBG_FUNC_START, 0, 0x1000, 0, 0);
+        trace.event(kTraceStartNanos + dlsym.startNanos + dlsym.nanos, DBG_DYLD_TIMING_DLSYM | DBG_FUNC_END, 0, 0x2000, 0, 0);
+    }
+    trace.write(path);
+}
+
+static NSDictionary* findEntry(NSArray* array, NSString* key, NSString* value)
+{
+    for (NSDictionary* entry in array) {
+        if ( [entry[key] isEqualToString:value] )
+            return entry;
+    }
+    return nil;
+}
+
+static uint64_t value(NSDictionary* dict, NSString* key)
+{
+    return strtoull([dict[key] UTF8String], NULL, 10);
+}
+
+static NSDictionary* findPhase(NSDictionary* summary, NSString* phaseName)
+{
+    NSDictionary* process = findEntry(summary[@"processes"], @"command", @(kCommand));
+    if ( process == nil )
+        FAIL("dyld_usage summary has no entry for %s", kCommand);
+    return findEntry(process[@"phases"], @"phase", phaseName);
+}
+
+static void checkLatency(NSDictionary* phase, const char* phaseName, uint64_t count, uint64_t minNanos, uint64_t maxNanos)
+{
+    if ( phase == nil )
+        FAIL("dyld_usage summary has no %s phase", phaseName);
+    NSDictionary* latency = phase[@"latency"];
+    if ( value(latency, @"count") != count )
+        FAIL("dyld_usage summary has %llu %s, expected %llu", value(latency, @"count"), phaseName, count);
+    if ( (value(latency, @"min_nano") != minNanos) || (value(latency, @"max_nano") != maxNanos) )
+        FAIL("dyld_usage summary %s range [%llu, %llu], expected [%llu, %llu]", phaseName,
+             value(latency, @"min_nano"), value(latency, @"max_nano"), minNanos, maxNanos);
+    uint64_t p50Nanos = value(latency, @"p50_nano");
+    if ( (p50Nanos < minNanos) || (p50Nanos > maxNanos) )
+        FAIL("dyld_usage summary %s p50 %llu outside of [%llu, %llu]", phaseName, p50Nanos, minNanos, maxNanos);
+    uint64_t bucketCount = 0;
+    for (NSDictionary* bucket in latency[@"buckets"]) {
+        if ( (value(bucket, @"high_nano") < minNanos) || (value(bucket, @"low_nano") > maxNanos) )
+            FAIL("dyld_usage summary %s has a bucket outside of [%llu, %llu]", phaseName, minNanos, maxNanos);
+        bucketCount += value(bucket, @"count");
+    }
+    if ( bucketCount != count )
+        FAIL("dyld_usage summary %s buckets hold %llu, expected %llu", phaseName, bucketCount, count);
+}
+
+static void checkDlopen(NSDictionary* summary)
+{
+    NSDictionary* dlopenPhase = findPhase(summary, @"dlopen");
+    checkLatency(dlopenPhase, "dlopen", 1, kDlopenNanos, kDlopenNanos);
+    NSDictionary* image = findEntry(dlopenPhase[@"images"], @"image", @(kImagePath));
+    if ( image == nil )
+        FAIL("dyld_usage summary did not attribute dlopen to %s", kImagePath);
+    if ( value(image[@"latency"], @"count") != 1 )
+        FAIL("dyld_usage summary has wrong dlopen count for %s", kImagePath);
+}
+
+// runs dyld_usage over the trace and hands the summaries it printed, one per line, to the handler.  The
+// _process is leaked because its read sources use it until dyld_usage exits
+static void runDyldUsage(const char* args[], void (^handler)(NSArray* summaries))
+{
+    _process* dyldUsage = new _process;
+    dyldUsage->set_executable_path("/usr/local/bin/dyld_usage");
+    dyldUsage->set_args(args);
+    std::string* output   = new std::string;
+    __block int  stdoutFd = -1;
+    void (^drain)(int) = ^(int fd) {
+        char    buffer[16384];
+        ssize_t size;
+        while ( (size = read(fd, buffer, sizeof(buffer))) > 0 )
+            output->append(buffer, size);
+    };
+    dyldUsage->set_stdout_handler(^(int fd) {
+        stdoutFd = fd;
+        drain(fd);
+    });
+    dyldUsage->set_exit_handler(^(pid_t pid) {
+        int status;
+        (void)wait4(pid, &status, 0, NULL);
+        if ( stdoutFd != -1 )
+            drain(stdoutFd);
+        if ( !WIFEXITED(status) || (WEXITSTATUS(status) != 0) )
+            FAIL("dyld_usage failed");
+        NSMutableArray* summaries = [NSMutableArray array];
+        NSString* lines = [NSString stringWithUTF8String:output->c_str()];
+        for (NSString* line in [lines componentsSeparatedByString:@"\n"]) {
+            if ( [line length] == 0 )
+                continue;
+            NSError* error = nil;
+            NSDictionary* root = [NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:&error];
+            if ( ![root isKindOfClass:[NSDictionary class]] || (root[@"summary"] == nil) )
+                FAIL("Could not deserialize dyld_usage summary: %s", [line UTF8String]);
+            [summaries addObject:root[@"summary"]];
+        }
+        handler(summaries);
+    });
+    dyldUsage->launch();
+}
+
+int main(int argc, const char* argv[], char *env[])
+{
+    static char tempDir[] = "/tmp/dyld_usage_aggregate.XXXXXX";
+    if ( mkdtemp(tempDir) == nullptr )
+        FAIL("mkdtemp failed");
+    static char tracePath[PATH_MAX];
+    snprintf(tracePath, sizeof(tracePath), "%s/trace.raw", tempDir);
+    writeTrace(tracePath);
+
+    // without -i there is exactly one summary, covering the whole trace
+    static const char* args[] = { "-a", "-R", tracePath, kCommand, NULL };
+    runDyldUsage(args, ^(NSArray* summaries) {
+        if ( [summaries count] != 1 )
+            FAIL("dyld_usage printed %lu summaries, expected 1", (unsigned long)[summaries count]);
+        checkDlopen(summaries[0]);
+        checkLatency(findPhase(summaries[0], @"dlsym"), "dlsym", 5, 10000, 160000);
+
+        // with -i 1 the dlsyms fall into three one second windows of trace time, starting at the dlopen
+        static const char* windowArgs[] = { "-a", "-i", "1", "-R", tracePath, kCommand, NULL };
+        runDyldUsage(windowArgs, ^(NSArray* windows) {
+            if ( [windows count] != 3 )
+                FAIL("dyld_usage printed %lu windows, expected 3", (unsigned long)[windows count]);
+            for (NSUInteger i = 0; i < 2; ++i) {
+                if (    (value(windows[i], @"start_nano") != kTraceStartNanos + i * NSEC_PER_SEC)
+                     || (value(windows[i], @"end_nano") != kTraceStartNanos + (i + 1) * NSEC_PER_SEC) )
+                    FAIL("dyld_usage window %lu is not the %lu second of the trace", (unsigned long)i, (unsigned long)i);
+            }
+            checkDlopen(windows[0]);
+            checkLatency(findPhase(windows[0], @"dlsym"), "dlsym", 3, 10000, 40000);
+            if ( findPhase(windows[1], @"dlopen") != nil )
+                FAIL("dyld_usage dlopen carried over into the second window");
+            checkLatency(findPhase(windows[1], @"dlsym"), "dlsym", 1, 80000, 80000);
+            checkLatency(findPhase(windows[2], @"dlsym"), "dlsym", 1, 160000, 160000);
+
+            unlink(tracePath);
+            rmdir(tempDir);
+            PASS("Success");
+        });
+    });
+
+    dispatch_main();
+}
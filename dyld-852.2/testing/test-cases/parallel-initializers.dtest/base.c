@@ -0,0 +1,30 @@
+#include <string.h>
+#include <stdatomic.h>
+
+// Records the order initializers ran in, from any thread
+
+static const char* sInits[32];
+static atomic_int  sInitCount = 0;
+
+void recordInit(const char* name)
+{
+    int index = atomic_fetch_add(&sInitCount, 1);
+    if ( index < 32 )
+        sInits[index] = name;
+}
+
+int initIndex(const char* name)
+{
+    int count = atomic_load(&sInitCount);
+    for (int i=0; (i < count) && (i < 32); ++i) {
+        if ( (sInits[i] != NULL) && (strcmp(sInits[i], name) == 0) )
+            return i;
+    }
+    return -1;
+}
+
+__attribute__((constructor))
+void baseInit()
+{
+    recordInit("base");
+}
@@ -0,0 +1,153 @@
+
+// BUILD:  $CC base.c      -dynamiclib -install_name $RUN_DIR/libbase.dylib      -o $BUILD_DIR/libbase.dylib
+// BUILD:  $CC par.c       -dynamiclib -install_name $RUN_DIR/libpar2.dylib      -o $BUILD_DIR/libpar2.dylib      $BUILD_DIR/libbase.dylib -DNAME=\"par2\"
+// BUILD:  $CC needspar2.c -dynamiclib -install_name $RUN_DIR/libneedspar2.dylib -o $BUILD_DIR/libneedspar2.dylib $BUILD_DIR/libpar2.dylib $BUILD_DIR/libbase.dylib
+// BUILD:  $CC par.c       -dynamiclib -install_name $RUN_DIR/libpar1.dylib      -o $BUILD_DIR/libpar1.dylib      $BUILD_DIR/libbase.dylib -DNAME=\"par1\" -DDLOPEN_DURING_INIT=1 -DRUN_DIR="$RUN_DIR"
+// BUILD:  $CC top.c       -dynamiclib -install_name $RUN_DIR/libtop.dylib       -o $BUILD_DIR/libtop.dylib       $BUILD_DIR/libpar1.dylib $BUILD_DIR/libpar2.dylib $BUILD_DIR/libbase.dylib
+// BUILD:  $CXX main.cpp   -o $BUILD_DIR/parallel-initializers.exe $BUILD_DIR/libtop.dylib $BUILD_DIR/libbase.dylib -DRUN_DIR="$RUN_DIR"
+
+// RUN:  ./parallel-initializers.exe
+// RUN:  DYLD_PARALLEL_INITIALIZERS=1 ./parallel-initializers.exe
+
+// libpar1.dylib and libpar2.dylib opt in to parallel initializers and do not link each other, so
+// may be initialized on different threads.  libpar1.dylib's initializer dlopen()s an image which
+// links libpar2.dylib, which must not be initialized before libpar2.dylib's slow initializer is done.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <string>
+
+#include "test_support.h"
+
+extern "C" int  initIndex(const char* name);
+
+struct InitTime
+{
+    const char* leafName;
+    int         depth;
+};
+
+static InitTime sInitTimes[] = {
+    { "/libbase.dylib", -1 },
+    { "/libpar1.dylib", -1 },
+    { "/libpar2.dylib", -1 },
+    { "/libtop.dylib",  -1 },
+};
+
+static int depthOf(const char* leafName)
+{
+    for (InitTime& time : sInitTimes) {
+        if ( strcmp(time.leafName, leafName) == 0 )
+            return time.depth;
+    }
+    return -1;
+}
+
+// parses lines like "dyld: initializers in /path/libfoo.dylib took 12 us, dependency depth 2"
+static void parseInitializerTimes(const std::string& output)
+{
+    size_t lineStart = 0;
+    while ( lineStart < output.size() ) {
+        size_t lineEnd = output.find('\n', lineStart);
+        if ( lineEnd == std::string::npos )
+            lineEnd = output.size();
+        std::string line = output.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        char               path[1024];
+        unsigned long long micros;
+        unsigned           depth;
+        if ( sscanf(line.c_str(), "dyld: initializers in %1023s took %llu us, dependency depth %u", path, &micros, &depth) != 3 )
+            continue;
+        for (InitTime& time : sInitTimes) {
+            size_t pathLen = strlen(path);
+            size_t leafLen = strlen(time.leafName);
+            if ( (pathLen > leafLen) && (strcmp(&path[pathLen - leafLen], time.leafName) == 0) )
+                time.depth = depth;
+        }
+    }
+}
+
+static int checkInitOrder()
+{
+    if ( initIndex("par1-dlopen-failed") != -1 ) {
+        fprintf(stderr, "parallel-initializers: dlopen() from libpar1.dylib's initializer failed\n");
+        return 1;
+    }
+    if ( initIndex("needspar2-too-early") != -1 ) {
+        fprintf(stderr, "parallel-initializers: libneedspar2.dylib initialized before libpar2.dylib\n");
+        return 1;
+    }
+    if ( initIndex("base") != 0 ) {
+        fprintf(stderr, "parallel-initializers: libbase.dylib not initialized first\n");
+        return 1;
+    }
+    int top = initIndex("top");
+    if ( (initIndex("par1") == -1) || (initIndex("par2") == -1) || (initIndex("needspar2") == -1) || (top == -1) ) {
+        fprintf(stderr, "parallel-initializers: missing initializers\n");
+        return 1;
+    }
+    if ( (initIndex("par1") > top) || (initIndex("par2") > top) || (initIndex("needspar2") > top) ) {
+        fprintf(stderr, "parallel-initializers: libtop.dylib initialized before its dependents\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[])
+{
+    if ( (argc > 1) && (strcmp(argv[1], "child") == 0) ) {
+        // PASS/FAIL are silent with TEST_OUTPUT=None, so report through the exit status
+        return checkInitOrder();
+    }
+
+    _process process;
+    process.set_executable_path(RUN_DIR "/parallel-initializers.exe");
+    const char* args[] = { "child", NULL };
+    process.set_args(args);
+    const char* serialEnv[]   = { "TEST_OUTPUT=None", "DYLD_PRINT_INITIALIZER_TIMES=1", NULL };
+    const char* parallelEnv[] = { "TEST_OUTPUT=None", "DYLD_PRINT_INITIALIZER_TIMES=1", "DYLD_PARALLEL_INITIALIZERS=1", NULL };
+    process.set_env(getenv("DYLD_PARALLEL_INITIALIZERS") ? parallelEnv : serialEnv);
+
+    __block std::string output;
+    __block int         stderrFd = -1;
+    void (^drain)(int) = ^(int fd) {
+        char    buffer[16384];
+        ssize_t size;
+        while ( (size = read(fd, buffer, sizeof(buffer))) > 0 )
+            output.append(buffer, size);
+    };
+    process.set_stderr_handler(^(int fd) {
+        stderrFd = fd;
+        drain(fd);
+    });
+    process.set_exit_handler(^(pid_t pid) {
+        int childStatus;
+        (void)wait4(pid, &childStatus, 0, NULL);
+        // pick up anything written just before exit which the read source has not seen yet
+        if ( stderrFd != -1 )
+            drain(stderrFd);
+        if ( WIFEXITED(childStatus) == 0 )
+            FAIL("child did not exit");
+        if ( WEXITSTATUS(childStatus) != 0 )
+            FAIL("child failed: %s", output.c_str());
+
+        parseInitializerTimes(output);
+        for (const InitTime& time : sInitTimes) {
+            if ( time.depth == -1 )
+                FAIL("no DYLD_PRINT_INITIALIZER_TIMES line for %s", time.leafName);
+        }
+        if ( depthOf("/libpar1.dylib") != depthOf("/libbase.dylib") + 1 )
+            FAIL("libpar1.dylib depth %d, libbase.dylib depth %d", depthOf("/libpar1.dylib"), depthOf("/libbase.dylib"));
+        // libpar2.dylib's depth is not checked, as libpar1.dylib's dlopen() may have initialized it
+        if ( depthOf("/libtop.dylib") != depthOf("/libpar1.dylib") + 1 )
+            FAIL("libtop.dylib depth %d, libpar1.dylib depth %d", depthOf("/libtop.dylib"), depthOf("/libpar1.dylib"));
+        PASS("Success");
+    });
+    process.launch();
+    dispatch_main();
+}
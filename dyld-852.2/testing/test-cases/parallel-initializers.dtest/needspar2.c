@@ -0,0 +1,11 @@
+extern void recordInit(const char* name);
+extern int  initIndex(const char* name);
+
+__attribute__((constructor))
+void needsPar2Init()
+{
+    if ( initIndex("par2") == -1 )
+        recordInit("needspar2-too-early");
+    else
+        recordInit("needspar2");
+}
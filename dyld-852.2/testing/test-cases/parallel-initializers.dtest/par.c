@@ -0,0 +1,23 @@
+#include <unistd.h>
+#include <dlfcn.h>
+
+extern void recordInit(const char* name);
+
+// opt in to DYLD_PARALLEL_INITIALIZERS
+__attribute__((used, section("__TEXT,__dyld_par_init")))
+static const int sParallelInitSafe = 1;
+
+__attribute__((constructor))
+void parInit()
+{
+#if DLOPEN_DURING_INIT
+    // libneedspar2.dylib must not be initialized until libpar2.dylib is, even if
+    // libpar2.dylib is part way through its initializer on another thread
+    if ( dlopen(RUN_DIR "/libneedspar2.dylib", RTLD_NOW) == NULL )
+        recordInit("par1-dlopen-failed");
+#else
+    // give a batch-mate time to call dlopen() while this initializer is still running
+    usleep(200000);
+#endif
+    recordInit(NAME);
+}
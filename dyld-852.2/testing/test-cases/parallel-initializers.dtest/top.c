@@ -0,0 +1,7 @@
+extern void recordInit(const char* name);
+
+__attribute__((constructor))
+void topInit()
+{
+    recordInit("top");
+}
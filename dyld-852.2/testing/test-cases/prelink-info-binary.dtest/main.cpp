@@ -0,0 +1,215 @@
+
+// BUILD(macos):  $CXX main.cpp -std=c++17 -I$SRCROOT/dyld3 -framework CoreFoundation -framework IOKit -o $BUILD_DIR/prelink-info-binary.exe
+
+// BUILD(ios,tvos,watchos,bridgeos):
+
+// RUN:  ./prelink-info-binary.exe
+
+// Builds a prelink info dictionary the size of a large kernel collection, and checks that the binary form
+// unserializes to the same objects with both IOCFUnserializeBinary(), which is the user space copy of the
+// kernel's OSUnserializeBinary(), and the reader the tools use.  Then compares generation time, size, and
+// parse time against XML, parsing that with IOCFUnserialize(), the copy of the kernel's OSUnserializeXML().
+
+#include <stdio.h>
+#include <string.h>
+#include <mach/mach_time.h>
+
+#include <string>
+#include <vector>
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/IOCFUnserialize.h>
+
+#include "test_support.h"
+#include "OSSerializeBinary.h"
+
+static const int kKextCount     = 2000;
+static const int kIterations    = 5;
+
+static CFStringRef createString(const std::string& str)
+{
+    return CFStringCreateWithCString(kCFAllocatorDefault, str.c_str(), kCFStringEncodingUTF8);
+}
+
+static void setString(CFMutableDictionaryRef dict, const char* key, const std::string& value)
+{
+    CFStringRef keyRef   = createString(key);
+    CFStringRef valueRef = createString(value);
+    CFDictionarySetValue(dict, keyRef, valueRef);
+    CFRelease(valueRef);
+    CFRelease(keyRef);
+}
+
+static void setNumber(CFMutableDictionaryRef dict, const char* key, uint64_t value)
+{
+    CFStringRef keyRef   = createString(key);
+    CFNumberRef valueRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberLongLongType, &value);
+    CFDictionarySetValue(dict, keyRef, valueRef);
+    CFRelease(valueRef);
+    CFRelease(keyRef);
+}
+
+static CFMutableDictionaryRef createDictionary()
+{
+    return CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+}
+
+// Roughly what a kext's Info.plist looks like once the builder has added its _Prelink keys
+static CFDictionaryRef createKextInfo(int index)
+{
+    std::string bundleID = "com.apple.driver.TestDriver" + std::to_string(index);
+    CFMutableDictionaryRef info = createDictionary();
+    setString(info, "CFBundleIdentifier", bundleID);
+    setString(info, "CFBundleName", "TestDriver" + std::to_string(index));
+    setString(info, "CFBundleVersion", "1.0." + std::to_string(index));
+    setString(info, "CFBundleExecutable", "TestDriver");
+    setString(info, "CFBundlePackageType", "KEXT");
+    setString(info, "OSBundleRequired", "Root");
+    setString(info, "_PrelinkBundlePath", "/System/Library/Extensions/TestDriver" + std::to_string(index) + ".kext");
+    setString(info, "_PrelinkExecutableRelativePath", "Contents/MacOS/TestDriver");
+    setNumber(info, "_PrelinkExecutableLoadAddr", 0xFFFFFE0007004000ULL + index * 0x4000);
+    setNumber(info, "_PrelinkExecutableSourceAddr", 0xFFFFFE0007004000ULL + index * 0x4000);
+    setNumber(info, "_PrelinkExecutableSize", 0x4000);
+    setNumber(info, "_PrelinkKmodInfo", 0xFFFFFE0007005000ULL + index * 0x4000);
+
+    CFMutableDictionaryRef libraries = createDictionary();
+    setString(libraries, "com.apple.kpi.iokit", "19.2");
+    setString(libraries, "com.apple.kpi.libkern", "19.2");
+    setString(libraries, "com.apple.kpi.mach", "19.2");
+    CFDictionarySetValue(info, CFSTR("OSBundleLibraries"), libraries);
+    CFRelease(libraries);
+
+    CFMutableDictionaryRef personality = createDictionary();
+    setString(personality, "CFBundleIdentifier", bundleID);
+    setString(personality, "IOClass", "TestDriver" + std::to_string(index));
+    setString(personality, "IOProviderClass", "IOPCIDevice");
+    setString(personality, "IOPCIMatch", "0x" + std::to_string(1000 + index) + "8086");
+    setNumber(personality, "IOProbeScore", index % 1000);
+    CFDictionarySetValue(personality, CFSTR("IOMatchDefer"), kCFBooleanTrue);
+    uint8_t bytes[8] = { 1, 2, 3, 4, 5, 6, 7, (uint8_t)index };
+    CFDataRef data = CFDataCreate(kCFAllocatorDefault, bytes, sizeof(bytes));
+    CFDictionarySetValue(personality, CFSTR("IOPropertyData"), data);
+    CFRelease(data);
+    CFMutableDictionaryRef personalities = createDictionary();
+    CFDictionarySetValue(personalities, CFSTR("TestDriver"), personality);
+    CFDictionarySetValue(info, CFSTR("IOKitPersonalities"), personalities);
+    CFRelease(personalities);
+    CFRelease(personality);
+
+    return info;
+}
+
+static uint64_t nanos(uint64_t machTime)
+{
+    static mach_timebase_info_data_t timebase;
+    if ( timebase.denom == 0 )
+        mach_timebase_info(&timebase);
+    return machTime * timebase.numer / timebase.denom;
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    CFMutableArrayRef kexts = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+    for (int i=0; i < kKextCount; ++i) {
+        CFDictionaryRef info = createKextInfo(i);
+        CFArrayAppendValue(kexts, info);
+        CFRelease(info);
+    }
+    CFMutableDictionaryRef prelinkInfo = createDictionary();
+    CFDictionarySetValue(prelinkInfo, CFSTR("_PrelinkInfoDictionary"), kexts);
+    CFRelease(kexts);
+    uuid_t uuid = { 0x11, 0x22, 0x33, 0x44 };
+    CFDataRef uuidData = CFDataCreate(kCFAllocatorDefault, uuid, sizeof(uuid));
+    CFDictionarySetValue(prelinkInfo, CFSTR("_PrelinkKCID"), uuidData);
+    CFRelease(uuidData);
+
+    // Generation
+    CFDataRef xmlData = nullptr;
+    uint64_t t1 = mach_absolute_time();
+    for (int i=0; i < kIterations; ++i) {
+        if ( xmlData != nullptr )
+            CFRelease(xmlData);
+        xmlData = CFPropertyListCreateData(kCFAllocatorDefault, prelinkInfo, kCFPropertyListXMLFormat_v1_0, 0, nullptr);
+    }
+    uint64_t t2 = mach_absolute_time();
+    std::vector<uint8_t> binary;
+    for (int i=0; i < kIterations; ++i) {
+        dyld3::OSSerializeBinaryWriter writer;
+        if ( !writer.addCFObject(prelinkInfo) || !writer.complete() )
+            FAIL("could not serialize binary prelink info: %s", writer.failureReason());
+        binary = writer.bytes();
+    }
+    uint64_t t3 = mach_absolute_time();
+    if ( xmlData == nullptr )
+        FAIL("could not serialize XML prelink info");
+    if ( !dyld3::isOSSerializeBinary(binary.data(), binary.size()) )
+        FAIL("binary prelink info is missing its signature");
+
+    // The XML parser needs a nul terminated buffer
+    std::string xml((const char*)CFDataGetBytePtr(xmlData), CFDataGetLength(xmlData));
+
+    // Parsing, as the kernel would
+    CFTypeRef fromXML = nullptr;
+    uint64_t t4 = mach_absolute_time();
+    for (int i=0; i < kIterations; ++i) {
+        if ( fromXML != nullptr )
+            CFRelease(fromXML);
+        fromXML = IOCFUnserialize(xml.c_str(), kCFAllocatorDefault, 0, nullptr);
+    }
+    uint64_t t5 = mach_absolute_time();
+    CFTypeRef fromBinary = nullptr;
+    for (int i=0; i < kIterations; ++i) {
+        if ( fromBinary != nullptr )
+            CFRelease(fromBinary);
+        CFStringRef errorString = nullptr;
+        fromBinary = IOCFUnserializeBinary((const char*)binary.data(), binary.size(), kCFAllocatorDefault, 0, &errorString);
+        if ( fromBinary == nullptr )
+            FAIL("IOCFUnserializeBinary() failed");
+    }
+    uint64_t t6 = mach_absolute_time();
+
+    if ( (fromXML == nullptr) || !CFEqual(fromXML, prelinkInfo) )
+        FAIL("XML prelink info did not round trip");
+    if ( !CFEqual(fromBinary, prelinkInfo) )
+        FAIL("binary prelink info unserialized by IOCFUnserializeBinary() does not match");
+
+    std::string failureReason;
+    CFTypeRef fromReader = dyld3::createCFObjectFromOSSerializeBinary(binary.data(), binary.size(), failureReason);
+    if ( fromReader == nullptr )
+        FAIL("could not read binary prelink info: %s", failureReason.c_str());
+    if ( !CFEqual(fromReader, prelinkInfo) )
+        FAIL("binary prelink info read by the tools does not match");
+
+    // Placeholders can be patched in place without changing the size
+    dyld3::OSSerializeBinaryWriter writer;
+    writer.beginDictionary(2);
+    writer.addKey("_PrelinkExecutableLoadAddr");
+    size_t loadAddrOffset = writer.addNumber(0);
+    writer.addKey("_PrelinkKCID");
+    uuid_t placeholderUUID = {};
+    size_t uuidOffset = writer.addData(placeholderUUID, sizeof(placeholderUUID));
+    size_t size = writer.bytes().size();
+    writer.patchNumber(loadAddrOffset, 0xFFFFFE0007004000ULL);
+    writer.patchData(uuidOffset, uuid, sizeof(uuid));
+    if ( !writer.complete() || (writer.bytes().size() != size) )
+        FAIL("patching placeholders changed the binary prelink info");
+    CFDictionaryRef patched = (CFDictionaryRef)IOCFUnserializeBinary((const char*)writer.bytes().data(), size, kCFAllocatorDefault, 0, nullptr);
+    if ( patched == nullptr )
+        FAIL("could not unserialize patched prelink info");
+    uint64_t loadAddr = 0;
+    CFNumberGetValue((CFNumberRef)CFDictionaryGetValue(patched, CFSTR("_PrelinkExecutableLoadAddr")), kCFNumberLongLongType, &loadAddr);
+    if ( loadAddr != 0xFFFFFE0007004000ULL )
+        FAIL("patched load address is 0x%llx", loadAddr);
+    if ( memcmp(CFDataGetBytePtr((CFDataRef)CFDictionaryGetValue(patched, CFSTR("_PrelinkKCID"))), uuid, sizeof(uuid)) != 0 )
+        FAIL("patched UUID does not match");
+
+    CFRelease(patched);
+    CFRelease(fromReader);
+    CFRelease(fromBinary);
+    CFRelease(fromXML);
+    CFRelease(xmlData);
+    CFRelease(prelinkInfo);
+
+    PASS("%d kexts: XML %lu bytes, generated in %lluus, parsed in %lluus; binary %lu bytes, generated in %lluus, parsed in %lluus",
+         kKextCount, xml.size(), nanos(t2 - t1)/kIterations/1000, nanos(t5 - t4)/kIterations/1000,
+         binary.size(), nanos(t3 - t2)/kIterations/1000, nanos(t6 - t5)/kIterations/1000);
+}
@@ -0,0 +1,171 @@
+
+// BUILD:  $CXX main.cpp -std=c++17 -I$SRCROOT/dyld3 -o $BUILD_DIR/symbolication-index.exe
+
+// RUN:  ./symbolication-index.exe
+
+// Builds a symbolication index for a cache sized set of images, sections and symbols, and checks that
+// looking up sorted addresses in one pass, and each address on its own, both give what a scan of every
+// symbol of the image gives, which is how MachOLoaded::findClosestSymbol() works.  Then compares the time
+// taken by each.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mach/mach_time.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "test_support.h"
+#include "SymbolicationIndex.h"
+
+static const int kImageCount        = 500;
+static const int kSectionsPerImage  = 4;
+static const int kSymbolsPerSection = 200;
+static const int kAddressCount      = 200000;
+static const int kScannedCount      = 200;
+
+struct TestSection
+{
+    uint64_t    vmAddr;
+    uint64_t    vmSize;
+    int         image;
+};
+
+struct TestSymbol
+{
+    uint64_t    vmAddr;
+    std::string name;
+};
+
+static std::vector<TestSection> sSections;
+static std::vector<TestSymbol>  sSymbols;
+
+// what findClosestSymbol() would say: the last symbol at or before the address in the section containing it
+static bool scan(uint64_t address, int& image, const TestSymbol*& symbol)
+{
+    for (const TestSection& section : sSections) {
+        if ( (address < section.vmAddr) || (address >= section.vmAddr + section.vmSize) )
+            continue;
+        image  = section.image;
+        symbol = nullptr;
+        for (const TestSymbol& sym : sSymbols) {
+            if ( (sym.vmAddr <= address) && (sym.vmAddr >= section.vmAddr) && ((symbol == nullptr) || (sym.vmAddr > symbol->vmAddr)) )
+                symbol = &sym;
+        }
+        return true;
+    }
+    return false;
+}
+
+static void check(uint64_t address, const dyld3::SymbolicationIndex::Result& result, const char* how)
+{
+    int               image;
+    const TestSymbol* symbol;
+    if ( !scan(address, image, symbol) ) {
+        if ( result.imagePath != nullptr )
+            FAIL("%s: 0x%llX is in no image, but got %s", how, address, result.imagePath);
+        return;
+    }
+    std::string imagePath = "/usr/lib/libtest" + std::to_string(image) + ".dylib";
+    if ( (result.imagePath == nullptr) || (imagePath != result.imagePath) )
+        FAIL("%s: 0x%llX should be in %s", how, address, imagePath.c_str());
+    if ( symbol == nullptr ) {
+        if ( result.symbolName != nullptr )
+            FAIL("%s: 0x%llX should have no symbol, but got %s", how, address, result.symbolName);
+    }
+    else if ( (result.symbolName == nullptr) || (symbol->name != result.symbolName) || (symbol->vmAddr != result.symbolAddress) ) {
+        FAIL("%s: 0x%llX should be in %s", how, address, symbol->name.c_str());
+    }
+}
+
+static uint64_t nanos(uint64_t machTime)
+{
+    static mach_timebase_info_data_t timebase;
+    if ( timebase.denom == 0 )
+        mach_timebase_info(&timebase);
+    return machTime * timebase.numer / timebase.denom;
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    dyld3::SymbolicationIndexBuilder builder;
+    std::set<uint64_t> symbolAddresses;
+    uint64_t vmAddr = 0x180000000ULL;
+    srandom(42);
+    for (int i=0; i < kImageCount; ++i) {
+        uint32_t imageIndex = builder.addImage(("/usr/lib/libtest" + std::to_string(i) + ".dylib").c_str(), vmAddr);
+        for (int s=0; s < kSectionsPerImage; ++s) {
+            uint64_t vmSize = 0x1000 + (random() % 0x10000);
+            builder.addRange(imageIndex, vmAddr, vmSize);
+            sSections.push_back({ vmAddr, vmSize, i });
+            for (int y=0; y < kSymbolsPerSection; ++y) {
+                // the first symbol of a section is not always at its start
+                TestSymbol symbol = { vmAddr + 0x10 + (random() % vmSize), "_sym_" + std::to_string(i) + "_" + std::to_string(s) + "_" + std::to_string(y) };
+                if ( symbol.vmAddr >= vmAddr + vmSize )
+                    continue;
+                // like a cache's globals and locals, there may be several names for an address, and the first wins
+                builder.addSymbol(symbol.vmAddr, symbol.name.c_str());
+                if ( symbolAddresses.insert(symbol.vmAddr).second )
+                    sSymbols.push_back(symbol);
+            }
+            // gaps between sections belong to no image
+            vmAddr += vmSize + 0x100 * (random() % 4);
+        }
+    }
+    uuid_t uuid = { 0x11, 0x22, 0x33, 0x44 };
+    std::vector<uint8_t> bytes;
+    builder.write(uuid, bytes);
+
+    dyld3::SymbolicationIndex index;
+    std::string failureReason;
+    if ( !index.init(bytes.data(), bytes.size(), failureReason) )
+        FAIL("could not open index: %s", failureReason.c_str());
+    if ( memcmp(index.cacheUUID(), uuid, sizeof(uuid)) != 0 )
+        FAIL("index has the wrong cache UUID");
+    if ( index.symbolCount() != sSymbols.size() )
+        FAIL("index has %llu symbols, expected %lu", index.symbolCount(), sSymbols.size());
+    std::string truncatedReason;
+    if ( index.init(bytes.data(), bytes.size() / 2, truncatedReason) )
+        FAIL("truncated index was accepted");
+    if ( !index.init(bytes.data(), bytes.size(), failureReason) )
+        FAIL("could not reopen index: %s", failureReason.c_str());
+
+    // addresses before, between, inside, and after all the images
+    std::vector<uint64_t> addresses;
+    for (int i=0; i < kAddressCount; ++i)
+        addresses.push_back(0x17FFFF000ULL + (random() % (vmAddr - 0x17FFFF000ULL + 0x2000)));
+    std::sort(addresses.begin(), addresses.end());
+
+    // check a sample against a scan, which is too slow to do for all of them
+    for (int i=0; i < kScannedCount; ++i) {
+        uint64_t address = addresses[random() % addresses.size()];
+        check(address, index.symbolicate(address), "symbolicate()");
+    }
+    __block std::vector<dyld3::SymbolicationIndex::Result> sortedResults(addresses.size());
+    uint64_t t1 = mach_absolute_time();
+    index.symbolicateSorted(addresses.data(), addresses.size(), ^(size_t i, const dyld3::SymbolicationIndex::Result& result) {
+        sortedResults[i] = result;
+    });
+    uint64_t t2 = mach_absolute_time();
+    std::vector<dyld3::SymbolicationIndex::Result> results;
+    results.reserve(addresses.size());
+    for (uint64_t address : addresses)
+        results.push_back(index.symbolicate(address));
+    uint64_t t3 = mach_absolute_time();
+    for (size_t i=0; i < addresses.size(); ++i) {
+        if ( (results[i].imagePath != sortedResults[i].imagePath) || (results[i].symbolName != sortedResults[i].symbolName) )
+            FAIL("0x%llX: symbolicateSorted() and symbolicate() differ", addresses[i]);
+    }
+
+    // an address out of order is still answered
+    std::vector<uint64_t> unsorted = { addresses[kAddressCount/2], addresses[10], addresses[kAddressCount-1] };
+    const uint64_t* unsortedAddresses = unsorted.data();
+    index.symbolicateSorted(unsortedAddresses, unsorted.size(), ^(size_t i, const dyld3::SymbolicationIndex::Result& result) {
+        check(unsortedAddresses[i], result, "symbolicateSorted() unsorted");
+    });
+
+    PASS("%lu symbols, %d addresses: merged in %lluus, looked up one at a time in %lluus",
+         sSymbols.size(), kAddressCount, nanos(t2 - t1)/1000, nanos(t3 - t2)/1000);
+}
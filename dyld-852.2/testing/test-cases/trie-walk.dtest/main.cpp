@@ -0,0 +1,267 @@
+
+// BUILD:  $CXX main.cpp -I$SRCROOT/dyld3 -o $BUILD_DIR/trie-walk.exe
+
+// RUN:  ./trie-walk.exe
+
+// Checks the vectorized trie edge matching against a byte-at-a-time walker using the export
+// tries of real frameworks, then times a million lookups with each.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <mach/mach_time.h>
+#include <mach-o/dyld.h>
+#include <mach-o/loader.h>
+
+#include <string>
+#include <vector>
+
+#include "test_support.h"
+#include "TrieEdge.h"
+
+struct ExportTrie
+{
+    const char*                 path;
+    const uint8_t*              start;
+    const uint8_t*              end;
+    std::vector<std::string>    names;
+};
+
+static uint64_t readUleb128(const uint8_t*& p, const uint8_t* end)
+{
+    uint64_t result = 0;
+    int      bit    = 0;
+    do {
+        if ( (p == end) || (bit > 63) )
+            return 0;
+        result |= ((uint64_t)(*p & 0x7f) << bit);
+        bit += 7;
+    } while ( *p++ & 0x80 );
+    return result;
+}
+
+// the trie walk as it was before edges were compared 16 bytes at a time
+static const uint8_t* scalarTrieWalk(const uint8_t* start, const uint8_t* end, const char* s)
+{
+    const uint8_t* p = start;
+    while ( (p != nullptr) && (p < end) ) {
+        uint64_t terminalSize = readUleb128(p, end);
+        if ( (*s == '\0') && (terminalSize != 0) )
+            return p;
+        const uint8_t* children = p + terminalSize;
+        if ( children >= end )
+            return nullptr;
+        uint8_t childrenRemaining = *children++;
+        p = children;
+        uint64_t nodeOffset = 0;
+        for (; childrenRemaining > 0; --childrenRemaining) {
+            const char* ss = s;
+            bool wrongEdge = false;
+            while ( (p < end) && (*p != '\0') ) {
+                if ( !wrongEdge ) {
+                    if ( *p != (uint8_t)*ss )
+                        wrongEdge = true;
+                    ++ss;
+                }
+                ++p;
+            }
+            if ( p >= end )
+                return nullptr;
+            ++p;
+            if ( wrongEdge ) {
+                while ( (p < end) && ((*p & 0x80) != 0) )
+                    ++p;
+                ++p;
+            }
+            else {
+                nodeOffset = readUleb128(p, end);
+                s = ss;
+                break;
+            }
+        }
+        p = ((nodeOffset != 0) && (nodeOffset < (uint64_t)(end - start))) ? &start[nodeOffset] : nullptr;
+    }
+    return nullptr;
+}
+
+template <bool StrictBounds>
+static const uint8_t* vectorTrieWalk(const uint8_t* start, const uint8_t* end, const char* s)
+{
+    const uint8_t* p = start;
+    while ( (p != nullptr) && (p < end) ) {
+        uint64_t terminalSize = readUleb128(p, end);
+        if ( (*s == '\0') && (terminalSize != 0) )
+            return p;
+        const uint8_t* children = p + terminalSize;
+        if ( children >= end )
+            return nullptr;
+        uint8_t childrenRemaining = *children++;
+        p = children;
+        uint64_t nodeOffset = 0;
+        for (; childrenRemaining > 0; --childrenRemaining) {
+            bool edgeMatches;
+            const uint8_t* edgeEnd = dyld3::trieMatchEdge<StrictBounds>(p, end, s, edgeMatches);
+            if ( edgeEnd == nullptr )
+                return nullptr;
+            const size_t edgeLength = edgeEnd - p;
+            p = edgeEnd + 1;
+            if ( !edgeMatches ) {
+                p = dyld3::trieSkipUleb128(p, end);
+                if ( p == nullptr )
+                    return nullptr;
+            }
+            else {
+                nodeOffset = readUleb128(p, end);
+                s += edgeLength;
+                break;
+            }
+        }
+        p = ((nodeOffset != 0) && (nodeOffset < (uint64_t)(end - start))) ? &start[nodeOffset] : nullptr;
+    }
+    return nullptr;
+}
+
+static void collectNames(const uint8_t* start, const uint8_t* end, const uint8_t* node, std::string& prefix, unsigned depth, std::vector<std::string>& names)
+{
+    if ( (depth > 128) || (node >= end) )
+        return;
+    const uint8_t* p = node;
+    uint64_t terminalSize = readUleb128(p, end);
+    if ( terminalSize != 0 )
+        names.push_back(prefix);
+    const uint8_t* children = p + terminalSize;
+    if ( children >= end )
+        return;
+    uint8_t childCount = *children++;
+    p = children;
+    for (uint8_t i=0; i < childCount; ++i) {
+        const uint8_t* edge = p;
+        while ( (p < end) && (*p != '\0') )
+            ++p;
+        if ( p >= end )
+            return;
+        size_t edgeLength = p - edge;
+        ++p;
+        uint64_t childOffset = readUleb128(p, end);
+        if ( (childOffset == 0) || (childOffset >= (uint64_t)(end - start)) )
+            return;
+        prefix.append((const char*)edge, edgeLength);
+        collectNames(start, end, &start[childOffset], prefix, depth+1, names);
+        prefix.resize(prefix.size() - edgeLength);
+    }
+}
+
+static bool findExportTrie(const mach_header* mh, intptr_t slide, ExportTrie& trie)
+{
+    const load_command* cmd = (load_command*)((uint8_t*)mh + ((mh->magic == MH_MAGIC_64) ? sizeof(mach_header_64) : sizeof(mach_header)));
+    uint64_t linkeditVMAddr   = 0;
+    uint64_t linkeditFileOff  = 0;
+    uint32_t trieOffset       = 0;
+    uint32_t trieSize         = 0;
+    for (uint32_t i=0; i < mh->ncmds; ++i) {
+        switch ( cmd->cmd ) {
+            case LC_SEGMENT_64: {
+                const segment_command_64* seg = (segment_command_64*)cmd;
+                if ( strcmp(seg->segname, "__LINKEDIT") == 0 ) {
+                    linkeditVMAddr  = seg->vmaddr;
+                    linkeditFileOff = seg->fileoff;
+                }
+                break;
+            }
+            case LC_SEGMENT: {
+                const segment_command* seg = (segment_command*)cmd;
+                if ( strcmp(seg->segname, "__LINKEDIT") == 0 ) {
+                    linkeditVMAddr  = seg->vmaddr;
+                    linkeditFileOff = seg->fileoff;
+                }
+                break;
+            }
+            case LC_DYLD_INFO:
+            case LC_DYLD_INFO_ONLY:
+                trieOffset = ((dyld_info_command*)cmd)->export_off;
+                trieSize   = ((dyld_info_command*)cmd)->export_size;
+                break;
+#ifdef LC_DYLD_EXPORTS_TRIE
+            case LC_DYLD_EXPORTS_TRIE:
+                trieOffset = ((linkedit_data_command*)cmd)->dataoff;
+                trieSize   = ((linkedit_data_command*)cmd)->datasize;
+                break;
+#endif
+        }
+        cmd = (load_command*)((uint8_t*)cmd + cmd->cmdsize);
+    }
+    if ( (trieSize == 0) || (linkeditVMAddr == 0) )
+        return false;
+    trie.start = (uint8_t*)(linkeditVMAddr + slide + (trieOffset - linkeditFileOff));
+    trie.end   = trie.start + trieSize;
+    std::string prefix;
+    collectNames(trie.start, trie.end, trie.start, prefix, 0, trie.names);
+    return !trie.names.empty();
+}
+
+typedef const uint8_t* (*TrieWalker)(const uint8_t* start, const uint8_t* end, const char* s);
+typedef std::vector<std::pair<const ExportTrie*, std::string>> Queries;
+
+static volatile uintptr_t sFound;
+
+static uint64_t timeWalker(TrieWalker walker, const Queries& queries)
+{
+    uint64_t t1 = mach_absolute_time();
+    for (const auto& query : queries)
+        sFound = (uintptr_t)walker(query.first->start, query.first->end, query.second.c_str());
+    return mach_absolute_time() - t1;
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[]) {
+    // make sure there are some big tries to look at
+    dlopen("/System/Library/Frameworks/Foundation.framework/Foundation", RTLD_LAZY);
+
+    std::vector<ExportTrie> tries;
+    for (uint32_t i=0; i < _dyld_image_count(); ++i) {
+        ExportTrie trie;
+        trie.path = _dyld_get_image_name(i);
+        if ( findExportTrie(_dyld_get_image_header(i), _dyld_get_image_vmaddr_slide(i), trie) )
+            tries.push_back(trie);
+    }
+    if ( tries.empty() )
+        FAIL("no export tries found");
+
+    // every name, and near misses of every name, must give the same answer from all walkers
+    size_t nameCount = 0;
+    for (const ExportTrie& trie : tries) {
+        for (const std::string& name : trie.names) {
+            std::string variants[3] = { name, name + "x", name.substr(0, name.size()/2) };
+            for (const std::string& variant : variants) {
+                const uint8_t* expected = scalarTrieWalk(trie.start, trie.end, variant.c_str());
+                if ( vectorTrieWalk<true>(trie.start, trie.end, variant.c_str()) != expected )
+                    FAIL("strict walk mismatch for %s in %s", variant.c_str(), trie.path);
+                if ( vectorTrieWalk<false>(trie.start, trie.end, variant.c_str()) != expected )
+                    FAIL("walk mismatch for %s in %s", variant.c_str(), trie.path);
+            }
+            if ( scalarTrieWalk(trie.start, trie.end, name.c_str()) == nullptr )
+                FAIL("%s not found in %s", name.c_str(), trie.path);
+            ++nameCount;
+        }
+    }
+    LOG("checked %lu names in %lu tries", nameCount, tries.size());
+
+    // time a million lookups, alternating hits and misses, spread over all tries
+    const size_t kLookupCount = 1000000;
+    Queries queries;
+    for (size_t i=0; queries.size() < kLookupCount/2; ++i) {
+        const ExportTrie& trie = tries[i % tries.size()];
+        const std::string& name = trie.names[(i / tries.size()) % trie.names.size()];
+        queries.push_back({ &trie, name });
+        queries.push_back({ &trie, name.substr(0, name.size()-1) + "?" });
+    }
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    uint64_t scalarNanos = timeWalker(&scalarTrieWalk, queries)         * timebase.numer / timebase.denom;
+    uint64_t strictNanos = timeWalker(&vectorTrieWalk<true>, queries)   * timebase.numer / timebase.denom;
+    uint64_t vectorNanos = timeWalker(&vectorTrieWalk<false>, queries)  * timebase.numer / timebase.denom;
+
+    PASS("%lu lookups: byte-at-a-time %llums, strict %llums, vector %llums",
+         queries.size(), scalarNanos/1000000, strictNanos/1000000, vectorNanos/1000000);
+}
+
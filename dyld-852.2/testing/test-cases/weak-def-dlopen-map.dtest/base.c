@@ -0,0 +1,13 @@
+// linked by the main executable, so its weak definitions are the ones everything else coalesces to
+
+__attribute__((weak)) int gWeakData = 1;
+
+__attribute__((weak)) int weakFunc()
+{
+    return 1;
+}
+
+int* baseWeakData()
+{
+    return &gWeakData;
+}
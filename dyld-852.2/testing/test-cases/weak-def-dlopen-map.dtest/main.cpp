@@ -0,0 +1,106 @@
+
+// BUILD(macos):  $CC base.c   -dynamiclib -install_name $RUN_DIR/libbase.dylib    -o $BUILD_DIR/libbase.dylib
+// BUILD(macos):  $CC plugin.c -dynamiclib -install_name $RUN_DIR/libplugin2.dylib -o $BUILD_DIR/libplugin2.dylib -DPLUGIN=2
+// BUILD(macos):  $CC plugin.c -dynamiclib -install_name $RUN_DIR/libplugin3.dylib -o $BUILD_DIR/libplugin3.dylib -DPLUGIN=3
+// BUILD(macos):  $CXX main.cpp -o $BUILD_DIR/weak-def-dlopen-map.exe $BUILD_DIR/libbase.dylib -DRUN_DIR="$RUN_DIR"
+
+// BUILD(ios,tvos,watchos,bridgeos):
+
+// RUN:  ./weak-def-dlopen-map.exe
+// RUN:  DYLD_LEGACY_WEAK_BIND=1 ./weak-def-dlopen-map.exe
+
+// dlopen()ed images' weak definitions must coalesce with the ones already loaded, both with the weak
+// definition map dyld2 now uses by default, and with the old scan which DYLD_LEGACY_WEAK_BIND turns back on.
+// DYLD_PRINT_WEAK_BINDINGS shows which was used.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/wait.h>
+
+#include <string>
+
+#include "test_support.h"
+
+extern "C" int* baseWeakData();
+
+static int checkPlugin(const char* path)
+{
+    void* handle = dlopen(path, RTLD_FIRST);
+    if ( handle == NULL ) {
+        fprintf(stderr, "weak-def-dlopen-map: dlopen(%s) failed: %s\n", path, dlerror());
+        return 1;
+    }
+    int* (*weakData)() = (int* (*)())dlsym(handle, "pluginWeakData");
+    int  (*weakFunc)() = (int (*)())dlsym(handle, "pluginWeakFunc");
+    if ( (weakData == NULL) || (weakFunc == NULL) ) {
+        fprintf(stderr, "weak-def-dlopen-map: dlsym() in %s failed\n", path);
+        return 1;
+    }
+    if ( weakData() != baseWeakData() ) {
+        fprintf(stderr, "weak-def-dlopen-map: gWeakData in %s is %p, not libbase.dylib's %p\n", path, weakData(), baseWeakData());
+        return 1;
+    }
+    if ( weakFunc() != 1 ) {
+        fprintf(stderr, "weak-def-dlopen-map: weakFunc() in %s is the plugin's own\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[])
+{
+    if ( (argc > 1) && (strcmp(argv[1], "child") == 0) ) {
+        // PASS/FAIL are silent with TEST_OUTPUT=None, so report through the exit status
+        // the second plugin finds the symbols already in the map, if it is used
+        if ( checkPlugin(RUN_DIR "/libplugin2.dylib") != 0 )
+            return 1;
+        return checkPlugin(RUN_DIR "/libplugin3.dylib");
+    }
+
+    // the weak definition map is only used by dyld2
+    const bool legacy = (getenv("DYLD_LEGACY_WEAK_BIND") != NULL);
+    _process process;
+    process.set_executable_path(RUN_DIR "/weak-def-dlopen-map.exe");
+    const char* args[] = { "child", NULL };
+    process.set_args(args);
+    const char* mapEnv[]    = { "TEST_OUTPUT=None", "DYLD_USE_CLOSURES=0", "DYLD_PRINT_WEAK_BINDINGS=1", NULL };
+    const char* legacyEnv[] = { "TEST_OUTPUT=None", "DYLD_USE_CLOSURES=0", "DYLD_PRINT_WEAK_BINDINGS=1", "DYLD_LEGACY_WEAK_BIND=1", NULL };
+    process.set_env(legacy ? legacyEnv : mapEnv);
+
+    __block std::string output;
+    __block int         stderrFd = -1;
+    void (^drain)(int) = ^(int fd) {
+        char    buffer[16384];
+        ssize_t size;
+        while ( (size = read(fd, buffer, sizeof(buffer))) > 0 )
+            output.append(buffer, size);
+    };
+    process.set_stderr_handler(^(int fd) {
+        stderrFd = fd;
+        drain(fd);
+    });
+    process.set_exit_handler(^(pid_t pid) {
+        int childStatus;
+        (void)wait4(pid, &childStatus, 0, NULL);
+        // pick up anything written just before exit which the read source has not seen yet
+        if ( stderrFd != -1 )
+            drain(stderrFd);
+        if ( WIFEXITED(childStatus) == 0 )
+            FAIL("child did not exit");
+        if ( WEXITSTATUS(childStatus) != 0 )
+            FAIL("child failed: %s", output.c_str());
+        if ( output.find("dyld: weak bind start:") == std::string::npos )
+            FAIL("no DYLD_PRINT_WEAK_BINDINGS output");
+        const bool usedMap = (output.find("dyld: weak binding dlopen using weak def map") != std::string::npos);
+        if ( legacy && usedMap )
+            FAIL("DYLD_LEGACY_WEAK_BIND=1 still used the weak definition map");
+        if ( !legacy && !usedMap )
+            FAIL("weak definition map not used by default");
+        PASS("Success");
+    });
+    process.launch();
+    dispatch_main();
+}
@@ -0,0 +1,18 @@
+// dlopen()ed, so its weak definitions lose to libbase.dylib's
+
+__attribute__((weak)) int gWeakData = PLUGIN;
+
+__attribute__((weak)) int weakFunc()
+{
+    return PLUGIN;
+}
+
+int* pluginWeakData()
+{
+    return &gWeakData;
+}
+
+int pluginWeakFunc()
+{
+    return weakFunc();
+}